@@ -1,7 +1,9 @@
 #include <iostream>
 #include <fstream>
+#include <cmath>
 #include "Assets/AssetIdentity.h"
 #include "AssimpConverter.h"
+#include "Simplifier/MeshSimplifier.h"
 #include "assimp/postprocess.h"
 
 namespace Lightning
@@ -39,6 +41,8 @@ namespace Lightning
 				auto& header = metadata.header;
 				auto mesh = metadata.mesh;
 				FillMeshHeader(header, mesh, meshDataOffset);
+				GenerateLods(metadata);
+				FillLodHeaders(metadata, meshDataOffset);
 			}
 
 			std::uint8_t* buffer = new std::uint8_t[meshDataOffset];
@@ -52,6 +56,7 @@ namespace Lightning
 				std::memcpy(buffer + sizeof(mMeshesHeader) + i * sizeof(meshHeader), &meshHeader, sizeof(meshHeader));
 				//copy vertex streams
 				CopyMeshData(meshHeader, mesh, buffer);
+				CopyLodData(mMeshMetadatas[i], buffer);
 			}
 
 			std::string fileName(mScene->GetShortFilename(inputFilePath.c_str()));
@@ -202,6 +207,64 @@ namespace Lightning
 			}
 		}
 
+		void AssimpConverter::GenerateLods(MeshMetadata& metadata)
+		{
+			const auto& header = metadata.header;
+			const auto mesh = metadata.mesh;
+			metadata.lods.clear();
+			metadata.lodErrors.clear();
+			if (!mesh->mVertices || header.IndexCount == 0 || mesh->mFaces[0].mNumIndices != 3)
+				return;
+			std::vector<std::uint32_t> indices;
+			indices.reserve(header.IndexCount);
+			for (unsigned int i = 0;i < mesh->mNumFaces; ++i)
+			{
+				const auto& face = mesh->mFaces[i];
+				indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+			}
+			static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "aiVector3D must be 3 floats.");
+			MeshSimplifier simplifier(reinterpret_cast<const float*>(mesh->mVertices), mesh->mNumVertices, indices.data(), indices.size());
+			//each level has about half the triangles of the previous one
+			std::size_t indexCount = indices.size();
+			while (metadata.lods.size() < Asset::MaxLodLevels)
+			{
+				auto targetIndexCount = indexCount / 6 * 3;
+				if (targetIndexCount < MinLodIndexCount)
+					break;
+				auto lod = simplifier.Simplify(targetIndexCount);
+				//borders and seams may prevent further simplification
+				if (lod.size() * 10 > indexCount * 9)
+					break;
+				indexCount = lod.size();
+				metadata.lods.emplace_back(std::move(lod));
+				metadata.lodErrors.push_back(std::sqrt(simplifier.GetError()));
+			}
+		}
+
+		void AssimpConverter::FillLodHeaders(MeshMetadata& metadata, std::uint32_t& meshDataOffset)
+		{
+			auto& header = metadata.header;
+			header.LodCount = static_cast<std::uint8_t>(metadata.lods.size());
+			for (std::size_t i = 0;i < metadata.lods.size();++i)
+			{
+				auto& lod = header.Lods[i];
+				lod.IndexOffset = meshDataOffset;
+				lod.IndexCount = static_cast<std::uint32_t>(metadata.lods[i].size());
+				lod.Error = metadata.lodErrors[i];
+				meshDataOffset += lod.IndexCount * header.IndexSize;
+			}
+		}
+
+		void AssimpConverter::CopyLodData(const MeshMetadata& metadata, std::uint8_t* buffer)
+		{
+			const auto& header = metadata.header;
+			for (std::size_t i = 0;i < header.LodCount;++i)
+			{
+				const auto& lod = header.Lods[i];
+				std::memcpy(buffer + lod.IndexOffset, metadata.lods[i].data(), lod.IndexCount * header.IndexSize);
+			}
+		}
+
 		void AssimpConverter::VisitNode(aiNode* node)
 		{
 			mMeshesHeader.NumberOfMeshes += node->mNumMeshes;
@@ -226,6 +289,7 @@ namespace Lightning
 			auto& header = meshMetadata.header;
 			header.PrimitiveType = 0;
 			header.VertexStreams = 0;
+			header.LodCount = 0;
 
 			return meshMetadata;
 		}
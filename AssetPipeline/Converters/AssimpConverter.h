@@ -19,11 +19,19 @@ namespace Lightning
 			{
 				Asset::MeshHeader header;
 				aiMesh* mesh;
+				//indices of simplified levels,from fine to coarse
+				std::vector<std::vector<std::uint32_t>> lods;
+				std::vector<float> lodErrors;
 			};
+			//a mesh is not simplified below this many indices
+			static constexpr std::size_t MinLodIndexCount = 36;
 			void VisitNode(aiNode* node);
 			MeshMetadata CreateMeshMetaData(aiMesh* mesh);
 			void FillMeshHeader(Asset::MeshHeader& header, const aiMesh* mesh, std::uint32_t& meshDataOffset);
 			void CopyMeshData(const Asset::MeshHeader& header, const aiMesh* mesh, std::uint8_t* buffer);
+			void GenerateLods(MeshMetadata& metadata);
+			void FillLodHeaders(MeshMetadata& metadata, std::uint32_t& meshDataOffset);
+			void CopyLodData(const MeshMetadata& metadata, std::uint8_t* buffer);
 			Assimp::Importer mImporter;
 			const aiScene* mScene;
 			Asset::MeshesHeader mMeshesHeader;
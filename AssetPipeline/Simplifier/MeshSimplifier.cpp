@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include "MeshSimplifier.h"
+
+namespace Lightning
+{
+	namespace Tools
+	{
+		namespace
+		{
+			void TriangleNormal(const float* p0, const float* p1, const float* p2, double* normal)
+			{
+				double e0[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+				double e1[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+				normal[0] = e0[1] * e1[2] - e0[2] * e1[1];
+				normal[1] = e0[2] * e1[0] - e0[0] * e1[2];
+				normal[2] = e0[0] * e1[1] - e0[1] * e1[0];
+			}
+
+			std::uint64_t EdgeKey(std::uint32_t v0, std::uint32_t v1)
+			{
+				return v0 < v1 ? (std::uint64_t(v0) << 32) | v1 : (std::uint64_t(v1) << 32) | v0;
+			}
+		}
+
+		void MeshSimplifier::Quadric::AddPlane(double a, double b, double c, double d, double weight)
+		{
+			a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+			b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+			c2 += weight * c * c; cd += weight * c * d;
+			d2 += weight * d * d;
+		}
+
+		void MeshSimplifier::Quadric::Add(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+		}
+
+		double MeshSimplifier::Quadric::Evaluate(const float* p)const
+		{
+			double x = p[0], y = p[1], z = p[2];
+			return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+				+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+				+ c2 * z * z + 2 * cd * z
+				+ d2;
+		}
+
+		MeshSimplifier::MeshSimplifier(const float* positions, std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount)
+			: mPositions(positions), mVertexCount(vertexCount), mIndices(indices), mIndexCount(indexCount - indexCount % 3), mError(0.0f)
+		{
+
+		}
+
+		std::vector<std::uint32_t> MeshSimplifier::Simplify(std::size_t targetIndexCount, float maxError)
+		{
+			mError = 0.0f;
+			auto triangleCount = mIndexCount / 3;
+			mTriangles.assign(mIndices, mIndices + mIndexCount);
+			mTriangleAlive.assign(triangleCount, true);
+			mVertexTriangles.assign(mVertexCount, std::vector<std::uint32_t>());
+			mQuadrics.assign(mVertexCount, Quadric{});
+			mLocked.assign(mVertexCount, false);
+			mVertexAlive.assign(mVertexCount, true);
+			mVersions.assign(mVertexCount, 0);
+
+			std::unordered_map<std::uint64_t, std::uint32_t> edgeUseCounts;
+			std::size_t indexCount{ 0 };
+			for (std::uint32_t t = 0;t < triangleCount;++t)
+			{
+				auto triangle = &mTriangles[3 * t];
+				assert(triangle[0] < mVertexCount && triangle[1] < mVertexCount && triangle[2] < mVertexCount && "Vertex index out of range!");
+				if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])
+				{
+					mTriangleAlive[t] = false;
+					continue;
+				}
+				indexCount += 3;
+				double normal[3];
+				TriangleNormal(Position(triangle[0]), Position(triangle[1]), Position(triangle[2]), normal);
+				auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				for (auto i = 0;i < 3;++i)
+				{
+					mVertexTriangles[triangle[i]].push_back(t);
+					++edgeUseCounts[EdgeKey(triangle[i], triangle[(i + 1) % 3])];
+				}
+				if (length <= 0)
+					continue;
+				auto p0 = Position(triangle[0]);
+				auto a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+				auto d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+				//weighted by area so that large faces dominate
+				for (auto i = 0;i < 3;++i)
+				{
+					mQuadrics[triangle[i]].AddPlane(a, b, c, d, length * 0.5);
+				}
+			}
+			//border and non manifold edges
+			for (const auto& edge : edgeUseCounts)
+			{
+				if (edge.second != 2)
+				{
+					mLocked[edge.first >> 32] = true;
+					mLocked[edge.first & 0xffffffff] = true;
+				}
+			}
+
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses;
+			for (const auto& edge : edgeUseCounts)
+			{
+				Collapse collapse;
+				if (MakeCollapse(std::uint32_t(edge.first >> 32), std::uint32_t(edge.first & 0xffffffff), collapse))
+					collapses.push(collapse);
+			}
+
+			while (indexCount > targetIndexCount && !collapses.empty())
+			{
+				auto collapse = collapses.top();
+				collapses.pop();
+				if (!mVertexAlive[collapse.from] || !mVertexAlive[collapse.to]
+					|| mVersions[collapse.from] != collapse.fromVersion || mVersions[collapse.to] != collapse.toVersion)
+					continue;
+				if (collapse.cost > maxError)
+					break;
+				if (FlipsTriangle(collapse.from, collapse.to))
+					continue;
+				auto& toTriangles = mVertexTriangles[collapse.to];
+				for (auto t : mVertexTriangles[collapse.from])
+				{
+					if (!mTriangleAlive[t])
+						continue;
+					auto triangle = &mTriangles[3 * t];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					{
+						mTriangleAlive[t] = false;
+						indexCount -= 3;
+						continue;
+					}
+					std::replace(triangle, triangle + 3, collapse.from, collapse.to);
+					toTriangles.push_back(t);
+				}
+				mVertexTriangles[collapse.from].clear();
+				mVertexAlive[collapse.from] = false;
+				mQuadrics[collapse.to].Add(mQuadrics[collapse.from]);
+				++mVersions[collapse.to];
+				mError = std::max(mError, static_cast<float>(collapse.cost));
+				//edges around the surviving vertex have new costs
+				toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+					[this](std::uint32_t t) { return !mTriangleAlive[t]; }), toTriangles.end());
+				for (auto t : toTriangles)
+				{
+					for (auto i = 0;i < 3;++i)
+					{
+						auto neighbor = mTriangles[3 * t + i];
+						Collapse neighborCollapse;
+						if (neighbor != collapse.to && MakeCollapse(collapse.to, neighbor, neighborCollapse))
+							collapses.push(neighborCollapse);
+					}
+				}
+			}
+
+			std::vector<std::uint32_t> result;
+			result.reserve(indexCount);
+			for (std::uint32_t t = 0;t < triangleCount;++t)
+			{
+				if (mTriangleAlive[t])
+					result.insert(result.end(), &mTriangles[3 * t], &mTriangles[3 * t] + 3);
+			}
+			return result;
+		}
+
+		bool MeshSimplifier::MakeCollapse(std::uint32_t v0, std::uint32_t v1, Collapse& collapse)const
+		{
+			if (mLocked[v0] && mLocked[v1])
+				return false;
+			Quadric quadric = mQuadrics[v0];
+			quadric.Add(mQuadrics[v1]);
+			auto cost0 = mLocked[v0] ? 0.0 : quadric.Evaluate(Position(v1));
+			auto cost1 = mLocked[v1] ? 0.0 : quadric.Evaluate(Position(v0));
+			if (mLocked[v1] || (!mLocked[v0] && cost0 <= cost1))
+			{
+				collapse = Collapse{ std::max(cost0, 0.0), v0, v1, mVersions[v0], mVersions[v1] };
+			}
+			else
+			{
+				collapse = Collapse{ std::max(cost1, 0.0), v1, v0, mVersions[v1], mVersions[v0] };
+			}
+			return true;
+		}
+
+		bool MeshSimplifier::FlipsTriangle(std::uint32_t from, std::uint32_t to)const
+		{
+			for (auto t : mVertexTriangles[from])
+			{
+				if (!mTriangleAlive[t])
+					continue;
+				const auto triangle = &mTriangles[3 * t];
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+					continue;
+				const float* positions[3];
+				for (auto i = 0;i < 3;++i)
+				{
+					positions[i] = Position(triangle[i]);
+				}
+				double before[3], after[3];
+				TriangleNormal(positions[0], positions[1], positions[2], before);
+				for (auto i = 0;i < 3;++i)
+				{
+					if (triangle[i] == from)
+						positions[i] = Position(to);
+				}
+				TriangleNormal(positions[0], positions[1], positions[2], after);
+				if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0)
+					return true;
+			}
+			return false;
+		}
+	}
+}
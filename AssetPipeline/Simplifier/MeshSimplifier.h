@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Lightning
+{
+	namespace Tools
+	{
+		//Quadric error metric edge collapse simplifier for indexed triangle lists.Vertices are never moved,an edge collapses onto
+		//one of its end points,so simplified levels share the vertex streams of the source mesh and only index data differs.
+		//Vertices on open borders(including attribute seams where vertices are split) are locked to keep the outline of the mesh.
+		class MeshSimplifier
+		{
+		public:
+			//positions are 3 floats per vertex.Data must stay valid while the simplifier is used
+			MeshSimplifier(const float* positions, std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount);
+			//Collapses edges with the lowest error until at most targetIndexCount indices are left or the next collapse would
+			//exceed maxError(squared distance to the original surface).Always starts from the source mesh
+			std::vector<std::uint32_t> Simplify(std::size_t targetIndexCount, float maxError = 3.402823466e+38f);
+			//largest squared error of the collapses done by the last Simplify call
+			float GetError()const { return mError; }
+		private:
+			struct Quadric
+			{
+				double a2, ab, ac, ad;
+				double b2, bc, bd;
+				double c2, cd;
+				double d2;
+				void AddPlane(double a, double b, double c, double d, double weight);
+				void Add(const Quadric& other);
+				double Evaluate(const float* p)const;
+			};
+			struct Collapse
+			{
+				double cost;
+				std::uint32_t from;
+				std::uint32_t to;
+				std::uint32_t fromVersion;
+				std::uint32_t toVersion;
+				bool operator>(const Collapse& other)const { return cost > other.cost; }
+			};
+			bool MakeCollapse(std::uint32_t v0, std::uint32_t v1, Collapse& collapse)const;
+			bool FlipsTriangle(std::uint32_t from, std::uint32_t to)const;
+			const float* Position(std::uint32_t vertex)const { return mPositions + 3 * vertex; }
+			const float* mPositions;
+			std::size_t mVertexCount;
+			const std::uint32_t* mIndices;
+			std::size_t mIndexCount;
+			float mError;
+			//state of the current Simplify call
+			std::vector<std::uint32_t> mTriangles;
+			std::vector<bool> mTriangleAlive;
+			std::vector<std::vector<std::uint32_t>> mVertexTriangles;
+			std::vector<Quadric> mQuadrics;
+			std::vector<bool> mLocked;
+			std::vector<bool> mVertexAlive;
+			std::vector<std::uint32_t> mVersions;
+		};
+	}
+}
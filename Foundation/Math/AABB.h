@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+			//Axis aligned bounding box.A box with min > max is empty.
+			template<typename T>
+			struct AABB
+			{
+				static_assert(std::is_floating_point<T>::value, "T must be a floating point type!");
+				Vector3<T> min;
+				Vector3<T> max;
+
+				static AABB<T> Empty()
+				{
+					const auto inf = std::numeric_limits<T>::infinity();
+					return AABB<T>{ Vector3<T>{inf, inf, inf}, Vector3<T>{-inf, -inf, -inf} };
+				}
+
+				//A box that contains everything.Used by objects whose bounds are unknown so that they're never culled.
+				static AABB<T> Infinite()
+				{
+					const auto inf = std::numeric_limits<T>::infinity();
+					return AABB<T>{ Vector3<T>{-inf, -inf, -inf}, Vector3<T>{inf, inf, inf} };
+				}
+
+				//points is a strided array,stride is the byte distance between two consecutive points.
+				//Vertex buffers usually interleave positions with other attributes,in which case stride is the vertex size.
+				static AABB<T> FromPoints(const void* points, std::size_t count, std::size_t stride = sizeof(Vector3<T>))
+				{
+					auto box = Empty();
+					auto p = static_cast<const std::uint8_t*>(points);
+					for (std::size_t i = 0;i < count;++i)
+					{
+						box.Merge(*reinterpret_cast<const Vector3<T>*>(p + i * stride));
+					}
+					return box;
+				}
+
+				bool IsEmpty()const
+				{
+					return min.x > max.x || min.y > max.y || min.z > max.z;
+				}
+
+				bool IsInfinite()const
+				{
+					return std::isinf(min.x) || std::isinf(min.y) || std::isinf(min.z) ||
+						std::isinf(max.x) || std::isinf(max.y) || std::isinf(max.z);
+				}
+
+				Vector3<T> GetCenter()const
+				{
+					return Vector3<T>{(min.x + max.x) * T(0.5), (min.y + max.y) * T(0.5), (min.z + max.z) * T(0.5)};
+				}
+
+				//half size of the box
+				Vector3<T> GetExtents()const
+				{
+					return Vector3<T>{(max.x - min.x) * T(0.5), (max.y - min.y) * T(0.5), (max.z - min.z) * T(0.5)};
+				}
+
+				void Merge(const Vector3<T>& point)
+				{
+					min.x = point.x < min.x ? point.x : min.x;
+					min.y = point.y < min.y ? point.y : min.y;
+					min.z = point.z < min.z ? point.z : min.z;
+					max.x = point.x > max.x ? point.x : max.x;
+					max.y = point.y > max.y ? point.y : max.y;
+					max.z = point.z > max.z ? point.z : max.z;
+				}
+
+				void Merge(const AABB<T>& other)
+				{
+					if (other.IsEmpty())
+						return;
+					Merge(other.min);
+					Merge(other.max);
+				}
+
+				bool Contains(const Vector3<T>& point)const
+				{
+					return point.x >= min.x && point.x <= max.x &&
+						point.y >= min.y && point.y <= max.y &&
+						point.z >= min.z && point.z <= max.z;
+				}
+
+				bool Intersects(const AABB<T>& other)const
+				{
+					return min.x <= other.max.x && max.x >= other.min.x &&
+						min.y <= other.max.y && max.y >= other.min.y &&
+						min.z <= other.max.z && max.z >= other.min.z;
+				}
+
+				//Returns the box that bounds this box transformed by matrix(row vector convention,translation in row 3)
+				AABB<T> Transformed(const Matrix4<T>& matrix)const
+				{
+					if (IsEmpty() || IsInfinite())
+						return *this;
+					auto center = GetCenter();
+					auto extents = GetExtents();
+					Vector3<T> newCenter, newExtents;
+					T* c[3] = { &newCenter.x, &newCenter.y, &newCenter.z };
+					T* e[3] = { &newExtents.x, &newExtents.y, &newExtents.z };
+					for (unsigned col = 0;col < 3;++col)
+					{
+						*c[col] = center.x * matrix.GetCell(0, col) + center.y * matrix.GetCell(1, col) +
+							center.z * matrix.GetCell(2, col) + matrix.GetCell(3, col);
+						*e[col] = extents.x * std::abs(matrix.GetCell(0, col)) + extents.y * std::abs(matrix.GetCell(1, col)) +
+							extents.z * std::abs(matrix.GetCell(2, col));
+					}
+					return AABB<T>{ newCenter - newExtents, newCenter + newExtents };
+				}
+			};
+
+			using AABBf = AABB<float>;
+			static_assert(std::is_pod<AABBf>::value, "AABBf is not a POD!");
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstring>
+#include <type_traits>
+#include "Math/Matrix.h"
+#include "Math/Vector.h"
+#include "Math/SIMD.h"
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+			//Affine transform in the row vector convention(translation in row 3).It's the first 3 columns of the equivalent
+			//Matrix4f in the same column major layout,column 3 is always (0, 0, 0, 1) so it's not stored.
+			struct AffineMatrix
+			{
+				static AffineMatrix FromMatrix4(const Matrix4f& matrix)
+				{
+					AffineMatrix res;
+					std::memcpy(res.m, matrix.m, sizeof(res.m));
+					return res;
+				}
+
+				Matrix4f ToMatrix4()const
+				{
+					Matrix4f res;
+					std::memcpy(res.m, m, sizeof(m));
+					res.m[12] = res.m[13] = res.m[14] = 0.0f;
+					res.m[15] = 1.0f;
+					return res;
+				}
+
+				float GetCell(unsigned row, unsigned column)const
+				{
+					assert(column < 3);
+					return m[column * 4 + row];
+				}
+
+				//Transforms by this matrix,then other
+				AffineMatrix operator*(const AffineMatrix& other)const
+				{
+					AffineMatrix res;
+#if defined(LIGHTNING_SIMD_VECTOR)
+					auto c0 = SIMDLoad(m);
+					auto c1 = SIMDLoad(m + 4);
+					auto c2 = SIMDLoad(m + 8);
+					//column 3 contributes cell(3, i) of other to row 3 only
+					auto c3 = SIMDSet(0.0f, 0.0f, 0.0f, 1.0f);
+					for (auto i = 0;i < 3;++i)
+					{
+						auto column = SIMDLoad(other.m + i * 4);
+						auto v = SIMDMul(c0, SIMDSplatLane<0>(column));
+						v = SIMDMulAdd(c1, SIMDSplatLane<1>(column), v);
+						v = SIMDMulAdd(c2, SIMDSplatLane<2>(column), v);
+						v = SIMDMulAdd(c3, SIMDSplatLane<3>(column), v);
+						SIMDStore(res.m + i * 4, v);
+					}
+#else
+					for (auto i = 0;i < 4;++i)
+					{
+						for (auto j = 0;j < 3;++j)
+						{
+							auto value = m[i] * other.m[j * 4] + m[4 + i] * other.m[j * 4 + 1] + m[8 + i] * other.m[j * 4 + 2];
+							res.m[j * 4 + i] = i == 3 ? value + other.m[j * 4 + 3] : value;
+						}
+					}
+#endif
+					return res;
+				}
+
+				Vector3f TransformPoint(const Vector3f& point)const
+				{
+					return Vector3f{
+						point.x * m[0] + point.y * m[1] + point.z * m[2] + m[3],
+						point.x * m[4] + point.y * m[5] + point.z * m[6] + m[7],
+						point.x * m[8] + point.y * m[9] + point.z * m[10] + m[11] };
+				}
+
+				Vector3f TransformDirection(const Vector3f& direction)const
+				{
+					return Vector3f{
+						direction.x * m[0] + direction.y * m[1] + direction.z * m[2],
+						direction.x * m[4] + direction.y * m[5] + direction.z * m[6],
+						direction.x * m[8] + direction.y * m[9] + direction.z * m[10] };
+				}
+
+				float m[12];
+			};
+			static_assert(std::is_pod<AffineMatrix>::value, "AffineMatrix is not a POD!");
+		}
+	}
+}
@@ -0,0 +1,337 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include "Vector.h"
+#include "Matrix.h"
+#include "AABB.h"
+#include "SIMD.h"
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+			//View frustum made up of 6 planes.Each plane is stored as (normal, distance) with normal pointing inside,
+			//so a point p is inside a plane if Dot(normal, p) + distance >= 0.
+			struct Frustum
+			{
+				static constexpr std::size_t PLANE_COUNT = 6;
+				//Plane order : left, right, bottom, top, near, far
+				Vector4f planes[PLANE_COUNT];
+
+				//Extract planes from a view * projection matrix(row vector convention, D3D style clip space where 0 <= z <= w).
+				//The planes are in world space if matrix is view * projection,in view space if matrix is projection.
+				static Frustum FromMatrix(const Matrix4f& matrix)
+				{
+					Vector4f columns[4];
+					for (unsigned i = 0;i < 4;++i)
+					{
+						columns[i] = Vector4f{ matrix.GetCell(0, i), matrix.GetCell(1, i), matrix.GetCell(2, i), matrix.GetCell(3, i) };
+					}
+					Frustum frustum;
+					frustum.planes[0] = columns[3] + columns[0];
+					frustum.planes[1] = columns[3] - columns[0];
+					frustum.planes[2] = columns[3] + columns[1];
+					frustum.planes[3] = columns[3] - columns[1];
+					frustum.planes[4] = columns[2];
+					frustum.planes[5] = columns[3] - columns[2];
+					for (auto& plane : frustum.planes)
+					{
+						auto length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+						if (length > 0)
+						{
+							plane.x /= length;
+							plane.y /= length;
+							plane.z /= length;
+							plane.w /= length;
+						}
+					}
+					return frustum;
+				}
+
+				//Returns false only if the box is completely outside of the frustum
+				bool Intersects(const AABBf& box)const
+				{
+					if (box.IsEmpty())
+						return false;
+					if (box.IsInfinite())
+						return true;
+					auto center = box.GetCenter();
+					auto extents = box.GetExtents();
+					for (const auto& plane : planes)
+					{
+						auto distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+						auto radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+						if (distance + radius < 0)
+							return false;
+					}
+					return true;
+				}
+
+				bool Intersects(const Vector3f& center, float radius)const
+				{
+					for (const auto& plane : planes)
+					{
+						auto distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+						if (distance + radius < 0)
+							return false;
+					}
+					return true;
+				}
+			};
+
+			//Structure of arrays layout of bounding boxes used by batch culling.
+			//Stream k(centerX, centerY, centerZ, extentX, extentY, extentZ) of box n is stored at data[k * stride + n].
+			struct AABBfSoA
+			{
+				static std::size_t GetRequiredSize(std::size_t count)
+				{
+					return count * 6;
+				}
+
+				//Infinite boxes are stored with zero center and infinite extents so they are never culled.
+				//Empty boxes are stored with zero center and the lowest finite extents so they are always culled like
+				//Frustum::Intersects does.Infinite extents would give NaN radius against planes with zero components
+				void Set(std::size_t index, const AABBf& box)
+				{
+					Vector3f center{ 0.0f, 0.0f, 0.0f };
+					Vector3f extents;
+					//checked first as Empty() has infinite bounds too
+					if (box.IsEmpty())
+					{
+						auto lowest = std::numeric_limits<float>::lowest();
+						extents = Vector3f{ lowest, lowest, lowest };
+					}
+					else if (box.IsInfinite())
+					{
+						extents = box.max;
+					}
+					else
+					{
+						center = box.GetCenter();
+						extents = box.GetExtents();
+					}
+					data[index] = center.x;
+					data[stride + index] = center.y;
+					data[2 * stride + index] = center.z;
+					data[3 * stride + index] = extents.x;
+					data[4 * stride + index] = extents.y;
+					data[5 * stride + index] = extents.z;
+				}
+
+				float* data;
+				std::size_t stride;
+			};
+
+			//Tests boxes in [begin, end) against frustum and writes 1 to visibilities[i] if box i intersects the frustum,otherwise 0.
+			//Processes 8(AVX) or 4(SSE) boxes at a time.Thread safe as long as ranges of concurrent calls don't overlap.
+			inline void CullAABBs(const Frustum& frustum, const AABBfSoA& boxes,
+				std::size_t begin, std::size_t end, std::uint8_t* visibilities)
+			{
+				const float* cx = boxes.data;
+				const float* cy = boxes.data + boxes.stride;
+				const float* cz = boxes.data + 2 * boxes.stride;
+				const float* ex = boxes.data + 3 * boxes.stride;
+				const float* ey = boxes.data + 4 * boxes.stride;
+				const float* ez = boxes.data + 5 * boxes.stride;
+				Vector4f absPlanes[Frustum::PLANE_COUNT];
+				for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+				{
+					const auto& plane = frustum.planes[i];
+					absPlanes[i] = Vector4f{ std::abs(plane.x), std::abs(plane.y), std::abs(plane.z), 0.0f };
+				}
+				std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_AVX)
+				for (;n + 8 <= end;n += 8)
+				{
+					auto centerX = _mm256_loadu_ps(cx + n);
+					auto centerY = _mm256_loadu_ps(cy + n);
+					auto centerZ = _mm256_loadu_ps(cz + n);
+					auto extentX = _mm256_loadu_ps(ex + n);
+					auto extentY = _mm256_loadu_ps(ey + n);
+					auto extentZ = _mm256_loadu_ps(ez + n);
+					auto outside = _mm256_setzero_ps();
+					for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+					{
+						const auto& plane = frustum.planes[i];
+						const auto& absPlane = absPlanes[i];
+						auto distance = _mm256_add_ps(_mm256_add_ps(
+							_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)), _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))),
+							_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z))), _mm256_set1_ps(plane.w));
+						auto radius = _mm256_add_ps(
+							_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(absPlane.x)), _mm256_mul_ps(extentY, _mm256_set1_ps(absPlane.y))),
+							_mm256_mul_ps(extentZ, _mm256_set1_ps(absPlane.z)));
+						outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+					}
+					auto mask = _mm256_movemask_ps(outside);
+					for (std::size_t k = 0;k < 8;++k)
+					{
+						visibilities[n + k] = static_cast<std::uint8_t>(((mask >> k) & 1) ^ 1);
+					}
+				}
+#endif
+#if defined(LIGHTNING_SIMD_SSE)
+				for (;n + 4 <= end;n += 4)
+				{
+					auto centerX = _mm_loadu_ps(cx + n);
+					auto centerY = _mm_loadu_ps(cy + n);
+					auto centerZ = _mm_loadu_ps(cz + n);
+					auto extentX = _mm_loadu_ps(ex + n);
+					auto extentY = _mm_loadu_ps(ey + n);
+					auto extentZ = _mm_loadu_ps(ez + n);
+					auto outside = _mm_setzero_ps();
+					for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+					{
+						const auto& plane = frustum.planes[i];
+						const auto& absPlane = absPlanes[i];
+						auto distance = _mm_add_ps(_mm_add_ps(
+							_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+							_mm_mul_ps(centerZ, _mm_set1_ps(plane.z))), _mm_set1_ps(plane.w));
+						auto radius = _mm_add_ps(
+							_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(absPlane.x)), _mm_mul_ps(extentY, _mm_set1_ps(absPlane.y))),
+							_mm_mul_ps(extentZ, _mm_set1_ps(absPlane.z)));
+						outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+					}
+					auto mask = _mm_movemask_ps(outside);
+					for (std::size_t k = 0;k < 4;++k)
+					{
+						visibilities[n + k] = static_cast<std::uint8_t>(((mask >> k) & 1) ^ 1);
+					}
+				}
+#endif
+				for (;n < end;++n)
+				{
+					std::uint8_t visible{ 1 };
+					for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+					{
+						const auto& plane = frustum.planes[i];
+						const auto& absPlane = absPlanes[i];
+						auto distance = cx[n] * plane.x + cy[n] * plane.y + cz[n] * plane.z + plane.w;
+						auto radius = ex[n] * absPlane.x + ey[n] * absPlane.y + ez[n] * absPlane.z;
+						if (distance + radius < 0)
+						{
+							visible = 0;
+							break;
+						}
+					}
+					visibilities[n] = visible;
+				}
+			}
+
+			//Maximum number of frustums CullAABBsMultiView tests at once,one bit of a view mask each
+			constexpr std::size_t MAX_CULL_VIEWS = 32;
+
+			//Tests boxes in [begin, end) against frustumCount frustums in one pass.Bit v of viewMasks[i] is set if box i intersects
+			//frustums[v].Each batch of boxes is loaded once and tested against all frustums,which is cheaper than culling the
+			//boxes once per frustum.Thread safe as long as ranges of concurrent calls don't overlap.
+			inline void CullAABBsMultiView(const Frustum* frustums, std::size_t frustumCount, const AABBfSoA& boxes,
+				std::size_t begin, std::size_t end, std::uint32_t* viewMasks)
+			{
+				assert(frustumCount <= MAX_CULL_VIEWS && "Too many views to cull at once!");
+				const float* cx = boxes.data;
+				const float* cy = boxes.data + boxes.stride;
+				const float* cz = boxes.data + 2 * boxes.stride;
+				const float* ex = boxes.data + 3 * boxes.stride;
+				const float* ey = boxes.data + 4 * boxes.stride;
+				const float* ez = boxes.data + 5 * boxes.stride;
+				Vector4f absPlanes[MAX_CULL_VIEWS][Frustum::PLANE_COUNT];
+				for (std::size_t v = 0;v < frustumCount;++v)
+				{
+					for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+					{
+						const auto& plane = frustums[v].planes[i];
+						absPlanes[v][i] = Vector4f{ std::abs(plane.x), std::abs(plane.y), std::abs(plane.z), 0.0f };
+					}
+				}
+				std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_AVX)
+				for (;n + 8 <= end;n += 8)
+				{
+					auto centerX = _mm256_loadu_ps(cx + n);
+					auto centerY = _mm256_loadu_ps(cy + n);
+					auto centerZ = _mm256_loadu_ps(cz + n);
+					auto extentX = _mm256_loadu_ps(ex + n);
+					auto extentY = _mm256_loadu_ps(ey + n);
+					auto extentZ = _mm256_loadu_ps(ez + n);
+					//masks are accumulated as float lanes so that AVX without AVX2 integer instructions works as well
+					auto masks = _mm256_setzero_ps();
+					for (std::size_t v = 0;v < frustumCount;++v)
+					{
+						auto outside = _mm256_setzero_ps();
+						for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+						{
+							const auto& plane = frustums[v].planes[i];
+							const auto& absPlane = absPlanes[v][i];
+							auto distance = _mm256_add_ps(_mm256_add_ps(
+								_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)), _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))),
+								_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z))), _mm256_set1_ps(plane.w));
+							auto radius = _mm256_add_ps(
+								_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(absPlane.x)), _mm256_mul_ps(extentY, _mm256_set1_ps(absPlane.y))),
+								_mm256_mul_ps(extentZ, _mm256_set1_ps(absPlane.z)));
+							outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+						}
+						masks = _mm256_or_ps(masks, _mm256_andnot_ps(outside, _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(1u << v)))));
+					}
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(viewMasks + n), _mm256_castps_si256(masks));
+				}
+#endif
+#if defined(LIGHTNING_SIMD_SSE)
+				for (;n + 4 <= end;n += 4)
+				{
+					auto centerX = _mm_loadu_ps(cx + n);
+					auto centerY = _mm_loadu_ps(cy + n);
+					auto centerZ = _mm_loadu_ps(cz + n);
+					auto extentX = _mm_loadu_ps(ex + n);
+					auto extentY = _mm_loadu_ps(ey + n);
+					auto extentZ = _mm_loadu_ps(ez + n);
+					auto masks = _mm_setzero_ps();
+					for (std::size_t v = 0;v < frustumCount;++v)
+					{
+						auto outside = _mm_setzero_ps();
+						for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+						{
+							const auto& plane = frustums[v].planes[i];
+							const auto& absPlane = absPlanes[v][i];
+							auto distance = _mm_add_ps(_mm_add_ps(
+								_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+								_mm_mul_ps(centerZ, _mm_set1_ps(plane.z))), _mm_set1_ps(plane.w));
+							auto radius = _mm_add_ps(
+								_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(absPlane.x)), _mm_mul_ps(extentY, _mm_set1_ps(absPlane.y))),
+								_mm_mul_ps(extentZ, _mm_set1_ps(absPlane.z)));
+							outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+						}
+						masks = _mm_or_ps(masks, _mm_andnot_ps(outside, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(1u << v)))));
+					}
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(viewMasks + n), _mm_castps_si128(masks));
+				}
+#endif
+				for (;n < end;++n)
+				{
+					std::uint32_t mask{ 0 };
+					for (std::size_t v = 0;v < frustumCount;++v)
+					{
+						std::uint32_t visible{ 1 };
+						for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+						{
+							const auto& plane = frustums[v].planes[i];
+							const auto& absPlane = absPlanes[v][i];
+							auto distance = cx[n] * plane.x + cy[n] * plane.y + cz[n] * plane.z + plane.w;
+							auto radius = ex[n] * absPlane.x + ey[n] * absPlane.y + ez[n] * absPlane.z;
+							if (distance + radius < 0)
+							{
+								visible = 0;
+								break;
+							}
+						}
+						mask |= visible << v;
+					}
+					viewMasks[n] = mask;
+				}
+			}
+		}
+	}
+}
@@ -1,6 +1,8 @@
 #pragma once
+#include <cassert>
 #include <type_traits>
 #include "Vector.h"
+#include "SIMD.h"
 
 namespace Lightning
 {
@@ -33,18 +35,21 @@ namespace Lightning
 					return m[CELL_INDEX(row, column)];
 				}
 
+				//result may be this matrix or other
 				void MultMatrix(const Matrix4<T>& other, Matrix4<T>& result)const
 				{
+					Matrix4<T> res;
 					for (int i = 0;i < 4;++i)
 					{
 						for (int j = 0; j < 4; ++j)
 						{
 							auto idx = CELL_INDEX(i, j);
-							result.m[idx] = T(0);
+							res.m[idx] = T(0);
 							for (int k = 0; k < 4; ++k)
-								result.m[idx] += m[CELL_INDEX(i, k)] * other.m[CELL_INDEX(k, j)];
+								res.m[idx] += m[CELL_INDEX(i, k)] * other.m[CELL_INDEX(k, j)];
 						}
 					}
+					result = res;
 				}
 
 				Matrix4<T> operator*(const Matrix4<T>& other)const
@@ -60,6 +65,45 @@ namespace Lightning
 					return *this;
 				}
 
+				Matrix4<T> Transposed()const
+				{
+					Matrix4<T> res;
+					for (unsigned i = 0;i < 4;++i)
+					{
+						for (unsigned j = 0;j < 4;++j)
+							res.m[CELL_INDEX(i, j)] = m[CELL_INDEX(j, i)];
+					}
+					return res;
+				}
+
+				//Inverse by cofactors.The expansion is symmetric in rows and columns so it works on m directly.
+				//ref : MESA gluInvertMatrix
+				Matrix4<T> Inversed()const
+				{
+					Matrix4<T> inv;
+					inv.m[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+					inv.m[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+					inv.m[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+					inv.m[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+					inv.m[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+					inv.m[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+					inv.m[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+					inv.m[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+					inv.m[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+					inv.m[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+					inv.m[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+					inv.m[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+					inv.m[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+					inv.m[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+					inv.m[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+					inv.m[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+					auto det = m[0] * inv.m[0] + m[1] * inv.m[4] + m[2] * inv.m[8] + m[3] * inv.m[12];
+					assert(det != T(0) && "matrix is singular!");
+					for (auto& cell : inv.m)
+						cell /= det;
+					return inv;
+				}
+
 				void SetRow(unsigned row, const Vector4<T>& v) 
 				{ 
 					m[CELL_INDEX(row, 0)] = v.x;
@@ -122,6 +166,156 @@ namespace Lightning
 			using Matrix4i = Matrix4<int>;
 			static_assert(std::is_pod<Matrix4f>::value, "Matrix4f is not a POD");
 			static_assert(std::is_pod<Matrix4i>::value, "Matrix4i is not a POD!");
+
+#if defined(LIGHTNING_SIMD_VECTOR)
+			//SIMD versions of float matrix operations,other types use the scalar code above.
+			//Columns are contiguous in m so each of them is a SIMDVector
+			template<>
+			inline void Matrix4f::MultMatrix(const Matrix4f& other, Matrix4f& result)const
+			{
+				//column j of result is sum of column k of this scaled by cell(k, j) of other.
+				//Columns of this are loaded before any store and column j of other is loaded before column j of result is stored
+				auto c0 = SIMDLoad(m);
+				auto c1 = SIMDLoad(m + 4);
+				auto c2 = SIMDLoad(m + 8);
+				auto c3 = SIMDLoad(m + 12);
+#if defined(LIGHTNING_SIMD_AVX)
+				//two result columns per iteration
+				auto a0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c0, 1);
+				auto a1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), c1, 1);
+				auto a2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c2, 1);
+				auto a3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), c3, 1);
+				for (std::size_t j = 0;j < 16;j += 8)
+				{
+					auto b = _mm256_loadu_ps(other.m + j);
+					auto r = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00)), _mm256_mul_ps(a1, _mm256_permute_ps(b, 0x55))),
+						_mm256_add_ps(_mm256_mul_ps(a2, _mm256_permute_ps(b, 0xAA)), _mm256_mul_ps(a3, _mm256_permute_ps(b, 0xFF))));
+					_mm256_storeu_ps(result.m + j, r);
+				}
+#else
+				for (std::size_t j = 0;j < 16;j += 4)
+				{
+					auto b = SIMDLoad(other.m + j);
+					auto r = SIMDAdd(SIMDMulAdd(c0, SIMDSplatLane<0>(b), SIMDMul(c1, SIMDSplatLane<1>(b))),
+						SIMDMulAdd(c2, SIMDSplatLane<2>(b), SIMDMul(c3, SIMDSplatLane<3>(b))));
+					SIMDStore(result.m + j, r);
+				}
+#endif
+			}
+
+			template<>
+			inline Matrix4f Matrix4f::Transposed()const
+			{
+				auto c0 = SIMDLoad(m);
+				auto c1 = SIMDLoad(m + 4);
+				auto c2 = SIMDLoad(m + 8);
+				auto c3 = SIMDLoad(m + 12);
+				SIMDTranspose(c0, c1, c2, c3);
+				Matrix4f res;
+				SIMDStore(res.m, c0);
+				SIMDStore(res.m + 4, c1);
+				SIMDStore(res.m + 8, c2);
+				SIMDStore(res.m + 12, c3);
+				return res;
+			}
+
+			//Block inverse of 2x2 sub matrices,each sub matrix is stored as (c00, c01, c10, c11).
+			//A# is the adjugate of sub matrix A and |A| its determinant.Like the scalar version it works on m directly
+			//ref : https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+			namespace Detail
+			{
+				//A * B
+				inline SIMDVector Matrix2Mul(SIMDVector a, SIMDVector b)
+				{
+					return SIMDAdd(SIMDMul(a, SIMDSwizzle<0, 3, 0, 3>(b)), SIMDMul(SIMDSwizzle<1, 0, 3, 2>(a), SIMDSwizzle<2, 1, 2, 1>(b)));
+				}
+
+				//A# * B
+				inline SIMDVector Matrix2AdjMul(SIMDVector a, SIMDVector b)
+				{
+					return SIMDSub(SIMDMul(SIMDSwizzle<3, 3, 0, 0>(a), b), SIMDMul(SIMDSwizzle<1, 1, 2, 2>(a), SIMDSwizzle<2, 3, 0, 1>(b)));
+				}
+
+				//A * B#
+				inline SIMDVector Matrix2MulAdj(SIMDVector a, SIMDVector b)
+				{
+					return SIMDSub(SIMDMul(a, SIMDSwizzle<3, 0, 3, 0>(b)), SIMDMul(SIMDSwizzle<1, 0, 3, 2>(a), SIMDSwizzle<2, 1, 2, 1>(b)));
+				}
+			}
+
+			template<>
+			inline Matrix4f Matrix4f::Inversed()const
+			{
+				auto c0 = SIMDLoad(m);
+				auto c1 = SIMDLoad(m + 4);
+				auto c2 = SIMDLoad(m + 8);
+				auto c3 = SIMDLoad(m + 12);
+				//m = | A B |
+				//    | C D |
+				auto A = SIMDShuffle<0, 1, 0, 1>(c0, c1);
+				auto B = SIMDShuffle<2, 3, 2, 3>(c0, c1);
+				auto C = SIMDShuffle<0, 1, 0, 1>(c2, c3);
+				auto D = SIMDShuffle<2, 3, 2, 3>(c2, c3);
+				//(|A|, |B|, |C|, |D|)
+				auto detSub = SIMDSub(SIMDMul(SIMDShuffle<0, 2, 0, 2>(c0, c2), SIMDShuffle<1, 3, 1, 3>(c1, c3)),
+					SIMDMul(SIMDShuffle<1, 3, 1, 3>(c0, c2), SIMDShuffle<0, 2, 0, 2>(c1, c3)));
+				auto detA = SIMDSplatLane<0>(detSub);
+				auto detB = SIMDSplatLane<1>(detSub);
+				auto detC = SIMDSplatLane<2>(detSub);
+				auto detD = SIMDSplatLane<3>(detSub);
+
+				//inverse = 1 / |m| * | X Y |
+				//                    | Z W |
+				auto DC = Detail::Matrix2AdjMul(D, C);
+				auto AB = Detail::Matrix2AdjMul(A, B);
+				auto X = SIMDSub(SIMDMul(detD, A), Detail::Matrix2Mul(B, DC));
+				auto W = SIMDSub(SIMDMul(detA, D), Detail::Matrix2Mul(C, AB));
+				auto Y = SIMDSub(SIMDMul(detB, C), Detail::Matrix2MulAdj(D, AB));
+				auto Z = SIMDSub(SIMDMul(detC, B), Detail::Matrix2MulAdj(A, DC));
+				//|m| = |A||D| + |B||C| - tr((A#B)(D#C))
+				auto trace = SIMDHorizontalAdd(SIMDMul(AB, SIMDSwizzle<0, 2, 1, 3>(DC)));
+				auto det = SIMDSub(SIMDAdd(SIMDMul(detA, detD), SIMDMul(detB, detC)), trace);
+				assert(SIMDGetX(det) != 0.0f && "matrix is singular!");
+				//X, Y, Z and W are adjugates,the signs and the swizzles below undo that
+				auto invDet = SIMDDiv(SIMDSet(1.0f, -1.0f, -1.0f, 1.0f), det);
+				X = SIMDMul(X, invDet);
+				Y = SIMDMul(Y, invDet);
+				Z = SIMDMul(Z, invDet);
+				W = SIMDMul(W, invDet);
+				Matrix4f res;
+				SIMDStore(res.m, SIMDShuffle<3, 1, 3, 1>(X, Y));
+				SIMDStore(res.m + 4, SIMDShuffle<2, 0, 2, 0>(X, Y));
+				SIMDStore(res.m + 8, SIMDShuffle<3, 1, 3, 1>(Z, W));
+				SIMDStore(res.m + 12, SIMDShuffle<2, 0, 2, 0>(Z, W));
+				return res;
+			}
+
+			inline Vector4f operator*(const Matrix4f& mat, const Vector4f& v)
+			{
+				auto res = SIMDMul(SIMDLoad(mat.m), SIMDSplat(v.x));
+				res = SIMDMulAdd(SIMDLoad(mat.m + 4), SIMDSplat(v.y), res);
+				res = SIMDMulAdd(SIMDLoad(mat.m + 8), SIMDSplat(v.z), res);
+				res = SIMDMulAdd(SIMDLoad(mat.m + 12), SIMDSplat(v.w), res);
+				Vector4f result;
+				SIMDStore(&result.x, res);
+				return result;
+			}
+
+			inline Vector4f operator*(const Vector4f& v, const Matrix4f& mat)
+			{
+				//component j is dot product of v and column j,transposing the products turns 4 horizontal sums into 3 adds
+				auto vec = SIMDLoad(&v.x);
+				auto p0 = SIMDMul(SIMDLoad(mat.m), vec);
+				auto p1 = SIMDMul(SIMDLoad(mat.m + 4), vec);
+				auto p2 = SIMDMul(SIMDLoad(mat.m + 8), vec);
+				auto p3 = SIMDMul(SIMDLoad(mat.m + 12), vec);
+				SIMDTranspose(p0, p1, p2, p3);
+				Vector4f result;
+				SIMDStore(&result.x, SIMDAdd(SIMDAdd(p0, p1), SIMDAdd(p2, p3)));
+				return result;
+			}
+#endif
 		}
 
 	}
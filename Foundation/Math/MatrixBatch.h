@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include "Matrix.h"
+#include "SIMD.h"
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+			//Structure of arrays layout of Matrix4f.Cell i of the matrix n is stored at cells[i * stride + n].
+			//The memory is owned by the caller(usually frame memory) so the struct can be copied freely.
+			struct Matrix4fSoA
+			{
+				//Number of floats required to hold count matrices
+				static std::size_t GetRequiredSize(std::size_t count)
+				{
+					return count * 16;
+				}
+
+				void Set(std::size_t index, const Matrix4f& matrix)
+				{
+					for (std::size_t i = 0;i < 16;++i)
+					{
+						cells[i * stride + index] = matrix.m[i];
+					}
+				}
+
+				void Get(std::size_t index, Matrix4f& matrix)const
+				{
+					for (std::size_t i = 0;i < 16;++i)
+					{
+						matrix.m[i] = cells[i * stride + index];
+					}
+				}
+
+				float* cells;
+				std::size_t stride;
+			};
+
+			//Computes results[i] = lhs[i] * rhs for i in [begin, end).results is array of structures so it can be
+			//written to constant memory directly.Thread safe as long as ranges of concurrent calls don't overlap.
+			inline void BatchMultiplyMatrix(const Matrix4fSoA& lhs, const Matrix4f& rhs,
+				Matrix4f* results, std::size_t begin, std::size_t end)
+			{
+				std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_SSE)
+				//rhs cells are the same for every lane,so broadcast them only once
+				__m128 r[16];
+				for (std::size_t i = 0;i < 16;++i)
+				{
+					r[i] = _mm_set1_ps(rhs.m[i]);
+				}
+#endif
+#if defined(LIGHTNING_SIMD_AVX)
+				__m256 rw[16];
+				for (std::size_t i = 0;i < 16;++i)
+				{
+					rw[i] = _mm256_set1_ps(rhs.m[i]);
+				}
+				for (;n + 8 <= end;n += 8)
+				{
+					__m256 l[16];
+					for (std::size_t i = 0;i < 16;++i)
+					{
+						l[i] = _mm256_loadu_ps(lhs.cells + i * lhs.stride + n);
+					}
+					for (std::size_t c = 0;c < 4;++c)
+					{
+						//acc[row] holds cell(row, c) of 8 matrices
+						__m256 acc[4];
+						for (std::size_t row = 0;row < 4;++row)
+						{
+							acc[row] = _mm256_add_ps(
+								_mm256_add_ps(_mm256_mul_ps(l[row], rw[c * 4]), _mm256_mul_ps(l[4 + row], rw[c * 4 + 1])),
+								_mm256_add_ps(_mm256_mul_ps(l[8 + row], rw[c * 4 + 2]), _mm256_mul_ps(l[12 + row], rw[c * 4 + 3])));
+						}
+						__m128 lo0 = _mm256_castps256_ps128(acc[0]), hi0 = _mm256_extractf128_ps(acc[0], 1);
+						__m128 lo1 = _mm256_castps256_ps128(acc[1]), hi1 = _mm256_extractf128_ps(acc[1], 1);
+						__m128 lo2 = _mm256_castps256_ps128(acc[2]), hi2 = _mm256_extractf128_ps(acc[2], 1);
+						__m128 lo3 = _mm256_castps256_ps128(acc[3]), hi3 = _mm256_extractf128_ps(acc[3], 1);
+						_MM_TRANSPOSE4_PS(lo0, lo1, lo2, lo3);
+						_MM_TRANSPOSE4_PS(hi0, hi1, hi2, hi3);
+						_mm_storeu_ps(results[n].m + c * 4, lo0);
+						_mm_storeu_ps(results[n + 1].m + c * 4, lo1);
+						_mm_storeu_ps(results[n + 2].m + c * 4, lo2);
+						_mm_storeu_ps(results[n + 3].m + c * 4, lo3);
+						_mm_storeu_ps(results[n + 4].m + c * 4, hi0);
+						_mm_storeu_ps(results[n + 5].m + c * 4, hi1);
+						_mm_storeu_ps(results[n + 6].m + c * 4, hi2);
+						_mm_storeu_ps(results[n + 7].m + c * 4, hi3);
+					}
+				}
+#endif
+#if defined(LIGHTNING_SIMD_SSE)
+				for (;n + 4 <= end;n += 4)
+				{
+					__m128 l[16];
+					for (std::size_t i = 0;i < 16;++i)
+					{
+						l[i] = _mm_loadu_ps(lhs.cells + i * lhs.stride + n);
+					}
+					for (std::size_t c = 0;c < 4;++c)
+					{
+						__m128 acc[4];
+						for (std::size_t row = 0;row < 4;++row)
+						{
+							acc[row] = _mm_add_ps(
+								_mm_add_ps(_mm_mul_ps(l[row], r[c * 4]), _mm_mul_ps(l[4 + row], r[c * 4 + 1])),
+								_mm_add_ps(_mm_mul_ps(l[8 + row], r[c * 4 + 2]), _mm_mul_ps(l[12 + row], r[c * 4 + 3])));
+						}
+						_MM_TRANSPOSE4_PS(acc[0], acc[1], acc[2], acc[3]);
+						_mm_storeu_ps(results[n].m + c * 4, acc[0]);
+						_mm_storeu_ps(results[n + 1].m + c * 4, acc[1]);
+						_mm_storeu_ps(results[n + 2].m + c * 4, acc[2]);
+						_mm_storeu_ps(results[n + 3].m + c * 4, acc[3]);
+					}
+				}
+#endif
+				//scalar tail(or the whole range if no SIMD instruction set is available)
+				for (;n < end;++n)
+				{
+					for (std::size_t c = 0;c < 4;++c)
+					{
+						for (std::size_t row = 0;row < 4;++row)
+						{
+							results[n].m[c * 4 + row] =
+								lhs.cells[row * lhs.stride + n] * rhs.m[c * 4] +
+								lhs.cells[(4 + row) * lhs.stride + n] * rhs.m[c * 4 + 1] +
+								lhs.cells[(8 + row) * lhs.stride + n] * rhs.m[c * 4 + 2] +
+								lhs.cells[(12 + row) * lhs.stride + n] * rhs.m[c * 4 + 3];
+						}
+					}
+				}
+			}
+		}
+	}
+}
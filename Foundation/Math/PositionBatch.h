@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include "Vector.h"
+#include "SIMD.h"
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+			//Structure of arrays layout of double precision positions.Component c of position n is stored at
+			//components[c * stride + n].The memory is owned by the caller(usually frame memory) like Matrix4fSoA
+			struct Vector3dSoA
+			{
+				//Number of doubles required to hold count positions
+				static std::size_t GetRequiredSize(std::size_t count)
+				{
+					return count * 3;
+				}
+
+				void Set(std::size_t index, const Vector3d& v)
+				{
+					components[index] = v.x;
+					components[stride + index] = v.y;
+					components[2 * stride + index] = v.z;
+				}
+
+				void Get(std::size_t index, Vector3d& v)const
+				{
+					v.x = components[index];
+					v.y = components[stride + index];
+					v.z = components[2 * stride + index];
+				}
+
+				double* components;
+				std::size_t stride;
+			};
+
+			namespace Detail
+			{
+				//results[n] = float(values[n] - origin) for n in [begin, end)
+				inline void SubtractToFloat(const double* values, double origin, float* results, std::size_t begin, std::size_t end)
+				{
+					std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_AVX)
+					auto originW = _mm256_set1_pd(origin);
+					for (;n + 4 <= end;n += 4)
+					{
+						_mm_storeu_ps(results + n, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(values + n), originW)));
+					}
+#elif defined(LIGHTNING_SIMD_SSE)
+					auto origin2 = _mm_set1_pd(origin);
+					for (;n + 4 <= end;n += 4)
+					{
+						//each conversion fills the low half of a float vector
+						auto lo = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(values + n), origin2));
+						auto hi = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(values + n + 2), origin2));
+						_mm_storeu_ps(results + n, _mm_movelh_ps(lo, hi));
+					}
+#elif defined(LIGHTNING_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+					auto origin2 = vdupq_n_f64(origin);
+					for (;n + 4 <= end;n += 4)
+					{
+						auto lo = vcvt_f32_f64(vsubq_f64(vld1q_f64(values + n), origin2));
+						auto hi = vcvt_f32_f64(vsubq_f64(vld1q_f64(values + n + 2), origin2));
+						vst1q_f32(results + n, vcombine_f32(lo, hi));
+					}
+#endif
+					for (;n < end;++n)
+					{
+						results[n] = static_cast<float>(values[n] - origin);
+					}
+				}
+			}
+
+			//Converts positions relative to origin(usually the camera position) to float for i in [begin, end).Component c of
+			//result i is written to results[c][i],so x, y and z may go to separate arrays such as the translation row of a
+			//Matrix4fSoA.The difference is taken in double,so results have float precision near origin however large the
+			//positions are.Thread safe as long as ranges of concurrent calls don't overlap.
+			inline void BatchToRelativePositions(const Vector3dSoA& positions, const Vector3d& origin,
+				float* const results[3], std::size_t begin, std::size_t end)
+			{
+				Detail::SubtractToFloat(positions.components, origin.x, results[0], begin, end);
+				Detail::SubtractToFloat(positions.components + positions.stride, origin.y, results[1], begin, end);
+				Detail::SubtractToFloat(positions.components + 2 * positions.stride, origin.z, results[2], begin, end);
+			}
+		}
+	}
+}
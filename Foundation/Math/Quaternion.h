@@ -195,6 +195,48 @@ namespace Lightning
 					mat.SetCell(2, 2, 1 - x2 - y2);
 				}
 
+				//Inverse of ToMatrix:the rotation that turns right, up and forward axes into the given orthonormal axes,
+				//which are rows 0-2 of its matrix.
+				//ref : Mathematics for 3D Game Programming And Computer Graphics
+				static Quaternion<T> FromAxes(const Vector3<T>& right, const Vector3<T>& up, const Vector3<T>& forward)
+				{
+					Quaternion<T> res;
+					auto trace = right.x + up.y + forward.z;
+					if (trace > 0)
+					{
+						auto s = std::sqrt(trace + 1) * 2;
+						res.w = T(0.25) * s;
+						res.x = (up.z - forward.y) / s;
+						res.y = (forward.x - right.z) / s;
+						res.z = (right.y - up.x) / s;
+					}
+					else if (right.x > up.y && right.x > forward.z)
+					{
+						auto s = std::sqrt(1 + right.x - up.y - forward.z) * 2;
+						res.w = (up.z - forward.y) / s;
+						res.x = T(0.25) * s;
+						res.y = (right.y + up.x) / s;
+						res.z = (right.z + forward.x) / s;
+					}
+					else if (up.y > forward.z)
+					{
+						auto s = std::sqrt(1 + up.y - right.x - forward.z) * 2;
+						res.w = (forward.x - right.z) / s;
+						res.x = (right.y + up.x) / s;
+						res.y = T(0.25) * s;
+						res.z = (up.z + forward.y) / s;
+					}
+					else
+					{
+						auto s = std::sqrt(1 + forward.z - right.x - up.y) * 2;
+						res.w = (right.y - up.x) / s;
+						res.x = (right.z + forward.x) / s;
+						res.y = (up.z + forward.y) / s;
+						res.z = T(0.25) * s;
+					}
+					return res;
+				}
+
 				static const Quaternion& Identity()
 				{
 					static Quaternion quat;
@@ -207,6 +249,48 @@ namespace Lightning
 
 			using Quaternionf = Quaternion<float>;
 			static_assert(std::is_pod<Quaternionf>::value, "Quaternionf is not a POD!");
+
+#if defined(LIGHTNING_SIMD_VECTOR)
+			//SIMD versions of float quaternion operations,(x, y, z, w) is loaded as one SIMDVector
+			template<>
+			inline Quaternionf Quaternionf::operator*(const Quaternionf& q)const
+			{
+				//res = w * q + x * (q.w, q.z, q.y, q.x) * (+ - + -) + y * (q.z, q.w, q.x, q.y) * (+ + - -) + z * (q.y, q.x, q.w, q.z) * (- + + -)
+				auto lhs = SIMDLoad(&x);
+				auto rhs = SIMDLoad(&q.x);
+				auto res = SIMDMul(SIMDSplatLane<3>(lhs), rhs);
+				res = SIMDMulAdd(SIMDMul(SIMDSplatLane<0>(lhs), SIMDSwizzle<3, 2, 1, 0>(rhs)), SIMDSet(1.0f, -1.0f, 1.0f, -1.0f), res);
+				res = SIMDMulAdd(SIMDMul(SIMDSplatLane<1>(lhs), SIMDSwizzle<2, 3, 0, 1>(rhs)), SIMDSet(1.0f, 1.0f, -1.0f, -1.0f), res);
+				res = SIMDMulAdd(SIMDMul(SIMDSplatLane<2>(lhs), SIMDSwizzle<1, 0, 3, 2>(rhs)), SIMDSet(-1.0f, 1.0f, 1.0f, -1.0f), res);
+				Quaternionf result;
+				SIMDStore(&result.x, res);
+				return result;
+			}
+
+			template<>
+			inline Vector3f Quaternionf::RotateVector(const Vector3f& v)const
+			{
+				//Same formula as the scalar version so non unit quaternions give the same result
+				auto q = SIMDLoad(&x);
+				auto vec = SIMDSet(v.x, v.y, v.z, 0.0f);
+				//both dot products are summed together,sums is (u.Dot(v), u.Dot(v), q.Dot(q), q.Dot(q))
+				auto qv = SIMDMul(q, vec);
+				auto qq = SIMDMul(q, q);
+				auto sums = SIMDAdd(SIMDShuffle<0, 1, 0, 1>(qv, qq), SIMDShuffle<2, 3, 2, 3>(qv, qq));
+				sums = SIMDAdd(sums, SIMDSwizzle<1, 0, 3, 2>(sums));
+				auto w = SIMDSplatLane<3>(q);
+				//w * w - u.Dot(u) = 2 * w * w - q.Dot(q)
+				auto ww = SIMDMul(w, w);
+				auto scale = SIMDSub(SIMDAdd(ww, ww), SIMDSplatLane<2>(sums));
+				auto uv = SIMDSplatLane<0>(sums);
+				auto res = SIMDMul(SIMDAdd(uv, uv), q);
+				res = SIMDMulAdd(scale, vec, res);
+				res = SIMDMulAdd(SIMDAdd(w, w), SIMDCross3(q, vec), res);
+				float result[4];
+				SIMDStore(result, res);
+				return Vector3f{ result[0], result[1], result[2] };
+			}
+#endif
 		}
 	}
 }
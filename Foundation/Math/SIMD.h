@@ -0,0 +1,196 @@
+#pragma once
+//Compile time selection of SIMD instruction set used by batch math kernels.
+//LIGHTNING_SIMD_AVX implies LIGHTNING_SIMD_SSE.If neither is defined kernels fall back to scalar code.
+//Defining LIGHTNING_SIMD_DISABLED forces the scalar code,e.g.to compare results or timings with it.
+#if defined(LIGHTNING_SIMD_DISABLED)
+#elif defined(__AVX__)
+#define LIGHTNING_SIMD_AVX
+#define LIGHTNING_SIMD_SSE
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTNING_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define LIGHTNING_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+//SIMDVector is a 4 lane float vector shared by SSE and NEON,math types are written against the functions below
+//instead of raw intrinsics so that they work on both.LIGHTNING_SIMD_VECTOR is defined if it's available
+#if defined(LIGHTNING_SIMD_SSE) || defined(LIGHTNING_SIMD_NEON)
+#define LIGHTNING_SIMD_VECTOR
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+#if defined(LIGHTNING_SIMD_SSE)
+			using SIMDVector = __m128;
+
+			inline SIMDVector SIMDLoad(const float* p) { return _mm_loadu_ps(p); }
+			inline void SIMDStore(float* p, SIMDVector v) { _mm_storeu_ps(p, v); }
+			inline SIMDVector SIMDSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+			inline SIMDVector SIMDSplat(float f) { return _mm_set1_ps(f); }
+			inline SIMDVector SIMDAdd(SIMDVector a, SIMDVector b) { return _mm_add_ps(a, b); }
+			inline SIMDVector SIMDSub(SIMDVector a, SIMDVector b) { return _mm_sub_ps(a, b); }
+			inline SIMDVector SIMDMul(SIMDVector a, SIMDVector b) { return _mm_mul_ps(a, b); }
+			inline SIMDVector SIMDDiv(SIMDVector a, SIMDVector b) { return _mm_div_ps(a, b); }
+			inline float SIMDGetX(SIMDVector v) { return _mm_cvtss_f32(v); }
+
+			//(a[X], a[Y], b[Z], b[W])
+			template<int X, int Y, int Z, int W>
+			inline SIMDVector SIMDShuffle(SIMDVector a, SIMDVector b)
+			{
+				return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+			}
+
+			template<int Lane>
+			inline SIMDVector SIMDSplatLane(SIMDVector v)
+			{
+				return _mm_shuffle_ps(v, v, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+			}
+
+			inline void SIMDTranspose(SIMDVector& r0, SIMDVector& r1, SIMDVector& r2, SIMDVector& r3)
+			{
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			}
+
+			inline SIMDVector SIMDAbs(SIMDVector v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+			inline SIMDVector SIMDSqrt(SIMDVector v) { return _mm_sqrt_ps(v); }
+
+			//Loads 4 packed xyz triples(12 floats) as x, y and z of 4 lanes
+			inline void SIMDLoadInterleaved3(const float* p, SIMDVector& x, SIMDVector& y, SIMDVector& z)
+			{
+				auto a = _mm_loadu_ps(p);		//x0 y0 z0 x1
+				auto b = _mm_loadu_ps(p + 4);	//y1 z1 x2 y2
+				auto c = _mm_loadu_ps(p + 8);	//z2 x3 y3 z3
+				x = SIMDShuffle<0, 3, 0, 2>(a, SIMDShuffle<2, 2, 1, 1>(b, c));
+				y = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<1, 1, 0, 0>(a, b), SIMDShuffle<3, 3, 2, 2>(b, c));
+				z = SIMDShuffle<0, 2, 0, 3>(SIMDShuffle<2, 2, 1, 1>(a, b), c);
+			}
+
+			inline void SIMDStoreInterleaved3(float* p, SIMDVector x, SIMDVector y, SIMDVector z)
+			{
+				_mm_storeu_ps(p, SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<0, 0, 0, 0>(x, y), SIMDShuffle<0, 0, 1, 1>(z, x)));
+				_mm_storeu_ps(p + 4, SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<1, 1, 1, 1>(y, z), SIMDShuffle<2, 2, 2, 2>(x, y)));
+				_mm_storeu_ps(p + 8, SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<2, 2, 3, 3>(z, x), SIMDShuffle<3, 3, 3, 3>(y, z)));
+			}
+#else
+			using SIMDVector = float32x4_t;
+
+			inline SIMDVector SIMDLoad(const float* p) { return vld1q_f32(p); }
+			inline void SIMDStore(float* p, SIMDVector v) { vst1q_f32(p, v); }
+			inline SIMDVector SIMDSet(float x, float y, float z, float w)
+			{
+				const float values[4] = { x, y, z, w };
+				return vld1q_f32(values);
+			}
+			inline SIMDVector SIMDSplat(float f) { return vdupq_n_f32(f); }
+			inline SIMDVector SIMDAdd(SIMDVector a, SIMDVector b) { return vaddq_f32(a, b); }
+			inline SIMDVector SIMDSub(SIMDVector a, SIMDVector b) { return vsubq_f32(a, b); }
+			inline SIMDVector SIMDMul(SIMDVector a, SIMDVector b) { return vmulq_f32(a, b); }
+			inline SIMDVector SIMDDiv(SIMDVector a, SIMDVector b)
+			{
+#if defined(__aarch64__) || defined(_M_ARM64)
+				return vdivq_f32(a, b);
+#else
+				//two Newton-Raphson steps bring the reciprocal estimate to full precision
+				auto reciprocal = vrecpeq_f32(b);
+				reciprocal = vmulq_f32(vrecpsq_f32(b, reciprocal), reciprocal);
+				reciprocal = vmulq_f32(vrecpsq_f32(b, reciprocal), reciprocal);
+				return vmulq_f32(a, reciprocal);
+#endif
+			}
+			inline float SIMDGetX(SIMDVector v) { return vgetq_lane_f32(v, 0); }
+
+			//(a[X], a[Y], b[Z], b[W]).Goes through memory,hot patterns can be specialized with vext/vrev/vzip
+			template<int X, int Y, int Z, int W>
+			inline SIMDVector SIMDShuffle(SIMDVector a, SIMDVector b)
+			{
+				float va[4], vb[4];
+				vst1q_f32(va, a);
+				vst1q_f32(vb, b);
+				const float values[4] = { va[X], va[Y], vb[Z], vb[W] };
+				return vld1q_f32(values);
+			}
+
+			template<int Lane>
+			inline SIMDVector SIMDSplatLane(SIMDVector v)
+			{
+				return vdupq_n_f32(vgetq_lane_f32(v, Lane));
+			}
+
+			inline void SIMDTranspose(SIMDVector& r0, SIMDVector& r1, SIMDVector& r2, SIMDVector& r3)
+			{
+				auto t01 = vtrnq_f32(r0, r1);
+				auto t23 = vtrnq_f32(r2, r3);
+				r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+				r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+				r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+				r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+			}
+
+			inline SIMDVector SIMDAbs(SIMDVector v) { return vabsq_f32(v); }
+			inline SIMDVector SIMDSqrt(SIMDVector v)
+			{
+#if defined(__aarch64__) || defined(_M_ARM64)
+				return vsqrtq_f32(v);
+#else
+				//v * 1/sqrt(v) refined by two Newton-Raphson steps,0 would yield NaN so it's selected explicitly
+				auto reciprocal = vrsqrteq_f32(v);
+				reciprocal = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, reciprocal), reciprocal), reciprocal);
+				reciprocal = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, reciprocal), reciprocal), reciprocal);
+				auto zero = vdupq_n_f32(0.0f);
+				return vbslq_f32(vceqq_f32(v, zero), zero, vmulq_f32(v, reciprocal));
+#endif
+			}
+
+			//Loads 4 packed xyz triples(12 floats) as x, y and z of 4 lanes
+			inline void SIMDLoadInterleaved3(const float* p, SIMDVector& x, SIMDVector& y, SIMDVector& z)
+			{
+				auto v = vld3q_f32(p);
+				x = v.val[0];
+				y = v.val[1];
+				z = v.val[2];
+			}
+
+			inline void SIMDStoreInterleaved3(float* p, SIMDVector x, SIMDVector y, SIMDVector z)
+			{
+				float32x4x3_t v;
+				v.val[0] = x;
+				v.val[1] = y;
+				v.val[2] = z;
+				vst3q_f32(p, v);
+			}
+#endif
+			template<int X, int Y, int Z, int W>
+			inline SIMDVector SIMDSwizzle(SIMDVector v)
+			{
+				return SIMDShuffle<X, Y, Z, W>(v, v);
+			}
+
+			//a * b + c
+			inline SIMDVector SIMDMulAdd(SIMDVector a, SIMDVector b, SIMDVector c)
+			{
+				return SIMDAdd(SIMDMul(a, b), c);
+			}
+
+			//Sum of the 4 lanes in every lane
+			inline SIMDVector SIMDHorizontalAdd(SIMDVector v)
+			{
+				v = SIMDAdd(v, SIMDSwizzle<1, 0, 3, 2>(v));
+				return SIMDAdd(v, SIMDSwizzle<2, 3, 0, 1>(v));
+			}
+
+			//Cross product of xyz lanes,w lane of the result is 0
+			inline SIMDVector SIMDCross3(SIMDVector a, SIMDVector b)
+			{
+				return SIMDSub(SIMDMul(SIMDSwizzle<1, 2, 0, 3>(a), SIMDSwizzle<2, 0, 1, 3>(b)),
+					SIMDMul(SIMDSwizzle<2, 0, 1, 3>(a), SIMDSwizzle<1, 2, 0, 3>(b)));
+			}
+		}
+	}
+}
+#endif
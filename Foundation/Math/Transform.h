@@ -2,6 +2,7 @@
 #undef min
 #undef max
 #include "Math/Matrix.h"
+#include "Math/AffineMatrix.h"
 #include "Math/Vector.h"
 #include "Math/Quaternion.h"
 
@@ -48,6 +49,9 @@ namespace Lightning
 				}
 
 				Matrix4f GetMatrix()const{ UpdateMatrix(); return mMatrix; }
+				//Affine forms of LocalToGlobalMatrix4 and GlobalToLocalMatrix4
+				AffineMatrix GetAffineMatrix()const { UpdateMatrix(); return AffineMatrix::FromMatrix4(mMatrix); }
+				AffineMatrix GetInverseAffineMatrix()const { UpdateMatrix(); return AffineMatrix::FromMatrix4(mInverseMatrix); }
 				Vector3f GetPosition()const { return mPosition; }
 
 				void SetRotation(const Quaternionf& rotation)
@@ -133,6 +137,47 @@ namespace Lightning
 				Vector3f Forward()const { return mRotation * Vector3f::forward(); }
 				Vector3f Up()const { return mRotation * Vector3f::up(); }
 				Vector3f Right()const { return mRotation * Vector3f::right(); }
+				//Decomposes a matrix composed of positive scale, rotation and translation.Scales are the lengths of rows 0-2.
+				//If the matrix has shear the rotation keeps the direction of row 2(forward) and the plane of rows 1 and 2 like OrientTo
+				static Transform FromAffineMatrix(const AffineMatrix& matrix)
+				{
+#if defined(LIGHTNING_SIMD_VECTOR)
+					auto r0 = SIMDLoad(matrix.m);
+					auto r1 = SIMDLoad(matrix.m + 4);
+					auto r2 = SIMDLoad(matrix.m + 8);
+					auto r3 = SIMDSet(0.0f, 0.0f, 0.0f, 1.0f);
+					//lane i is the length of row i while they are still columns
+					auto scale = SIMDSqrt(SIMDMulAdd(r0, r0, SIMDMulAdd(r1, r1, SIMDMul(r2, r2))));
+					SIMDTranspose(r0, r1, r2, r3);
+					auto forward = SIMDDiv(r2, SIMDSplatLane<2>(scale));
+					auto right = SIMDCross3(r1, forward);
+					right = SIMDDiv(right, SIMDSqrt(SIMDHorizontalAdd(SIMDMul(right, right))));
+					auto up = SIMDCross3(forward, right);
+					float values[5][4];
+					SIMDStore(values[0], right);
+					SIMDStore(values[1], up);
+					SIMDStore(values[2], forward);
+					SIMDStore(values[3], r3);
+					SIMDStore(values[4], scale);
+					auto rotation = Quaternionf::FromAxes(Vector3f{ values[0][0], values[0][1], values[0][2] },
+						Vector3f{ values[1][0], values[1][1], values[1][2] }, Vector3f{ values[2][0], values[2][1], values[2][2] });
+					return Transform(Vector3f{ values[3][0], values[3][1], values[3][2] },
+						Vector3f{ values[4][0], values[4][1], values[4][2] }, rotation);
+#else
+					Vector3f rows[3];
+					for (unsigned i = 0;i < 3;++i)
+					{
+						rows[i] = Vector3f{ matrix.GetCell(i, 0), matrix.GetCell(i, 1), matrix.GetCell(i, 2) };
+					}
+					Vector3f scale{ rows[0].Length(), rows[1].Length(), rows[2].Length() };
+					auto forward = rows[2] * (1.0f / scale.z);
+					auto right = rows[1].Cross(forward);
+					right.Normalize();
+					auto up = forward.Cross(right);
+					return Transform(Vector3f{ matrix.GetCell(3, 0), matrix.GetCell(3, 1), matrix.GetCell(3, 2) },
+						scale, Quaternionf::FromAxes(right, up, forward));
+#endif
+				}
 				//ref : https://math.stackexchange.com/questions/44689/how-to-find-a-random-axis-or-unit-vector-in-3d
 				static Quaternionf RandomRotation()
 				{
@@ -154,33 +199,70 @@ namespace Lightning
 					if (!mMatrixDirty)
 						return;
 					mMatrixDirty = false;
-
-					Matrix4f matTrans;
-					matTrans.SetIdentity();
-					matTrans.SetRow(3, Vector4f{mPosition.x, mPosition.y, mPosition.z, 1.0f});
-
+					//Matrix is scale * rotation * translation,so row i(i < 3) is rotation row i scaled by scale i and row 3 is position.
+					//Inverse is translation^-1 * rotation^T * scale^-1:column i is rotation row i with w = -position.(rotation row i)
+					//divided by scale i.Column 3 of both is (0, 0, 0, 1)
+#if defined(LIGHTNING_SIMD_VECTOR)
+					//rotation rows are assembled the way Quaternion::ToMatrix computes the cells
+					auto q = SIMDLoad(&mRotation.x);
+					auto q2 = SIMDAdd(q, q);
+					auto squares = SIMDMul(q, q2);
+					//(1 - y2 - z2, 1 - x2 - z2, 1 - x2 - y2)
+					auto diagonal = SIMDSub(SIMDSub(SIMDSplat(1.0f), SIMDSwizzle<1, 0, 0, 3>(squares)), SIMDSwizzle<2, 2, 1, 3>(squares));
+					//(xz, xy, yz) and (wy, wz, wx)
+					auto v0 = SIMDMul(SIMDSwizzle<0, 0, 1, 3>(q), SIMDSwizzle<2, 1, 2, 3>(q2));
+					auto v1 = SIMDMul(SIMDSplatLane<3>(q), SIMDSwizzle<1, 2, 0, 3>(q2));
+					auto sum = SIMDAdd(v0, v1);
+					auto difference = SIMDSub(v0, v1);
+					auto zero = SIMDSplat(0.0f);
+					auto row0 = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<0, 0, 1, 1>(diagonal, sum), SIMDShuffle<0, 0, 0, 0>(difference, zero));
+					auto row1 = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<1, 1, 1, 1>(difference, diagonal), SIMDShuffle<2, 2, 0, 0>(sum, zero));
+					auto row2 = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<0, 0, 2, 2>(sum, difference), SIMDShuffle<2, 2, 0, 0>(diagonal, zero));
+
+					auto c0 = SIMDMul(row0, SIMDSplat(mScale.x));
+					auto c1 = SIMDMul(row1, SIMDSplat(mScale.y));
+					auto c2 = SIMDMul(row2, SIMDSplat(mScale.z));
+					auto position = SIMDSet(mPosition.x, mPosition.y, mPosition.z, 1.0f);
+					auto c3 = position;
+					SIMDTranspose(c0, c1, c2, c3);
+					SIMDStore(mMatrix.m, c0);
+					SIMDStore(mMatrix.m + 4, c1);
+					SIMDStore(mMatrix.m + 8, c2);
+					SIMDStore(mMatrix.m + 12, c3);
+
+					auto inverseScale = SIMDDiv(SIMDSplat(1.0f), SIMDSet(mScale.x, mScale.y, mScale.z, 1.0f));
+					auto w = SIMDSet(0.0f, 0.0f, 0.0f, 1.0f);
+					auto positionXYZ = SIMDSub(position, w);
+					//w lane of rotation rows is 0,so subtracting w * dot only sets the w lane
+					auto inverseColumn = [positionXYZ, w](SIMDVector row, SIMDVector inverseScale) {
+						auto dot = SIMDHorizontalAdd(SIMDMul(positionXYZ, row));
+						return SIMDMul(SIMDSub(row, SIMDMul(w, dot)), inverseScale);
+					};
+					SIMDStore(mInverseMatrix.m, inverseColumn(row0, SIMDSplatLane<0>(inverseScale)));
+					SIMDStore(mInverseMatrix.m + 4, inverseColumn(row1, SIMDSplatLane<1>(inverseScale)));
+					SIMDStore(mInverseMatrix.m + 8, inverseColumn(row2, SIMDSplatLane<2>(inverseScale)));
+					SIMDStore(mInverseMatrix.m + 12, w);
+#else
 					Matrix4f matRotation;
 					mRotation.ToMatrix(matRotation);
-
-					Matrix4f matScale;
-					matScale.SetIdentity();
-					matScale.SetCell(0, 0, mScale.x);
-					matScale.SetCell(1, 1, mScale.y);
-					matScale.SetCell(2, 2, mScale.z);
-
-					mMatrix = matScale * matRotation * matTrans;
-
-					matScale.SetIdentity();
-					matScale.SetCell(0, 0, float(1.0 / mScale.x));
-					matScale.SetCell(1, 1, float(1.0 / mScale.y));
-					matScale.SetCell(2, 2, float(1.0 / mScale.z));
-
-					mRotation.Inversed().ToMatrix(matRotation);
-
-					matTrans.SetIdentity();
-					matTrans.SetRow(3, Vector4f{-mPosition.x, -mPosition.y, -mPosition.z, 1.0f});
-
-					mInverseMatrix = matTrans * matRotation * matScale;
+					const float position[3] = { mPosition.x, mPosition.y, mPosition.z };
+					const float scale[3] = { mScale.x, mScale.y, mScale.z };
+					mMatrix.SetIdentity();
+					mInverseMatrix.SetIdentity();
+					for (unsigned i = 0;i < 3;++i)
+					{
+						auto inverseScale = 1.0f / scale[i];
+						float dot{ 0.0f };
+						for (unsigned j = 0;j < 3;++j)
+						{
+							mMatrix.SetCell(i, j, matRotation.GetCell(i, j) * scale[i]);
+							mInverseMatrix.SetCell(j, i, matRotation.GetCell(i, j) * inverseScale);
+							dot += position[j] * matRotation.GetCell(i, j);
+						}
+						mMatrix.SetCell(3, i, position[i]);
+						mInverseMatrix.SetCell(3, i, -dot * inverseScale);
+					}
+#endif
 				}
 				Vector3f mPosition;
 				Vector3f mScale;
@@ -0,0 +1,310 @@
+#pragma once
+#include <cstddef>
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "AABB.h"
+#include "SIMD.h"
+
+namespace Lightning
+{
+	namespace Foundation
+	{
+		namespace Math
+		{
+			//Structure of arrays layout of Vector3f.Component c of the vector n is stored at components[c * stride + n].
+			//Like Matrix4fSoA the memory is owned by the caller.
+			struct Vector3fSoA
+			{
+				//Number of floats required to hold count vectors
+				static std::size_t GetRequiredSize(std::size_t count)
+				{
+					return count * 3;
+				}
+
+				void Set(std::size_t index, const Vector3f& v)
+				{
+					components[index] = v.x;
+					components[stride + index] = v.y;
+					components[2 * stride + index] = v.z;
+				}
+
+				void Get(std::size_t index, Vector3f& v)const
+				{
+					v.x = components[index];
+					v.y = components[stride + index];
+					v.z = components[2 * stride + index];
+				}
+
+				float* components;
+				std::size_t stride;
+			};
+
+			//Stream kernels below work on [begin, end) of their arrays so that callers can split them among threads.
+			//Matrices follow the row vector convention(translation in row 3),results may alias inputs.
+			static_assert(sizeof(Vector3f) == sizeof(float) * 3, "Vector3f arrays must be packed xyz triples!");
+
+			//results[i] = points[i] * matrix.w of the result is dropped,so matrix should be affine
+			inline void BatchTransformPoints(const Matrix4f& matrix, const Vector3f* points, Vector3f* results,
+				std::size_t begin, std::size_t end)
+			{
+				std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_VECTOR)
+				//component c of results is dot product of the point and column c
+				SIMDVector cells[12];
+				for (std::size_t i = 0;i < 12;++i)
+				{
+					cells[i] = SIMDSplat(matrix.m[i]);
+				}
+				for (;n + 4 <= end;n += 4)
+				{
+					SIMDVector x, y, z;
+					SIMDLoadInterleaved3(&points[n].x, x, y, z);
+					auto rx = SIMDMulAdd(x, cells[0], SIMDMulAdd(y, cells[1], SIMDMulAdd(z, cells[2], cells[3])));
+					auto ry = SIMDMulAdd(x, cells[4], SIMDMulAdd(y, cells[5], SIMDMulAdd(z, cells[6], cells[7])));
+					auto rz = SIMDMulAdd(x, cells[8], SIMDMulAdd(y, cells[9], SIMDMulAdd(z, cells[10], cells[11])));
+					SIMDStoreInterleaved3(&results[n].x, rx, ry, rz);
+				}
+#endif
+				for (;n < end;++n)
+				{
+					const auto p = points[n];
+					results[n].x = p.x * matrix.m[0] + p.y * matrix.m[1] + p.z * matrix.m[2] + matrix.m[3];
+					results[n].y = p.x * matrix.m[4] + p.y * matrix.m[5] + p.z * matrix.m[6] + matrix.m[7];
+					results[n].z = p.x * matrix.m[8] + p.y * matrix.m[9] + p.z * matrix.m[10] + matrix.m[11];
+				}
+			}
+
+			//SoA version of BatchTransformPoints,no shuffles are needed so AVX processes 8 points at once
+			inline void BatchTransformPoints(const Matrix4f& matrix, const Vector3fSoA& points, const Vector3fSoA& results,
+				std::size_t begin, std::size_t end)
+			{
+				std::size_t n = begin;
+				const float* px = points.components;
+				const float* py = points.components + points.stride;
+				const float* pz = points.components + 2 * points.stride;
+				float* rx = results.components;
+				float* ry = results.components + results.stride;
+				float* rz = results.components + 2 * results.stride;
+#if defined(LIGHTNING_SIMD_AVX)
+				__m256 wideCells[12];
+				for (std::size_t i = 0;i < 12;++i)
+				{
+					wideCells[i] = _mm256_set1_ps(matrix.m[i]);
+				}
+				for (;n + 8 <= end;n += 8)
+				{
+					auto x = _mm256_loadu_ps(px + n);
+					auto y = _mm256_loadu_ps(py + n);
+					auto z = _mm256_loadu_ps(pz + n);
+					for (std::size_t c = 0;c < 3;++c)
+					{
+						auto r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, wideCells[c * 4]), _mm256_mul_ps(y, wideCells[c * 4 + 1])),
+							_mm256_add_ps(_mm256_mul_ps(z, wideCells[c * 4 + 2]), wideCells[c * 4 + 3]));
+						_mm256_storeu_ps((c == 0 ? rx : c == 1 ? ry : rz) + n, r);
+					}
+				}
+#endif
+#if defined(LIGHTNING_SIMD_VECTOR)
+				SIMDVector cells[12];
+				for (std::size_t i = 0;i < 12;++i)
+				{
+					cells[i] = SIMDSplat(matrix.m[i]);
+				}
+				for (;n + 4 <= end;n += 4)
+				{
+					auto x = SIMDLoad(px + n);
+					auto y = SIMDLoad(py + n);
+					auto z = SIMDLoad(pz + n);
+					auto resX = SIMDMulAdd(x, cells[0], SIMDMulAdd(y, cells[1], SIMDMulAdd(z, cells[2], cells[3])));
+					auto resY = SIMDMulAdd(x, cells[4], SIMDMulAdd(y, cells[5], SIMDMulAdd(z, cells[6], cells[7])));
+					auto resZ = SIMDMulAdd(x, cells[8], SIMDMulAdd(y, cells[9], SIMDMulAdd(z, cells[10], cells[11])));
+					SIMDStore(rx + n, resX);
+					SIMDStore(ry + n, resY);
+					SIMDStore(rz + n, resZ);
+				}
+#endif
+				for (;n < end;++n)
+				{
+					const auto x = px[n], y = py[n], z = pz[n];
+					rx[n] = x * matrix.m[0] + y * matrix.m[1] + z * matrix.m[2] + matrix.m[3];
+					ry[n] = x * matrix.m[4] + y * matrix.m[5] + z * matrix.m[6] + matrix.m[7];
+					rz[n] = x * matrix.m[8] + y * matrix.m[9] + z * matrix.m[10] + matrix.m[11];
+				}
+			}
+
+			//results[i] = boxes[i].Transformed(matrix)
+			inline void BatchTransformAABBs(const Matrix4f& matrix, const AABBf* boxes, AABBf* results,
+				std::size_t begin, std::size_t end)
+			{
+#if defined(LIGHTNING_SIMD_VECTOR)
+				//rows of matrix,the new center is the combination of rows weighted by the center and so are the extents
+				auto r0 = SIMDLoad(matrix.m);
+				auto r1 = SIMDLoad(matrix.m + 4);
+				auto r2 = SIMDLoad(matrix.m + 8);
+				auto r3 = SIMDLoad(matrix.m + 12);
+				SIMDTranspose(r0, r1, r2, r3);
+				auto a0 = SIMDAbs(r0);
+				auto a1 = SIMDAbs(r1);
+				auto a2 = SIMDAbs(r2);
+				auto half = SIMDSplat(0.5f);
+				for (auto n = begin;n < end;++n)
+				{
+					const auto& box = boxes[n];
+					if (box.IsEmpty() || box.IsInfinite())
+					{
+						results[n] = box;
+						continue;
+					}
+					//both loads stay inside the box,(min.x, min.y, min.z, max.x) and (min.z, max.x, max.y, max.z)
+					auto min = SIMDLoad(&box.min.x);
+					auto max = SIMDSwizzle<1, 2, 3, 3>(SIMDLoad(&box.min.z));
+					auto center = SIMDMul(SIMDAdd(min, max), half);
+					auto extents = SIMDMul(SIMDSub(max, min), half);
+					auto newCenter = SIMDMulAdd(SIMDSplatLane<0>(center), r0, SIMDMulAdd(SIMDSplatLane<1>(center), r1,
+						SIMDMulAdd(SIMDSplatLane<2>(center), r2, r3)));
+					auto newExtents = SIMDMulAdd(SIMDSplatLane<0>(extents), a0, SIMDMulAdd(SIMDSplatLane<1>(extents), a1,
+						SIMDMul(SIMDSplatLane<2>(extents), a2)));
+					auto newMin = SIMDSub(newCenter, newExtents);
+					auto newMax = SIMDAdd(newCenter, newExtents);
+					//(min.z, min.z, max.x, max.x)
+					auto middle = SIMDShuffle<2, 2, 0, 0>(newMin, newMax);
+					SIMDStore(&results[n].min.x, SIMDShuffle<0, 1, 0, 2>(newMin, middle));
+					SIMDStore(&results[n].min.z, SIMDShuffle<0, 2, 1, 2>(middle, newMax));
+				}
+#else
+				for (auto n = begin;n < end;++n)
+				{
+					results[n] = boxes[n].Transformed(matrix);
+				}
+#endif
+			}
+
+#if defined(LIGHTNING_SIMD_VECTOR)
+			namespace Detail
+			{
+				//Rotation matrix cells of 4 quaternions given as x, y, z and w lanes.rotation[row][col] are the same as Quaternion::ToMatrix
+				inline void ComputeRotationCells(SIMDVector x, SIMDVector y, SIMDVector z, SIMDVector w, SIMDVector(&rotation)[3][3])
+				{
+					auto one = SIMDSplat(1.0f);
+					auto x2 = SIMDAdd(x, x);
+					auto y2 = SIMDAdd(y, y);
+					auto z2 = SIMDAdd(z, z);
+					auto xx = SIMDMul(x2, x);
+					auto yy = SIMDMul(y2, y);
+					auto zz = SIMDMul(z2, z);
+					auto xy = SIMDMul(x2, y);
+					auto xz = SIMDMul(x2, z);
+					auto yz = SIMDMul(y2, z);
+					auto wx = SIMDMul(x2, w);
+					auto wy = SIMDMul(y2, w);
+					auto wz = SIMDMul(z2, w);
+					rotation[0][0] = SIMDSub(SIMDSub(one, yy), zz);
+					rotation[1][0] = SIMDSub(xy, wz);
+					rotation[2][0] = SIMDAdd(xz, wy);
+					rotation[0][1] = SIMDAdd(xy, wz);
+					rotation[1][1] = SIMDSub(SIMDSub(one, xx), zz);
+					rotation[2][1] = SIMDSub(yz, wx);
+					rotation[0][2] = SIMDSub(xz, wy);
+					rotation[1][2] = SIMDAdd(yz, wx);
+					rotation[2][2] = SIMDSub(SIMDSub(one, xx), yy);
+				}
+
+				//Loads 4 quaternions as x, y, z and w lanes
+				inline void LoadQuaternions(const Quaternionf* rotations, SIMDVector& x, SIMDVector& y, SIMDVector& z, SIMDVector& w)
+				{
+					x = SIMDLoad(&rotations[0].x);
+					y = SIMDLoad(&rotations[1].x);
+					z = SIMDLoad(&rotations[2].x);
+					w = SIMDLoad(&rotations[3].x);
+					SIMDTranspose(x, y, z, w);
+				}
+
+				//column c of results[k] is lane k of cells[0..3][c],column 3 is (0, 0, 0, 1)
+				inline void StoreMatrixColumns(SIMDVector(&cells)[4][3], Matrix4f* results)
+				{
+					for (std::size_t c = 0;c < 3;++c)
+					{
+						auto c0 = cells[0][c], c1 = cells[1][c], c2 = cells[2][c], c3 = cells[3][c];
+						SIMDTranspose(c0, c1, c2, c3);
+						SIMDStore(results[0].m + c * 4, c0);
+						SIMDStore(results[1].m + c * 4, c1);
+						SIMDStore(results[2].m + c * 4, c2);
+						SIMDStore(results[3].m + c * 4, c3);
+					}
+					auto lastColumn = SIMDSet(0.0f, 0.0f, 0.0f, 1.0f);
+					for (std::size_t k = 0;k < 4;++k)
+					{
+						SIMDStore(results[k].m + 12, lastColumn);
+					}
+				}
+			}
+#endif
+
+			//results[i] is the rotation matrix of rotations[i],same as Quaternion::ToMatrix
+			inline void BatchQuaternionToMatrix(const Quaternionf* rotations, Matrix4f* results, std::size_t begin, std::size_t end)
+			{
+				std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_VECTOR)
+				for (;n + 4 <= end;n += 4)
+				{
+					SIMDVector x, y, z, w;
+					Detail::LoadQuaternions(rotations + n, x, y, z, w);
+					SIMDVector rotation[3][3];
+					Detail::ComputeRotationCells(x, y, z, w, rotation);
+					auto zero = SIMDSplat(0.0f);
+					SIMDVector cells[4][3] = {
+						{ rotation[0][0], rotation[0][1], rotation[0][2] },
+						{ rotation[1][0], rotation[1][1], rotation[1][2] },
+						{ rotation[2][0], rotation[2][1], rotation[2][2] },
+						{ zero, zero, zero } };
+					Detail::StoreMatrixColumns(cells, results + n);
+				}
+#endif
+				for (;n < end;++n)
+				{
+					rotations[n].ToMatrix(results[n]);
+				}
+			}
+
+			//results[i] = scale * rotation * translation,the same matrix Transform builds from its position, rotation and scale
+			inline void BatchComposeTRS(const Vector3f* positions, const Quaternionf* rotations, const Vector3f* scales,
+				Matrix4f* results, std::size_t begin, std::size_t end)
+			{
+				std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_VECTOR)
+				for (;n + 4 <= end;n += 4)
+				{
+					SIMDVector x, y, z, w;
+					Detail::LoadQuaternions(rotations + n, x, y, z, w);
+					SIMDVector rotation[3][3];
+					Detail::ComputeRotationCells(x, y, z, w, rotation);
+					SIMDVector sx, sy, sz, px, py, pz;
+					SIMDLoadInterleaved3(&scales[n].x, sx, sy, sz);
+					SIMDLoadInterleaved3(&positions[n].x, px, py, pz);
+					//row i of rotation is scaled by component i of scale,row 3 is the position
+					SIMDVector cells[4][3] = {
+						{ SIMDMul(rotation[0][0], sx), SIMDMul(rotation[0][1], sx), SIMDMul(rotation[0][2], sx) },
+						{ SIMDMul(rotation[1][0], sy), SIMDMul(rotation[1][1], sy), SIMDMul(rotation[1][2], sy) },
+						{ SIMDMul(rotation[2][0], sz), SIMDMul(rotation[2][1], sz), SIMDMul(rotation[2][2], sz) },
+						{ px, py, pz } };
+					Detail::StoreMatrixColumns(cells, results + n);
+				}
+#endif
+				for (;n < end;++n)
+				{
+					auto& result = results[n];
+					rotations[n].ToMatrix(result);
+					const auto& scale = scales[n];
+					const auto& position = positions[n];
+					for (unsigned col = 0;col < 3;++col)
+					{
+						result.SetCell(0, col, result.GetCell(0, col) * scale.x);
+						result.SetCell(1, col, result.GetCell(1, col) * scale.y);
+						result.SetCell(2, col, result.GetCell(2, col) * scale.z);
+					}
+					result.SetRow(3, Vector4f{ position.x, position.y, position.z, 1.0f });
+				}
+			}
+		}
+	}
+}
@@ -325,7 +325,9 @@ namespace Lightning
 
 			using Vector3f = Vector3<float>;
 			using Vector3i = Vector3<int>;
+			using Vector3d = Vector3<double>;
 			static_assert(std::is_pod<Vector3f>::value, "Vector3f is not POD!");
+			static_assert(std::is_pod<Vector3d>::value, "Vector3d is not POD!");
 			static_assert(std::is_pod<Vector3i>::value, "Vector3i is not POD!");
 			
 			//Vector4
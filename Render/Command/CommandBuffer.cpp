@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cassert>
+#include <istream>
+#include <ostream>
+#include "CommandBuffer.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		static constexpr std::size_t COMMAND_CHUNK_SIZE = 4096;
+		static constexpr std::uint32_t COMMAND_FILE_MAGIC = 0x4243474c;	//"LGCB"
+		static constexpr std::uint32_t COMMAND_FILE_VERSION = 1;
+
+		struct CommandFileHeader
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint64_t commandCount;
+			std::uint64_t size;
+		};
+
+		CommandBuffer::CommandBuffer(FrameMemoryAllocator& allocator)
+			: mAllocator(allocator), mCommandCount(0), mSize(0)
+		{
+
+		}
+
+		void CommandBuffer::Begin(std::uint64_t key)
+		{
+			auto& stream = mStreams.Local();
+			stream.segments.push_back(Segment{ key, stream.spans.size() });
+			auto position = stream.chunk + stream.used;
+			stream.spans.push_back(Span{ position, position });
+		}
+
+		void* CommandBuffer::Write(std::uint32_t type, std::size_t size)
+		{
+			auto& stream = mStreams.Local();
+			assert(!stream.segments.empty() && "Begin must be called before writing commands!");
+			size = (size + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+			auto commandSize = sizeof(CommandHeader) + size;
+			if (stream.used + commandSize > stream.capacity)
+			{
+				AllocateChunk(stream, commandSize);
+				auto position = stream.chunk;
+				stream.spans.push_back(Span{ position, position });
+			}
+			auto command = stream.chunk + stream.used;
+			auto header = reinterpret_cast<CommandHeader*>(command);
+			header->type = type;
+			header->size = static_cast<std::uint32_t>(size);
+			stream.used += commandSize;
+			stream.spans.back().end = stream.chunk + stream.used;
+			++stream.commandCount;
+			return command + sizeof(CommandHeader);
+		}
+
+		void CommandBuffer::AllocateChunk(Stream& stream, std::size_t size)
+		{
+			//Commands never cross chunks,a command larger than a chunk gets a chunk of its own
+			auto capacity = std::max(size, COMMAND_CHUNK_SIZE);
+			auto memory = mAllocator.Allocate<std::uint8_t>(capacity + COMMAND_ALIGNMENT - 1);
+			auto address = reinterpret_cast<std::uintptr_t>(memory);
+			address = (address + COMMAND_ALIGNMENT - 1) & ~static_cast<std::uintptr_t>(COMMAND_ALIGNMENT - 1);
+			stream.chunk = reinterpret_cast<std::uint8_t*>(address);
+			stream.used = 0;
+			stream.capacity = capacity;
+		}
+
+		void CommandBuffer::Merge()
+		{
+			struct SegmentRange
+			{
+				std::uint64_t key;
+				const Span* begin;
+				const Span* end;
+			};
+			std::vector<SegmentRange> segments;
+			mCommandCount = 0;
+			for (auto it = mStreams.begin();it != mStreams.end();++it)
+			{
+				const auto& stream = *it;
+				for (std::size_t i = 0;i < stream.segments.size();++i)
+				{
+					auto lastSpan = i + 1 < stream.segments.size() ? stream.segments[i + 1].firstSpan : stream.spans.size();
+					segments.push_back(SegmentRange{ stream.segments[i].key,
+						stream.spans.data() + stream.segments[i].firstSpan, stream.spans.data() + lastSpan });
+				}
+				mCommandCount += stream.commandCount;
+			}
+			std::sort(segments.begin(), segments.end(), [](const SegmentRange& lhs, const SegmentRange& rhs) {
+				return lhs.key < rhs.key;
+			});
+			mSpans.clear();
+			mSize = 0;
+			for (const auto& segment : segments)
+			{
+				for (auto span = segment.begin;span != segment.end;++span)
+				{
+					if (span->begin == span->end)
+						continue;
+					mSpans.push_back(*span);
+					mSize += span->end - span->begin;
+				}
+			}
+		}
+
+		void CommandBuffer::Reset()
+		{
+			//Chunks are allocated from frame memory and must not be shared by two frames,so every stream starts with a new one
+			for (auto it = mStreams.begin();it != mStreams.end();++it)
+			{
+				auto& stream = *it;
+				stream.chunk = nullptr;
+				stream.used = stream.capacity = stream.commandCount = 0;
+				stream.spans.clear();
+				stream.segments.clear();
+			}
+			mSpans.clear();
+			mCommandCount = 0;
+			mSize = 0;
+			mLoadedCommands.clear();
+		}
+
+		bool CommandBuffer::Save(std::ostream& stream)const
+		{
+			CommandFileHeader header{ COMMAND_FILE_MAGIC, COMMAND_FILE_VERSION, mCommandCount, mSize };
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			for (const auto& span : mSpans)
+			{
+				stream.write(reinterpret_cast<const char*>(span.begin), span.end - span.begin);
+			}
+			return stream.good();
+		}
+
+		bool CommandBuffer::Load(std::istream& stream)
+		{
+			Reset();
+			CommandFileHeader header;
+			if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+				return false;
+			if (header.magic != COMMAND_FILE_MAGIC || header.version != COMMAND_FILE_VERSION)
+				return false;
+			mLoadedCommands.resize(static_cast<std::size_t>(header.size));
+			if (!stream.read(reinterpret_cast<char*>(mLoadedCommands.data()), mLoadedCommands.size()))
+			{
+				mLoadedCommands.clear();
+				return false;
+			}
+			//validate command sizes so ForEach never reads out of the loaded data
+			std::size_t offset{ 0 };
+			std::size_t commandCount{ 0 };
+			while (offset + sizeof(CommandHeader) <= mLoadedCommands.size())
+			{
+				const auto& commandHeader = *reinterpret_cast<const CommandHeader*>(mLoadedCommands.data() + offset);
+				offset += sizeof(CommandHeader) + commandHeader.size;
+				++commandCount;
+			}
+			if (offset != mLoadedCommands.size() || commandCount != header.commandCount)
+			{
+				mLoadedCommands.clear();
+				return false;
+			}
+			if (!mLoadedCommands.empty())
+			{
+				mSpans.push_back(Span{ mLoadedCommands.data(), mLoadedCommands.data() + mLoadedCommands.size() });
+			}
+			mCommandCount = commandCount;
+			mSize = mLoadedCommands.size();
+			return true;
+		}
+	}
+}
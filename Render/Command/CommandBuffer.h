@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "FrameMemoryAllocator.h"
+#include "ThreadLocalObject.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		//Every command is a header followed by size bytes of payload.size is a multiple of COMMAND_ALIGNMENT
+		struct CommandHeader
+		{
+			std::uint32_t type;
+			std::uint32_t size;
+		};
+		constexpr std::size_t COMMAND_ALIGNMENT = 8;
+		static_assert(sizeof(CommandHeader) % COMMAND_ALIGNMENT == 0, "CommandHeader breaks payload alignment.");
+
+		//A compact binary command stream.Commands are tagged POD payloads written into frame memory,every recording thread
+		//writes to its own stream so recording needs no lock.Commands are grouped into segments started by Begin,Merge orders
+		//segments of all threads by their keys so the replay order doesn't depend on which thread recorded a segment.
+		//Keys should be unique in a frame,the order of segments with the same key is undefined.
+		//Command memory is owned by the frame allocator and stays valid until the frame it is recorded in is released
+		class CommandBuffer
+		{
+		public:
+			explicit CommandBuffer(FrameMemoryAllocator& allocator);
+			CommandBuffer(const CommandBuffer&) = delete;
+			CommandBuffer& operator=(const CommandBuffer&) = delete;
+			//Starts a new segment in calling thread's stream.Thread safe
+			void Begin(std::uint64_t key);
+			//Appends a command to the current segment of calling thread and returns its payload of at least size bytes.Thread safe
+			void* Write(std::uint32_t type, std::size_t size);
+			//Appends a command whose payload is a Command followed by extraSize bytes.Command::TYPE is the tag.Thread safe
+			template<typename Command>
+			Command* Write(std::size_t extraSize = 0)
+			{
+				return static_cast<Command*>(Write(static_cast<std::uint32_t>(Command::TYPE), sizeof(Command) + extraSize));
+			}
+			//Orders segments recorded by all threads.Must be called after recording finishes and before ForEach/Save.Thread unsafe
+			void Merge();
+			//Calls func(const CommandHeader& header, const void* payload) for every command in merged order
+			template<typename Function>
+			void ForEach(Function func)const
+			{
+				for (const auto& span : mSpans)
+				{
+					auto command = span.begin;
+					while (command < span.end)
+					{
+						const auto& header = *reinterpret_cast<const CommandHeader*>(command);
+						func(header, static_cast<const void*>(command + sizeof(CommandHeader)));
+						command += sizeof(CommandHeader) + header.size;
+					}
+				}
+			}
+			//Discards all commands.Should be called before recording a new frame.Thread unsafe
+			void Reset();
+			//Number of commands in merged order
+			std::size_t GetCommandCount()const { return mCommandCount; }
+			//Bytes of all merged commands including headers
+			std::size_t GetSize()const { return mSize; }
+			//Writes merged commands to stream.Payloads are saved byte by byte,so pointers saved in them are meaningless
+			//in another process and a loaded buffer referencing resources can only be replayed by a backend that ignores them.
+			bool Save(std::ostream& stream)const;
+			//Replaces all commands with the ones saved by Save.The loaded commands are ready for ForEach
+			bool Load(std::istream& stream);
+		private:
+			struct Span
+			{
+				const std::uint8_t* begin;
+				const std::uint8_t* end;
+			};
+			struct Segment
+			{
+				std::uint64_t key;
+				//index of the first span of the segment in Stream::spans,the segment ends at the first span of the next one
+				std::size_t firstSpan;
+			};
+			//Commands recorded by a thread.A segment is split into several spans when it doesn't fit in a chunk
+			struct Stream
+			{
+				std::uint8_t* chunk{ nullptr };
+				std::size_t used{ 0 };
+				std::size_t capacity{ 0 };
+				std::size_t commandCount{ 0 };
+				std::vector<Span> spans;
+				std::vector<Segment> segments;
+			};
+			void AllocateChunk(Stream& stream, std::size_t size);
+			FrameMemoryAllocator& mAllocator;
+			Foundation::ThreadLocalObject<Stream> mStreams;
+			//commands in replay order
+			std::vector<Span> mSpans;
+			std::size_t mCommandCount;
+			std::size_t mSize;
+			//storage of commands read by Load
+			std::vector<std::uint8_t> mLoadedCommands;
+		};
+	}
+}
@@ -0,0 +1,193 @@
+#include <cassert>
+#include <cstring>
+#include "RenderCommands.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		RenderCommandRecorder::RenderCommandRecorder(CommandBuffer& commandBuffer) : mCommandBuffer(commandBuffer)
+		{
+
+		}
+
+		void RenderCommandRecorder::ClearRenderTarget(IRenderTarget* renderTarget, const ColorF& color, const RectI* rects, std::size_t rectCount)
+		{
+			auto command = mCommandBuffer.Write<ClearRenderTargetCommand>(sizeof(RectI) * rectCount);
+			command->renderTarget = renderTarget;
+			command->color = color;
+			command->rectCount = static_cast<std::uint32_t>(rectCount);
+			if (rectCount > 0)
+			{
+				std::memcpy(GetCommandArray<RectI>(command), rects, sizeof(RectI) * rectCount);
+			}
+		}
+
+		void RenderCommandRecorder::ClearDepthStencilBuffer(IDepthStencilBuffer* buffer, DepthStencilClearFlags flags, float depth, std::uint8_t stencil,
+			const RectI* rects, std::size_t rectCount)
+		{
+			auto command = mCommandBuffer.Write<ClearDepthStencilBufferCommand>(sizeof(RectI) * rectCount);
+			command->buffer = buffer;
+			command->depth = depth;
+			command->flags = flags;
+			command->stencil = stencil;
+			command->rectCount = static_cast<std::uint32_t>(rectCount);
+			if (rectCount > 0)
+			{
+				std::memcpy(GetCommandArray<RectI>(command), rects, sizeof(RectI) * rectCount);
+			}
+		}
+
+		void RenderCommandRecorder::ApplyRenderTargets(const IRenderTarget*const * renderTargets, std::size_t renderTargetCount, IDepthStencilBuffer* dsBuffer)
+		{
+			auto command = mCommandBuffer.Write<ApplyRenderTargetsCommand>(sizeof(const IRenderTarget*) * renderTargetCount);
+			command->depthStencilBuffer = dsBuffer;
+			command->renderTargetCount = renderTargetCount;
+			if (renderTargetCount > 0)
+			{
+				std::memcpy(GetCommandArray<const IRenderTarget*>(command), renderTargets, sizeof(const IRenderTarget*) * renderTargetCount);
+			}
+		}
+
+		void RenderCommandRecorder::ApplyPipelineState(const PipelineState* state)
+		{
+			mCommandBuffer.Write<ApplyPipelineStateCommand>()->state = state;
+		}
+
+		void RenderCommandRecorder::ApplyViewports(const Viewport* viewports, std::size_t viewportCount)
+		{
+			auto command = mCommandBuffer.Write<ApplyViewportsCommand>(sizeof(Viewport) * viewportCount);
+			command->viewportCount = static_cast<std::uint32_t>(viewportCount);
+			if (viewportCount > 0)
+			{
+				std::memcpy(GetCommandArray<Viewport>(command), viewports, sizeof(Viewport) * viewportCount);
+			}
+		}
+
+		void RenderCommandRecorder::ApplyScissorRects(const ScissorRect* scissorRects, std::size_t scissorRectCount)
+		{
+			auto command = mCommandBuffer.Write<ApplyScissorRectsCommand>(sizeof(ScissorRect) * scissorRectCount);
+			command->scissorRectCount = scissorRectCount;
+			if (scissorRectCount > 0)
+			{
+				std::memcpy(GetCommandArray<ScissorRect>(command), scissorRects, sizeof(ScissorRect) * scissorRectCount);
+			}
+		}
+
+		void RenderCommandRecorder::BindVertexBuffer(std::size_t slot, IVertexBuffer* buffer)
+		{
+			auto command = mCommandBuffer.Write<BindVertexBufferCommand>();
+			command->buffer = buffer;
+			command->slot = slot;
+		}
+
+		void RenderCommandRecorder::BindIndexBuffer(IIndexBuffer* buffer)
+		{
+			mCommandBuffer.Write<BindIndexBufferCommand>()->buffer = buffer;
+		}
+
+		void RenderCommandRecorder::SetShaderParameter(IShader* shader, const ShaderParameterBinding& binding, const void* data)
+		{
+			auto command = mCommandBuffer.Write<SetShaderParameterCommand>(binding.size);
+			command->shader = shader;
+			command->binding = binding;
+			if (binding.size > 0)
+			{
+				std::memcpy(GetCommandArray<std::uint8_t>(command), data, binding.size);
+				command->data = nullptr;
+			}
+			else
+			{
+				command->data = data;
+			}
+		}
+
+		void RenderCommandRecorder::Draw(const DrawParam& param)
+		{
+			mCommandBuffer.Write<DrawCallCommand>()->param = param;
+		}
+
+		void ReplayRenderCommands(const CommandBuffer& commandBuffer, IRenderer& renderer)
+		{
+			//draws are skipped while their pipeline state is compiling in background
+			bool pipelineStateReady{ true };
+			commandBuffer.ForEach([&renderer, &pipelineStateReady](const CommandHeader& header, const void* payload) {
+				switch (static_cast<RenderCommandType>(header.type))
+				{
+				case RenderCommandType::CLEAR_RENDER_TARGET:
+				{
+					auto command = static_cast<const ClearRenderTargetCommand*>(payload);
+					renderer.ClearRenderTarget(command->renderTarget, command->color,
+						command->rectCount > 0 ? GetCommandArray<RectI>(command) : nullptr, command->rectCount);
+					break;
+				}
+				case RenderCommandType::CLEAR_DEPTH_STENCIL_BUFFER:
+				{
+					auto command = static_cast<const ClearDepthStencilBufferCommand*>(payload);
+					renderer.ClearDepthStencilBuffer(command->buffer, command->flags, command->depth, command->stencil,
+						command->rectCount > 0 ? GetCommandArray<RectI>(command) : nullptr, command->rectCount);
+					break;
+				}
+				case RenderCommandType::APPLY_RENDER_TARGETS:
+				{
+					auto command = static_cast<const ApplyRenderTargetsCommand*>(payload);
+					renderer.ApplyRenderTargets(GetCommandArray<const IRenderTarget*>(command),
+						static_cast<std::size_t>(command->renderTargetCount), command->depthStencilBuffer);
+					break;
+				}
+				case RenderCommandType::APPLY_PIPELINE_STATE:
+				{
+					auto command = static_cast<const ApplyPipelineStateCommand*>(payload);
+					pipelineStateReady = renderer.ApplyPipelineState(*command->state);
+					break;
+				}
+				case RenderCommandType::APPLY_VIEWPORTS:
+				{
+					auto command = static_cast<const ApplyViewportsCommand*>(payload);
+					renderer.ApplyViewports(GetCommandArray<Viewport>(command), command->viewportCount);
+					break;
+				}
+				case RenderCommandType::APPLY_SCISSOR_RECTS:
+				{
+					auto command = static_cast<const ApplyScissorRectsCommand*>(payload);
+					renderer.ApplyScissorRects(GetCommandArray<ScissorRect>(command), static_cast<std::size_t>(command->scissorRectCount));
+					break;
+				}
+				case RenderCommandType::BIND_VERTEX_BUFFER:
+				{
+					auto command = static_cast<const BindVertexBufferCommand*>(payload);
+					command->buffer->Commit();
+					renderer.BindVertexBuffer(static_cast<std::size_t>(command->slot), command->buffer);
+					break;
+				}
+				case RenderCommandType::BIND_INDEX_BUFFER:
+				{
+					auto command = static_cast<const BindIndexBufferCommand*>(payload);
+					command->buffer->Commit();
+					renderer.BindIndexBuffer(command->buffer);
+					break;
+				}
+				case RenderCommandType::SET_SHADER_PARAMETER:
+				{
+					auto command = static_cast<const SetShaderParameterCommand*>(payload);
+					auto data = command->data ? command->data : GetCommandArray<std::uint8_t>(command);
+					command->shader->SetParameter(command->binding, data);
+					break;
+				}
+				case RenderCommandType::DRAW:
+				{
+					auto command = static_cast<const DrawCallCommand*>(payload);
+					if (pipelineStateReady)
+					{
+						renderer.Draw(command->param);
+					}
+					break;
+				}
+				default:
+					assert(false && "Unknown render command!");
+					break;
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "IRenderer.h"
+#include "CommandBuffer.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		enum class RenderCommandType : std::uint32_t
+		{
+			CLEAR_RENDER_TARGET,
+			CLEAR_DEPTH_STENCIL_BUFFER,
+			APPLY_RENDER_TARGETS,
+			APPLY_PIPELINE_STATE,
+			APPLY_VIEWPORTS,
+			APPLY_SCISSOR_RECTS,
+			BIND_VERTEX_BUFFER,
+			BIND_INDEX_BUFFER,
+			SET_SHADER_PARAMETER,
+			DRAW
+		};
+
+		//Payloads of render commands,each one maps to an IRenderer call.Arrays are stored right after the struct.
+		//Resources are referenced by pointer,the recorder must keep them alive until the command buffer is replayed.
+		struct ClearRenderTargetCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::CLEAR_RENDER_TARGET;
+			IRenderTarget* renderTarget;
+			ColorF color;
+			std::uint32_t rectCount;	//followed by RectI[rectCount]
+		};
+
+		struct ClearDepthStencilBufferCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::CLEAR_DEPTH_STENCIL_BUFFER;
+			IDepthStencilBuffer* buffer;
+			float depth;
+			DepthStencilClearFlags flags;
+			std::uint8_t stencil;
+			std::uint32_t rectCount;	//followed by RectI[rectCount]
+		};
+
+		struct ApplyRenderTargetsCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::APPLY_RENDER_TARGETS;
+			IDepthStencilBuffer* depthStencilBuffer;
+			std::uint64_t renderTargetCount;	//followed by const IRenderTarget*[renderTargetCount]
+		};
+
+		struct ApplyPipelineStateCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::APPLY_PIPELINE_STATE;
+			//PipelineState holds shared pointers and vectors,so only its address is recorded
+			const PipelineState* state;
+		};
+
+		struct ApplyViewportsCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::APPLY_VIEWPORTS;
+			std::uint32_t viewportCount;	//followed by Viewport[viewportCount]
+		};
+
+		struct ApplyScissorRectsCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::APPLY_SCISSOR_RECTS;
+			std::uint64_t scissorRectCount;	//followed by ScissorRect[scissorRectCount]
+		};
+
+		//The buffer is committed right before it is bound
+		struct BindVertexBufferCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::BIND_VERTEX_BUFFER;
+			IVertexBuffer* buffer;
+			std::uint64_t slot;
+		};
+
+		//The buffer is committed right before it is bound
+		struct BindIndexBufferCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::BIND_INDEX_BUFFER;
+			IIndexBuffer* buffer;
+		};
+
+		//Constants(binding.size > 0) are copied after the struct and data is nullptr,
+		//textures and samplers are referenced by data
+		struct SetShaderParameterCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::SET_SHADER_PARAMETER;
+			IShader* shader;
+			ShaderParameterBinding binding;
+			const void* data;
+		};
+
+		struct DrawCallCommand
+		{
+			static constexpr RenderCommandType TYPE = RenderCommandType::DRAW;
+			DrawParam param;
+		};
+
+		//Gets the array stored right after a command payload
+		template<typename Element, typename Command>
+		Element* GetCommandArray(Command* command)
+		{
+			static_assert(sizeof(Command) % alignof(Element) == 0, "Command array is misaligned.");
+			return reinterpret_cast<Element*>(command + 1);
+		}
+
+		template<typename Element, typename Command>
+		const Element* GetCommandArray(const Command* command)
+		{
+			static_assert(sizeof(Command) % alignof(Element) == 0, "Command array is misaligned.");
+			return reinterpret_cast<const Element*>(command + 1);
+		}
+
+		//Records IRenderer calls into a command buffer instead of executing them.Methods have the same meanings as their
+		//IRenderer counterparts.Segments have to be started by CommandBuffer::Begin.Thread safe as CommandBuffer::Write is
+		class RenderCommandRecorder
+		{
+		public:
+			explicit RenderCommandRecorder(CommandBuffer& commandBuffer);
+			void ClearRenderTarget(IRenderTarget* renderTarget, const ColorF& color,
+				const RectI* rects = nullptr, std::size_t rectCount = 0);
+			void ClearDepthStencilBuffer(IDepthStencilBuffer* buffer, DepthStencilClearFlags flags, float depth, std::uint8_t stencil,
+				const RectI* rects = nullptr, std::size_t rectCount = 0);
+			void ApplyRenderTargets(const IRenderTarget*const * renderTargets, std::size_t renderTargetCount, IDepthStencilBuffer* dsBuffer);
+			//state must stay alive and unchanged until the command buffer is replayed
+			void ApplyPipelineState(const PipelineState* state);
+			void ApplyViewports(const Viewport* viewports, std::size_t viewportCount);
+			void ApplyScissorRects(const ScissorRect* scissorRects, std::size_t scissorRectCount);
+			void BindVertexBuffer(std::size_t slot, IVertexBuffer* buffer);
+			void BindIndexBuffer(IIndexBuffer* buffer);
+			void SetShaderParameter(IShader* shader, const ShaderParameterBinding& binding, const void* data);
+			void Draw(const DrawParam& param);
+		private:
+			CommandBuffer& mCommandBuffer;
+		};
+
+		//Executes merged commands of commandBuffer through renderer in order on calling thread
+		void ReplayRenderCommands(const CommandBuffer& commandBuffer, IRenderer& renderer);
+	}
+}
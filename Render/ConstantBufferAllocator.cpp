@@ -0,0 +1,85 @@
+#include <cassert>
+#include "ConstantBufferAllocator.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		ConstantBufferAllocator::ConstantBufferAllocator(std::uint8_t* mappedMemory, std::uint64_t gpuAddress, std::size_t size)
+			: mMappedMemory(mappedMemory)
+			, mGPUAddress(gpuAddress)
+			, mChunkCount(size / CONSTANT_BUFFER_CHUNK_SIZE)
+			, mChunkCursor(0)
+			, mReleasedCursor(0)
+			, mGeneration(1)
+			, mFrameMarkers(8)
+			, mFrameMarkerHead(0)
+			, mFrameMarkerCount(0)
+		{
+			assert(mappedMemory && mChunkCount > 0 && "Constant buffer region must hold at least one chunk!");
+			assert(gpuAddress % CONSTANT_BUFFER_ALIGNMENT == 0 && "Constant buffer region is not aligned!");
+		}
+
+		ConstantBufferAllocation ConstantBufferAllocator::Allocate(std::size_t size)
+		{
+			auto alignedSize = (size + CONSTANT_BUFFER_ALIGNMENT - 1) & ~(CONSTANT_BUFFER_ALIGNMENT - 1);
+			assert(alignedSize > 0 && alignedSize <= CONSTANT_BUFFER_CHUNK_SIZE && "Constant buffer size is out of range!");
+			auto& threadChunk = mThreadChunks.Local();
+			auto generation = mGeneration.load(std::memory_order_relaxed);
+			if (threadChunk.generation != generation || threadChunk.offset + alignedSize > CONSTANT_BUFFER_CHUNK_SIZE)
+			{
+				std::uint64_t chunk;
+				if (!AcquireChunk(chunk))
+				{
+					assert(false && "Constant buffer ring is out of memory!");
+					return ConstantBufferAllocation{ nullptr, 0, 0 };
+				}
+				threadChunk.chunk = chunk;
+				threadChunk.offset = 0;
+				threadChunk.generation = generation;
+			}
+			auto offset = static_cast<std::size_t>(threadChunk.chunk % mChunkCount) * CONSTANT_BUFFER_CHUNK_SIZE + threadChunk.offset;
+			threadChunk.offset += alignedSize;
+			return ConstantBufferAllocation{ mMappedMemory + offset, mGPUAddress + offset, alignedSize };
+		}
+
+		bool ConstantBufferAllocator::AcquireChunk(std::uint64_t& chunk)
+		{
+			chunk = mChunkCursor.load(std::memory_order_relaxed);
+			do
+			{
+				if (chunk - mReleasedCursor.load(std::memory_order_acquire) >= mChunkCount)
+					return false;
+			} while (!mChunkCursor.compare_exchange_weak(chunk, chunk + 1, std::memory_order_relaxed));
+			return true;
+		}
+
+		void ConstantBufferAllocator::FinishFrame(std::uint64_t frame)
+		{
+			if (mFrameMarkerCount == mFrameMarkers.size())
+			{
+				//unroll the queue into a larger one
+				std::vector<FrameMarker> frameMarkers(mFrameMarkers.size() * 2);
+				for (std::size_t i = 0;i < mFrameMarkerCount;++i)
+				{
+					frameMarkers[i] = mFrameMarkers[(mFrameMarkerHead + i) % mFrameMarkers.size()];
+				}
+				mFrameMarkers.swap(frameMarkers);
+				mFrameMarkerHead = 0;
+			}
+			mFrameMarkers[(mFrameMarkerHead + mFrameMarkerCount) % mFrameMarkers.size()] = FrameMarker{ frame, mChunkCursor.load() };
+			++mFrameMarkerCount;
+			mGeneration.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void ConstantBufferAllocator::ReleaseFramesBefore(std::uint64_t frame)
+		{
+			while (mFrameMarkerCount > 0 && mFrameMarkers[mFrameMarkerHead].frame <= frame)
+			{
+				mReleasedCursor.store(mFrameMarkers[mFrameMarkerHead].chunkCursor, std::memory_order_release);
+				mFrameMarkerHead = (mFrameMarkerHead + 1) % mFrameMarkers.size();
+				--mFrameMarkerCount;
+			}
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ThreadLocalObject.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		//Placement alignment of constant buffers(the constant buffer alignment of D3D12)
+		constexpr std::size_t CONSTANT_BUFFER_ALIGNMENT = 256;
+		//Unit of memory a thread takes from the ring at a time.It's also the size limit of a single constant buffer
+		constexpr std::size_t CONSTANT_BUFFER_CHUNK_SIZE = 64 * 1024;
+
+		struct ConstantBufferAllocation
+		{
+			//nullptr if the ring is out of memory
+			std::uint8_t* cpuAddress;
+			std::uint64_t gpuAddress;
+			std::size_t size;
+		};
+
+		//Suballocates per frame constant buffers from one persistently mapped region supplied by the backend.The region is a
+		//ring of chunks.Each thread takes a whole chunk with a lock free compare and swap and bump allocates constant buffers
+		//inside it,so threads never contend on single allocations.Chunks of a frame are reclaimed after the GPU finishes
+		//the frame.No memory is allocated after threads take their first chunk.
+		//Allocate is thread safe.FinishFrame must not run simultaneously with Allocate
+		class ConstantBufferAllocator
+		{
+		public:
+			//mappedMemory is the CPU address of a region of size bytes whose GPU address is gpuAddress
+			ConstantBufferAllocator(std::uint8_t* mappedMemory, std::uint64_t gpuAddress, std::size_t size);
+			ConstantBufferAllocator(const ConstantBufferAllocator&) = delete;
+			ConstantBufferAllocator& operator=(const ConstantBufferAllocator&) = delete;
+			//size is rounded up to CONSTANT_BUFFER_ALIGNMENT and can't exceed CONSTANT_BUFFER_CHUNK_SIZE
+			ConstantBufferAllocation Allocate(std::size_t size);
+			//Marks the end of frame.Memory allocated before is reclaimed by ReleaseFramesBefore(frame)
+			void FinishFrame(std::uint64_t frame);
+			//Reclaims memory of frames up to frame.Call it after the GPU finishes frame.Can run simultaneously with Allocate
+			void ReleaseFramesBefore(std::uint64_t frame);
+			std::size_t GetChunkCount()const { return mChunkCount; }
+			//Number of chunks taken and not reclaimed yet
+			std::size_t GetUsedChunkCount()const { return static_cast<std::size_t>(mChunkCursor - mReleasedCursor); }
+		private:
+			struct ThreadChunk
+			{
+				std::uint64_t chunk{ 0 };
+				std::size_t offset{ CONSTANT_BUFFER_CHUNK_SIZE };
+				std::uint64_t generation{ 0 };
+			};
+			struct FrameMarker
+			{
+				std::uint64_t frame;
+				//chunks taken before this value belong to the frame or earlier ones
+				std::uint64_t chunkCursor;
+			};
+			bool AcquireChunk(std::uint64_t& chunk);
+			std::uint8_t* mMappedMemory;
+			std::uint64_t mGPUAddress;
+			std::size_t mChunkCount;
+			//monotonic counters of taken and reclaimed chunks,the chunk index is the counter modulo mChunkCount
+			std::atomic<std::uint64_t> mChunkCursor;
+			std::atomic<std::uint64_t> mReleasedCursor;
+			//threads holding a chunk of an older generation take a new one
+			std::atomic<std::uint64_t> mGeneration;
+			Foundation::ThreadLocalObject<ThreadChunk> mThreadChunks;
+			//circular queue of unreleased frames,it only grows when more frames are in flight than ever before
+			std::vector<FrameMarker> mFrameMarkers;
+			std::size_t mFrameMarkerHead;
+			std::size_t mFrameMarkerCount;
+		};
+	}
+}
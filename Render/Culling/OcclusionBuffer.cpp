@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "tbb/parallel_for.h"
+#include "SIMD.h"
+#include "OcclusionBuffer.h"
+
+namespace
+{
+	//vertices whose clip w is below this are considered behind the camera
+	constexpr float MIN_CLIP_W = 1e-4f;
+
+	std::size_t RoundUp(std::size_t value, std::size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using Foundation::Math::Vector3f;
+
+		OcclusionBuffer::OcclusionBuffer(std::size_t width, std::size_t height)
+			: mWidth(RoundUp(std::max<std::size_t>(width, 1), TILE_SIZE))
+			, mHeight(RoundUp(std::max<std::size_t>(height, 1), TILE_SIZE))
+			, mTileCountX(mWidth / TILE_SIZE)
+			, mTileCountY(mHeight / TILE_SIZE)
+			, mBlockCountX(mWidth / BLOCK_SIZE)
+			, mBlockCountY(mHeight / BLOCK_SIZE)
+			, mDepth(mWidth * mHeight, 1.0f)
+			, mBlockDepth(mBlockCountX * mBlockCountY, 1.0f)
+			, mTileBins(mTileCountX * mTileCountY)
+		{
+			mViewProjection.SetIdentity();
+		}
+
+		void OcclusionBuffer::Begin(const Matrix4f& viewProjection)
+		{
+			mViewProjection = viewProjection;
+			mTriangles.clear();
+			for (auto& bin : mTileBins)
+			{
+				bin.clear();
+			}
+		}
+
+		void OcclusionBuffer::AddOccluder(const OccluderGeometry& geometry, const Matrix4f& worldMatrix)
+		{
+			if (!geometry.positions || !geometry.indices || geometry.vertexCount == 0)
+				return;
+			const auto matrix = worldMatrix * mViewProjection;
+			mClipPositions.resize(geometry.vertexCount);
+			auto positions = static_cast<const std::uint8_t*>(geometry.positions);
+			for (std::size_t i = 0;i < geometry.vertexCount;++i)
+			{
+				const auto& position = *reinterpret_cast<const Vector3f*>(positions + i * geometry.stride);
+				mClipPositions[i] = Vector4f{ position.x, position.y, position.z, 1.0f } * matrix;
+			}
+			const auto width = static_cast<float>(mWidth);
+			const auto height = static_cast<float>(mHeight);
+			for (std::size_t i = 0;i + 2 < geometry.indexCount;i += 3)
+			{
+				ScreenTriangle triangle;
+				bool clipped{ false };
+				for (std::size_t k = 0;k < 3;++k)
+				{
+					auto index = geometry.indices[i + k];
+					if (index >= geometry.vertexCount)
+					{
+						clipped = true;
+						break;
+					}
+					const auto& clip = mClipPositions[index];
+					//No near plane clipping.Triangles crossing the camera plane are dropped,
+					//which only makes occlusion less aggressive.
+					if (clip.w < MIN_CLIP_W)
+					{
+						clipped = true;
+						break;
+					}
+					auto invW = 1.0f / clip.w;
+					triangle.x[k] = (clip.x * invW * 0.5f + 0.5f) * width;
+					triangle.y[k] = (0.5f - clip.y * invW * 0.5f) * height;
+					triangle.z[k] = std::max(clip.z * invW, 0.0f);
+				}
+				if (clipped)
+					continue;
+				auto area = (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]) -
+					(triangle.y[2] - triangle.y[0]) * (triangle.x[1] - triangle.x[0]);
+				if (std::abs(area) < 1e-6f)
+					continue;
+				//Occluders are rasterized regardless of facing
+				if (area < 0)
+				{
+					std::swap(triangle.x[1], triangle.x[2]);
+					std::swap(triangle.y[1], triangle.y[2]);
+					std::swap(triangle.z[1], triangle.z[2]);
+				}
+				auto minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+				auto maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+				auto minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+				auto maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+				if (maxX < 0 || maxY < 0 || minX >= width || minY >= height)
+					continue;
+				if (std::min({ triangle.z[0], triangle.z[1], triangle.z[2] }) > 1.0f)
+					continue;
+				auto tileX0 = static_cast<std::size_t>(std::max(minX, 0.0f)) / TILE_SIZE;
+				auto tileY0 = static_cast<std::size_t>(std::max(minY, 0.0f)) / TILE_SIZE;
+				auto tileX1 = std::min(static_cast<std::size_t>(maxX) / TILE_SIZE, mTileCountX - 1);
+				auto tileY1 = std::min(static_cast<std::size_t>(maxY) / TILE_SIZE, mTileCountY - 1);
+				auto triangleIndex = static_cast<std::uint32_t>(mTriangles.size());
+				mTriangles.push_back(triangle);
+				for (auto tileY = tileY0;tileY <= tileY1;++tileY)
+				{
+					for (auto tileX = tileX0;tileX <= tileX1;++tileX)
+					{
+						mTileBins[tileY * mTileCountX + tileX].push_back(triangleIndex);
+					}
+				}
+			}
+		}
+
+		void OcclusionBuffer::Rasterize()
+		{
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mTileBins.size()),
+				[this](const tbb::blocked_range<std::size_t>& range) {
+				for (auto tileIndex = range.begin();tileIndex != range.end();++tileIndex)
+				{
+					RasterizeTile(tileIndex);
+				}
+			});
+		}
+
+		void OcclusionBuffer::RasterizeTile(std::size_t tileIndex)
+		{
+			const auto tileX = tileIndex % mTileCountX;
+			const auto tileY = tileIndex / mTileCountX;
+			const auto x0 = tileX * TILE_SIZE;
+			const auto y0 = tileY * TILE_SIZE;
+			for (auto y = y0;y < y0 + TILE_SIZE;++y)
+			{
+				std::fill_n(mDepth.begin() + y * mWidth + x0, TILE_SIZE, 1.0f);
+			}
+			for (auto triangleIndex : mTileBins[tileIndex])
+			{
+				RasterizeTriangle(mTriangles[triangleIndex], x0, y0, x0 + TILE_SIZE, y0 + TILE_SIZE);
+			}
+			//build max depth of the blocks inside this tile
+			for (auto blockY = y0 / BLOCK_SIZE;blockY < (y0 + TILE_SIZE) / BLOCK_SIZE;++blockY)
+			{
+				for (auto blockX = x0 / BLOCK_SIZE;blockX < (x0 + TILE_SIZE) / BLOCK_SIZE;++blockX)
+				{
+					float maxDepth{ 0.0f };
+					for (auto y = blockY * BLOCK_SIZE;y < (blockY + 1) * BLOCK_SIZE;++y)
+					{
+						auto row = mDepth.data() + y * mWidth + blockX * BLOCK_SIZE;
+						maxDepth = std::max(maxDepth, *std::max_element(row, row + BLOCK_SIZE));
+					}
+					mBlockDepth[blockY * mBlockCountX + blockX] = maxDepth;
+				}
+			}
+		}
+
+		void OcclusionBuffer::RasterizeTriangle(const ScreenTriangle& triangle,
+			std::size_t minX, std::size_t minY, std::size_t maxX, std::size_t maxY)
+		{
+			const auto& tx = triangle.x;
+			const auto& ty = triangle.y;
+			//clip triangle bounds against the tile
+			auto x0 = std::max(minX, static_cast<std::size_t>(std::max(std::min({ tx[0], tx[1], tx[2] }), 0.0f)));
+			auto y0 = std::max(minY, static_cast<std::size_t>(std::max(std::min({ ty[0], ty[1], ty[2] }), 0.0f)));
+			auto x1 = std::min(maxX, static_cast<std::size_t>(std::max({ tx[0], tx[1], tx[2] })) + 1);
+			auto y1 = std::min(maxY, static_cast<std::size_t>(std::max({ ty[0], ty[1], ty[2] })) + 1);
+			if (x0 >= x1 || y0 >= y1)
+				return;
+			//Edge function of edge(a, b) is E(p) = (p.x - a.x) * (b.y - a.y) - (p.y - a.y) * (b.x - a.x),
+			//edge k is opposite to vertex k so that E_k / area is the barycentric weight of vertex k.
+			float stepX[3], stepY[3], origin[3];
+			for (std::size_t k = 0;k < 3;++k)
+			{
+				auto a = (k + 1) % 3;
+				auto b = (k + 2) % 3;
+				stepX[k] = ty[b] - ty[a];
+				stepY[k] = tx[a] - tx[b];
+				origin[k] = -tx[a] * stepX[k] - ty[a] * stepY[k];
+			}
+			auto area = origin[0] + tx[0] * stepX[0] + ty[0] * stepY[0];
+			auto invArea = 1.0f / area;
+			//depth is linear in screen space
+			float depthStepX{ 0.0f }, depthStepY{ 0.0f }, depthOrigin{ 0.0f };
+			for (std::size_t k = 0;k < 3;++k)
+			{
+				depthStepX += triangle.z[k] * stepX[k] * invArea;
+				depthStepY += triangle.z[k] * stepY[k] * invArea;
+				depthOrigin += triangle.z[k] * origin[k] * invArea;
+			}
+#if defined(LIGHTNING_SIMD_SSE)
+			//tiles are aligned to 4 pixels so widening the span never leaves the tile
+			x0 &= ~std::size_t(3);
+			x1 = RoundUp(x1, 4);
+			const auto laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const auto zero = _mm_setzero_ps();
+			__m128 edgeStepX[3];
+			for (std::size_t k = 0;k < 3;++k)
+			{
+				edgeStepX[k] = _mm_set1_ps(stepX[k] * 4.0f);
+			}
+			const auto depthStep = _mm_set1_ps(depthStepX * 4.0f);
+			for (auto y = y0;y < y1;++y)
+			{
+				auto py = static_cast<float>(y) + 0.5f;
+				auto px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x0)), laneOffsets);
+				__m128 edges[3];
+				for (std::size_t k = 0;k < 3;++k)
+				{
+					edges[k] = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(stepX[k])), _mm_set1_ps(origin[k] + py * stepY[k]));
+				}
+				auto depth = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(depthStepX)), _mm_set1_ps(depthOrigin + py * depthStepY));
+				auto row = mDepth.data() + y * mWidth;
+				for (auto x = x0;x < x1;x += 4)
+				{
+					auto inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edges[0], zero), _mm_cmpge_ps(edges[1], zero)),
+						_mm_cmpge_ps(edges[2], zero));
+					if (_mm_movemask_ps(inside))
+					{
+						auto current = _mm_loadu_ps(row + x);
+						auto nearer = _mm_min_ps(current, depth);
+						_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+					}
+					for (std::size_t k = 0;k < 3;++k)
+					{
+						edges[k] = _mm_add_ps(edges[k], edgeStepX[k]);
+					}
+					depth = _mm_add_ps(depth, depthStep);
+				}
+			}
+#else
+			for (auto y = y0;y < y1;++y)
+			{
+				auto py = static_cast<float>(y) + 0.5f;
+				auto px = static_cast<float>(x0) + 0.5f;
+				float edges[3];
+				for (std::size_t k = 0;k < 3;++k)
+				{
+					edges[k] = origin[k] + px * stepX[k] + py * stepY[k];
+				}
+				auto depth = depthOrigin + px * depthStepX + py * depthStepY;
+				auto row = mDepth.data() + y * mWidth;
+				for (auto x = x0;x < x1;++x)
+				{
+					if (edges[0] >= 0 && edges[1] >= 0 && edges[2] >= 0)
+					{
+						row[x] = std::min(row[x], depth);
+					}
+					for (std::size_t k = 0;k < 3;++k)
+					{
+						edges[k] += stepX[k];
+					}
+					depth += depthStepX;
+				}
+			}
+#endif
+		}
+
+		bool OcclusionBuffer::IsVisible(const AABBf& box)const
+		{
+			if (box.IsEmpty())
+				return false;
+			if (box.IsInfinite())
+				return true;
+			const auto width = static_cast<float>(mWidth);
+			const auto height = static_cast<float>(mHeight);
+			auto minX = width, minY = height, maxX = 0.0f, maxY = 0.0f, minZ = 1.0f;
+			for (unsigned i = 0;i < 8;++i)
+			{
+				Vector4f corner{ i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z, 1.0f };
+				auto clip = corner * mViewProjection;
+				//the box crosses the camera plane,it can't be hidden
+				if (clip.w < MIN_CLIP_W)
+					return true;
+				auto invW = 1.0f / clip.w;
+				auto x = (clip.x * invW * 0.5f + 0.5f) * width;
+				auto y = (0.5f - clip.y * invW * 0.5f) * height;
+				minX = std::min(minX, x);
+				maxX = std::max(maxX, x);
+				minY = std::min(minY, y);
+				maxY = std::max(maxY, y);
+				minZ = std::min(minZ, clip.z * invW);
+			}
+			//Not on screen.That is frustum culling's business,so don't reject it here.
+			if (maxX < 0 || maxY < 0 || minX >= width || minY >= height)
+				return true;
+			auto blockX0 = static_cast<std::size_t>(std::max(minX, 0.0f)) / BLOCK_SIZE;
+			auto blockY0 = static_cast<std::size_t>(std::max(minY, 0.0f)) / BLOCK_SIZE;
+			auto blockX1 = std::min(static_cast<std::size_t>(std::min(maxX, width - 1)) / BLOCK_SIZE, mBlockCountX - 1);
+			auto blockY1 = std::min(static_cast<std::size_t>(std::min(maxY, height - 1)) / BLOCK_SIZE, mBlockCountY - 1);
+			for (auto blockY = blockY0;blockY <= blockY1;++blockY)
+			{
+				for (auto blockX = blockX0;blockX <= blockX1;++blockX)
+				{
+					if (mBlockDepth[blockY * mBlockCountX + blockX] >= minZ)
+						return true;
+				}
+			}
+			return false;
+		}
+
+		bool OcclusionBuffer::SaveDepthImage(const std::string& path)const
+		{
+			std::ofstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+			//Perspective depth is packed near 1,so normalize between the nearest depth and the far plane to make it readable
+			auto nearest = *std::min_element(mDepth.begin(), mDepth.end());
+			auto range = 1.0f - nearest;
+			std::vector<std::uint8_t> pixels(mDepth.size());
+			for (std::size_t i = 0;i < mDepth.size();++i)
+			{
+				auto normalized = range > 0 ? (1.0f - mDepth[i]) / range : 0.0f;
+				pixels[i] = static_cast<std::uint8_t>(std::min(std::max(normalized, 0.0f), 1.0f) * 255.0f);
+			}
+			file << "P5\n" << mWidth << " " << mHeight << "\n255\n";
+			file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+			return static_cast<bool>(file);
+		}
+	}
+}
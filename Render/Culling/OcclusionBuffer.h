@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "AABB.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using Foundation::Math::Matrix4f;
+		using Foundation::Math::Vector4f;
+		using Foundation::Math::AABBf;
+
+		//CPU side geometry used to rasterize the occlusion buffer.positions is a strided array of Vector3f.
+		struct OccluderGeometry
+		{
+			const void* positions;
+			std::size_t vertexCount;
+			std::size_t stride;
+			const std::uint16_t* indices;
+			std::size_t indexCount;
+		};
+
+		//Low resolution software depth buffer used for occlusion culling.Depth follows D3D convention(0 is near,1 is far).
+		//Occluder triangles are binned into tiles that are rasterized in parallel.Each tile then records the max depth of
+		//its blocks(a one level hierarchical z) and occludees are rejected only if every block they cover is nearer than them.
+		class OcclusionBuffer
+		{
+		public:
+			static constexpr std::size_t TILE_SIZE = 32;
+			static constexpr std::size_t BLOCK_SIZE = 8;
+			//width and height are rounded up to multiples of TILE_SIZE
+			OcclusionBuffer(std::size_t width = 256, std::size_t height = 128);
+			//Clears depth and binned occluders and sets up the camera.Thread unsafe
+			void Begin(const Matrix4f& viewProjection);
+			//Transforms an occluder to screen space and bins its triangles.Thread unsafe
+			void AddOccluder(const OccluderGeometry& geometry, const Matrix4f& worldMatrix);
+			//Rasterizes binned triangles tile by tile in parallel and builds block depth
+			void Rasterize();
+			//Returns false only if the box is completely hidden by occluders.Thread safe after Rasterize
+			bool IsVisible(const AABBf& box)const;
+			float GetDepth(std::size_t x, std::size_t y)const { return mDepth[y * mWidth + x]; }
+			float GetBlockDepth(std::size_t blockX, std::size_t blockY)const { return mBlockDepth[blockY * mBlockCountX + blockX]; }
+			std::size_t GetWidth()const { return mWidth; }
+			std::size_t GetHeight()const { return mHeight; }
+			std::size_t GetTriangleCount()const { return mTriangles.size(); }
+			//Dumps depth to a binary PGM image for debugging,nearer pixels are brighter
+			bool SaveDepthImage(const std::string& path)const;
+		private:
+			struct ScreenTriangle
+			{
+				float x[3];
+				float y[3];
+				float z[3];
+			};
+			void RasterizeTile(std::size_t tileIndex);
+			void RasterizeTriangle(const ScreenTriangle& triangle,
+				std::size_t minX, std::size_t minY, std::size_t maxX, std::size_t maxY);
+			std::size_t mWidth;
+			std::size_t mHeight;
+			std::size_t mTileCountX;
+			std::size_t mTileCountY;
+			std::size_t mBlockCountX;
+			std::size_t mBlockCountY;
+			Matrix4f mViewProjection;
+			std::vector<float> mDepth;
+			//max depth of each BLOCK_SIZE x BLOCK_SIZE block
+			std::vector<float> mBlockDepth;
+			std::vector<ScreenTriangle> mTriangles;
+			//triangle indices overlapping each tile
+			std::vector<std::vector<std::uint32_t>> mTileBins;
+			std::vector<Vector4f> mClipPositions;
+		};
+	}
+}
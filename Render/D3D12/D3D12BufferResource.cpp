@@ -65,5 +65,19 @@ namespace Lightning
 			mResource->TransitTo(commandList, bufferState);
 			mDirtyRange.Begin = mDirtyRange.End = 0;
 		}
+
+		void D3D12BufferResource::CopyFrom(ID3D12GraphicsCommandList* commandList, ID3D12Resource* source, std::size_t sourceOffset, 
+			std::size_t offset, std::size_t size)
+		{
+			assert(offset + size <= mSize && "Copy is out of buffer range!");
+			auto bufferState = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+			if(mBufferType == GPUBufferType::INDEX)
+				bufferState = D3D12_RESOURCE_STATE_INDEX_BUFFER;
+			mResource->TransitTo(commandList, D3D12_RESOURCE_STATE_COPY_DEST);
+			commandList->CopyBufferRegion(mResource->GetResource(), offset, source, sourceOffset, size);
+			mResource->TransitTo(commandList, bufferState);
+			//the intermediate resource is never written,don't let Commit overwrite the copied data with it
+			mDirtyRange.Begin = mDirtyRange.End = 0;
+		}
 	}
 }
@@ -21,6 +21,10 @@ namespace Lightning
 			std::uint8_t* Lock(std::size_t start, std::size_t size);
 			void Unlock(std::size_t start, std::size_t size);
 			void Commit();
+			//Records a copy of size bytes at sourceOffset of source into the buffer at offset.The data bypasses the intermediate
+			//resource,so writes through Lock and through copies shouldn't be mixed on the same buffer
+			void CopyFrom(ID3D12GraphicsCommandList* commandList, ID3D12Resource* source, std::size_t sourceOffset, 
+				std::size_t offset, std::size_t size);
 			D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress()const { 
 				return mResource->GetResource()->GetGPUVirtualAddress();
 			}
@@ -2,6 +2,7 @@
 #include "D3D12ConstantBufferManager.h"
 #include "Renderer.h"
 #include "D3D12Device.h"
+#include "Logger.h"
 
 namespace Lightning
 {
@@ -18,78 +19,53 @@ namespace Lightning
 			Clear();
 		}
 
-		//Thread unsafe
-		void D3D12ConstantBufferManager::Clear()
+		void D3D12ConstantBufferManager::Initialize(D3D12Device* device)
 		{
-			for (std::size_t i = 0;i < RENDER_FRAME_COUNT;++i)
+			if (mAllocator)
+				return;
+			mResource = device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+				&CD3DX12_RESOURCE_DESC::Buffer(REGION_SIZE),
+				D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
+			if (!mResource)
 			{
-				mBufferResources[i].for_each([](std::vector<BufferResource>& bufferResources) {
-					bufferResources.clear();
-				});
+				LOG_ERROR("Failed to create constant buffer region!");
+				return;
 			}
+			static const CD3DX12_RANGE range(0, 0);
+			//map to process virtual memory on creation to prevent mapping every time change buffer content
+			void* mapAddress{ nullptr };
+			mResource->GetResource()->Map(0, &range, &mapAddress);
+			mAllocator = std::make_unique<ConstantBufferAllocator>(static_cast<std::uint8_t*>(mapAddress), 
+				mResource->GetResource()->GetGPUVirtualAddress(), REGION_SIZE);
 		}
 
-		D3D12ConstantBufferManager::BufferResource D3D12ConstantBufferManager::Reserve(std::size_t bufferSize)
+		//Thread unsafe
+		void D3D12ConstantBufferManager::Clear()
 		{
-			assert(bufferSize > 0 && "bufferSize must be a positive value!");
-			BufferResource bufferResource;
-			auto resourceSize = std::max(AlignedSize(bufferSize), MIN_BUFFER_SIZE);
-			D3D12Device* device = static_cast<D3D12Device*>(Renderer::Instance()->GetDevice());
-			bufferResource.resource = device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
-				&CD3DX12_RESOURCE_DESC::Buffer(resourceSize),
-				D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
-			static const CD3DX12_RANGE range(0, 0);
-			//map to process virtual memory on creation to prevent mapping every time change buffer content
-			bufferResource.resource->GetResource()->Map(0, &range, &bufferResource.mapAddress);
-			bufferResource.offset = 0;
-			bufferResource.size = resourceSize;
-			bufferResource.virtualAddress = bufferResource.resource->GetResource()->GetGPUVirtualAddress();
-			bufferResource.frameCount = Renderer::Instance()->GetCurrentFrameCount();
-			return bufferResource;
+			mAllocator.reset();
+			mResource.reset();
 		}
 
-		D3D12ConstantBuffer D3D12ConstantBufferManager::AllocBuffer(std::size_t bufferSize)
+		void D3D12ConstantBufferManager::FinishFrame(std::uint64_t frame)
 		{
-			auto resourceIndex = Renderer::Instance()->GetFrameResourceIndex();
-			auto frameCount = Renderer::Instance()->GetCurrentFrameCount();
-			auto& bufferResources = mBufferResources[resourceIndex];
-			auto& threadBufferResources = bufferResources.Local();
+			if (mAllocator)
+				mAllocator->FinishFrame(frame);
+		}
 
-			auto realSize = AlignedSize(bufferSize);
-			D3D12ConstantBuffer cbuffer;
-			cbuffer.size = realSize;
-			
-			if (threadBufferResources.empty() || threadBufferResources.back().frameCount != frameCount)
-			{
-				//It's another new frame,we need to merge buffers of previous frame
-				if (threadBufferResources.size() == 1 && threadBufferResources.back().size >= realSize)//Try to reuse buffers allocated on previous frame,if its size is big enough
-				{
-					auto& bufferResource = threadBufferResources.back();
-					bufferResource.frameCount = frameCount;
-					bufferResource.offset = 0;
-				}
-				else			//need to merge all buffers into one bigger buffer and make sure the merged buffer is big enough
-				{
-					std::size_t totalBufferSize{ 0 };
-					std::for_each(threadBufferResources.cbegin(), threadBufferResources.cend(), 
-						[&totalBufferSize](const BufferResource& bufferResource) {
-						totalBufferSize += bufferResource.size;
-					});
-					threadBufferResources.clear();
-					threadBufferResources.emplace_back(Reserve(std::max(totalBufferSize, realSize)));
-				}
-			}
-			auto offset = threadBufferResources.back().offset;
-			if (offset + realSize >= threadBufferResources.back().size)
-			{
-				threadBufferResources.emplace_back(Reserve(realSize));
-				offset = 0;
-			}
-			assert(offset + realSize < threadBufferResources.back().size);
-			cbuffer.userMemory = reinterpret_cast<std::uint8_t*>(threadBufferResources.back().mapAddress) + offset;
-			cbuffer.virtualAdress = threadBufferResources.back().virtualAddress + offset;
-			threadBufferResources.back().offset += realSize;
+		void D3D12ConstantBufferManager::ReleaseFramesBefore(std::uint64_t frame)
+		{
+			if (mAllocator)
+				mAllocator->ReleaseFramesBefore(frame);
+		}
 
+		D3D12ConstantBuffer D3D12ConstantBufferManager::AllocBuffer(std::size_t bufferSize)
+		{
+			assert(mAllocator && "D3D12ConstantBufferManager is not initialized!");
+			auto allocation = mAllocator->Allocate(bufferSize);
+			D3D12ConstantBuffer cbuffer;
+			cbuffer.userMemory = allocation.cpuAddress;
+			cbuffer.size = allocation.size;
+			cbuffer.virtualAdress = allocation.gpuAddress;
 			return cbuffer;
 		}
 	}
@@ -3,16 +3,18 @@
 #include <wrl/client.h>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 #include "Singleton.h"
 #include "RenderConstants.h"
 #include "D3D12StatefulResource.h"
-#include "ThreadLocalObject.h"
+#include "ConstantBufferAllocator.h"
 
 namespace Lightning
 {
 	namespace Render
 	{
 		using Microsoft::WRL::ComPtr;
+		class D3D12Device;
 		struct D3D12ConstantBuffer
 		{
 			std::uint8_t *userMemory;
@@ -24,9 +26,15 @@ namespace Lightning
 		{
 		public:
 			~D3D12ConstantBufferManager();
+			//Creates the persistently mapped region constant buffers are allocated from.Thread unsafe
+			void Initialize(D3D12Device* device);
 			//Thread safe
 			D3D12ConstantBuffer AllocBuffer(std::size_t bufferSize);
 			//Thread unsafe
+			void FinishFrame(std::uint64_t frame);
+			//Reclaims constant buffers of frames up to frame,which must be finished by the GPU
+			void ReleaseFramesBefore(std::uint64_t frame);
+			//Thread unsafe
 			void Clear();
 			static inline constexpr std::size_t AlignedSize(std::size_t size, std::size_t alignment = 256)
 			{
@@ -34,22 +42,11 @@ namespace Lightning
 			}
 		private:
 			friend class Foundation::Singleton<D3D12ConstantBufferManager>;
-			struct BufferResource
-			{
-				D3D12StatefulResourcePtr resource;
-				std::size_t offset;
-				std::size_t size;
-				void *mapAddress;
-				D3D12_GPU_VIRTUAL_ADDRESS virtualAddress;
-				std::uint64_t frameCount;
-			};
-			//Thread unsafe
-			BufferResource Reserve(std::size_t bufferSize);
 			D3D12ConstantBufferManager();
-			//BufferResource mBufferResources[RENDER_FRAME_COUNT];
-			Foundation::ThreadLocalObject<std::vector<BufferResource>> mBufferResources[RENDER_FRAME_COUNT];
-			//minimum buffer size
-			static constexpr std::size_t MIN_BUFFER_SIZE{ 2048 * 10};
+			D3D12StatefulResourcePtr mResource;
+			std::unique_ptr<ConstantBufferAllocator> mAllocator;
+			//size of the region shared by all frames in flight
+			static constexpr std::size_t REGION_SIZE{ 32 * 1024 * 1024 };
 		};
 	}
 }
\ No newline at end of file
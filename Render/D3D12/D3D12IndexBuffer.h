@@ -17,6 +17,7 @@ namespace Lightning
 			void Unlock(std::size_t start, std::size_t size)override { mResource.Unlock(start, size); };
 			void Commit() override{ mResource.Commit(); };
 			D3D12_INDEX_BUFFER_VIEW GetBufferView() { return mBufferView; }
+			D3D12BufferResource& GetBufferResource() { return mResource; }
 		private:
 			D3D12_INDEX_BUFFER_VIEW mBufferView;
 			D3D12BufferResource mResource;
@@ -69,6 +69,7 @@ namespace Lightning
 		void D3D12Renderer::Start()
 		{
 			Renderer::Start();
+			D3D12ConstantBufferManager::Instance()->Initialize(static_cast<D3D12Device*>(mDevice.get()));
 #ifndef NDEBUG
 			InitDXGIDebug();
 #endif
@@ -79,6 +80,7 @@ namespace Lightning
 		{
 			LOG_INFO("Start to clean up render resources.");
 			Renderer::ShutDown();
+			mUploadStagingResource.reset();
 			D3D12DescriptorHeapManager::Instance()->Clear();
 			D3D12ConstantBufferManager::Instance()->Clear();
 			D3D12StatefulResourceManager::Instance()->Clear();
@@ -203,29 +205,28 @@ namespace Lightning
 			commandList->OMSetRenderTargets(UINT(renderTargetCount), rtvHandles, FALSE, &dsHandle);
 		}
 
-		void D3D12Renderer::ApplyPipelineState(const PipelineState& state)
+		bool D3D12Renderer::ApplyPipelineState(const PipelineState& state)
 		{
 			auto hashValue = std::hash<PipelineState>{}(state);
-			PipelineCacheMap::iterator it = mPipelineCache.end();
+			PipelineCacheObject cacheObject;
 			bool createNewPSO{ true };
 			{
+				//The cache object is copied under lock since worker threads may insert compiled states any time
 				MutexLock lock(mtxPipelineCache);
-				it = mPipelineCache.find(hashValue);
+				auto it = mPipelineCache.find(hashValue);
 				if (it != mPipelineCache.end())
 				{
+					cacheObject = it->second;
 					createNewPSO = false;
 				}
 			}
 
-			PipelineCacheObject cacheObject;
 			if(createNewPSO)
 			{
+				if (!RequestPipelineState(hashValue, state))
+					return false;
 				cacheObject = CreateAndCachePipelineState(state, hashValue);
 			}
-			else
-			{
-				cacheObject = it->second;
-			}
 
 			auto commandList = GetGraphicsCommandList();
 			commandList->SetPipelineState(cacheObject.pipelineState.Get());
@@ -235,6 +236,17 @@ namespace Lightning
 				commandList->SetGraphicsRootSignature(rootSignature);
 				cacheObject.shaderGroup->Commit(commandList);
 			}
+			return true;
+		}
+
+		bool D3D12Renderer::CompilePipelineState(const void* desc, std::size_t size)
+		{
+			PipelineStateDesc stateDesc;
+			PipelineState state;
+			if (!stateDesc.Read(desc, size) || !ResolvePipelineState(stateDesc, state))
+				return false;
+			auto cacheObject = CreateAndCachePipelineState(state, std::hash<PipelineState>{}(state));
+			return cacheObject.pipelineState != nullptr;
 		}
 
 		void D3D12Renderer::ApplyViewports(const Viewport* viewports, std::size_t viewportCount)
@@ -345,20 +357,22 @@ namespace Lightning
 			{
 				ApplyShader(state.ds, cacheObject.shaderGroup.get(), desc);
 			}
-			UpdatePSOInputLayout(state.inputLayouts, desc);
+			std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+			std::vector<std::string> semanticNames;
+			UpdatePSOInputLayout(state.inputLayouts, desc, inputElements, semanticNames);
 			desc.pRootSignature = cacheObject.shaderGroup->CreateRootSignature().Get();
 			desc.PrimitiveTopologyType = D3D12TypeMapper::MapPrimitiveType(state.primType);
 			//TODO : should apply pipeline state based on PipelineState
 			desc.NumRenderTargets = UINT(state.renderTargetBlendStates.size());
 			for (std::uint8_t i = 0; i < desc.NumRenderTargets; i++)
 			{
-				auto renderTexture = state.renderTargetBlendStates[i].renderTarget->GetTexture();
+				const auto& renderTargetBlendState = state.renderTargetBlendStates[i];
 				if (i == 0)
 				{
-					desc.SampleDesc.Count = renderTexture->GetMultiSampleCount();
-					desc.SampleDesc.Quality = renderTexture->GetMultiSampleQuality();
+					desc.SampleDesc.Count = renderTargetBlendState.multiSampleCount;
+					desc.SampleDesc.Quality = renderTargetBlendState.multiSampleQuality;
 				}
-				desc.RTVFormats[i] = D3D12TypeMapper::MapRenderFormat(renderTexture->GetRenderFormat());
+				desc.RTVFormats[i] = D3D12TypeMapper::MapRenderFormat(renderTargetBlendState.format);
 			}
 			desc.SampleMask = 0xfffffff;
 			auto device = static_cast<D3D12Device*>(mDevice.get());
@@ -474,7 +488,8 @@ namespace Lightning
 			shaderGroup->AddShader(std::static_pointer_cast<D3D12Shader>(pShader));
 		}
 
-		void D3D12Renderer::UpdatePSOInputLayout(const std::vector<VertexInputLayout>& inputLayouts, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+		void D3D12Renderer::UpdatePSOInputLayout(const std::vector<VertexInputLayout>& inputLayouts, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+			std::vector<D3D12_INPUT_ELEMENT_DESC>& elements, std::vector<std::string>& semanticNames)
 		{
 			D3D12_INPUT_LAYOUT_DESC& inputLayoutDesc = desc.InputLayout;
 			if (inputLayouts.empty())
@@ -488,7 +503,10 @@ namespace Lightning
 			{
 				inputElementCount += inputLayouts[i].componentCount;
 			}
-			auto pInputElementDesc = g_RenderAllocator.Allocate<D3D12_INPUT_ELEMENT_DESC>(inputElementCount);
+			elements.resize(inputElementCount);
+			//names are referenced by elements,so semanticNames must never reallocate
+			semanticNames.reserve(inputElementCount);
+			auto pInputElementDesc = elements.data();
 			std::size_t i = 0;
 			for (int j = 0;j < inputLayouts.size();++j)
 			{
@@ -508,12 +526,9 @@ namespace Lightning
 					SemanticIndex semanticIndex;
 					std::string semanticName;
 					GetSemanticInfo(component.semantic, semanticIndex, semanticName);
-					auto nameBufferSize = semanticName.length() + 1;
-					auto nameArr = g_RenderAllocator.Allocate<char>(nameBufferSize);
-					nameArr[nameBufferSize - 1] = 0;
-					strncpy_s(nameArr, nameBufferSize, semanticName.c_str(), semanticName.length());
+					semanticNames.push_back(std::move(semanticName));
 					pInputElementDesc[i].SemanticIndex = semanticIndex;
-					pInputElementDesc[i].SemanticName = nameArr;
+					pInputElementDesc[i].SemanticName = semanticNames.back().c_str();
 					++i;
 				}
 			}
@@ -531,6 +546,42 @@ namespace Lightning
 			return new D3D12SwapChain(mDXGIFactory.Get(), GetCommandQueue(), mOutputWindow);
 		}
 
+		UploadQueue* D3D12Renderer::CreateUploadQueue()
+		{
+			auto D3DDevice = dynamic_cast<D3D12Device*>(mDevice.get());
+			assert(D3DDevice != nullptr && "A D3D12Device is required.");
+			mUploadStagingResource = D3DDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+				D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(UPLOAD_STAGING_BUFFER_SIZE),
+				D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
+			if (!mUploadStagingResource)
+			{
+				LOG_WARNING("Failed to create upload staging buffer!Buffers will be written directly.");
+				return nullptr;
+			}
+			//upload heaps can stay mapped during their lifetime
+			static const D3D12_RANGE readRange{ 0, 0 };
+			void* stagingMemory{ nullptr };
+			mUploadStagingResource->GetResource()->Map(0, &readRange, &stagingMemory);
+			return new UploadQueue(static_cast<std::uint8_t*>(stagingMemory), UPLOAD_STAGING_BUFFER_SIZE, UPLOAD_FRAME_BUDGET);
+		}
+
+		void D3D12Renderer::ExecuteUploads(const UploadCopy* copies, std::size_t copyCount)
+		{
+			auto commandList = GetGraphicsCommandList();
+			auto stagingResource = mUploadStagingResource->GetResource();
+			for (std::size_t i = 0;i < copyCount;++i)
+			{
+				const auto& copy = copies[i];
+				D3D12BufferResource* resource{ nullptr };
+				if (auto vertexBuffer = dynamic_cast<D3D12VertexBuffer*>(copy.destination))
+					resource = &vertexBuffer->GetBufferResource();
+				else if (auto indexBuffer = dynamic_cast<D3D12IndexBuffer*>(copy.destination))
+					resource = &indexBuffer->GetBufferResource();
+				assert(resource != nullptr && "Upload destination must be a D3D12 buffer!");
+				resource->CopyFrom(commandList, stagingResource, copy.stagingOffset, copy.destinationOffset, copy.size);
+			}
+		}
+
 #ifndef NDEBUG
 		void D3D12Renderer::InitDXGIDebug()
 		{
@@ -559,6 +610,8 @@ namespace Lightning
 		void D3D12Renderer::OnFrameBegin()
 		{
 			auto frameResourceIndex = GetFrameResourceIndex();
+			//the frame last using this frame resource is finished by GPU
+			D3D12ConstantBufferManager::Instance()->ReleaseFramesBefore(mFrameResources[frameResourceIndex].frame);
 			mCmdEncoders[frameResourceIndex].for_each([](D3D12CommandEncoder& encoder) {
 				encoder.Reset();
 			});
@@ -598,6 +651,7 @@ namespace Lightning
 			}
 			auto commandQueue = GetCommandQueue();
 			commandQueue->ExecuteCommandLists(UINT(commandLists.size()), &commandLists[0]);
+			D3D12ConstantBufferManager::Instance()->FinishFrame(GetCurrentFrameCount());
 		}
 
 		void D3D12Renderer::ResizeDepthStencilBuffer(IDepthStencilBuffer* depthStencilBuffer, 
@@ -33,7 +33,7 @@ namespace Lightning
 			void ClearDepthStencilBuffer(IDepthStencilBuffer* buffer, DepthStencilClearFlags flags, float depth, std::uint8_t stencil, 
 				const RectI* rects = nullptr, std::size_t rectCount = 0)override;
 			void ApplyRenderTargets(const IRenderTarget*const * renderTargets, std::size_t renderTargetCount, IDepthStencilBuffer* dsBuffer)override;
-			void ApplyPipelineState(const PipelineState& state)override;
+			bool ApplyPipelineState(const PipelineState& state)override;
 			void ApplyViewports(const Viewport* viewports, std::size_t viewportCount)override;
 			void ApplyScissorRects(const ScissorRect* scissorRects, std::size_t scissorRectCount)override;
 			void BindVertexBuffer(std::size_t slot, IVertexBuffer* buffer)override;
@@ -51,6 +51,9 @@ namespace Lightning
 			IRenderFence* CreateRenderFence()override;
 			Device* CreateDevice()override;
 			SwapChain* CreateSwapChain()override;
+			UploadQueue* CreateUploadQueue()override;
+			void ExecuteUploads(const UploadCopy* copies, std::size_t copyCount)override;
+			bool CompilePipelineState(const void* desc, std::size_t size)override;
 		private:
 			struct PipelineCacheObject
 			{
@@ -64,12 +67,17 @@ namespace Lightning
 			void ApplyBlendStates(const std::vector<RenderTargetBlendState>& states, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
 			void ApplyDepthStencilState(const DepthStencilState& state, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
 			void ApplyShader(const std::shared_ptr<IShader>& pShader, D3D12ShaderGroup* shaderGroup, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
-			void UpdatePSOInputLayout(const std::vector<VertexInputLayout>& inputLayouts, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+			//Input elements and their semantic names are stored in elements and semanticNames,which must outlive desc.
+			//Pipeline states may be compiled on worker threads across frames,so frame memory can't be used
+			void UpdatePSOInputLayout(const std::vector<VertexInputLayout>& inputLayouts, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+				std::vector<D3D12_INPUT_ELEMENT_DESC>& elements, std::vector<std::string>& semanticNames);
 
 			ComPtr<IDXGIFactory4> mDXGIFactory;
 			ComPtr<ID3D12CommandQueue> mCommandQueue;
 			Foundation::ThreadLocalObject<D3D12CommandEncoder> mCmdEncoders[RENDER_FRAME_COUNT];
 			PipelineCacheMap mPipelineCache;
+			//persistently mapped staging ring of the upload queue
+			D3D12StatefulResourcePtr mUploadStagingResource;
 #ifndef NDEBUG
 			ComPtr<ID3D12Debug> mD3D12Debug;
 			ComPtr<ID3D12Debug1> mD3D12Debug1;
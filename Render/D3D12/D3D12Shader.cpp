@@ -18,6 +18,53 @@ namespace Lightning
 
 		extern FrameMemoryAllocator g_RenderAllocator;
 
+		namespace
+		{
+			//Compiles hlsl with D3DCompile,the macros passed in are defined in the order of IShaderMacros::GetAllMacros.
+			//No include handler is passed,so sources using #include fail to compile
+			class D3D12ShaderCompiler : public IShaderCompiler
+			{
+			public:
+				D3D12ShaderCompiler(const IShaderMacros* macros) : mMacros(macros){}
+				std::uint32_t GetVersion()const override
+				{
+					return D3D_COMPILER_VERSION;
+				}
+
+				bool Compile(const ShaderCompileInput& input, ShaderBytecode& byteCode, std::string& errors)override
+				{
+					std::vector<std::pair<std::string, std::string>> macros;
+					if (mMacros)
+					{
+						mMacros->GetAllMacros(macros);
+					}
+					std::vector<D3D_SHADER_MACRO> shaderMacros;
+					for (const auto& macro : macros)
+					{
+						shaderMacros.push_back(D3D_SHADER_MACRO{ macro.first.c_str(), macro.second.c_str() });
+					}
+					shaderMacros.push_back(D3D_SHADER_MACRO{ nullptr, nullptr });
+					//TODO : flags2 is used to compile effect file.Should implement it later
+					UINT flags2 = 0;
+					ComPtr<ID3DBlob> code;
+					ComPtr<ID3DBlob> errorLog;
+					HRESULT hr = ::D3DCompile(input.source.c_str(), static_cast<SIZE_T>(input.source.length() + 1), input.name.c_str(), 
+						shaderMacros.data(), nullptr, input.entry.c_str(), input.target.c_str(), input.flags, flags2, &code, &errorLog);
+					if (errorLog)
+					{
+						errors.assign(static_cast<const char*>(errorLog->GetBufferPointer()), errorLog->GetBufferSize());
+					}
+					if (FAILED(hr))
+						return false;
+					auto codeBuffer = static_cast<const std::uint8_t*>(code->GetBufferPointer());
+					byteCode.assign(codeBuffer, codeBuffer + code->GetBufferSize());
+					return true;
+				}
+			private:
+				const IShaderMacros* mMacros;
+			};
+		}
+
 		D3D12Shader::D3D12Shader(D3D_SHADER_MODEL shaderModel, ShaderType type, 
 			const std::string& name, const std::string& shaderSource, const std::shared_ptr<IShaderMacros>& macros):
 			Shader(type, name, shaderSource, macros)
@@ -27,7 +74,7 @@ namespace Lightning
 			assert(!shaderSource.empty() && "Invalid shader source");
 			CompileImpl();
 			ComPtr<ID3D12ShaderReflection> shaderReflection;
-			D3DReflect(mByteCode->GetBufferPointer(), mByteCode->GetBufferSize(), IID_PPV_ARGS(&shaderReflection));
+			D3DReflect(mByteCode->data(), mByteCode->size(), IID_PPV_ARGS(&shaderReflection));
 			shaderReflection->GetDesc(&mDesc);
 			std::unordered_map<std::string, D3D12_SHADER_INPUT_BIND_DESC> inputBindDescs;
 			for (UINT i = 0;i < mDesc.BoundResources;++i)
@@ -216,7 +263,7 @@ namespace Lightning
 
 		D3D12Shader::~D3D12Shader()
 		{
-			mByteCode.Reset();
+			mByteCode.reset();
 		}
 
 		D3D12Shader::ShaderResourceProxy::ShaderResourceProxy()
@@ -369,11 +416,11 @@ namespace Lightning
 			boundResource[mSamplerResourceIndex].samplerStates[index] = samplerState;
 		}
 
-		void* D3D12Shader::GetByteCodeBuffer()const
+		const void* D3D12Shader::GetByteCodeBuffer()const
 		{
 			if (mByteCode)
 			{
-				return mByteCode->GetBufferPointer();
+				return mByteCode->data();
 			}
 			return nullptr;
 		}
@@ -382,7 +429,7 @@ namespace Lightning
 		{
 			if (mByteCode)
 			{
-				return mByteCode->GetBufferSize();
+				return mByteCode->size();
 			}
 			return 0;
 		}
@@ -400,33 +447,44 @@ namespace Lightning
 				LOG_WARNING("Unknown shader parameter type when set shader {0}", mName.c_str());
 				return false;
 			}
-			auto it = mParameters.find(parameter.GetName());
-			assert(it != mParameters.end());
+			ShaderParameterBinding binding;
+			auto found = GetParameterBinding(parameter.GetName(), binding);
+			assert(found);
+			if (!found)
+				return false;
+			if (binding.type != parameterType)
+			{
+				LOG_WARNING("Mismatched parameter type of {0} when set shader {1}", parameter.GetName(), mName.c_str());
+				return false;
+			}
 			std::size_t size{ 0 };
+			auto parameterBuffer = parameter.Buffer(size);
+			if (!parameterBuffer)
+				return false;
+			return SetParameter(binding, parameterBuffer);
+		}
+
+		bool D3D12Shader::SetParameter(const ShaderParameterBinding& binding, const void* data)
+		{
+			assert(data != nullptr && "Encounter null parameter data!");
 			InitResourceProxy();
-			if (parameterType == ParameterType::TEXTURE)
+			if (binding.type == ParameterType::TEXTURE)
 			{
-				auto texture = parameter.GetValue<std::shared_ptr<ITexture>>();
+				const auto& texture = *static_cast<const std::shared_ptr<ITexture>*>(data);
 				assert(texture != nullptr && "Encounter null texture!");
 				texture->Commit();
-				mResourceProxy->SetTexture(it->second.index, static_cast<D3D12Texture*>(texture.get()));
+				mResourceProxy->SetTexture(binding.index, static_cast<D3D12Texture*>(texture.get()));
 				return true;
 			}
-			else if (parameterType == ParameterType::SAMPLER)
+			else if (binding.type == ParameterType::SAMPLER)
 			{
-				mResourceProxy->SetSamplerState(it->second.index, parameter.GetValue<SamplerState>());
+				mResourceProxy->SetSamplerState(binding.index, *static_cast<const SamplerState*>(data));
 				return true;
 			}
-			else
+			else if (binding.size > 0)
 			{
-				auto parameterBuffer = parameter.Buffer(size);
-				if (parameterBuffer)
-				{
-					const auto& paramInfo = it->second;
-					auto offset = mConstantBufferInfo[paramInfo.index].offset + paramInfo.offset;
-					mResourceProxy->SetConstantBuffer(offset, parameterBuffer, size);
-					return true;
-				}
+				mResourceProxy->SetConstantBuffer(binding.offset, data, binding.size);
+				return true;
 			}
 			return false;
 		}
@@ -439,6 +497,23 @@ namespace Lightning
 			return it->second.parameterType;
 		}
 
+		bool D3D12Shader::GetParameterBinding(const std::string& name, ShaderParameterBinding& binding)const
+		{
+			auto it = mParameters.find(name);
+			if (it == mParameters.end())
+				return false;
+			const auto& paramInfo = it->second;
+			binding.type = paramInfo.parameterType;
+			binding.index = paramInfo.index;
+			binding.offset = 0;
+			binding.size = static_cast<std::uint32_t>(GetParameterTypeSize(paramInfo.parameterType));
+			if (binding.size > 0)
+			{
+				binding.offset = mConstantBufferInfo.at(paramInfo.index).offset + paramInfo.offset;
+			}
+			return true;
+		}
+
 		void D3D12Shader::Compile()
 		{
 			if (!mSource.empty())
@@ -560,26 +635,35 @@ namespace Lightning
 
 		void D3D12Shader::CompileImpl()
 		{
-			auto source = mSource;
-			if (mMacros)
-			{
-				source = mMacros->GetMacroString() + source;
-			}
-			//TODO: resolve include
 #ifndef NDEBUG
 			UINT flags1 = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #else
 			UINT flags1 = 0;
 #endif
-			//TODO : flags2 is used to compile effect file.Should implement it later
-			UINT flags2 = 0;
-			ComPtr<ID3DBlob> errorLog;
 			char shaderModel[32];
 			
 			GetShaderModelString(shaderModel);
-			HRESULT hr = ::D3DCompile(source.c_str(), static_cast<SIZE_T>(source.length() + 1), nullptr, nullptr, nullptr, DEFAULT_SHADER_ENTRY,
-				shaderModel, flags1, flags2, &mByteCode, &errorLog);
-			if (FAILED(hr))
+			//Includes are not supported:the compiler gets no include handler and the cache key could not cover the
+			//included files.Such shaders are rejected before the cache is consulted
+			if (mSource.find("#include") != std::string::npos)
+			{
+				LOG_ERROR("Compile shader {0} failed!#include is not supported", mName);
+				return;
+			}
+			ShaderCompileInput input;
+			input.name = mName;
+			input.source = mSource;
+			input.entry = DEFAULT_SHADER_ENTRY;
+			input.target = shaderModel;
+			if (mMacros)
+			{
+				input.macros = mMacros->GetMacroString();
+			}
+			input.flags = flags1;
+			D3D12ShaderCompiler compiler(mMacros.get());
+			std::string errors;
+			mByteCode = ShaderBytecodeCache::Instance()->GetOrCompile(input, compiler, errors);
+			if (!mByteCode)
 			{
 				std::stringstream ss;
 				ss << "Compile shader " << mName << " failed!";
@@ -589,16 +673,12 @@ namespace Lightning
 					ss << mMacros->GetMacroString();
 				}
 				ss << "Detailed info:" << std::endl;
-				size_t compileErrorBufferSize = errorLog->GetBufferSize();
-				char* compileErrorBuffer = g_RenderAllocator.Allocate<char>(compileErrorBufferSize);
-				std::memcpy(compileErrorBuffer, errorLog->GetBufferPointer(), compileErrorBufferSize);
-				compileErrorBuffer[compileErrorBufferSize] = 0;
-				ss << compileErrorBuffer;
+				ss << errors;
 				LOG_ERROR("{0}", ss.str().c_str());
 			}
 			else
 			{
-				LOG_INFO("Succeeded compiling shader {0}", mName);
+				LOG_INFO("Succeeded loading shader {0}", mName);
 			}
 		}
 	}
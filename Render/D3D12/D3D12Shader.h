@@ -7,6 +7,7 @@
 #include "D3D12Texture.h"
 #include "Texture/Sampler.h"
 #include "Shader.h"
+#include "ShaderBytecodeCache.h"
 
 namespace Lightning
 {
@@ -48,10 +49,12 @@ namespace Lightning
 			~D3D12Shader()override;
 			std::size_t GetParameterCount()const override;
 			bool SetParameter(const Parameter& parameter) override;
+			bool SetParameter(const ShaderParameterBinding& binding, const void* data)override;
 			ParameterType GetParameterType(const std::string& name)const override;
+			bool GetParameterBinding(const std::string& name, ShaderParameterBinding& binding)const override;
 			void Compile()override;
 			void GetUniformSemantics(RenderSemantics** semantics, std::uint16_t& semanticCount)override;
-			void* GetByteCodeBuffer()const;
+			const void* GetByteCodeBuffer()const;
 			SIZE_T GetByteCodeBufferSize()const;
 			const std::vector<D3D12_ROOT_PARAMETER>& GetRootParameters()const;
 			std::size_t GetRootParameterCount()const;
@@ -112,7 +115,7 @@ namespace Lightning
 		private:
 			void InitResourceProxy();
 		private:
-			ComPtr<ID3D10Blob> mByteCode;
+			std::shared_ptr<const ShaderBytecode> mByteCode;
 			D3D12_SHADER_DESC mDesc;
 			std::unordered_map<std::string, ParameterInfo> mParameters;
 			std::vector<D3D12_ROOT_PARAMETER> mRootParameters;
@@ -1,5 +1,6 @@
 #include <cassert>
 #include "Device.h"
+#include "Renderer.h"
 #include "IPluginManager.h"
 #include "ILoaderPlugin.h"
 #include "RenderObjectCache.h"
@@ -82,6 +83,42 @@ namespace Lightning
 			loader->Load(path, serializer);
 		}
 
+		void Device::UploadSharedBuffer(const std::shared_ptr<IGPUBuffer>& buffer, const void* data, std::size_t size)
+		{
+			//shared geometry goes through the renderer's upload queue
+			Renderer::Instance()->UploadBuffer(buffer, 0, data, size);
+		}
+
+		std::shared_ptr<IVertexBuffer> Device::GetSharedVertexBuffer(const void* data, std::uint32_t bufferSize, const VertexDescriptor& descriptor)
+		{
+			//hash components field by field,padding bytes are undefined
+			std::uint64_t layoutKey{ GeometryRegistry::Hash(&descriptor.componentCount, sizeof(descriptor.componentCount)) };
+			for (std::size_t i = 0;i < descriptor.componentCount;++i)
+			{
+				const auto& component = descriptor.components[i];
+				layoutKey = GeometryRegistry::Hash(&component.semantic, sizeof(component.semantic), layoutKey);
+				layoutKey = GeometryRegistry::Hash(&component.format, sizeof(component.format), layoutKey);
+				layoutKey = GeometryRegistry::Hash(&component.offset, sizeof(component.offset), layoutKey);
+				layoutKey = GeometryRegistry::Hash(&component.isInstance, sizeof(component.isInstance), layoutKey);
+				layoutKey = GeometryRegistry::Hash(&component.instanceStepRate, sizeof(component.instanceStepRate), layoutKey);
+			}
+			auto buffer = mGeometryRegistry.GetBuffer(layoutKey, data, bufferSize, [this, &descriptor](std::size_t size) {
+				return std::static_pointer_cast<IGPUBuffer>(CreateVertexBuffer(static_cast<std::uint32_t>(size), descriptor));
+			}, UploadSharedBuffer);
+			return std::static_pointer_cast<IVertexBuffer>(buffer);
+		}
+
+		std::shared_ptr<IIndexBuffer> Device::GetSharedIndexBuffer(const void* data, std::uint32_t bufferSize, IndexType type)
+		{
+			//index buffers never share entries with vertex buffers
+			static const std::uint64_t IndexLayoutSeed = GeometryRegistry::Hash("IndexBuffer", 11);
+			auto layoutKey = GeometryRegistry::Hash(&type, sizeof(type), IndexLayoutSeed);
+			auto buffer = mGeometryRegistry.GetBuffer(layoutKey, data, bufferSize, [this, type](std::size_t size) {
+				return std::static_pointer_cast<IGPUBuffer>(CreateIndexBuffer(static_cast<std::uint32_t>(size), type));
+			}, UploadSharedBuffer);
+			return std::static_pointer_cast<IIndexBuffer>(buffer);
+		}
+
 		std::shared_ptr<IShader> Device::GetDefaultShader(ShaderType type)
 		{
 			auto it = mDefaultShaders.find(type);
@@ -2,6 +2,7 @@
 #include <unordered_map>
 #include "IDevice.h"
 #include "ILoader.h"
+#include "Geometry/GeometryRegistry.h"
 
 namespace Lightning
 {
@@ -16,12 +17,16 @@ namespace Lightning
 			void CreateShaderFromFile(ShaderType type, const std::string& path, 
 				const std::shared_ptr<IShaderMacros>& macros, ResourceAsyncCallback<IShader> callback)override;
 			void CreateTextureFromFile(const std::string& path, ResourceAsyncCallback<ITexture> callback)override;
+			std::shared_ptr<IVertexBuffer> GetSharedVertexBuffer(const void* data, std::uint32_t bufferSize, const VertexDescriptor& descriptor)override;
+			std::shared_ptr<IIndexBuffer> GetSharedIndexBuffer(const void* data, std::uint32_t bufferSize, IndexType type)override;
 		protected:
 			Device();
 			Loading::ILoader* GetLoader();
+			static void UploadSharedBuffer(const std::shared_ptr<IGPUBuffer>& buffer, const void* data, std::size_t size);
 			std::unordered_map<ShaderType, std::shared_ptr<IShader>> mDefaultShaders;
 		private:
 			Loading::ILoader* mLoader;
+			GeometryRegistry mGeometryRegistry;
 		};
 	}
 }
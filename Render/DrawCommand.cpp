@@ -1,7 +1,6 @@
 #include <cassert>
 #include <algorithm>
 #include "DrawCommand.h"
-#include "DrawCommand.h"
 #include "FrameMemoryAllocator.h"
 #include "Logger.h"
 #undef min
@@ -13,7 +12,7 @@ namespace Lightning
 	{
 		extern FrameMemoryAllocator g_RenderAllocator;
 		DrawCommand::DrawCommand(IRenderer& renderer, IRenderPass& renderPass)
-			: mRenderPass(renderPass), mRenderer(renderer)
+			: mWVPMatrix(nullptr), mRenderPass(renderPass), mRenderer(renderer)
 		{
 
 		}
@@ -48,19 +47,9 @@ namespace Lightning
 			mMaterial = material;
 		}
 
-		void DrawCommand::SetTransform(const Transform& transform)
+		void DrawCommand::SetWVPMatrix(const Matrix4f* matrix)
 		{
-			mTransform = transform;
-		}
-
-		void DrawCommand::SetViewMatrix(const Matrix4f& matrix)
-		{
-			mViewMatrix = matrix;
-		}
-
-		void DrawCommand::SetProjectionMatrix(const Matrix4f& matrix)
-		{
-			mProjectionMatrix = matrix;
+			mWVPMatrix = matrix;
 		}
 
 		void DrawCommand::Reset()
@@ -68,18 +57,22 @@ namespace Lightning
 			DoReset();
 		}
 
-		void DrawCommand::Commit()
+		void DrawCommand::Commit(CommandBuffer& commandBuffer, std::uint64_t sortKey)
 		{
-			CommitShaderParameters();
-			CommitPipelineStates();
-			CommitBuffers();
-			Draw();
+			RenderCommandRecorder recorder(commandBuffer);
+			commandBuffer.Begin(sortKey);
+			CommitShaderParameters(recorder);
+			CommitPipelineStates(recorder);
+			CommitBuffers(recorder);
+			Draw(recorder);
 		}
 
 		void DrawCommand::DoReset()
 		{
 			mIndexBuffer.reset();
 			mMaterial.reset();
+			mWVPMatrix = nullptr;
+			mPipelineState.Reset();
 			DoClearVertexBuffers();
 		}
 
@@ -96,7 +89,7 @@ namespace Lightning
 			DrawCommandPool::free(this);
 		}
 
-		void DrawCommand::CommitShaderParameters()
+		void DrawCommand::CommitShaderParameters(RenderCommandRecorder& recorder)
 		{
 			static const ShaderType shaderTypes[] =
 			{
@@ -110,24 +103,26 @@ namespace Lightning
 				return;
 			for (auto shaderType : shaderTypes)
 			{
-				auto shader = mMaterial->GetShader(shaderType);
-				if (shader)
+				auto table = mMaterial->GetBindingTable(shaderType);
+				if (!table)
+					continue;
+				for (const auto& binding : table->bindings)
 				{
-					mMaterial->VisitParameters([this, &shader](const Parameter& parameter) {
-						auto shaderParamType = shader->GetParameterType(parameter.GetName());
-						if (shaderParamType != ParameterType::UNKNOWN)
-						{
-							shader->SetParameter(parameter);
-						}
-					});
-					CommitSemanticUniforms(shader.get());
+					if (binding.semantic == RenderSemantics::UNKNOWN)
+					{
+						recorder.SetShaderParameter(table->shader, binding.binding, binding.data);
+					}
+					else
+					{
+						CommitSemanticUniform(recorder, table->shader, binding);
+					}
 				}
 			}
 		}
 
-		void DrawCommand::CommitPipelineStates()
+		void DrawCommand::CommitPipelineStates(RenderCommandRecorder& recorder)
 		{
-			PipelineState state;
+			auto& state = mPipelineState;
 			state.Reset();
 			auto renderTargetCount = mRenderPass.GetRenderTargetCount();
 			for (auto i = 0;i < renderTargetCount;++i)
@@ -141,8 +136,9 @@ namespace Lightning
 						state.depthStencilState.depthWriteEnable = false;
 					}
 				}
-				auto renderTarget = mRenderPass.GetRenderTarget(i);
-				state.renderTargetBlendStates.push_back({renderTarget, blendState });
+				auto renderTexture = mRenderPass.GetRenderTarget(i)->GetTexture();
+				state.renderTargetBlendStates.push_back({ renderTexture->GetRenderFormat(), renderTexture->GetMultiSampleCount(),
+					renderTexture->GetMultiSampleQuality(), blendState });
 			}
 			auto depthStencilBuffer = mRenderPass.GetDepthStencilBuffer();
 			if (depthStencilBuffer)
@@ -164,24 +160,23 @@ namespace Lightning
 			
 			GetInputLayouts(state.inputLayouts);
 
-			mRenderer.ApplyPipelineState(state);
+			recorder.ApplyPipelineState(&state);
 		}
 
-		void DrawCommand::CommitBuffers()
+		void DrawCommand::CommitBuffers(RenderCommandRecorder& recorder)
 		{
+			//buffers are committed by replay right before they are bound
 			for (std::uint8_t i = 0; i < mVertexBuffers.size(); i++)
 			{
-				mVertexBuffers[i]->Commit();
-				mRenderer.BindVertexBuffer(i, mVertexBuffers[i].get());
+				recorder.BindVertexBuffer(i, mVertexBuffers[i].get());
 			}
 			if (mIndexBuffer)
 			{
-				mIndexBuffer->Commit();
-				mRenderer.BindIndexBuffer(mIndexBuffer.get());
+				recorder.BindIndexBuffer(mIndexBuffer.get());
 			}
 		}
 
-		void DrawCommand::Draw()
+		void DrawCommand::Draw(RenderCommandRecorder& recorder)
 		{
 			if (mIndexBuffer)
 			{
@@ -189,7 +184,7 @@ namespace Lightning
 				param.drawType = DrawType::Index;
 				param.indexCount = mIndexBuffer->GetIndexCount();
 				param.instanceCount = 1;
-				mRenderer.Draw(param);
+				recorder.Draw(param);
 			}
 			else
 			{
@@ -197,30 +192,19 @@ namespace Lightning
 			}
 		}
 
-		void DrawCommand::CommitSemanticUniforms(IShader* shader)
+		void DrawCommand::CommitSemanticUniform(RenderCommandRecorder& recorder, IShader* shader, const MaterialParameterBinding& binding)
 		{
-			RenderSemantics* semantics{ nullptr };
-			std::uint16_t semanticCount{ 0 };
-			shader->GetUniformSemantics(&semantics, semanticCount);
-			if (semanticCount == 0)
-				return;
-			for (auto i = 0;i < semanticCount;++i)
+			switch (binding.semantic)
 			{
-				auto semantic = semantics[i];
-				auto uniformName = mRenderer.GetUniformName(semantic);
-				switch (semantic)
-				{
-				case RenderSemantics::WVP:
-				{
-					//We know that transform.ToMatrix4 may change it's internal matrix
-					auto wvp = mTransform.GetMatrix() * mViewMatrix * mProjectionMatrix;
-					shader->SetParameter(Parameter(uniformName, wvp));
-					break;
-				}
-				default:
-					LOG_WARNING("Unsupported semantics : {0}", semantic);
-					break;
-				}
+			case RenderSemantics::WVP:
+			{
+				assert(mWVPMatrix != nullptr && "WVP matrix is not set!");
+				recorder.SetShaderParameter(shader, binding.binding, mWVPMatrix);
+				break;
+			}
+			default:
+				LOG_WARNING("Unsupported semantics : {0}", binding.semantic);
+				break;
 			}
 		}
 
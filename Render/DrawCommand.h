@@ -4,6 +4,7 @@
 #include <tbb/scalable_allocator.h>
 #include "IRenderer.h"
 #include "IDrawCommand.h"
+#include "Command/RenderCommands.h"
 #include "RenderPass/IRenderPass.h"
 
 namespace Lightning
@@ -20,28 +21,25 @@ namespace Lightning
 			void ClearVertexBuffers()override;
 			void SetVertexBuffers(const std::vector<std::shared_ptr<IVertexBuffer>>& vertexBuffers)override;
 			void SetMaterial(const std::shared_ptr<IMaterial>& material)override;
-			void SetTransform(const Transform& transform)override;
-			void SetViewMatrix(const Matrix4f& matrix)override;
-			void SetProjectionMatrix(const Matrix4f& matrix)override;
+			void SetWVPMatrix(const Matrix4f* matrix)override;
 			void Reset()override;
-			void Commit()override;
+			void Commit(CommandBuffer& commandBuffer, std::uint64_t sortKey)override;
 			void Release()override;
 		private:
 			void DoReset();
 			void DoClearVertexBuffers();
-			void CommitBuffers();
-			void CommitPipelineStates();
-			void CommitShaderParameters();
-			void CommitSemanticUniforms(IShader* shader);
-			void Draw();
+			void CommitBuffers(RenderCommandRecorder& recorder);
+			void CommitPipelineStates(RenderCommandRecorder& recorder);
+			void CommitShaderParameters(RenderCommandRecorder& recorder);
+			void CommitSemanticUniform(RenderCommandRecorder& recorder, IShader* shader, const MaterialParameterBinding& binding);
+			void Draw(RenderCommandRecorder& recorder);
 			void GetInputLayouts(std::vector<VertexInputLayout>& inputLayouts);
 			PrimitiveType mPrimitiveType;
-			Transform mTransform;		//position rotation scale
-			Matrix4f mViewMatrix;		//camera view matrix
-			Matrix4f mProjectionMatrix;//camera projection matrix
+			const Matrix4f* mWVPMatrix;	//world-view-projection matrix in frame memory
 			std::shared_ptr<IIndexBuffer> mIndexBuffer;
 			std::shared_ptr<IMaterial> mMaterial;	//shader material attributes
 			std::vector<std::shared_ptr<IVertexBuffer>> mVertexBuffers;
+			PipelineState mPipelineState;	//referenced by the recorded pipeline state command
 			IRenderPass& mRenderPass;
 			IRenderer& mRenderer;
 		};
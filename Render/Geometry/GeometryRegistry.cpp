@@ -0,0 +1,108 @@
+#include <cassert>
+#include <cstring>
+#include "GeometryRegistry.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		GeometryRegistry::GeometryRegistry() : mCreatedBufferCount(0), mUploadedBytes(0)
+		{
+
+		}
+
+		std::shared_ptr<IGPUBuffer> GeometryRegistry::GetBuffer(std::uint64_t layoutKey, const void* data, std::size_t size, const BufferFactory& factory,
+			const BufferUploader& uploader)
+		{
+			assert(data && size > 0 && "Shared geometry can't be empty!");
+			auto hash = Hash(data, size, Hash(&layoutKey, sizeof(layoutKey)));
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto range = mEntries.equal_range(hash);
+			for (auto it = range.first;it != range.second;)
+			{
+				auto& entry = it->second;
+				auto buffer = entry.buffer.lock();
+				if (!buffer)
+				{
+					it = mEntries.erase(it);
+					continue;
+				}
+				//compare content in case of hash collision
+				if (entry.layoutKey == layoutKey && entry.data.size() == size && std::memcmp(entry.data.data(), data, size) == 0)
+					return buffer;
+				++it;
+			}
+			auto buffer = factory(size);
+			if (!buffer)
+				return nullptr;
+			if (uploader)
+			{
+				uploader(buffer, data, size);
+			}
+			else
+			{
+				auto mem = buffer->Lock(0, size);
+				std::memcpy(mem, data, size);
+				buffer->Unlock(0, size);
+			}
+			Entry entry;
+			entry.layoutKey = layoutKey;
+			entry.data.assign(static_cast<const std::uint8_t*>(data), static_cast<const std::uint8_t*>(data) + size);
+			entry.buffer = buffer;
+			mEntries.emplace(hash, std::move(entry));
+			++mCreatedBufferCount;
+			mUploadedBytes += size;
+			return buffer;
+		}
+
+		void GeometryRegistry::Clear()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mEntries.clear();
+		}
+
+		std::size_t GeometryRegistry::GetBufferCount()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			std::size_t count{ 0 };
+			for (auto it = mEntries.begin();it != mEntries.end();)
+			{
+				if (it->second.buffer.expired())
+				{
+					it = mEntries.erase(it);
+				}
+				else
+				{
+					++count;
+					++it;
+				}
+			}
+			return count;
+		}
+
+		std::size_t GeometryRegistry::GetCreatedBufferCount()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mCreatedBufferCount;
+		}
+
+		std::size_t GeometryRegistry::GetUploadedBytes()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mUploadedBytes;
+		}
+
+		std::uint64_t GeometryRegistry::Hash(const void* data, std::size_t size, std::uint64_t seed)
+		{
+			//FNV-1a
+			auto bytes = static_cast<const std::uint8_t*>(data);
+			auto hash = seed;
+			for (std::size_t i = 0;i < size;++i)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+	}
+}
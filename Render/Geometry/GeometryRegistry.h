@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "IGPUBuffer.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		//Hands out GPU buffers for immutable geometry.Buffers with the same layout and the same content are created and
+		//uploaded once and shared by all users.The registry doesn't own buffers,an entry goes away with its last user.
+		//Users must not lock a shared buffer.Thread safe
+		class GeometryRegistry
+		{
+		public:
+			//creates an empty buffer of the given size in bytes
+			using BufferFactory = std::function<std::shared_ptr<IGPUBuffer>(std::size_t)>;
+			//fills a newly created buffer with data
+			using BufferUploader = std::function<void(const std::shared_ptr<IGPUBuffer>&, const void*, std::size_t)>;
+			GeometryRegistry();
+			//layoutKey distinguishes data of the same bytes but different meanings,for example vertex formats or index types.
+			//New buffers are filled by uploader,or locked and written directly if uploader is empty
+			std::shared_ptr<IGPUBuffer> GetBuffer(std::uint64_t layoutKey, const void* data, std::size_t size, const BufferFactory& factory,
+				const BufferUploader& uploader = nullptr);
+			void Clear();
+			//number of buffers still in use
+			std::size_t GetBufferCount();
+			//total number of buffers created
+			std::size_t GetCreatedBufferCount();
+			//total bytes copied into created buffers
+			std::size_t GetUploadedBytes();
+			static std::uint64_t Hash(const void* data, std::size_t size, std::uint64_t seed = 14695981039346656037ULL);
+		private:
+			struct Entry
+			{
+				std::uint64_t layoutKey;
+				std::vector<std::uint8_t> data;
+				std::weak_ptr<IGPUBuffer> buffer;
+			};
+			std::unordered_multimap<std::uint64_t, Entry> mEntries;
+			std::mutex mMutex;
+			std::size_t mCreatedBufferCount;
+			std::size_t mUploadedBytes;
+		};
+	}
+}
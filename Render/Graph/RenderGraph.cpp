@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cassert>
+#include "tbb/parallel_for.h"
+#include "RenderGraph.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		RenderGraph::RenderGraph() : mTransientMemorySize(0), mUnaliasedMemorySize(0)
+		{
+
+		}
+
+		void RenderGraph::Reset()
+		{
+			mPasses.clear();
+			mResources.clear();
+			mResourceNames.clear();
+			mPassOrder.clear();
+			mLevelStarts.clear();
+			mTransientMemorySize = 0;
+			mUnaliasedMemorySize = 0;
+		}
+
+		RenderGraphHandle RenderGraph::CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc)
+		{
+			assert(mResourceNames.find(name) == mResourceNames.end() && "Render graph resource name already exists!");
+			auto handle = static_cast<RenderGraphHandle>(mResources.size());
+			std::size_t size = std::size_t(desc.width) * desc.height * desc.bytesPerPixel;
+			mResources.push_back(Resource{ name, false, size, UNUSED, UNUSED, 0 });
+			mResourceNames[name] = handle;
+			return handle;
+		}
+
+		RenderGraphHandle RenderGraph::ImportResource(const std::string& name)
+		{
+			assert(mResourceNames.find(name) == mResourceNames.end() && "Render graph resource name already exists!");
+			auto handle = static_cast<RenderGraphHandle>(mResources.size());
+			mResources.push_back(Resource{ name, true, 0, UNUSED, UNUSED, 0 });
+			mResourceNames[name] = handle;
+			return handle;
+		}
+
+		RenderGraphHandle RenderGraph::GetResourceHandle(const std::string& name)const
+		{
+			auto it = mResourceNames.find(name);
+			if (it == mResourceNames.end())
+				return INVALID_RENDER_GRAPH_HANDLE;
+			return it->second;
+		}
+
+		RenderGraphHandle RenderGraph::AddPass(const std::string& name, const PassFunction& record, const PassFunction& execute)
+		{
+			auto handle = static_cast<RenderGraphHandle>(mPasses.size());
+			Pass pass;
+			pass.name = name;
+			pass.record = record;
+			pass.execute = execute;
+			pass.sideEffect = false;
+			pass.level = CULLED_LEVEL;
+			mPasses.push_back(std::move(pass));
+			return handle;
+		}
+
+		void RenderGraph::Read(RenderGraphHandle pass, RenderGraphHandle resource)
+		{
+			assert(pass < mPasses.size() && resource < mResources.size() && "Invalid render graph handle!");
+			mPasses[pass].reads.push_back(resource);
+		}
+
+		void RenderGraph::Write(RenderGraphHandle pass, RenderGraphHandle resource)
+		{
+			assert(pass < mPasses.size() && resource < mResources.size() && "Invalid render graph handle!");
+			mPasses[pass].writes.push_back(resource);
+		}
+
+		void RenderGraph::SetSideEffect(RenderGraphHandle pass)
+		{
+			assert(pass < mPasses.size() && "Invalid render graph handle!");
+			mPasses[pass].sideEffect = true;
+		}
+
+		void RenderGraph::Compile()
+		{
+			BuildDependencies();
+			CullPasses();
+			SchedulePasses();
+			ComputeLifetimes();
+			PlanTransientMemory();
+		}
+
+		void RenderGraph::Execute()
+		{
+			for (std::size_t level = 0;level < GetLevelCount();++level)
+			{
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(mLevelStarts[level], mLevelStarts[level + 1], 1),
+					[this](const tbb::blocked_range<std::size_t>& range) {
+					for (auto i = range.begin();i != range.end();++i)
+					{
+						const auto& pass = mPasses[mPassOrder[i]];
+						if (pass.record)
+							pass.record();
+					}
+				});
+			}
+			for (auto handle : mPassOrder)
+			{
+				const auto& pass = mPasses[handle];
+				if (pass.execute)
+					pass.execute();
+			}
+		}
+
+		void RenderGraph::BuildDependencies()
+		{
+			std::vector<RenderGraphHandle> lastWriters(mResources.size(), INVALID_RENDER_GRAPH_HANDLE);
+			std::vector<std::vector<RenderGraphHandle>> readers(mResources.size());
+			for (RenderGraphHandle handle = 0;handle < mPasses.size();++handle)
+			{
+				auto& pass = mPasses[handle];
+				pass.dependencies.clear();
+				pass.producers.clear();
+				for (auto resource : pass.reads)
+				{
+					if (lastWriters[resource] != INVALID_RENDER_GRAPH_HANDLE && lastWriters[resource] != handle)
+					{
+						pass.producers.push_back(lastWriters[resource]);
+						pass.dependencies.push_back(lastWriters[resource]);
+					}
+				}
+				for (auto resource : pass.writes)
+				{
+					if (lastWriters[resource] != INVALID_RENDER_GRAPH_HANDLE && lastWriters[resource] != handle)
+					{
+						pass.dependencies.push_back(lastWriters[resource]);
+					}
+					for (auto reader : readers[resource])
+					{
+						if (reader != handle)
+							pass.dependencies.push_back(reader);
+					}
+				}
+				for (auto resource : pass.reads)
+				{
+					readers[resource].push_back(handle);
+				}
+				for (auto resource : pass.writes)
+				{
+					lastWriters[resource] = handle;
+					readers[resource].clear();
+				}
+				std::sort(pass.dependencies.begin(), pass.dependencies.end());
+				pass.dependencies.erase(std::unique(pass.dependencies.begin(), pass.dependencies.end()), pass.dependencies.end());
+				std::sort(pass.producers.begin(), pass.producers.end());
+				pass.producers.erase(std::unique(pass.producers.begin(), pass.producers.end()), pass.producers.end());
+			}
+		}
+
+		void RenderGraph::CullPasses()
+		{
+			//A pass is kept if it has side effects,writes an imported resource or produces something read by a kept pass
+			std::vector<bool> alive(mPasses.size(), false);
+			std::vector<RenderGraphHandle> stack;
+			for (RenderGraphHandle handle = 0;handle < mPasses.size();++handle)
+			{
+				const auto& pass = mPasses[handle];
+				auto root = pass.sideEffect || std::any_of(pass.writes.begin(), pass.writes.end(),
+					[this](RenderGraphHandle resource) { return mResources[resource].imported; });
+				if (root)
+				{
+					alive[handle] = true;
+					stack.push_back(handle);
+				}
+			}
+			while (!stack.empty())
+			{
+				auto handle = stack.back();
+				stack.pop_back();
+				for (auto producer : mPasses[handle].producers)
+				{
+					if (!alive[producer])
+					{
+						alive[producer] = true;
+						stack.push_back(producer);
+					}
+				}
+			}
+			for (RenderGraphHandle handle = 0;handle < mPasses.size();++handle)
+			{
+				mPasses[handle].level = alive[handle] ? 0 : CULLED_LEVEL;
+			}
+		}
+
+		void RenderGraph::SchedulePasses()
+		{
+			//Dependencies always point to passes declared earlier,so levels can be computed in declaration order
+			std::size_t levelCount{ 0 };
+			mPassOrder.clear();
+			for (RenderGraphHandle handle = 0;handle < mPasses.size();++handle)
+			{
+				auto& pass = mPasses[handle];
+				if (pass.level == CULLED_LEVEL)
+					continue;
+				std::size_t level{ 0 };
+				for (auto dependency : pass.dependencies)
+				{
+					const auto& dependencyPass = mPasses[dependency];
+					if (dependencyPass.level != CULLED_LEVEL)
+						level = std::max(level, dependencyPass.level + 1);
+				}
+				pass.level = level;
+				levelCount = std::max(levelCount, level + 1);
+				mPassOrder.push_back(handle);
+			}
+			std::stable_sort(mPassOrder.begin(), mPassOrder.end(), [this](RenderGraphHandle lhs, RenderGraphHandle rhs) {
+				return mPasses[lhs].level < mPasses[rhs].level;
+			});
+			mLevelStarts.assign(levelCount + 1, mPassOrder.size());
+			for (auto i = mPassOrder.size();i > 0;--i)
+			{
+				mLevelStarts[mPasses[mPassOrder[i - 1]].level] = i - 1;
+			}
+			if (levelCount == 0)
+				mLevelStarts.clear();
+		}
+
+		void RenderGraph::ComputeLifetimes()
+		{
+			for (auto& resource : mResources)
+			{
+				resource.firstUse = resource.lastUse = UNUSED;
+				resource.offset = 0;
+			}
+			auto use = [this](RenderGraphHandle handle, std::size_t order) {
+				auto& resource = mResources[handle];
+				if (resource.firstUse == UNUSED)
+				{
+					resource.firstUse = resource.lastUse = order;
+				}
+				else
+				{
+					resource.firstUse = std::min(resource.firstUse, order);
+					resource.lastUse = std::max(resource.lastUse, order);
+				}
+			};
+			for (std::size_t order = 0;order < mPassOrder.size();++order)
+			{
+				const auto& pass = mPasses[mPassOrder[order]];
+				for (auto resource : pass.reads)
+					use(resource, order);
+				for (auto resource : pass.writes)
+					use(resource, order);
+			}
+		}
+
+		void RenderGraph::PlanTransientMemory()
+		{
+			//Greedy placement,larger textures first.Each texture takes the lowest offset that doesn't overlap
+			//the memory of any placed texture alive at the same time
+			std::vector<RenderGraphHandle> transients;
+			for (RenderGraphHandle handle = 0;handle < mResources.size();++handle)
+			{
+				const auto& resource = mResources[handle];
+				if (!resource.imported && resource.firstUse != UNUSED)
+					transients.push_back(handle);
+			}
+			auto alignedSize = [this](RenderGraphHandle handle) {
+				return (mResources[handle].size + RENDER_GRAPH_RESOURCE_ALIGNMENT - 1) & ~(RENDER_GRAPH_RESOURCE_ALIGNMENT - 1);
+			};
+			std::stable_sort(transients.begin(), transients.end(), [this](RenderGraphHandle lhs, RenderGraphHandle rhs) {
+				return mResources[lhs].size > mResources[rhs].size;
+			});
+			mTransientMemorySize = 0;
+			mUnaliasedMemorySize = 0;
+			std::vector<RenderGraphHandle> placed;
+			std::vector<std::pair<std::size_t, std::size_t>> occupied;
+			for (auto handle : transients)
+			{
+				auto& resource = mResources[handle];
+				auto size = alignedSize(handle);
+				occupied.clear();
+				for (auto other : placed)
+				{
+					const auto& otherResource = mResources[other];
+					if (otherResource.firstUse <= resource.lastUse && resource.firstUse <= otherResource.lastUse)
+					{
+						occupied.emplace_back(otherResource.offset, otherResource.offset + alignedSize(other));
+					}
+				}
+				std::sort(occupied.begin(), occupied.end());
+				std::size_t offset{ 0 };
+				for (const auto& range : occupied)
+				{
+					if (offset + size <= range.first)
+						break;
+					offset = std::max(offset, range.second);
+				}
+				resource.offset = offset;
+				placed.push_back(handle);
+				mTransientMemorySize = std::max(mTransientMemorySize, offset + size);
+				mUnaliasedMemorySize += size;
+			}
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using RenderGraphHandle = std::uint32_t;
+		constexpr RenderGraphHandle INVALID_RENDER_GRAPH_HANDLE = 0xffffffff;
+		//Transient textures are placed in a heap at offsets aligned to this value(the placement alignment of D3D12)
+		constexpr std::size_t RENDER_GRAPH_RESOURCE_ALIGNMENT = 65536;
+
+		struct RenderGraphTextureDesc
+		{
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint32_t bytesPerPixel;
+		};
+
+		//A frame described as passes and the resources they read and write.Dependencies follow declaration order:a pass
+		//reading a resource depends on the last pass declared before it that writes the resource,a pass writing a resource
+		//runs after the previous writer and readers of it.Compile removes passes whose results are never used,orders the
+		//rest and plans transient texture memory so textures with non overlapping lifetimes share the same memory.
+		//Thread unsafe
+		class RenderGraph
+		{
+		public:
+			using PassFunction = std::function<void()>;
+			RenderGraph();
+			//Removes all passes and resources
+			void Reset();
+			//Adds a texture owned by the graph.Its memory may be shared with other transient textures
+			RenderGraphHandle CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+			//Adds a resource owned outside of the graph,for example the back buffer.Passes writing it are never culled
+			RenderGraphHandle ImportResource(const std::string& name);
+			//Returns INVALID_RENDER_GRAPH_HANDLE if there's no resource named name
+			RenderGraphHandle GetResourceHandle(const std::string& name)const;
+			//record is the CPU work of the pass and may run on any thread in parallel with passes of the same level.
+			//execute runs on the thread calling Execute in pass order,after all passes are recorded.Both can be empty
+			RenderGraphHandle AddPass(const std::string& name, const PassFunction& record, const PassFunction& execute);
+			void Read(RenderGraphHandle pass, RenderGraphHandle resource);
+			void Write(RenderGraphHandle pass, RenderGraphHandle resource);
+			//A pass with side effects is never culled
+			void SetSideEffect(RenderGraphHandle pass);
+			//Culls passes,schedules the rest and computes resource lifetimes and the transient memory plan
+			void Compile();
+			//Records passes level by level in parallel,then executes them in order.Must be called after Compile
+			void Execute();
+
+			//The following methods are valid after Compile
+			bool IsPassCulled(RenderGraphHandle pass)const { return mPasses[pass].level == CULLED_LEVEL; }
+			//Passes that survive culling,sorted by level.A pass only depends on passes of lower levels
+			const std::vector<RenderGraphHandle>& GetPassOrder()const { return mPassOrder; }
+			std::size_t GetPassLevel(RenderGraphHandle pass)const { return mPasses[pass].level; }
+			std::size_t GetLevelCount()const { return mLevelStarts.empty() ? 0 : mLevelStarts.size() - 1; }
+			//Whether the resource is used by a pass that survives culling
+			bool IsResourceUsed(RenderGraphHandle resource)const { return mResources[resource].firstUse != UNUSED; }
+			//Lifetime of a resource as indices in pass order
+			std::size_t GetResourceFirstUse(RenderGraphHandle resource)const { return mResources[resource].firstUse; }
+			std::size_t GetResourceLastUse(RenderGraphHandle resource)const { return mResources[resource].lastUse; }
+			//Byte offset of a used transient texture in the transient heap
+			std::size_t GetResourceOffset(RenderGraphHandle resource)const { return mResources[resource].offset; }
+			std::size_t GetResourceSize(RenderGraphHandle resource)const { return mResources[resource].size; }
+			//Bytes of the transient heap holding all used transient textures with aliasing
+			std::size_t GetTransientMemorySize()const { return mTransientMemorySize; }
+			//Bytes used transient textures would take if each one had memory of its own
+			std::size_t GetUnaliasedMemorySize()const { return mUnaliasedMemorySize; }
+			std::size_t GetPassCount()const { return mPasses.size(); }
+			std::size_t GetResourceCount()const { return mResources.size(); }
+		private:
+			static constexpr std::size_t CULLED_LEVEL = static_cast<std::size_t>(-1);
+			static constexpr std::size_t UNUSED = static_cast<std::size_t>(-1);
+			struct Pass
+			{
+				std::string name;
+				PassFunction record;
+				PassFunction execute;
+				std::vector<RenderGraphHandle> reads;
+				std::vector<RenderGraphHandle> writes;
+				//passes this one must run after
+				std::vector<RenderGraphHandle> dependencies;
+				//passes producing resources this one reads,a subset of dependencies
+				std::vector<RenderGraphHandle> producers;
+				bool sideEffect;
+				std::size_t level;
+			};
+			struct Resource
+			{
+				std::string name;
+				bool imported;
+				std::size_t size;
+				std::size_t firstUse;
+				std::size_t lastUse;
+				std::size_t offset;
+			};
+			void BuildDependencies();
+			void CullPasses();
+			void SchedulePasses();
+			void ComputeLifetimes();
+			void PlanTransientMemory();
+			std::vector<Pass> mPasses;
+			std::vector<Resource> mResources;
+			std::unordered_map<std::string, RenderGraphHandle> mResourceNames;
+			std::vector<RenderGraphHandle> mPassOrder;
+			//passes of level i are mPassOrder[mLevelStarts[i], mLevelStarts[i + 1])
+			std::vector<std::size_t> mLevelStarts;
+			std::size_t mTransientMemorySize;
+			std::size_t mUnaliasedMemorySize;
+		};
+	}
+}
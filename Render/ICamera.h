@@ -19,6 +19,9 @@ namespace Lightning
 			virtual Matrix4f GetViewMatrix()const = 0;
 			virtual Matrix4f GetProjectionMatrix()const = 0;
 			virtual Matrix4f GetInvViewMatrix()const = 0;
+			//Camera position in double precision.Render passes compute WVP matrices relative to it,so they stay precise far
+			//from the origin
+			virtual Foundation::Math::Vector3d GetPrecisePosition()const = 0;
 			virtual void SetNear(const float nearPlane) = 0;
 			virtual void SetFar(const float farPlane) = 0;
 			virtual float GetNear()const = 0;
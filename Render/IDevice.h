@@ -31,6 +31,10 @@ namespace Lightning
 			virtual std::shared_ptr<ITexture> CreateTexture(const TextureDescriptor& descriptor, const std::shared_ptr<ISerializeBuffer>& buffer) = 0;
 			virtual void CreateTextureFromFile(const std::string& path, ResourceAsyncCallback<ITexture> callback) = 0;
 			virtual std::shared_ptr<IShader> GetDefaultShader(ShaderType type) = 0;
+			//Returns a vertex buffer filled with data.Calls with the same descriptor and the same data share one buffer,so
+			//the returned buffer must never be locked again.Use it for immutable geometry like primitives
+			virtual std::shared_ptr<IVertexBuffer> GetSharedVertexBuffer(const void* data, std::uint32_t bufferSize, const VertexDescriptor& descriptor) = 0;
+			virtual std::shared_ptr<IIndexBuffer> GetSharedIndexBuffer(const void* data, std::uint32_t bufferSize, IndexType type) = 0;
 		};
 	}
 }
@@ -3,6 +3,7 @@
 #include "IIndexBuffer.h"
 #include "IVertexBuffer.h"
 #include "Transform.h"
+#include "Command/CommandBuffer.h"
 
 namespace Lightning
 {
@@ -14,7 +15,7 @@ namespace Lightning
 		//the Set/Get methods whatever they like
 		//as long as it is not committed.After the unit is committed,any further operations that potentially
 		//change the object is a no-no.Such behavior usually cause undesired outcome.So don't try to reuse it
-		//after the commitment.You'd better call Release() after calling IRenderer::CommitDrawCommand
+		//after the commitment.You'd better call Release() after the command buffer it's committed to is replayed
 		struct IDrawCommand
 		{
 			virtual ~IDrawCommand() = default;
@@ -23,11 +24,13 @@ namespace Lightning
 			virtual void ClearVertexBuffers() = 0;
 			virtual void SetVertexBuffers(const std::vector<std::shared_ptr<IVertexBuffer>>& vertexBuffers) = 0;
 			virtual void SetMaterial(const std::shared_ptr<IMaterial>& material) = 0;
-			virtual void SetTransform(const Transform& transform) = 0;
-			virtual void SetViewMatrix(const Matrix4f& matrix) = 0;
-			virtual void SetProjectionMatrix(const Matrix4f& matrix) = 0;
+			//Set world-view-projection matrix of the drawable.The matrix is not copied,it must stay alive until the
+			//command is committed(usually it's allocated from frame memory by the render pass batch computation)
+			virtual void SetWVPMatrix(const Matrix4f* matrix) = 0;
 			virtual void Reset() = 0;
-			virtual void Commit() = 0;
+			//Records the render commands of this draw into commandBuffer as a segment with sortKey.Nothing reaches the renderer
+			//until the command buffer is replayed,so the resources of this object must stay unchanged until then
+			virtual void Commit(CommandBuffer& commandBuffer, std::uint64_t sortKey) = 0;
 			virtual void Release() = 0;
 		};
 	}
@@ -6,6 +6,8 @@
 #include "IVertexBuffer.h"
 #include "IMaterial.h"
 #include "Transform.h"
+#include "AABB.h"
+#include "Culling/OcclusionBuffer.h"
 
 namespace Lightning
 {
@@ -22,6 +24,12 @@ namespace Lightning
 			virtual std::shared_ptr<IMaterial> GetMaterial()const = 0;
 			//This is the global transform
 			virtual const Transform GetDrawTransform()const = 0;
+			//Global position in double precision,the position of draw transform is this value rounded to float
+			virtual Foundation::Math::Vector3d GetPreciseDrawPosition()const = 0;
+			//Bounding box in world space used for culling.Returns AABBf::Infinite() if the bounds are unknown
+			virtual Foundation::Math::AABBf GetWorldBoundingBox()const = 0;
+			//Fills CPU side geometry in local space if the drawable is used as an occluder,otherwise returns false
+			virtual bool GetOccluderGeometry(OccluderGeometry& geometry)const = 0;
 		};
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <functional>
+#include <vector>
 #include "boost/variant.hpp"
 #include "PipelineState.h"
 #include "IShader.h"
@@ -10,6 +11,23 @@ namespace Lightning
 {
 	namespace Render
 	{
+		struct MaterialParameterBinding
+		{
+			ShaderParameterBinding binding;
+			//Points to the parameter value stored in material.nullptr for semantic uniforms
+			const void* data;
+			//RenderSemantics::UNKNOWN for material parameters
+			RenderSemantics semantic;
+		};
+
+		//Precompiled bindings between material parameters and a shader.
+		//It's built once per material/shader pair and only rebuilt after the material or shader changes.
+		struct MaterialBindingTable
+		{
+			IShader* shader;
+			std::vector<MaterialParameterBinding> bindings;
+		};
+
 		struct IMaterial
 		{
 			virtual ~IMaterial() = default;
@@ -30,6 +48,9 @@ namespace Lightning
 			virtual void GetBlendState(BlendState& blendState)const = 0;
 			//The visitor should not modify the underlying parameter map during iteration
 			virtual void VisitParameters(std::function<void(const Parameter& parameter)> visitor)const = 0;
+			//Gets the binding table of the shader with shaderType,returns nullptr if there's no such shader.
+			//Thread safe with other GetBindingTable calls,but the returned table is invalidated by SetShader/SetParameter.
+			virtual const MaterialBindingTable* GetBindingTable(ShaderType shaderType) = 0;
 		};
 	}
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "Color.h"
 #include "Math/Matrix.h"
 #include "IDrawable.h"
+#include "Proxy/RenderProxyTable.h"
+#include "Light/LightData.h"
 #include "ICamera.h"
 #include "IWindow.h"
 
@@ -41,6 +43,14 @@ namespace Lightning
 		};
 		static_assert(std::is_pod<DrawParam>::value, "DrawParam is not a POD type.");
 
+		//Fields of a render proxy to refresh from its drawable
+		enum class RenderProxyDirtyFlags : std::uint8_t
+		{
+			TRANSFORM = 0x01,
+			MATERIAL = 0x02,
+		};
+		ENABLE_ENUM_BITMASK_OPERATORS(RenderProxyDirtyFlags)
+
 		enum class RendererEvent
 		{
 			FRAME_BEGIN,
@@ -67,16 +77,41 @@ namespace Lightning
 			virtual void ClearDepthStencilBuffer(IDepthStencilBuffer* buffer, DepthStencilClearFlags flags, float depth, std::uint8_t stencil, 
 				const RectI* rects = nullptr, std::size_t rectCount = 0) = 0;
 			virtual void ApplyRenderTargets(const IRenderTarget*const * renderTargets, std::size_t renderTargetCount, IDepthStencilBuffer* dsBuffer) = 0;
-			virtual void ApplyPipelineState(const PipelineState& state) = 0;
+			//Returns false if state can't be applied yet because it's compiling in background,draws must be skipped until
+			//another state is applied
+			virtual bool ApplyPipelineState(const PipelineState& state) = 0;
+			//With asynchronous compilation,pipeline states missing from cache are compiled on worker threads and draws
+			//using them are skipped meanwhile instead of stalling the render thread.Disabled by default
+			virtual void SetAsyncPipelineCompile(bool enable) = 0;
+			//Blocks until pipeline states scheduled for compilation are compiled,including the ones of the pipeline state
+			//manifest compiled ahead on start
+			virtual void WaitForPipelineStates() = 0;
 			virtual void ApplyViewports(const Viewport* viewports, std::size_t viewportCount) = 0;
 			virtual void ApplyScissorRects(const ScissorRect* scissorRects, std::size_t scissorRectCount) = 0;
 			//bind pBuffer to a GPU slot(does not copy data,just binding), each invocation will override previous binding
 			virtual void BindVertexBuffer(std::size_t slot, IVertexBuffer* buffer) = 0;
 			virtual void BindIndexBuffer(IIndexBuffer* buffer) = 0;
+			//Queues a write of data to buffer,thread safe.Writes are copied to the GPU in a batch at the start of a frame,limited
+			//by a byte budget per frame so bursts of new objects are spread over several frames.Drawables with buffers that have
+			//queued writes are skipped until the writes are flushed
+			virtual void UploadBuffer(const std::shared_ptr<IGPUBuffer>& buffer, std::size_t offset, const void* data, std::size_t size) = 0;
+			//Whether buffer has queued writes that are not copied yet,thread safe
+			virtual bool IsUploadPending(const IGPUBuffer* buffer) = 0;
 			//Adds a drawable to draw queue,thread safe.
 			virtual void Draw(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera) = 0;
 			//issue underlying draw call
 			virtual void Draw(const DrawParam& param) = 0;
+			//Retained mode.A render proxy is a snapshot of a drawable kept in a proxy table across frames,so only changed fields
+			//have to be updated.Tables are owned by callers,usually one for each scene.Proxy methods are thread unsafe.
+			virtual RenderProxyHandle AddRenderProxy(RenderProxyTable& proxies, const std::shared_ptr<IDrawable>& drawable) = 0;
+			virtual void RemoveRenderProxy(RenderProxyTable& proxies, RenderProxyHandle handle) = 0;
+			//Refreshes the fields specified by flags from the drawable the proxy was created with
+			virtual void UpdateRenderProxy(RenderProxyTable& proxies, RenderProxyHandle handle, RenderProxyDirtyFlags flags) = 0;
+			//Draws all render proxies of the table with camera in current frame.Render passes hold the table until the frame is
+			//rendered,so it may be released by its owner in the meantime
+			virtual void DrawRenderProxies(const std::shared_ptr<const RenderProxyTable>& proxies, const std::shared_ptr<ICamera>& camera) = 0;
+			//Adds a dynamic light to current frame,thread safe.Lights are binned into view clusters by passes that shade with them
+			virtual void DrawLight(const LightData& light) = 0;
 			//get near plane value corresponding to normalized device coordinate
 			//different render API may have different near plane definition
 			//for example OpenGL clips coordinates to [-1, 1] and DirectX clips coordinates to [0, 1]
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "tbb/parallel_for.h"
+#include "SIMD.h"
+#include "LightCluster.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		static constexpr std::size_t LIGHT_GRAIN_SIZE = 64;
+		//layout of mLightRanges
+		enum LightRangeField
+		{
+			MIN_X, MAX_X, MIN_Y, MAX_Y, MIN_Z, MAX_Z, LIGHT_RANGE_FIELD_COUNT
+		};
+
+		LightClusterBuilder::LightClusterBuilder(FrameMemoryAllocator& allocator, std::size_t dimX, std::size_t dimY, std::size_t dimZ)
+			: mAllocator(allocator), mDimX(dimX), mDimY(dimY), mDimZ(dimZ)
+			, mTileTangentsX(dimX + 1), mTileTangentsY(dimY + 1), mTileScalesX(dimX + 1), mTileScalesY(dimY + 1)
+			, mSliceScale(0.0f), mNearPlane(0.0f), mFarPlane(0.0f)
+			, mLightRanges(nullptr), mClusters(nullptr), mLightIndices(nullptr), mLightIndexCount(0)
+		{
+			assert(dimX > 0 && dimX < 256 && dimY > 0 && dimY < 256 && dimZ > 0 && dimZ < 256 && "Invalid light cluster dimensions!");
+		}
+
+		std::size_t LightClusterBuilder::GetSlice(float depth)const
+		{
+			if (depth <= mNearPlane)
+				return 0;
+			auto slice = static_cast<std::size_t>(std::log(depth / mNearPlane) * mSliceScale);
+			return std::min(slice, mDimZ - 1);
+		}
+
+		void LightClusterBuilder::Build(const LightClusterView& view, const LightBounds* lights, std::size_t lightCount)
+		{
+			assert(lightCount <= MAX_CLUSTERED_LIGHTS && "Too many lights to cluster!");
+			assert(view.nearPlane > 0 && view.farPlane > view.nearPlane && "Invalid light cluster view!");
+			mNearPlane = view.nearPlane;
+			mFarPlane = view.farPlane;
+			mSliceScale = mDimZ / std::log(mFarPlane / mNearPlane);
+			//Tile boundary planes pass through the eye.Boundary b of columns is x = t * z and boundary b of rows is -y = t * z,
+			//t grows from left to right and from top to bottom.Light centers are stored with y flipped so rows are handled
+			//the same way as columns
+			auto tanHalfY = std::tan(view.fov * 0.5f);
+			auto tanHalfX = tanHalfY * view.aspectRatio;
+			for (std::size_t b = 0;b <= mDimX;++b)
+			{
+				mTileTangentsX[b] = tanHalfX * (2.0f * b / mDimX - 1.0f);
+				mTileScalesX[b] = std::sqrt(1.0f + mTileTangentsX[b] * mTileTangentsX[b]);
+			}
+			for (std::size_t b = 0;b <= mDimY;++b)
+			{
+				mTileTangentsY[b] = tanHalfY * (2.0f * b / mDimY - 1.0f);
+				mTileScalesY[b] = std::sqrt(1.0f + mTileTangentsY[b] * mTileTangentsY[b]);
+			}
+
+			const auto clusterCount = GetClusterCount();
+			mClusters = mAllocator.Allocate<LightCluster>(clusterCount);
+			mLightIndices = nullptr;
+			mLightIndexCount = 0;
+			if (lightCount == 0)
+				return;
+			//view space spheres in SoA layout,y points downwards
+			auto spheres = mAllocator.Allocate<float>(4 * lightCount);
+			auto x = spheres;
+			auto y = spheres + lightCount;
+			auto z = spheres + 2 * lightCount;
+			auto r = spheres + 3 * lightCount;
+			mLightRanges = mAllocator.Allocate<std::uint8_t>(LIGHT_RANGE_FIELD_COUNT * lightCount);
+			const auto& m = view.viewMatrix;
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, lightCount, LIGHT_GRAIN_SIZE),
+				[this, &m, lights, x, y, z, r](const tbb::blocked_range<std::size_t>& range) {
+				for (auto i = range.begin();i != range.end();++i)
+				{
+					const auto& center = lights[i].center;
+					x[i] = center.x * m.GetCell(0, 0) + center.y * m.GetCell(1, 0) + center.z * m.GetCell(2, 0) + m.GetCell(3, 0);
+					y[i] = -(center.x * m.GetCell(0, 1) + center.y * m.GetCell(1, 1) + center.z * m.GetCell(2, 1) + m.GetCell(3, 1));
+					z[i] = center.x * m.GetCell(0, 2) + center.y * m.GetCell(1, 2) + center.z * m.GetCell(2, 2) + m.GetCell(3, 2);
+					r[i] = lights[i].radius;
+				}
+				ComputeLightRanges(x, y, z, r, range.begin(), range.end());
+			});
+
+			//Slices are binned in parallel,each slice only touches its own clusters.The first pass counts lights of
+			//each cluster,the second one fills the index lists at offsets computed from the counts
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mDimZ, 1),
+				[this, lightCount](const tbb::blocked_range<std::size_t>& range) {
+				for (auto slice = range.begin();slice != range.end();++slice)
+				{
+					BinSlice(slice, lightCount, false);
+				}
+			});
+			std::uint32_t offset{ 0 };
+			for (std::size_t i = 0;i < clusterCount;++i)
+			{
+				mClusters[i].offset = offset;
+				offset += mClusters[i].count;
+				mClusters[i].count = 0;
+			}
+			mLightIndexCount = offset;
+			if (mLightIndexCount == 0)
+				return;
+			mLightIndices = mAllocator.Allocate<std::uint16_t>(mLightIndexCount);
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mDimZ, 1),
+				[this, lightCount](const tbb::blocked_range<std::size_t>& range) {
+				for (auto slice = range.begin();slice != range.end();++slice)
+				{
+					BinSlice(slice, lightCount, true);
+				}
+			});
+		}
+
+		void LightClusterBuilder::ComputeLightRanges(const float* x, const float* y, const float* z, const float* r, std::size_t begin, std::size_t end)
+		{
+			auto ranges = mLightRanges;
+			CountTileBoundaries(x, z, r, mTileTangentsX.data(), mTileScalesX.data(), mDimX + 1, begin, end, ranges + MIN_X, ranges + MAX_X);
+			CountTileBoundaries(y, z, r, mTileTangentsY.data(), mTileScalesY.data(), mDimY + 1, begin, end, ranges + MIN_Y, ranges + MAX_Y);
+			for (auto i = begin;i < end;++i)
+			{
+				auto range = ranges + i * LIGHT_RANGE_FIELD_COUNT;
+				//tiles to skip from the left(top) are in MIN_X(MIN_Y),tiles to skip from the right(bottom) are in MAX_X(MAX_Y)
+				auto outside = range[MIN_X] >= mDimX || range[MAX_X] >= mDimX || range[MIN_Y] >= mDimY || range[MAX_Y] >= mDimY
+					|| z[i] + r[i] < mNearPlane || z[i] - r[i] > mFarPlane;
+				if (outside)
+				{
+					range[MIN_X] = range[MIN_Y] = range[MIN_Z] = 1;
+					range[MAX_X] = range[MAX_Y] = range[MAX_Z] = 0;
+					continue;
+				}
+				range[MAX_X] = static_cast<std::uint8_t>(mDimX - 1 - range[MAX_X]);
+				range[MAX_Y] = static_cast<std::uint8_t>(mDimY - 1 - range[MAX_Y]);
+				range[MIN_Z] = static_cast<std::uint8_t>(GetSlice(z[i] - r[i]));
+				range[MAX_Z] = static_cast<std::uint8_t>(GetSlice(z[i] + r[i]));
+			}
+		}
+
+		//The distance of point(u, z) to boundary plane b is proportional to u - t[b] * z,and a sphere lies completely on one
+		//side of the plane if the distance exceeds r * scale[b].greater receives the number of boundaries in [1, count) the sphere
+		//is completely in front of,less the number of boundaries in [0, count - 1) it is completely behind.As boundaries are
+		//sorted,these are the numbers of tiles to skip from either side.Outputs are strided by LIGHT_RANGE_FIELD_COUNT
+		void LightClusterBuilder::CountTileBoundaries(const float* u, const float* z, const float* r, const float* tangents, const float* scales,
+			std::size_t boundaryCount, std::size_t begin, std::size_t end, std::uint8_t* greater, std::uint8_t* less)
+		{
+			const auto last = boundaryCount - 1;
+			auto n = begin;
+#if defined(LIGHTNING_SIMD_AVX)
+			for (;n + 8 <= end;n += 8)
+			{
+				auto U = _mm256_loadu_ps(u + n);
+				auto Z = _mm256_loadu_ps(z + n);
+				auto R = _mm256_loadu_ps(r + n);
+				auto one = _mm256_set1_ps(1.0f);
+				auto greaterCount = _mm256_setzero_ps();
+				auto lessCount = _mm256_setzero_ps();
+				for (std::size_t b = 0;b < boundaryCount;++b)
+				{
+					auto distance = _mm256_sub_ps(U, _mm256_mul_ps(_mm256_set1_ps(tangents[b]), Z));
+					auto radius = _mm256_mul_ps(R, _mm256_set1_ps(scales[b]));
+					if (b > 0)
+						greaterCount = _mm256_add_ps(greaterCount, _mm256_and_ps(_mm256_cmp_ps(distance, radius, _CMP_GT_OQ), one));
+					if (b < last)
+						lessCount = _mm256_add_ps(lessCount, _mm256_and_ps(_mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), radius), _CMP_LT_OQ), one));
+				}
+				float greaterCounts[8], lessCounts[8];
+				_mm256_storeu_ps(greaterCounts, greaterCount);
+				_mm256_storeu_ps(lessCounts, lessCount);
+				for (std::size_t k = 0;k < 8;++k)
+				{
+					greater[(n + k) * LIGHT_RANGE_FIELD_COUNT] = static_cast<std::uint8_t>(greaterCounts[k]);
+					less[(n + k) * LIGHT_RANGE_FIELD_COUNT] = static_cast<std::uint8_t>(lessCounts[k]);
+				}
+			}
+#endif
+#if defined(LIGHTNING_SIMD_SSE)
+			for (;n + 4 <= end;n += 4)
+			{
+				auto U = _mm_loadu_ps(u + n);
+				auto Z = _mm_loadu_ps(z + n);
+				auto R = _mm_loadu_ps(r + n);
+				auto one = _mm_set1_ps(1.0f);
+				auto greaterCount = _mm_setzero_ps();
+				auto lessCount = _mm_setzero_ps();
+				for (std::size_t b = 0;b < boundaryCount;++b)
+				{
+					auto distance = _mm_sub_ps(U, _mm_mul_ps(_mm_set1_ps(tangents[b]), Z));
+					auto radius = _mm_mul_ps(R, _mm_set1_ps(scales[b]));
+					if (b > 0)
+						greaterCount = _mm_add_ps(greaterCount, _mm_and_ps(_mm_cmpgt_ps(distance, radius), one));
+					if (b < last)
+						lessCount = _mm_add_ps(lessCount, _mm_and_ps(_mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)), one));
+				}
+				float greaterCounts[4], lessCounts[4];
+				_mm_storeu_ps(greaterCounts, greaterCount);
+				_mm_storeu_ps(lessCounts, lessCount);
+				for (std::size_t k = 0;k < 4;++k)
+				{
+					greater[(n + k) * LIGHT_RANGE_FIELD_COUNT] = static_cast<std::uint8_t>(greaterCounts[k]);
+					less[(n + k) * LIGHT_RANGE_FIELD_COUNT] = static_cast<std::uint8_t>(lessCounts[k]);
+				}
+			}
+#endif
+			for (;n < end;++n)
+			{
+				std::uint8_t greaterCount{ 0 }, lessCount{ 0 };
+				for (std::size_t b = 0;b < boundaryCount;++b)
+				{
+					auto distance = u[n] - tangents[b] * z[n];
+					auto radius = r[n] * scales[b];
+					if (b > 0 && distance > radius)
+						++greaterCount;
+					if (b < last && distance < -radius)
+						++lessCount;
+				}
+				greater[n * LIGHT_RANGE_FIELD_COUNT] = greaterCount;
+				less[n * LIGHT_RANGE_FIELD_COUNT] = lessCount;
+			}
+		}
+
+		void LightClusterBuilder::BinSlice(std::size_t slice, std::size_t lightCount, bool fill)
+		{
+			for (std::size_t i = 0;i < lightCount;++i)
+			{
+				const auto range = mLightRanges + i * LIGHT_RANGE_FIELD_COUNT;
+				if (slice < range[MIN_Z] || slice > range[MAX_Z])
+					continue;
+				for (std::size_t y = range[MIN_Y];y <= range[MAX_Y];++y)
+				{
+					for (std::size_t x = range[MIN_X];x <= range[MAX_X];++x)
+					{
+						auto& cluster = mClusters[GetClusterIndex(x, y, slice)];
+						if (fill)
+							mLightIndices[cluster.offset + cluster.count] = static_cast<std::uint16_t>(i);
+						++cluster.count;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "FrameMemoryAllocator.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using Foundation::Math::Vector3f;
+		using Foundation::Math::Matrix4f;
+		constexpr std::size_t LIGHT_CLUSTER_DIM_X = 16;
+		constexpr std::size_t LIGHT_CLUSTER_DIM_Y = 9;
+		constexpr std::size_t LIGHT_CLUSTER_DIM_Z = 24;
+		//Light indices are stored in 16 bits
+		constexpr std::size_t MAX_CLUSTERED_LIGHTS = 65535;
+
+		//Bounding sphere of a light in world space
+		struct LightBounds
+		{
+			Vector3f center;
+			float radius;
+		};
+
+		//Light index list of a cluster is lightIndices[offset, offset + count)
+		struct LightCluster
+		{
+			std::uint32_t offset;
+			std::uint32_t count;
+		};
+
+		struct LightClusterView
+		{
+			Matrix4f viewMatrix;
+			//vertical field of view in radians
+			float fov;
+			float aspectRatio;
+			float nearPlane;
+			float farPlane;
+		};
+
+		//Bins lights into clusters of the view frustum(froxels).The screen is split into dimX * dimY tiles and depth into dimZ
+		//slices growing exponentially from near to far plane.Build runs on worker threads,light spheres are tested against
+		//cluster planes several lights at a time with SIMD,and the per cluster light index lists are packed into one array
+		//allocated from frame memory,so results are valid until the allocator releases the frame.Thread unsafe
+		class LightClusterBuilder
+		{
+		public:
+			LightClusterBuilder(FrameMemoryAllocator& allocator, std::size_t dimX = LIGHT_CLUSTER_DIM_X,
+				std::size_t dimY = LIGHT_CLUSTER_DIM_Y, std::size_t dimZ = LIGHT_CLUSTER_DIM_Z);
+			void Build(const LightClusterView& view, const LightBounds* lights, std::size_t lightCount);
+			std::size_t GetDimX()const { return mDimX; }
+			std::size_t GetDimY()const { return mDimY; }
+			std::size_t GetDimZ()const { return mDimZ; }
+			std::size_t GetClusterCount()const { return mDimX * mDimY * mDimZ; }
+			//x grows to the right and y grows downwards like screen coordinates
+			std::size_t GetClusterIndex(std::size_t x, std::size_t y, std::size_t z)const { return (z * mDimY + y) * mDimX + x; }
+			//The following methods are valid after Build
+			const LightCluster* GetClusters()const { return mClusters; }
+			const std::uint16_t* GetLightIndices()const { return mLightIndices; }
+			std::size_t GetLightIndexCount()const { return mLightIndexCount; }
+			//Depth slice of a view space depth,clamped to valid slices
+			std::size_t GetSlice(float depth)const;
+		private:
+			//Inclusive cluster ranges each light overlaps,computed from view space spheres
+			void ComputeLightRanges(const float* x, const float* y, const float* z, const float* r, std::size_t begin, std::size_t end);
+			//Counts the tile boundary planes each light sphere lies completely on one side of
+			static void CountTileBoundaries(const float* u, const float* z, const float* r, const float* tangents, const float* scales,
+				std::size_t boundaryCount, std::size_t begin, std::size_t end, std::uint8_t* greater, std::uint8_t* less);
+			void BinSlice(std::size_t slice, std::size_t lightCount, bool fill);
+			FrameMemoryAllocator& mAllocator;
+			std::size_t mDimX;
+			std::size_t mDimY;
+			std::size_t mDimZ;
+			//tan of the angle between view direction and each tile boundary plane,dimX + 1 and dimY + 1 of them
+			std::vector<float> mTileTangentsX;
+			std::vector<float> mTileTangentsY;
+			//sqrt(1 + tan^2) of each boundary plane,scales light radius to compare with unnormalized plane distances
+			std::vector<float> mTileScalesX;
+			std::vector<float> mTileScalesY;
+			//dimZ / log(far / near),slice of depth d is log(d / near) * mSliceScale
+			float mSliceScale;
+			float mNearPlane;
+			float mFarPlane;
+			//per light [min, max] cluster coordinates,min > max if the light is outside of the frustum
+			std::uint8_t* mLightRanges;
+			LightCluster* mClusters;
+			std::uint16_t* mLightIndices;
+			std::size_t mLightIndexCount;
+		};
+	}
+}
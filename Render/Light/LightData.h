@@ -0,0 +1,48 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include "Color.h"
+#include "LightCluster.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		enum class LightType : std::uint8_t
+		{
+			POINT,
+			SPOT
+		};
+
+		//A dynamic light drawn in a frame,in world space
+		struct LightData
+		{
+			LightType type;
+			Vector3f position;
+			//normalized direction of spot light
+			Vector3f direction;
+			ColorF color;
+			float intensity;
+			//distance at which the light fades out
+			float range;
+			//half angle of spot light cone in radians
+			float spotAngle;
+		};
+
+		//Bounding sphere of the volume lit by light.A narrow spot light gets the smallest sphere around its cone
+		inline LightBounds GetLightBounds(const LightData& light)
+		{
+			if (light.type == LightType::SPOT)
+			{
+				auto cosAngle = std::cos(light.spotAngle);
+				if (cosAngle >= 0.70710678f)
+				{
+					auto radius = light.range / (2.0f * cosAngle);
+					return LightBounds{ light.position + light.direction * radius, radius };
+				}
+				return LightBounds{ light.position + light.direction * (light.range * cosAngle), light.range * std::sin(light.spotAngle) };
+			}
+			return LightBounds{ light.position, light.range };
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "LodSelector.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		LodSelector::LodSelector() : mTriangleBudget(0), mHysteresis(0.1f)
+		{
+
+		}
+
+		LodSelectionStats LodSelector::Select(const LodInstance* instances, std::size_t count, std::uint8_t* levels)
+		{
+			LodSelectionStats stats{ 0, 0, 0 };
+			for (std::size_t i = 0;i < count;++i)
+			{
+				const auto& instance = instances[i];
+				assert(instance.chain->levelCount > 0 && instance.chain->levelCount <= MAX_LOD_LEVELS && "Invalid lod chain!");
+				levels[i] = SelectLevel(instance, levels[i]);
+				stats.submittedTriangles += instance.chain->triangleCounts[levels[i]];
+				stats.fullDetailTriangles += instance.chain->triangleCounts[0];
+			}
+			if (mTriangleBudget > 0 && stats.submittedTriangles > mTriangleBudget)
+				FitBudget(instances, count, levels, stats);
+			return stats;
+		}
+
+		std::uint8_t LodSelector::SelectLevel(const LodInstance& instance, std::uint8_t previousLevel)const
+		{
+			const auto& chain = *instance.chain;
+			const auto lastLevel = chain.levelCount - 1;
+			if (previousLevel > lastLevel)
+			{
+				std::uint32_t level{ 0 };
+				while (level < lastLevel && instance.screenSize < chain.screenSizes[level])
+					++level;
+				return static_cast<std::uint8_t>(level);
+			}
+			//thresholds are widened by hysteresis in the direction of the switch
+			std::uint32_t level = previousLevel;
+			while (level > 0 && instance.screenSize >= chain.screenSizes[level - 1] * (1.0f + mHysteresis))
+				--level;
+			while (level < lastLevel && instance.screenSize < chain.screenSizes[level] * (1.0f - mHysteresis))
+				++level;
+			return static_cast<std::uint8_t>(level);
+		}
+
+		void LodSelector::FitBudget(const LodInstance* instances, std::size_t count, std::uint8_t* levels, LodSelectionStats& stats)
+		{
+			mBudgetOrder.resize(count);
+			for (std::size_t i = 0;i < count;++i)
+			{
+				mBudgetOrder[i] = static_cast<std::uint32_t>(i);
+			}
+			std::sort(mBudgetOrder.begin(), mBudgetOrder.end(), [instances](std::uint32_t lhs, std::uint32_t rhs) {
+				return instances[lhs].screenSize < instances[rhs].screenSize;
+			});
+			//Each round makes every instance one level coarser,smallest first,until the budget is met.
+			//The first round visits all instances,so it alone counts the instances that are coarsened
+			for (std::size_t round = 0;round < MAX_LOD_LEVELS;++round)
+			{
+				bool coarsened{ false };
+				for (auto i : mBudgetOrder)
+				{
+					const auto& chain = *instances[i].chain;
+					if (levels[i] + 1u >= chain.levelCount)
+						continue;
+					stats.submittedTriangles -= chain.triangleCounts[levels[i]] - chain.triangleCounts[levels[i] + 1];
+					++levels[i];
+					coarsened = true;
+					if (round == 0)
+						++stats.budgetCoarsenedInstances;
+					if (stats.submittedTriangles <= mTriangleBudget)
+						return;
+				}
+				if (!coarsened)
+					return;
+			}
+		}
+
+		float LodSelector::ComputeScreenSize(const Vector3f& center, float radius, const Vector3f& cameraPosition, float projectionScale)
+		{
+			auto dx = center.x - cameraPosition.x;
+			auto dy = center.y - cameraPosition.y;
+			auto dz = center.z - cameraPosition.z;
+			auto distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+			//camera inside the sphere
+			if (distance <= radius)
+				return 1.0f;
+			return std::min(1.0f, radius * projectionScale / distance);
+		}
+	}
+}
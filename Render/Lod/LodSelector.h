@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using Foundation::Math::Vector3f;
+		constexpr std::size_t MAX_LOD_LEVELS = 8;
+
+		//Levels of detail of a drawable,level 0 is the finest.
+		//Level i is used while the screen size of the drawable is at least screenSizes[i],the last level has no lower bound
+		struct LodChain
+		{
+			std::uint32_t levelCount;
+			std::uint32_t triangleCounts[MAX_LOD_LEVELS];
+			float screenSizes[MAX_LOD_LEVELS];
+		};
+
+		struct LodInstance
+		{
+			const LodChain* chain;
+			//fraction of the screen height covered by the drawable,see ComputeScreenSize
+			float screenSize;
+		};
+
+		struct LodSelectionStats
+		{
+			//triangles of the selected levels
+			std::size_t submittedTriangles;
+			//triangles if every instance used level 0
+			std::size_t fullDetailTriangles;
+			//instances made coarser than their screen size asks for to fit the triangle budget
+			std::size_t budgetCoarsenedInstances;
+		};
+
+		//Chooses a level of detail for each instance from its projected screen size.An instance only switches level once
+		//its screen size crosses the threshold by the hysteresis ratio,so instances near a threshold don't flicker between
+		//levels.If the selected levels exceed the triangle budget,instances with the smallest screen size are made coarser
+		//first.Thread unsafe
+		class LodSelector
+		{
+		public:
+			LodSelector();
+			//levels is in/out:it holds the levels selected in the previous frame(MAX_LOD_LEVELS for new instances,which
+			//select without hysteresis) and receives the levels of this frame
+			LodSelectionStats Select(const LodInstance* instances, std::size_t count, std::uint8_t* levels);
+			//0 means unlimited
+			void SetTriangleBudget(std::size_t budget) { mTriangleBudget = budget; }
+			std::size_t GetTriangleBudget()const { return mTriangleBudget; }
+			void SetHysteresis(float hysteresis) { mHysteresis = hysteresis; }
+			float GetHysteresis()const { return mHysteresis; }
+			//Fraction of the screen height covered by a bounding sphere.projectionScale is cell(1, 1) of the projection
+			//matrix(cot(fov / 2) for a perspective camera)
+			static float ComputeScreenSize(const Vector3f& center, float radius, const Vector3f& cameraPosition, float projectionScale);
+		private:
+			std::uint8_t SelectLevel(const LodInstance& instance, std::uint8_t previousLevel)const;
+			void FitBudget(const LodInstance* instances, std::size_t count, std::uint8_t* levels, LodSelectionStats& stats);
+			std::size_t mTriangleBudget;
+			float mHysteresis;
+			std::vector<std::uint32_t> mBudgetOrder;
+		};
+	}
+}
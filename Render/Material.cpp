@@ -1,4 +1,6 @@
 #include "Material.h"
+#include "Renderer.h"
+#include "Logger.h"
 
 namespace Lightning
 {
@@ -23,6 +25,7 @@ namespace Lightning
 
 		void Material::SetShader(ShaderType shaderType, const std::shared_ptr<IShader>& shader)
 		{
+			mBindingTables[GetShaderTypeIndex(shaderType)].valid = false;
 			if (!shader)
 			{
 				mShaders.erase(shaderType);
@@ -34,7 +37,15 @@ namespace Lightning
 
 		bool Material::SetParameter(const Parameter& parameter)
 		{
+			auto it = mParameters.find(parameter.GetName());
+			if (it != mParameters.end() && it->second.GetType() == parameter.GetType())
+			{
+				//Same type assignment reuses the value storage,so bindings pointing to it are still valid.
+				it->second = parameter;
+				return true;
+			}
 			mParameters[parameter.GetName()] = parameter;
+			InvalidateBindingTables();
 			return true;
 		}
 
@@ -79,5 +90,72 @@ namespace Lightning
 				visitor(it->second);
 			}
 		}
+	
+		const MaterialBindingTable* Material::GetBindingTable(ShaderType shaderType)
+		{
+			auto it = mShaders.find(shaderType);
+			if (it == mShaders.end())
+				return nullptr;
+			auto& cache = mBindingTables[GetShaderTypeIndex(shaderType)];
+			if (!cache.valid.load(std::memory_order_acquire))
+			{
+				tbb::spin_mutex::scoped_lock lock(mBindingTableMutex);
+				if (!cache.valid.load(std::memory_order_relaxed))
+				{
+					BuildBindingTable(it->second.get(), cache.table);
+					cache.valid.store(true, std::memory_order_release);
+				}
+			}
+			return &cache.table;
+		}
+
+		std::size_t Material::GetShaderTypeIndex(ShaderType shaderType)
+		{
+			auto index = static_cast<std::size_t>(shaderType) - static_cast<std::size_t>(ShaderType::VERTEX);
+			assert(index < SHADER_TYPE_COUNT && "Invalid shader type.");
+			return index;
+		}
+
+		void Material::BuildBindingTable(IShader* shader, MaterialBindingTable& table)
+		{
+			table.shader = shader;
+			table.bindings.clear();
+			for (const auto& pair : mParameters)
+			{
+				MaterialParameterBinding binding;
+				if (!shader->GetParameterBinding(pair.first, binding.binding))
+					continue;
+				if (binding.binding.type != pair.second.GetType())
+				{
+					LOG_WARNING("Mismatched type of material parameter {0} in shader {1}", pair.first, shader->GetName());
+					continue;
+				}
+				std::size_t size{ 0 };
+				binding.data = pair.second.Buffer(size);
+				binding.semantic = RenderSemantics::UNKNOWN;
+				table.bindings.push_back(binding);
+			}
+			RenderSemantics* semantics{ nullptr };
+			std::uint16_t semanticCount{ 0 };
+			shader->GetUniformSemantics(&semantics, semanticCount);
+			for (auto i = 0;i < semanticCount;++i)
+			{
+				MaterialParameterBinding binding;
+				auto uniformName = Renderer::Instance()->GetUniformName(semantics[i]);
+				if (!uniformName || !shader->GetParameterBinding(uniformName, binding.binding))
+					continue;
+				binding.data = nullptr;
+				binding.semantic = semantics[i];
+				table.bindings.push_back(binding);
+			}
+		}
+
+		void Material::InvalidateBindingTables()
+		{
+			for (auto& cache : mBindingTables)
+			{
+				cache.valid = false;
+			}
+		}
 	}
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include <memory>
+#include <atomic>
+#include <tbb/spin_mutex.h>
 #include "Semantics.h"
 #include "IMaterial.h"
 #include "Parameter.h"
@@ -21,10 +23,22 @@ namespace Lightning
 			void EnableBlend(bool enable)override;
 			void GetBlendState(BlendState& state)const override{ state = mBlendState; }
 			void VisitParameters(std::function<void(const Parameter& parameter)> visitor)const override;
+			const MaterialBindingTable* GetBindingTable(ShaderType shaderType)override;
 		protected:
+			static constexpr std::size_t SHADER_TYPE_COUNT = 5;
+			struct BindingTableCache
+			{
+				MaterialBindingTable table;
+				std::atomic<bool> valid{ false };
+			};
+			static std::size_t GetShaderTypeIndex(ShaderType shaderType);
+			void BuildBindingTable(IShader* shader, MaterialBindingTable& table);
+			void InvalidateBindingTables();
 			std::unordered_map<ShaderType, std::shared_ptr<IShader>> mShaders;
 			std::unordered_map<std::string, Parameter> mParameters;
 			BlendState mBlendState;
+			BindingTableCache mBindingTables[SHADER_TYPE_COUNT];
+			tbb::spin_mutex mBindingTableMutex;
 		};
 	}
 }
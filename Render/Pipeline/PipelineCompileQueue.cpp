@@ -0,0 +1,71 @@
+#include <memory>
+#include <vector>
+#include "PipelineCompileQueue.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		PipelineCompileQueue::PipelineCompileQueue(IPipelineStateCompiler& compiler)
+			: mCompiler(compiler), mPendingCount(0), mReadyCount(0), mFailedCount(0)
+		{
+
+		}
+
+		PipelineCompileQueue::~PipelineCompileQueue()
+		{
+			Wait();
+		}
+
+		PipelineCompileStatus PipelineCompileQueue::Request(std::size_t hash, const void* desc, std::size_t size)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				auto result = mStatuses.emplace(hash, PipelineCompileStatus::PENDING);
+				if (!result.second)
+					return result.first->second;
+				++mPendingCount;
+			}
+			auto bytes = static_cast<const std::uint8_t*>(desc);
+			auto descCopy = std::make_shared<std::vector<std::uint8_t>>(bytes, bytes + size);
+			mArena.enqueue([this, hash, descCopy]() {
+				auto compiled = mCompiler.CompilePipelineState(descCopy->data(), descCopy->size());
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mStatuses[hash] = compiled ? PipelineCompileStatus::READY : PipelineCompileStatus::FAILED;
+					++(compiled ? mReadyCount : mFailedCount);
+					--mPendingCount;
+				}
+				mCompiled.notify_all();
+			});
+			return PipelineCompileStatus::PENDING;
+		}
+
+		PipelineCompileStatus PipelineCompileQueue::GetStatus(std::size_t hash)const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto it = mStatuses.find(hash);
+			if (it == mStatuses.end())
+				return PipelineCompileStatus::NONE;
+			return it->second;
+		}
+
+		void PipelineCompileQueue::Wait()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCompiled.wait(lock, [this]() { return mPendingCount == 0; });
+		}
+
+		PipelineCompileStatus PipelineCompileQueue::Wait(std::size_t hash)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			auto it = mStatuses.find(hash);
+			if (it == mStatuses.end())
+				return PipelineCompileStatus::NONE;
+			//references to elements stay valid when other requests rehash the map,iterators don't
+			const auto& status = it->second;
+			mCompiled.wait(lock, [&status]() { return status != PipelineCompileStatus::PENDING; });
+			return status;
+		}
+	}
+}
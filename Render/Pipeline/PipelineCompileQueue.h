@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include "tbb/task_arena.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		struct IPipelineStateCompiler
+		{
+			virtual ~IPipelineStateCompiler() = default;
+			//Creates and caches the backend pipeline object of a description written by the renderer.
+			//Runs on worker threads,several states may be compiled at the same time.Returns false if compilation fails
+			virtual bool CompilePipelineState(const void* desc, std::size_t size) = 0;
+		};
+
+		enum class PipelineCompileStatus : std::uint8_t
+		{
+			//never requested
+			NONE,
+			//scheduled or compiling on a worker thread
+			PENDING,
+			READY,
+			FAILED
+		};
+
+		//Compiles pipeline states on worker threads so the render thread never waits for the driver.A state is compiled at
+		//most once,its status tells whether draws can use it yet.Requests may come from any thread,including loader callbacks,
+		//so compilations are enqueued to an arena rather than spawned from the requesting thread.Thread safe
+		class PipelineCompileQueue
+		{
+		public:
+			explicit PipelineCompileQueue(IPipelineStateCompiler& compiler);
+			PipelineCompileQueue(const PipelineCompileQueue&) = delete;
+			PipelineCompileQueue& operator=(const PipelineCompileQueue&) = delete;
+			//Waits for scheduled states,the compiler must outlive the queue
+			~PipelineCompileQueue();
+			//Schedules compilation of a description of size bytes unless hash is already requested.desc is copied.
+			//Returns the status of hash after the call
+			PipelineCompileStatus Request(std::size_t hash, const void* desc, std::size_t size);
+			PipelineCompileStatus GetStatus(std::size_t hash)const;
+			//Blocks until all scheduled states are compiled.Must not be called from a compilation
+			void Wait();
+			//Blocks until hash is no longer pending and returns its status.Must not be called from a compilation
+			PipelineCompileStatus Wait(std::size_t hash);
+			std::size_t GetPendingCount()const { return mPendingCount; }
+			std::size_t GetReadyCount()const { return mReadyCount; }
+			std::size_t GetFailedCount()const { return mFailedCount; }
+		private:
+			IPipelineStateCompiler& mCompiler;
+			tbb::task_arena mArena;
+			mutable std::mutex mMutex;
+			std::condition_variable mCompiled;
+			std::unordered_map<std::size_t, PipelineCompileStatus> mStatuses;
+			std::atomic<std::size_t> mPendingCount;
+			std::atomic<std::size_t> mReadyCount;
+			std::atomic<std::size_t> mFailedCount;
+		};
+	}
+}
@@ -0,0 +1,180 @@
+#include <cstring>
+#include <type_traits>
+#include "PipelineStateDesc.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		namespace
+		{
+			class DescWriter
+			{
+			public:
+				DescWriter(std::vector<std::uint8_t>& buffer) : mBuffer(buffer){}
+				void WriteBytes(const void* data, std::size_t size)
+				{
+					auto bytes = static_cast<const std::uint8_t*>(data);
+					mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+				}
+				template<typename T>
+				void Write(const T& value)
+				{
+					static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written.");
+					WriteBytes(&value, sizeof(T));
+				}
+				void WriteString(const std::string& str)
+				{
+					Write(static_cast<std::uint32_t>(str.length()));
+					WriteBytes(str.data(), str.length());
+				}
+			private:
+				std::vector<std::uint8_t>& mBuffer;
+			};
+
+			class DescReader
+			{
+			public:
+				DescReader(const void* data, std::size_t size) : mData(static_cast<const std::uint8_t*>(data)), mSize(size), mOffset(0){}
+				bool ReadBytes(void* data, std::size_t size)
+				{
+					if (mSize - mOffset < size)
+						return false;
+					std::memcpy(data, mData + mOffset, size);
+					mOffset += size;
+					return true;
+				}
+				template<typename T>
+				bool Read(T& value)
+				{
+					static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read.");
+					return ReadBytes(&value, sizeof(T));
+				}
+				bool ReadString(std::string& str)
+				{
+					std::uint32_t length{ 0 };
+					if (!Read(length) || mSize - mOffset < length)
+						return false;
+					str.assign(reinterpret_cast<const char*>(mData + mOffset), length);
+					mOffset += length;
+					return true;
+				}
+				//Reads an element count,rejecting counts larger than the remaining bytes can hold
+				bool ReadCount(std::uint32_t& count, std::size_t minElementSize)
+				{
+					return Read(count) && count <= (mSize - mOffset) / minElementSize;
+				}
+				bool AtEnd()const { return mOffset == mSize; }
+			private:
+				const std::uint8_t* mData;
+				std::size_t mSize;
+				std::size_t mOffset;
+			};
+
+			void AppendShaderKey(const std::shared_ptr<IShader>& shader, std::vector<PipelineShaderKey>& shaders)
+			{
+				if (!shader)
+					return;
+				PipelineShaderKey key;
+				key.type = shader->GetType();
+				key.name = shader->GetName();
+				auto macros = shader->GetMacros();
+				if (macros)
+				{
+					macros->GetAllMacros(key.macros);
+				}
+				shaders.push_back(std::move(key));
+			}
+		}
+
+		void PipelineStateDesc::Assign(const PipelineState& state)
+		{
+			primType = state.primType;
+			rasterizerState = state.rasterizerState;
+			depthStencilState = state.depthStencilState;
+			shaders.clear();
+			AppendShaderKey(state.vs, shaders);
+			AppendShaderKey(state.fs, shaders);
+			AppendShaderKey(state.gs, shaders);
+			AppendShaderKey(state.hs, shaders);
+			AppendShaderKey(state.ds, shaders);
+			inputLayoutSlots.clear();
+			inputLayoutComponents.clear();
+			for (const auto& inputLayout : state.inputLayouts)
+			{
+				inputLayoutSlots.push_back(inputLayout.slot);
+				inputLayoutComponents.emplace_back(inputLayout.components, inputLayout.components + inputLayout.componentCount);
+			}
+			renderTargetBlendStates = state.renderTargetBlendStates;
+		}
+
+		void PipelineStateDesc::Write(std::vector<std::uint8_t>& buffer)const
+		{
+			DescWriter writer(buffer);
+			writer.Write(primType);
+			writer.Write(rasterizerState);
+			writer.Write(depthStencilState);
+			writer.Write(static_cast<std::uint32_t>(shaders.size()));
+			for (const auto& shader : shaders)
+			{
+				writer.Write(shader.type);
+				writer.WriteString(shader.name);
+				writer.Write(static_cast<std::uint32_t>(shader.macros.size()));
+				for (const auto& macro : shader.macros)
+				{
+					writer.WriteString(macro.first);
+					writer.WriteString(macro.second);
+				}
+			}
+			writer.Write(static_cast<std::uint32_t>(inputLayoutSlots.size()));
+			for (std::size_t i = 0;i < inputLayoutSlots.size();++i)
+			{
+				writer.Write(static_cast<std::uint32_t>(inputLayoutSlots[i]));
+				writer.Write(static_cast<std::uint32_t>(inputLayoutComponents[i].size()));
+				writer.WriteBytes(inputLayoutComponents[i].data(), inputLayoutComponents[i].size() * sizeof(VertexComponent));
+			}
+			writer.Write(static_cast<std::uint32_t>(renderTargetBlendStates.size()));
+			writer.WriteBytes(renderTargetBlendStates.data(), renderTargetBlendStates.size() * sizeof(RenderTargetBlendState));
+		}
+
+		bool PipelineStateDesc::Read(const void* data, std::size_t size)
+		{
+			DescReader reader(data, size);
+			std::uint32_t count{ 0 };
+			if (!reader.Read(primType) || !reader.Read(rasterizerState) || !reader.Read(depthStencilState)
+				|| !reader.ReadCount(count, sizeof(ShaderType)))
+				return false;
+			shaders.resize(count);
+			for (auto& shader : shaders)
+			{
+				std::uint32_t macroCount{ 0 };
+				if (!reader.Read(shader.type) || !reader.ReadString(shader.name) || !reader.ReadCount(macroCount, 2 * sizeof(std::uint32_t)))
+					return false;
+				shader.macros.resize(macroCount);
+				for (auto& macro : shader.macros)
+				{
+					if (!reader.ReadString(macro.first) || !reader.ReadString(macro.second))
+						return false;
+				}
+			}
+			if (!reader.ReadCount(count, 2 * sizeof(std::uint32_t)))
+				return false;
+			inputLayoutSlots.resize(count);
+			inputLayoutComponents.resize(count);
+			for (std::size_t i = 0;i < count;++i)
+			{
+				std::uint32_t slot{ 0 }, componentCount{ 0 };
+				if (!reader.Read(slot) || !reader.ReadCount(componentCount, sizeof(VertexComponent)))
+					return false;
+				inputLayoutSlots[i] = slot;
+				inputLayoutComponents[i].resize(componentCount);
+				if (!reader.ReadBytes(inputLayoutComponents[i].data(), componentCount * sizeof(VertexComponent)))
+					return false;
+			}
+			if (!reader.ReadCount(count, sizeof(RenderTargetBlendState)))
+				return false;
+			renderTargetBlendStates.resize(count);
+			return reader.ReadBytes(renderTargetBlendStates.data(), count * sizeof(RenderTargetBlendState)) && reader.AtEnd();
+		}
+	}
+}
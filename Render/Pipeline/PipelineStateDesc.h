@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PipelineState.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		struct PipelineShaderKey
+		{
+			ShaderType type;
+			std::string name;
+			std::vector<std::pair<std::string, std::string>> macros;
+		};
+
+		//A self contained copy of a PipelineState.Shaders are referred by type,name and macros and vertex components are
+		//stored by value,so it can be written to a pipeline state manifest and rebuilt in another session once the shaders
+		//are loaded again
+		struct PipelineStateDesc
+		{
+			void Assign(const PipelineState& state);
+			void Write(std::vector<std::uint8_t>& buffer)const;
+			//Returns false if data is not a description written by Write
+			bool Read(const void* data, std::size_t size);
+			PrimitiveType primType;
+			RasterizerState rasterizerState;
+			DepthStencilState depthStencilState;
+			std::vector<PipelineShaderKey> shaders;
+			std::vector<std::size_t> inputLayoutSlots;
+			std::vector<std::vector<VertexComponent>> inputLayoutComponents;
+			std::vector<RenderTargetBlendState> renderTargetBlendStates;
+		};
+	}
+}
@@ -0,0 +1,119 @@
+#include <fstream>
+#include "PipelineStateManifest.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		namespace
+		{
+			template<typename T>
+			void WriteValue(std::ofstream& file, const T& value)
+			{
+				file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			template<typename T>
+			bool ReadValue(std::ifstream& file, T& value)
+			{
+				return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+			}
+		}
+
+		constexpr std::uint32_t PipelineStateManifest::FILE_MAGIC;
+		constexpr std::uint32_t PipelineStateManifest::FILE_VERSION;
+
+		PipelineStateManifest::PipelineStateManifest() : mDirty(false)
+		{
+
+		}
+
+		bool PipelineStateManifest::Add(std::size_t hash, const void* desc, std::size_t size)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mEntryIndices.find(hash) != mEntryIndices.end())
+				return false;
+			mEntryIndices.emplace(hash, mEntries.size());
+			auto bytes = static_cast<const std::uint8_t*>(desc);
+			mEntries.push_back(Entry{ hash, std::vector<std::uint8_t>(bytes, bytes + size) });
+			mDirty = true;
+			return true;
+		}
+
+		bool PipelineStateManifest::Contains(std::size_t hash)const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mEntryIndices.find(hash) != mEntryIndices.end();
+		}
+
+		std::size_t PipelineStateManifest::GetCount()const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mEntries.size();
+		}
+
+		void PipelineStateManifest::Clear()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mEntries.clear();
+			mEntryIndices.clear();
+			mDirty = false;
+		}
+
+		//File layout : magic,version,state count,then hash,description size and description bytes of each state
+		bool PipelineStateManifest::Save(const std::string& path)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file)
+				return false;
+			WriteValue(file, FILE_MAGIC);
+			WriteValue(file, FILE_VERSION);
+			WriteValue(file, static_cast<std::uint32_t>(mEntries.size()));
+			for (const auto& entry : mEntries)
+			{
+				WriteValue(file, entry.hash);
+				WriteValue(file, static_cast<std::uint32_t>(entry.desc.size()));
+				file.write(reinterpret_cast<const char*>(entry.desc.data()), entry.desc.size());
+			}
+			if (!file)
+				return false;
+			mDirty = false;
+			return true;
+		}
+
+		bool PipelineStateManifest::Load(const std::string& path)
+		{
+			Clear();
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+			std::uint32_t magic{ 0 }, version{ 0 }, count{ 0 };
+			if (!ReadValue(file, magic) || !ReadValue(file, version) || !ReadValue(file, count)
+				|| magic != FILE_MAGIC || version != FILE_VERSION)
+				return false;
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (std::uint32_t i = 0;i < count;++i)
+			{
+				Entry entry;
+				std::uint32_t size{ 0 };
+				if (!ReadValue(file, entry.hash) || !ReadValue(file, size))
+					break;
+				entry.desc.resize(size);
+				if (!file.read(reinterpret_cast<char*>(entry.desc.data()), size))
+					break;
+				if (mEntryIndices.emplace(entry.hash, mEntries.size()).second)
+				{
+					mEntries.push_back(std::move(entry));
+				}
+			}
+			if (!file)
+			{
+				mEntries.clear();
+				mEntryIndices.clear();
+				return false;
+			}
+			return true;
+		}
+	}
+}
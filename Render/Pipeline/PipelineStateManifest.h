@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Lightning
+{
+	namespace Render
+	{
+		//Pipeline state descriptions seen in a session.It's saved on shut down and compiled ahead on next start up,so the first
+		//frames using a state don't wait for the driver.Descriptions are opaque bytes written by the renderer,keyed by pipeline
+		//state hash.Add,Contains and ForEach are thread safe
+		class PipelineStateManifest
+		{
+		public:
+			static constexpr std::uint32_t FILE_MAGIC = 0x4d53504c;	//"LPSM"
+			static constexpr std::uint32_t FILE_VERSION = 1;
+			PipelineStateManifest();
+			PipelineStateManifest(const PipelineStateManifest&) = delete;
+			PipelineStateManifest& operator=(const PipelineStateManifest&) = delete;
+			//Records a description of size bytes.Returns false if hash is already recorded
+			bool Add(std::size_t hash, const void* desc, std::size_t size);
+			bool Contains(std::size_t hash)const;
+			std::size_t GetCount()const;
+			//Whether states are added since the last Load or Save
+			bool IsDirty()const { return mDirty; }
+			void Clear();
+			//Calls func(hash, desc, size) for every state in the order they are added
+			template<typename Function>
+			void ForEach(Function&& func)const
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				for (const auto& entry : mEntries)
+				{
+					func(static_cast<std::size_t>(entry.hash), entry.desc.data(), entry.desc.size());
+				}
+			}
+			//Returns false if the file can't be written
+			bool Save(const std::string& path);
+			//Replaces states with the ones in file.Returns false and leaves the manifest empty if the file is missing,
+			//truncated or written by another version
+			bool Load(const std::string& path);
+		private:
+			struct Entry
+			{
+				std::uint64_t hash;
+				std::vector<std::uint8_t> desc;
+			};
+			mutable std::mutex mMutex;
+			std::vector<Entry> mEntries;
+			std::unordered_map<std::uint64_t, std::size_t> mEntryIndices;
+			bool mDirty;
+		};
+	}
+}
@@ -213,11 +213,15 @@ namespace Lightning
 		};
 		static_assert(std::is_pod<ScissorRect>::value, "ScissorRect is not a POD type.");
 
+		//Render targets are described by their formats,so pipeline states don't depend on render target objects
 		struct RenderTargetBlendState
 		{
-			std::shared_ptr<IRenderTarget> renderTarget;
+			RenderFormat format;
+			std::uint16_t multiSampleCount;
+			std::uint16_t multiSampleQuality;
 			BlendState blendState;
 		};
+		static_assert(std::is_pod<RenderTargetBlendState>::value, "RenderTargetBlendState is not a POD type.");
 
 		struct PipelineState
 		{
@@ -285,11 +289,11 @@ namespace std{
 			}
 			for (auto i = 0;i < state.renderTargetBlendStates.size();++i)
 			{
-				const auto& renderTarget = state.renderTargetBlendStates[i].renderTarget;
-				const auto& blendState = state.renderTargetBlendStates[i].blendState;
-				boost::hash_combine(hashValue, blendState.GetHash());
-				//FIXME : render target should have its own descriptor,now only use the attached texture's render format to calculate the hash
-				boost::hash_combine(hashValue, renderTarget->GetTexture()->GetRenderFormat());
+				const auto& renderTargetBlendState = state.renderTargetBlendStates[i];
+				boost::hash_combine(hashValue, renderTargetBlendState.blendState.GetHash());
+				boost::hash_combine(hashValue, renderTargetBlendState.format);
+				boost::hash_combine(hashValue, renderTargetBlendState.multiSampleCount);
+				boost::hash_combine(hashValue, renderTargetBlendState.multiSampleQuality);
 			}
 			if (state.vs)
 			{
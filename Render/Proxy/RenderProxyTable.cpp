@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cassert>
+#include "RenderProxyTable.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		static constexpr std::size_t MIN_PROXY_CAPACITY = 64;
+
+		static Vector3d GetTranslation(const Matrix4f& matrix)
+		{
+			return Vector3d{ matrix.GetCell(3, 0), matrix.GetCell(3, 1), matrix.GetCell(3, 2) };
+		}
+
+		RenderProxyTable::RenderProxyTable() : mCapacity(0)
+		{
+
+		}
+
+		RenderProxyHandle RenderProxyTable::Add(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<IMaterial>& material,
+			const Matrix4f& worldMatrix, const AABBf& worldBoundingBox)
+		{
+			return Add(drawable, material, worldMatrix, worldBoundingBox, GetTranslation(worldMatrix));
+		}
+
+		RenderProxyHandle RenderProxyTable::Add(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<IMaterial>& material,
+			const Matrix4f& worldMatrix, const AABBf& worldBoundingBox, const Vector3d& precisePosition)
+		{
+			auto index = mDrawables.size();
+			if (index == mCapacity)
+			{
+				Reserve(std::max(mCapacity * 2, MIN_PROXY_CAPACITY));
+			}
+			RenderProxyHandle handle;
+			if (mFreeHandles.empty())
+			{
+				handle = static_cast<RenderProxyHandle>(mIndices.size());
+				mIndices.push_back(static_cast<std::uint32_t>(index));
+			}
+			else
+			{
+				handle = mFreeHandles.back();
+				mFreeHandles.pop_back();
+				mIndices[handle] = static_cast<std::uint32_t>(index);
+			}
+			mHandles.push_back(handle);
+			mDrawables.push_back(drawable);
+			mMaterials.push_back(material);
+			mWorldMatrices.push_back(worldMatrix);
+			mWorldBoundingBoxes.push_back(worldBoundingBox);
+			mPrecisePositions.push_back(precisePosition);
+			AABBfSoA{ mWorldBoundingBoxSoA.data(), mCapacity }.Set(index, worldBoundingBox);
+			return handle;
+		}
+
+		void RenderProxyTable::Remove(RenderProxyHandle handle)
+		{
+			assert(IsValid(handle) && "Invalid render proxy handle!");
+			auto index = mIndices[handle];
+			auto last = mDrawables.size() - 1;
+			if (index != last)
+			{
+				auto lastHandle = mHandles[last];
+				mHandles[index] = lastHandle;
+				mIndices[lastHandle] = index;
+				mDrawables[index] = std::move(mDrawables[last]);
+				mMaterials[index] = std::move(mMaterials[last]);
+				mWorldMatrices[index] = mWorldMatrices[last];
+				mWorldBoundingBoxes[index] = mWorldBoundingBoxes[last];
+				mPrecisePositions[index] = mPrecisePositions[last];
+				AABBfSoA{ mWorldBoundingBoxSoA.data(), mCapacity }.Set(index, mWorldBoundingBoxes[last]);
+			}
+			mHandles.pop_back();
+			mDrawables.pop_back();
+			mMaterials.pop_back();
+			mWorldMatrices.pop_back();
+			mWorldBoundingBoxes.pop_back();
+			mPrecisePositions.pop_back();
+			mIndices[handle] = INVALID_RENDER_PROXY_HANDLE;
+			mFreeHandles.push_back(handle);
+		}
+
+		void RenderProxyTable::Clear()
+		{
+			mDrawables.clear();
+			mMaterials.clear();
+			mWorldMatrices.clear();
+			mWorldBoundingBoxes.clear();
+			mPrecisePositions.clear();
+			mHandles.clear();
+			mIndices.clear();
+			mFreeHandles.clear();
+		}
+
+		void RenderProxyTable::SetTransform(RenderProxyHandle handle, const Matrix4f& worldMatrix, const AABBf& worldBoundingBox)
+		{
+			SetTransform(handle, worldMatrix, worldBoundingBox, GetTranslation(worldMatrix));
+		}
+
+		void RenderProxyTable::SetTransform(RenderProxyHandle handle, const Matrix4f& worldMatrix, const AABBf& worldBoundingBox,
+			const Vector3d& precisePosition)
+		{
+			assert(IsValid(handle) && "Invalid render proxy handle!");
+			auto index = mIndices[handle];
+			mWorldMatrices[index] = worldMatrix;
+			mWorldBoundingBoxes[index] = worldBoundingBox;
+			mPrecisePositions[index] = precisePosition;
+			AABBfSoA{ mWorldBoundingBoxSoA.data(), mCapacity }.Set(index, worldBoundingBox);
+		}
+
+		void RenderProxyTable::SetMaterial(RenderProxyHandle handle, const std::shared_ptr<IMaterial>& material)
+		{
+			assert(IsValid(handle) && "Invalid render proxy handle!");
+			mMaterials[mIndices[handle]] = material;
+		}
+
+		bool RenderProxyTable::IsValid(RenderProxyHandle handle)const
+		{
+			return handle < mIndices.size() && mIndices[handle] != INVALID_RENDER_PROXY_HANDLE;
+		}
+
+		AABBfSoA RenderProxyTable::GetWorldBoundingBoxSoA()const
+		{
+			return AABBfSoA{ const_cast<float*>(mWorldBoundingBoxSoA.data()), mCapacity };
+		}
+
+		void RenderProxyTable::Reserve(std::size_t capacity)
+		{
+			//The stride of SoA streams is the capacity,so every stream has to be moved when it grows
+			std::vector<float> boundingBoxes(AABBfSoA::GetRequiredSize(capacity));
+			AABBfSoA soa{ boundingBoxes.data(), capacity };
+			for (std::size_t i = 0;i < mWorldBoundingBoxes.size();++i)
+			{
+				soa.Set(i, mWorldBoundingBoxes[i]);
+			}
+			mWorldBoundingBoxSoA.swap(boundingBoxes);
+			mCapacity = capacity;
+			mDrawables.reserve(capacity);
+			mMaterials.reserve(capacity);
+			mWorldMatrices.reserve(capacity);
+			mWorldBoundingBoxes.reserve(capacity);
+			mPrecisePositions.reserve(capacity);
+			mHandles.reserve(capacity);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Matrix.h"
+#include "AABB.h"
+#include "Frustum.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using Foundation::Math::Matrix4f;
+		using Foundation::Math::Vector3d;
+		using Foundation::Math::AABBf;
+		using Foundation::Math::AABBfSoA;
+		struct IDrawable;
+		struct IMaterial;
+
+		using RenderProxyHandle = std::uint32_t;
+		constexpr RenderProxyHandle INVALID_RENDER_PROXY_HANDLE = 0xffffffff;
+
+		//Packed storage of render proxies.A render proxy is the renderer side snapshot of a drawable that persists across
+		//frames,so only changed fields need to be set.Proxies are kept contiguous(removing one moves the last proxy into
+		//its slot) so render passes iterate plain arrays.Handles stay valid until the proxy is removed.Thread unsafe
+		class RenderProxyTable
+		{
+		public:
+			RenderProxyTable();
+			//precisePosition is the world position in double precision,worldMatrix translation is the same value rounded to float.
+			//Overloads without it use worldMatrix translation
+			RenderProxyHandle Add(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<IMaterial>& material,
+				const Matrix4f& worldMatrix, const AABBf& worldBoundingBox, const Vector3d& precisePosition);
+			RenderProxyHandle Add(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<IMaterial>& material,
+				const Matrix4f& worldMatrix, const AABBf& worldBoundingBox);
+			void Remove(RenderProxyHandle handle);
+			void Clear();
+			void SetTransform(RenderProxyHandle handle, const Matrix4f& worldMatrix, const AABBf& worldBoundingBox,
+				const Vector3d& precisePosition);
+			void SetTransform(RenderProxyHandle handle, const Matrix4f& worldMatrix, const AABBf& worldBoundingBox);
+			void SetMaterial(RenderProxyHandle handle, const std::shared_ptr<IMaterial>& material);
+			bool IsValid(RenderProxyHandle handle)const;
+			std::size_t GetCount()const { return mDrawables.size(); }
+			//Gets the packed index of a proxy.The index changes when other proxies are removed
+			std::size_t GetIndex(RenderProxyHandle handle)const { return mIndices[handle]; }
+			RenderProxyHandle GetHandle(std::size_t index)const { return mHandles[index]; }
+			const std::shared_ptr<IDrawable>& GetDrawable(std::size_t index)const { return mDrawables[index]; }
+			const std::shared_ptr<IMaterial>& GetMaterial(std::size_t index)const { return mMaterials[index]; }
+			const Matrix4f& GetWorldMatrix(std::size_t index)const { return mWorldMatrices[index]; }
+			const AABBf& GetWorldBoundingBox(std::size_t index)const { return mWorldBoundingBoxes[index]; }
+			const Vector3d& GetPrecisePosition(std::size_t index)const { return mPrecisePositions[index]; }
+			//World bounding boxes in the layout expected by CullAABBs
+			AABBfSoA GetWorldBoundingBoxSoA()const;
+		private:
+			void Reserve(std::size_t capacity);
+			std::vector<std::shared_ptr<IDrawable>> mDrawables;
+			std::vector<std::shared_ptr<IMaterial>> mMaterials;
+			std::vector<Matrix4f> mWorldMatrices;
+			std::vector<AABBf> mWorldBoundingBoxes;
+			std::vector<Vector3d> mPrecisePositions;
+			//SoA copy of mWorldBoundingBoxes,stride is mCapacity
+			std::vector<float> mWorldBoundingBoxSoA;
+			std::size_t mCapacity;
+			//packed index -> handle
+			std::vector<RenderProxyHandle> mHandles;
+			//handle -> packed index,removed handles are INVALID_RENDER_PROXY_HANDLE
+			std::vector<std::uint32_t> mIndices;
+			std::vector<RenderProxyHandle> mFreeHandles;
+		};
+	}
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include "EnumOperation.h"
 
@@ -40,6 +41,12 @@ namespace Lightning
 		ENABLE_ENUM_BITMASK_OPERATORS(DepthStencilClearFlags)
 
 		constexpr std::uint8_t RENDER_FRAME_COUNT = 3;
+		//Size of the staging ring used by the upload queue and bytes it uploads per frame at most
+		constexpr std::size_t UPLOAD_STAGING_BUFFER_SIZE = 16 * 1024 * 1024;
+		constexpr std::size_t UPLOAD_FRAME_BUDGET = 2 * 1024 * 1024;
 		constexpr char* const DEFAULT_SHADER_ENTRY = "main";
+		//Names of the resources renderer imports into render graph every frame
+		constexpr char* const DEFAULT_RENDER_TARGET_RESOURCE = "DefaultRenderTarget";
+		constexpr char* const DEFAULT_DEPTH_STENCIL_RESOURCE = "DefaultDepthStencilBuffer";
 	}
 }
\ No newline at end of file
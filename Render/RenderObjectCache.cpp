@@ -15,15 +15,15 @@ namespace Lightning
 			return AddObject(GetKey(shader->GetType(), shader->GetName(), shader->GetMacros().get()), shader);
 		}
 
-		std::string ShaderCache::GetKey(ShaderType type, const std::string& name, const IShaderMacros* macros)
+		ShaderKey ShaderCache::GetKey(ShaderType type, const std::string& name, const IShaderMacros* macros)
 		{
 			if (macros)
 			{
-				return std::to_string(static_cast<int>(type)) + "_" + name + + "_" + macros->GetMacroString();
+				return ShaderKey{ type, name, macros->GetVariantBits(), macros->GetValueMacroString() };
 			}
 			else
 			{
-				return std::to_string(static_cast<int>(type)) + "_" + name + + "_";
+				return ShaderKey{ type, name, 0, std::string() };
 			}
 		}
 	}
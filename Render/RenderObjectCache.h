@@ -1,4 +1,5 @@
 #pragma once
+#include <boost/functional/hash.hpp>
 #include "RefObjectCache.h"
 #include "Texture/ITexture.h"
 #include "IShader.h"
@@ -12,13 +13,48 @@ namespace Lightning
 
 		};
 
-		class ShaderCache : public Foundation::RefObjectCache<ShaderCache, std::string, IShader>
+		//Identifies a shader variant.Feature macros are compared as one integer,only macros carrying values are strings
+		struct ShaderKey
+		{
+			ShaderType type;
+			std::string name;
+			ShaderVariantBits variantBits;
+			std::string valueMacros;
+			bool operator==(const ShaderKey& other)const
+			{
+				return type == other.type && variantBits == other.variantBits && name == other.name && valueMacros == other.valueMacros;
+			}
+		};
+	}
+}
+
+namespace std
+{
+	template<> struct hash<Lightning::Render::ShaderKey>
+	{
+		std::size_t operator()(const Lightning::Render::ShaderKey& key)const noexcept
+		{
+			std::size_t seed = 0;
+			boost::hash_combine(seed, key.name);
+			boost::hash_combine(seed, key.variantBits);
+			boost::hash_combine(seed, key.valueMacros);
+			boost::hash_combine(seed, static_cast<int>(key.type));
+			return seed;
+		}
+	};
+}
+
+namespace Lightning
+{
+	namespace Render
+	{
+		class ShaderCache : public Foundation::RefObjectCache<ShaderCache, ShaderKey, IShader>
 		{
 		public:
 			std::shared_ptr<IShader> GetShader(ShaderType type, const std::string& name, const IShaderMacros* macros);
 			bool AddShader(const std::shared_ptr<IShader>& shader);
 		private:
-			static std::string GetKey(ShaderType type, const std::string& name, const IShaderMacros* macros);
+			static ShaderKey GetKey(ShaderType type, const std::string& name, const IShaderMacros* macros);
 		};
 	}
 }
\ No newline at end of file
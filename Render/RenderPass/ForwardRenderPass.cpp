@@ -1,8 +1,9 @@
 #include "ForwardRenderPass.h"
 #include "Renderer.h"
-#include "FrameMemoryAllocator.h"
+#include "Command/RenderCommands.h"
 #include "tbb/flow_graph.h"
 #include "tbb/parallel_for.h"
+#include "Math/Common.h"
 
 
 namespace Lightning
@@ -10,60 +11,78 @@ namespace Lightning
 	namespace Render
 	{
 		extern FrameMemoryAllocator g_RenderAllocator;
+
 		ForwardRenderPass::ForwardRenderPass(IRenderer& renderer) 
-			:RenderPass(renderer), mClearColor{0.5f, 0.5f, 0.5f, 1.0f}
+			:RenderPass(renderer), mClearColor{0.5f, 0.5f, 0.5f, 1.0f}, mLightClusters(g_RenderAllocator)
 		{
 
 		}
 
+		void ForwardRenderPass::BuildLightClusters()
+		{
+			if (mVisibleCount == 0)
+				return;
+			auto camera = GetVisibleDrawable(0).camera;
+			//Clusters slice the view frustum,orthographic views are not clustered
+			if (camera->GetCameraType() != CameraType::Perspective)
+				return;
+			auto lightCount = std::min(mCurrentLights->size(), MAX_CLUSTERED_LIGHTS);
+			auto lightBounds = g_RenderAllocator.Allocate<LightBounds>(lightCount);
+			for (std::size_t i = 0;i < lightCount;++i)
+			{
+				lightBounds[i] = GetLightBounds((*mCurrentLights)[i]);
+			}
+			LightClusterView view;
+			view.viewMatrix = camera->GetViewMatrix();
+			view.fov = Foundation::Math::DegreesToRadians(camera->GetFOV());
+			view.aspectRatio = camera->GetAspectRatio();
+			view.nearPlane = camera->GetNear();
+			view.farPlane = camera->GetFar();
+			mLightClusters.Build(view, lightBounds, lightCount);
+		}
+
 		void ForwardRenderPass::DoRender()
 		{
+			//Segment 0 sets up the pass,draws follow in visible list order
+			RenderCommandRecorder recorder(mCommandBuffer);
+			mCommandBuffer.Begin(0);
 			auto backBuffer = mRenderer.GetDefaultRenderTarget();
-			mRenderer.ClearRenderTarget(backBuffer.get(), mClearColor);
+			recorder.ClearRenderTarget(backBuffer.get(), mClearColor);
 			auto depthStencilBuffer = mRenderer.GetDefaultDepthStencilBuffer();
-			mRenderer.ClearDepthStencilBuffer(depthStencilBuffer.get(), DepthStencilClearFlags::CLEAR_DEPTH | DepthStencilClearFlags::CLEAR_STENCIL,
+			recorder.ClearDepthStencilBuffer(depthStencilBuffer.get(), DepthStencilClearFlags::CLEAR_DEPTH | DepthStencilClearFlags::CLEAR_STENCIL,
 				depthStencilBuffer->GetDepthClearValue(), depthStencilBuffer->GetStencilClearValue(), nullptr);
-			
-			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mCurrentDrawList->size()), 
-				[this](const tbb::blocked_range<std::size_t>& range) {
-				auto currentFrame = mRenderer.GetCurrentFrameCount();
-				auto& lastRenderFrame = mLastRenderFrame.Local();
-				if (currentFrame != lastRenderFrame)
-				{
-					lastRenderFrame = currentFrame;
-					auto backBuffer = mRenderer.GetDefaultRenderTarget();
-					auto depthStencilBuffer = mRenderer.GetDefaultDepthStencilBuffer();
-					auto renderTargets = g_RenderAllocator.Allocate<IRenderTarget*>(1);
-					renderTargets[0] = backBuffer.get();
-					mRenderer.ApplyRenderTargets(renderTargets, 1, depthStencilBuffer.get());
 
-					auto scissorRects = g_RenderAllocator.Allocate<ScissorRect>(1);
-					auto viewports = g_RenderAllocator.Allocate<Viewport>(1);
-					auto window = mRenderer.GetOutputWindow();
+			const IRenderTarget* renderTargets[] = { backBuffer.get() };
+			recorder.ApplyRenderTargets(renderTargets, 1, depthStencilBuffer.get());
 
-					viewports[0].left = viewports[0].top = .0f;
-					viewports[0].width = static_cast<float>(window->GetWidth());
-					viewports[0].height = static_cast<float>(window->GetHeight());
+			auto window = mRenderer.GetOutputWindow();
+			Viewport viewport;
+			viewport.left = viewport.top = .0f;
+			viewport.width = static_cast<float>(window->GetWidth());
+			viewport.height = static_cast<float>(window->GetHeight());
 
-					scissorRects[0].left = static_cast<long>(viewports[0].left);
-					scissorRects[0].top = static_cast<long>(viewports[0].top);
-					scissorRects[0].width = static_cast<long>(viewports[0].width);
-					scissorRects[0].height = static_cast<long>(viewports[0].height);
-					mRenderer.ApplyViewports(viewports, 1);
-					mRenderer.ApplyScissorRects(scissorRects, 1);
-				}
+			ScissorRect scissorRect;
+			scissorRect.left = static_cast<long>(viewport.left);
+			scissorRect.top = static_cast<long>(viewport.top);
+			scissorRect.width = static_cast<long>(viewport.width);
+			scissorRect.height = static_cast<long>(viewport.height);
+			recorder.ApplyViewports(&viewport, 1);
+			recorder.ApplyScissorRects(&scissorRect, 1);
+			
+			BuildLightClusters();
+			auto wvpMatrices = ComputeWVPMatrices();
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mVisibleCount), 
+				[this, wvpMatrices](const tbb::blocked_range<std::size_t>& range) {
 				for (std::size_t i = range.begin(); i != range.end();++i)
 				{
-					DrawableElement element = mCurrentDrawList->at(i);
+					const auto& visible = GetVisibleDrawable(i);
 					auto drawCommand = NewDrawCommand();
-					drawCommand->SetPrimitiveType(element.drawable->GetPrimitiveType());
-					drawCommand->SetIndexBuffer(element.drawable->GetIndexBuffer());
-					drawCommand->SetVertexBuffers(element.drawable->GetVertexBuffers());
-					drawCommand->SetMaterial(element.drawable->GetMaterial());
-					drawCommand->SetTransform(element.drawable->GetDrawTransform());
-					drawCommand->SetViewMatrix(element.camera->GetViewMatrix());
-					drawCommand->SetProjectionMatrix(element.camera->GetProjectionMatrix());
-					drawCommand->Commit();
+					drawCommand->SetPrimitiveType(visible.drawable->GetPrimitiveType());
+					drawCommand->SetIndexBuffer(visible.drawable->GetIndexBuffer());
+					drawCommand->SetVertexBuffers(visible.drawable->GetVertexBuffers());
+					drawCommand->SetMaterial(GetMaterial(visible));
+					drawCommand->SetWVPMatrix(&wvpMatrices[i]);
+					drawCommand->Commit(mCommandBuffer, i + 1);
 				}
 			});
 		}
@@ -73,6 +92,17 @@ namespace Lightning
 			return true;
 		}
 
+		const char* ForwardRenderPass::GetName()const
+		{
+			return "Forward";
+		}
+
+		void ForwardRenderPass::DeclareResources(RenderGraph& graph, RenderGraphHandle pass)
+		{
+			graph.Write(pass, graph.GetResourceHandle(DEFAULT_RENDER_TARGET_RESOURCE));
+			graph.Write(pass, graph.GetResourceHandle(DEFAULT_DEPTH_STENCIL_RESOURCE));
+		}
+
 		std::size_t ForwardRenderPass::GetRenderTargetCount()const
 		{
 			return 1;
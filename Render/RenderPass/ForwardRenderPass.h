@@ -1,6 +1,6 @@
 #pragma once
 #include "RenderPass.h"
-#include "ThreadLocalObject.h"
+#include "Light/LightCluster.h"
 
 namespace Lightning
 {
@@ -13,11 +13,17 @@ namespace Lightning
 			std::size_t GetRenderTargetCount()const override;
 			std::shared_ptr<IRenderTarget> GetRenderTarget(std::size_t index)const override;
 			std::shared_ptr<IDepthStencilBuffer> GetDepthStencilBuffer()const override;
+			//Lights of current frame binned into clusters of the view of the first visible drawable.
+			//Valid until the frame ends,consumed by the forward shader once light buffers are bound
+			const LightClusterBuilder& GetLightClusters()const { return mLightClusters; }
 		protected:
 			void DoRender()override;
 			bool AcceptDrawable(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera)override;
-			Foundation::ThreadLocalObject<std::uint64_t> mLastRenderFrame;
+			const char* GetName()const override;
+			void DeclareResources(RenderGraph& graph, RenderGraphHandle pass)override;
+			void BuildLightClusters();
 			ColorF mClearColor;
+			LightClusterBuilder mLightClusters;
 		};
 	}
 }
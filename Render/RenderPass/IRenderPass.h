@@ -3,6 +3,9 @@
 #include "IDrawable.h"
 #include "IRenderTarget.h"
 #include "IDepthStencilBuffer.h"
+#include "Proxy/RenderProxyTable.h"
+#include "Graph/RenderGraph.h"
+#include "Light/LightData.h"
 
 namespace Lightning
 {
@@ -11,10 +14,15 @@ namespace Lightning
 		struct IRenderPass
 		{
 			virtual ~IRenderPass() = default;
-			//Do the actual render,different algorithms will be carried out in this step
-			virtual void Render() = 0;
+			//Adds the pass and its subpasses to graph with the resources they read and write.Called once per frame,
+			//the actual render is carried out when renderer executes the graph
+			virtual void Setup(RenderGraph& graph) = 0;
 			//Adds a drawable to the pass,if the pass accepts this drawable, true is returned,otherwise false is returned.
 			virtual bool AddDrawable(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera) = 0;
+			//Renders all proxies in the table with camera in this frame.The table is held and must stay unchanged until EndRender
+			virtual void AddRenderProxies(const std::shared_ptr<const RenderProxyTable>& proxies, const std::shared_ptr<ICamera>& camera) = 0;
+			//Adds a light to the pass and its subpasses in this frame,thread safe
+			virtual void AddLight(const LightData& light) = 0;
 			//Tells the pass that Renderer will begin to render,the pass should not accept Drawables in this frame anymore
 			virtual void BeginRender() = 0;
 			//EndRender means the renderer finishes work and the cached drawables are safe to discard
@@ -1,13 +1,33 @@
+#include <algorithm>
+#include "tbb/parallel_for.h"
 #include "RenderPass.h"
 #include "Renderer.h"
 #include "DrawCommand.h"
+#include "FrameMemoryAllocator.h"
+#include "MatrixBatch.h"
+#include "PositionBatch.h"
+#include "Frustum.h"
+#include "Command/RenderCommands.h"
 
 namespace Lightning
 {
 	namespace Render
 	{
+		extern FrameMemoryAllocator g_RenderAllocator;
+		using Foundation::Math::Matrix4fSoA;
+		using Foundation::Math::AABBfSoA;
+		using Foundation::Math::Vector3dSoA;
+		using Foundation::Math::Frustum;
+		static constexpr std::size_t BATCH_GRAIN_SIZE = 1024;
+
 		RenderPass::RenderPass(IRenderer& renderer) 
 			: mCurrentDrawList(&mDrawables[0])
+			, mCurrentRenderProxyViews(&mRenderProxyViews[0])
+			, mCurrentLights(&mLights[0])
+			, mVisibleDrawables(nullptr)
+			, mVisibleCount(0)
+			, mBoundingBoxes(nullptr)
+			, mCommandBuffer(g_RenderAllocator)
 			, mRenderer(renderer)
 		{
 
@@ -18,6 +38,8 @@ namespace Lightning
 			for (auto i = 0;i < RENDER_FRAME_COUNT;++i)
 			{
 				mDrawables[i].clear();
+				mRenderProxyViews[i].clear();
+				mLights[i].clear();
 				for (auto it = mDrawCommands[i].unsafe_begin(); it != mDrawCommands[i].unsafe_end();++it)
 				{
 					(*it)->Release();
@@ -33,15 +55,263 @@ namespace Lightning
 			return command;
 		}
 
-		void RenderPass::Render()
+		void RenderPass::CullDrawables()
 		{
-			DoRender();
+			auto drawableCount = mCurrentDrawList->size();
+			std::size_t proxyCount{ 0 };
+			for (const auto& view : *mCurrentRenderProxyViews)
+			{
+				proxyCount += view.proxies->GetCount();
+			}
+			mVisibleCount = 0;
+			mVisibleDrawables = nullptr;
+			mBoundingBoxes = nullptr;
+			if (drawableCount + proxyCount == 0)
+				return;
+			auto visibilities = drawableCount > 0 ? g_RenderAllocator.Allocate<std::uint8_t>(drawableCount) : nullptr;
+			auto cull = [visibilities](const Frustum& frustum, const AABBfSoA& boundingBoxes, std::size_t begin, std::size_t end) {
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end, BATCH_GRAIN_SIZE),
+					[&frustum, &boundingBoxes, visibilities](const tbb::blocked_range<std::size_t>& range) {
+					Foundation::Math::CullAABBs(frustum, boundingBoxes, range.begin(), range.end(), visibilities);
+				});
+			};
+			if (drawableCount > 0)
+			{
+				mBoundingBoxes = g_RenderAllocator.Allocate<Foundation::Math::AABBf>(drawableCount);
+				AABBfSoA boundingBoxes;
+				boundingBoxes.data = g_RenderAllocator.Allocate<float>(AABBfSoA::GetRequiredSize(drawableCount));
+				boundingBoxes.stride = drawableCount;
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(0, drawableCount, BATCH_GRAIN_SIZE),
+					[this, &boundingBoxes](const tbb::blocked_range<std::size_t>& range) {
+					for (std::size_t i = range.begin(); i != range.end();++i)
+					{
+						mBoundingBoxes[i] = (*mCurrentDrawList)[i].drawable->GetWorldBoundingBox();
+						boundingBoxes.Set(i, mBoundingBoxes[i]);
+					}
+				});
+				//Drawables are added camera by camera,so one frustum is built for each run of the same camera
+				std::size_t begin{ 0 };
+				while (begin < drawableCount)
+				{
+					const auto& camera = (*mCurrentDrawList)[begin].camera;
+					auto end = begin + 1;
+					while (end < drawableCount && (*mCurrentDrawList)[end].camera == camera)
+						++end;
+					cull(Frustum::FromMatrix(camera->GetViewMatrix() * camera->GetProjectionMatrix()), boundingBoxes, begin, end);
+					begin = end;
+				}
+			}
+			//Bounding boxes of proxies are already packed,so they are culled in place.All views of the same proxy table are
+			//culled in one pass,each box is tested against every frustum and bit i of its mask tells if it's visible in view i
+			const auto viewCount = mCurrentRenderProxyViews->size();
+			auto viewMasks = g_RenderAllocator.Allocate<const std::uint32_t*>(viewCount);
+			//zero initialized,a view is not assigned to a cull pass yet if its bit is 0
+			auto viewBits = g_RenderAllocator.Allocate<std::uint32_t>(viewCount);
+			Frustum frustums[Foundation::Math::MAX_CULL_VIEWS];
+			for (std::size_t first = 0;first < viewCount;++first)
+			{
+				if (viewBits[first])
+					continue;
+				auto proxies = (*mCurrentRenderProxyViews)[first].proxies.get();
+				auto count = proxies->GetCount();
+				auto masks = count > 0 ? g_RenderAllocator.Allocate<std::uint32_t>(count) : nullptr;
+				std::size_t frustumCount{ 0 };
+				for (auto i = first;i < viewCount && frustumCount < Foundation::Math::MAX_CULL_VIEWS;++i)
+				{
+					const auto& view = (*mCurrentRenderProxyViews)[i];
+					if (view.proxies.get() != proxies || viewBits[i])
+						continue;
+					frustums[frustumCount] = Frustum::FromMatrix(view.camera->GetViewMatrix() * view.camera->GetProjectionMatrix());
+					viewMasks[i] = masks;
+					viewBits[i] = 1u << frustumCount;
+					++frustumCount;
+				}
+				const auto& boundingBoxes = proxies->GetWorldBoundingBoxSoA();
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(0, count, BATCH_GRAIN_SIZE),
+					[&frustums, frustumCount, &boundingBoxes, masks](const tbb::blocked_range<std::size_t>& range) {
+					Foundation::Math::CullAABBsMultiView(frustums, frustumCount, boundingBoxes, range.begin(), range.end(), masks);
+				});
+			}
+			mVisibleDrawables = g_RenderAllocator.Allocate<VisibleDrawable>(drawableCount + proxyCount);
+			for (std::size_t i = 0;i < drawableCount;++i)
+			{
+				if (visibilities[i] && !HasPendingUploads((*mCurrentDrawList)[i].drawable.get()))
+				{
+					const auto& element = (*mCurrentDrawList)[i];
+					mVisibleDrawables[mVisibleCount++] = VisibleDrawable{ element.drawable.get(), element.camera.get(), nullptr, i };
+				}
+			}
+			//visible list keeps views in order so drawables of the same camera stay together
+			for (std::size_t v = 0;v < viewCount;++v)
+			{
+				const auto& view = (*mCurrentRenderProxyViews)[v];
+				auto masks = viewMasks[v];
+				auto bit = viewBits[v];
+				auto count = view.proxies->GetCount();
+				for (std::size_t i = 0;i < count;++i)
+				{
+					if ((masks[i] & bit) && !HasPendingUploads(view.proxies->GetDrawable(i).get()))
+					{
+						mVisibleDrawables[mVisibleCount++] = VisibleDrawable{ view.proxies->GetDrawable(i).get(), view.camera.get(), view.proxies.get(), i };
+					}
+				}
+			}
+		}
+
+		void RenderPass::CullOccludedDrawables()
+		{
+			if (mVisibleCount == 0)
+				return;
+			//visibilities are indexed by visible list index
+			auto visibilities = g_RenderAllocator.Allocate<std::uint8_t>(mVisibleCount);
+			bool culled{ false };
+			ForEachCameraRun([this, visibilities, &culled](ICamera* camera, std::size_t begin, std::size_t end) {
+				mOcclusionBuffer.Begin(camera->GetViewMatrix() * camera->GetProjectionMatrix());
+				bool hasOccluder{ false };
+				OccluderGeometry geometry;
+				for (auto i = begin;i < end;++i)
+				{
+					const auto& visible = GetVisibleDrawable(i);
+					visibilities[i] = 0;
+					if (visible.drawable->GetOccluderGeometry(geometry))
+					{
+						mOcclusionBuffer.AddOccluder(geometry, GetWorldMatrix(visible));
+						//occluders are never hidden
+						visibilities[i] = 1;
+						hasOccluder = true;
+					}
+				}
+				if (!hasOccluder)
+				{
+					std::fill(visibilities + begin, visibilities + end, std::uint8_t(1));
+					return;
+				}
+				culled = true;
+				mOcclusionBuffer.Rasterize();
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end, BATCH_GRAIN_SIZE),
+					[this, visibilities](const tbb::blocked_range<std::size_t>& range) {
+					for (std::size_t i = range.begin(); i != range.end();++i)
+					{
+						if (!visibilities[i])
+						{
+							visibilities[i] = mOcclusionBuffer.IsVisible(GetWorldBoundingBox(GetVisibleDrawable(i))) ? 1 : 0;
+						}
+					}
+				});
+			});
+			if (!culled)
+				return;
+			std::size_t visibleCount{ 0 };
+			for (std::size_t i = 0;i < mVisibleCount;++i)
+			{
+				if (visibilities[i])
+				{
+					mVisibleDrawables[visibleCount++] = mVisibleDrawables[i];
+				}
+			}
+			mVisibleCount = visibleCount;
+		}
+
+		Matrix4f* RenderPass::ComputeWVPMatrices()
+		{
+			if (mVisibleCount == 0)
+				return nullptr;
+			Matrix4fSoA worldMatrices;
+			worldMatrices.cells = g_RenderAllocator.Allocate<float>(Matrix4fSoA::GetRequiredSize(mVisibleCount));
+			worldMatrices.stride = mVisibleCount;
+			Vector3dSoA positions;
+			positions.components = g_RenderAllocator.Allocate<double>(Vector3dSoA::GetRequiredSize(mVisibleCount));
+			positions.stride = mVisibleCount;
+			auto wvpMatrices = g_RenderAllocator.Allocate<Matrix4f>(mVisibleCount);
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mVisibleCount, BATCH_GRAIN_SIZE),
+				[this, &worldMatrices, &positions](const tbb::blocked_range<std::size_t>& range) {
+				for (std::size_t i = range.begin(); i != range.end();++i)
+				{
+					const auto& visible = GetVisibleDrawable(i);
+					worldMatrices.Set(i, GetWorldMatrix(visible));
+					positions.Set(i, GetPrecisePosition(visible));
+				}
+			});
+			//cells 3, 7 and 11 are the translation row
+			float* const translations[3] = { worldMatrices.cells + 3 * worldMatrices.stride,
+				worldMatrices.cells + 7 * worldMatrices.stride, worldMatrices.cells + 11 * worldMatrices.stride };
+			//view * projection is computed only once for each run of the same camera.The camera is moved to the origin
+			//and world translations are made relative to it in the same pass right before the multiplication
+			ForEachCameraRun([&worldMatrices, &positions, &translations, wvpMatrices](ICamera* camera, std::size_t begin, std::size_t end) {
+				auto view = camera->GetViewMatrix();
+				view.SetRow(3, Foundation::Math::Vector4f{ 0.0f, 0.0f, 0.0f, 1.0f });
+				const auto viewProjection = view * camera->GetProjectionMatrix();
+				const auto origin = camera->GetPrecisePosition();
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end, BATCH_GRAIN_SIZE),
+					[&worldMatrices, &positions, &translations, &viewProjection, &origin, wvpMatrices](const tbb::blocked_range<std::size_t>& range) {
+					Foundation::Math::BatchToRelativePositions(positions, origin, translations, range.begin(), range.end());
+					Foundation::Math::BatchMultiplyMatrix(worldMatrices, viewProjection, wvpMatrices, range.begin(), range.end());
+				});
+			});
+			return wvpMatrices;
+		}
+
+		bool RenderPass::HasPendingUploads(const IDrawable* drawable)const
+		{
+			auto indexBuffer = drawable->GetIndexBuffer();
+			if (indexBuffer && mRenderer.IsUploadPending(indexBuffer.get()))
+				return true;
+			for (const auto& vertexBuffer : drawable->GetVertexBuffers())
+			{
+				if (mRenderer.IsUploadPending(vertexBuffer.get()))
+					return true;
+			}
+			return false;
+		}
+
+		Matrix4f RenderPass::GetWorldMatrix(const VisibleDrawable& visible)const
+		{
+			if (visible.proxies)
+				return visible.proxies->GetWorldMatrix(visible.index);
+			return visible.drawable->GetDrawTransform().GetMatrix();
+		}
+
+		Foundation::Math::Vector3d RenderPass::GetPrecisePosition(const VisibleDrawable& visible)const
+		{
+			if (visible.proxies)
+				return visible.proxies->GetPrecisePosition(visible.index);
+			return visible.drawable->GetPreciseDrawPosition();
+		}
+
+		Foundation::Math::AABBf RenderPass::GetWorldBoundingBox(const VisibleDrawable& visible)const
+		{
+			if (visible.proxies)
+				return visible.proxies->GetWorldBoundingBox(visible.index);
+			return mBoundingBoxes[visible.index];
+		}
+
+		std::shared_ptr<IMaterial> RenderPass::GetMaterial(const VisibleDrawable& visible)const
+		{
+			if (visible.proxies)
+				return visible.proxies->GetMaterial(visible.index);
+			return visible.drawable->GetMaterial();
+		}
+
+		void RenderPass::Setup(RenderGraph& graph)
+		{
+			auto pass = graph.AddPass(GetName(), [this]() { Record(); },
+				[this]() { ReplayRenderCommands(mCommandBuffer, mRenderer); });
+			DeclareResources(graph, pass);
 			for (const auto& renderPass : mSubPasses)
 			{
-				renderPass->Render();
+				renderPass->Setup(graph);
 			}
 		}
 
+		void RenderPass::Record()
+		{
+			CullDrawables();
+			CullOccludedDrawables();
+			mCommandBuffer.Reset();
+			DoRender();
+			mCommandBuffer.Merge();
+		}
+
 		bool RenderPass::AddDrawable(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera)
 		{
 			bool succeed{ false };
@@ -58,6 +328,24 @@ namespace Lightning
 			return succeed;
 		}
 
+		void RenderPass::AddRenderProxies(const std::shared_ptr<const RenderProxyTable>& proxies, const std::shared_ptr<ICamera>& camera)
+		{
+			mCurrentRenderProxyViews->emplace_back(RenderProxyView{ proxies, camera });
+			for (const auto& renderPass : mSubPasses)
+			{
+				renderPass->AddRenderProxies(proxies, camera);
+			}
+		}
+
+		void RenderPass::AddLight(const LightData& light)
+		{
+			mCurrentLights->push_back(light);
+			for (const auto& renderPass : mSubPasses)
+			{
+				renderPass->AddLight(light);
+			}
+		}
+
 		void RenderPass::BeginRender()
 		{
 			mFrameResourceIndex = mRenderer.GetFrameResourceIndex();
@@ -87,6 +375,10 @@ namespace Lightning
 					}
 					mCurrentDrawList->clear();
 					mCurrentDrawList = &mDrawables[queueIndex];
+					mCurrentRenderProxyViews->clear();
+					mCurrentRenderProxyViews = &mRenderProxyViews[queueIndex];
+					mCurrentLights->clear();
+					mCurrentLights = &mLights[queueIndex];
 					break;
 				}
 			}
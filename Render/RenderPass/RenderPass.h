@@ -6,6 +6,8 @@
 #include "IRenderer.h"
 #include "IRenderPass.h"
 #include "IDrawCommand.h"
+#include "Culling/OcclusionBuffer.h"
+#include "Command/CommandBuffer.h"
 
 namespace Lightning
 {
@@ -17,22 +19,96 @@ namespace Lightning
 			RenderPass(IRenderer& renderer);
 			~RenderPass()override;
 			bool AddDrawable(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera)override;
+			void AddRenderProxies(const std::shared_ptr<const RenderProxyTable>& proxies, const std::shared_ptr<ICamera>& camera)override;
+			void AddLight(const LightData& light)override;
 			void BeginRender()override;
-			void Render()override;
+			void Setup(RenderGraph& graph)override;
 			void EndRender()override;
-			//Render is called by renderer once per frame.Subpasses are also rendered by this method
+			//Gets the commands recorded by DoRender in current frame,valid until next frame.They can be saved for offline replay
+			const CommandBuffer& GetCommandBuffer()const { return mCommandBuffer; }
 		protected:
 			virtual bool AcceptDrawable(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera) = 0;
+			//Name of the pass in render graph
+			virtual const char* GetName()const = 0;
+			//Declares the resources the pass reads and writes in graph
+			virtual void DeclareResources(RenderGraph& graph, RenderGraphHandle pass) = 0;
+			//Records render commands of the pass into mCommandBuffer.The commands are merged after DoRender returns and
+			//replayed through renderer when the graph executes the pass,so recording can be spread over worker threads
 			virtual void DoRender() = 0;
+			//CPU work of the pass in render graph,may run in parallel with independent passes
+			void Record();
 			IDrawCommand* NewDrawCommand();
+			//Tests world bounding boxes of current draw list and render proxies against camera frustums and fills the visible list.
+			//Render proxies drawn by several cameras are tested against all of their frustums in a single pass.
+			//Called by Render before DoRender
+			void CullDrawables();
+			//Rasterizes visible occluders of each camera into the occlusion buffer and removes drawables hidden
+			//behind them from the visible list.Called by Render after CullDrawables
+			void CullOccludedDrawables();
+			//Computes world-view-projection matrices of all visible drawables in a batch.
+			//The returned array is allocated from frame memory and has the same order as the visible list.
+			//World translations are replaced by precise positions relative to the camera and view matrices don't translate,
+			//so the matrices keep float precision far from the origin
+			Matrix4f* ComputeWVPMatrices();
 			struct DrawableElement
 			{
 				std::shared_ptr<IDrawable> drawable;
 				std::shared_ptr<ICamera> camera;
 			};
+			struct RenderProxyView
+			{
+				std::shared_ptr<const RenderProxyTable> proxies;
+				std::shared_ptr<ICamera> camera;
+			};
+			//A drawable that passes culling in this frame.It comes either from the draw list or from a render proxy table,
+			//index is the index in the draw list or the packed index in proxies.The pointers are valid until EndRender.
+			struct VisibleDrawable
+			{
+				IDrawable* drawable;
+				ICamera* camera;
+				const RenderProxyTable* proxies;
+				std::size_t index;
+			};
+			const VisibleDrawable& GetVisibleDrawable(std::size_t index)const
+			{
+				return mVisibleDrawables[index];
+			}
+			//Whether buffers of drawable still wait in the upload queue.Such drawables are left out of the visible list
+			bool HasPendingUploads(const IDrawable* drawable)const;
+			Matrix4f GetWorldMatrix(const VisibleDrawable& visible)const;
+			Foundation::Math::Vector3d GetPrecisePosition(const VisibleDrawable& visible)const;
+			Foundation::Math::AABBf GetWorldBoundingBox(const VisibleDrawable& visible)const;
+			std::shared_ptr<IMaterial> GetMaterial(const VisibleDrawable& visible)const;
+			//Calls func(camera, begin, end) for every run of consecutive visible drawables sharing the same camera.
+			//Drawables are added camera by camera so there are usually as many runs as cameras.
+			template<typename Function>
+			void ForEachCameraRun(Function func)
+			{
+				std::size_t begin{ 0 };
+				while (begin < mVisibleCount)
+				{
+					auto camera = GetVisibleDrawable(begin).camera;
+					auto end = begin + 1;
+					while (end < mVisibleCount && GetVisibleDrawable(end).camera == camera)
+						++end;
+					func(camera, begin, end);
+					begin = end;
+				}
+			}
 			tbb::concurrent_vector<DrawableElement> mDrawables[RENDER_FRAME_COUNT];
 			tbb::concurrent_queue<IDrawCommand*> mDrawCommands[RENDER_FRAME_COUNT];
 			tbb::concurrent_vector<DrawableElement>* mCurrentDrawList;
+			tbb::concurrent_vector<RenderProxyView> mRenderProxyViews[RENDER_FRAME_COUNT];
+			tbb::concurrent_vector<RenderProxyView>* mCurrentRenderProxyViews;
+			tbb::concurrent_vector<LightData> mLights[RENDER_FRAME_COUNT];
+			tbb::concurrent_vector<LightData>* mCurrentLights;
+			//Drawables that pass culling,allocated from frame memory
+			VisibleDrawable* mVisibleDrawables;
+			std::size_t mVisibleCount;
+			//World bounding boxes indexed by current draw list index,allocated from frame memory
+			Foundation::Math::AABBf* mBoundingBoxes;
+			OcclusionBuffer mOcclusionBuffer;
+			CommandBuffer mCommandBuffer;
 			std::vector<std::shared_ptr<RenderPass>> mSubPasses;
 			std::size_t mFrameResourceIndex;
 			IRenderer& mRenderer;
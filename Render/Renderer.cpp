@@ -1,4 +1,6 @@
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include "Device.h"
 #include "Renderer.h"
 #include "FrameMemoryAllocator.h"
@@ -7,6 +9,10 @@
 #include "Serializers/ShaderSerializer.h"
 #include "Serializers/TextureSerializer.h"
 #include "RenderPass/ForwardRenderPass.h"
+#include "RenderObjectCache.h"
+#include "ShaderMacros.h"
+#include "ShaderBytecodeCache.h"
+#include "Logger.h"
 
 namespace Lightning
 {
@@ -14,6 +20,40 @@ namespace Lightning
 	{
 		IRenderer* Renderer::sInstance{ nullptr };
 		FrameMemoryAllocator g_RenderAllocator;
+		static constexpr const char* PIPELINE_MANIFEST_FILE_NAME = "PipelineStates.manifest";
+		static constexpr const char* SHADER_BYTECODE_CACHE_DIRECTORY = "ShaderCache";
+
+		namespace
+		{
+			//A manifest state waiting for its shaders to load
+			struct PipelinePrewarmState
+			{
+				std::size_t hash;
+				std::vector<std::uint8_t> desc;
+				std::atomic<std::size_t> pendingShaderCount;
+				std::atomic<bool> failed;
+			};
+
+			void OnPrewarmShaderLoaded(PipelineCompileQueue& queue, const std::shared_ptr<PipelinePrewarmState>& state)
+			{
+				if (--state->pendingShaderCount == 0 && !state->failed)
+				{
+					queue.Request(state->hash, state->desc.data(), state->desc.size());
+				}
+			}
+
+			std::shared_ptr<IShaderMacros> CreatePipelineShaderMacros(const PipelineShaderKey& key)
+			{
+				if (key.macros.empty())
+					return nullptr;
+				auto macros = std::make_shared<ShaderMacros>();
+				for (const auto& macro : key.macros)
+				{
+					macros->Define(macro.first, macro.second);
+				}
+				return macros;
+			}
+		}
 		
 		void FrameResource::Release()
 		{
@@ -26,9 +66,16 @@ namespace Lightning
 			, mFrameCount(0)
 			, mFrameResourceIndex(0)
 			, mStarted(false)
+			, mPipelineCompileQueue(*this)
+			, mAsyncPipelineCompile(false)
 		{
 			assert(!sInstance);
 			sInstance = this;
+			ShaderBytecodeCache::Instance()->SetDirectory(SHADER_BYTECODE_CACHE_DIRECTORY);
+			for (auto macroName : EngineShaderFeatureMacros)
+			{
+				ShaderMacroVocabulary::Instance()->Declare(macroName);
+			}
 			for (const auto& semanticItem : PipelineInputSemantics)
 			{
 				mPipelineInputSemanticInfos[semanticItem.semantic] = ParsePipelineInputSemantics(semanticItem);
@@ -54,6 +101,12 @@ namespace Lightning
 			HandleWindowResize();
 			mFrameCount++;
 			OnFrameBegin();
+			if (mUploadQueue)
+			{
+				mUploadQueue->Flush(mFrameCount, [this](const UploadCopy* copies, std::size_t copyCount) {
+					ExecuteUploads(copies, copyCount);
+				});
+			}
 			if (mRootRenderPass)
 			{
 				mRootRenderPass->BeginRender();
@@ -61,7 +114,12 @@ namespace Lightning
 			OnFrameUpdate();
 			if (mRootRenderPass)
 			{
-				mRootRenderPass->Render();
+				mRenderGraph.Reset();
+				mRenderGraph.ImportResource(DEFAULT_RENDER_TARGET_RESOURCE);
+				mRenderGraph.ImportResource(DEFAULT_DEPTH_STENCIL_RESOURCE);
+				mRootRenderPass->Setup(mRenderGraph);
+				mRenderGraph.Compile();
+				mRenderGraph.Execute();
 			}
 			OnFrameEnd();
 			if (mRootRenderPass)
@@ -108,6 +166,183 @@ namespace Lightning
 			}
 		}
 
+		RenderProxyHandle Renderer::AddRenderProxy(RenderProxyTable& proxies, const std::shared_ptr<IDrawable>& drawable)
+		{
+			return proxies.Add(drawable, drawable->GetMaterial(),
+				drawable->GetDrawTransform().GetMatrix(), drawable->GetWorldBoundingBox(), drawable->GetPreciseDrawPosition());
+		}
+
+		void Renderer::RemoveRenderProxy(RenderProxyTable& proxies, RenderProxyHandle handle)
+		{
+			proxies.Remove(handle);
+		}
+
+		void Renderer::UpdateRenderProxy(RenderProxyTable& proxies, RenderProxyHandle handle, RenderProxyDirtyFlags flags)
+		{
+			const auto& drawable = proxies.GetDrawable(proxies.GetIndex(handle));
+			if ((flags & RenderProxyDirtyFlags::TRANSFORM) == RenderProxyDirtyFlags::TRANSFORM)
+			{
+				proxies.SetTransform(handle, drawable->GetDrawTransform().GetMatrix(), drawable->GetWorldBoundingBox(),
+					drawable->GetPreciseDrawPosition());
+			}
+			if ((flags & RenderProxyDirtyFlags::MATERIAL) == RenderProxyDirtyFlags::MATERIAL)
+			{
+				proxies.SetMaterial(handle, drawable->GetMaterial());
+			}
+		}
+
+		void Renderer::DrawRenderProxies(const std::shared_ptr<const RenderProxyTable>& proxies, const std::shared_ptr<ICamera>& camera)
+		{
+			if (mRootRenderPass)
+			{
+				mRootRenderPass->AddRenderProxies(proxies, camera);
+			}
+		}
+
+		void Renderer::DrawLight(const LightData& light)
+		{
+			if (mRootRenderPass)
+			{
+				mRootRenderPass->AddLight(light);
+			}
+		}
+
+		void Renderer::UploadBuffer(const std::shared_ptr<IGPUBuffer>& buffer, std::size_t offset, const void* data, std::size_t size)
+		{
+			if (!mUploadQueue)
+			{
+				auto mem = buffer->Lock(offset, size);
+				std::memcpy(mem, data, size);
+				buffer->Unlock(offset, size);
+				return;
+			}
+			mUploadQueue->Enqueue(buffer, offset, data, size);
+		}
+
+		bool Renderer::IsUploadPending(const IGPUBuffer* buffer)
+		{
+			return mUploadQueue && mUploadQueue->IsPending(buffer);
+		}
+
+		void Renderer::WaitForPipelineStates()
+		{
+			mPipelineCompileQueue.Wait();
+		}
+
+		bool Renderer::RequestPipelineState(std::size_t hash, const PipelineState& state)
+		{
+			auto status = mPipelineCompileQueue.GetStatus(hash);
+			if (status == PipelineCompileStatus::NONE)
+			{
+				PipelineStateDesc desc;
+				desc.Assign(state);
+				std::vector<std::uint8_t> descData;
+				desc.Write(descData);
+				mPipelineManifest.Add(hash, descData.data(), descData.size());
+				if (!mAsyncPipelineCompile)
+					return true;
+				status = mPipelineCompileQueue.Request(hash, descData.data(), descData.size());
+			}
+			switch (status)
+			{
+			//Without asynchronous compilation the draw waits for the state prewarming is compiling instead of compiling
+			//it a second time
+			case PipelineCompileStatus::PENDING:
+				return !mAsyncPipelineCompile && mPipelineCompileQueue.Wait(hash) == PipelineCompileStatus::READY;
+			//compiled after the backend looked up its cache
+			case PipelineCompileStatus::READY:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool Renderer::ResolvePipelineState(const PipelineStateDesc& desc, PipelineState& state)
+		{
+			state.Reset();
+			for (const auto& key : desc.shaders)
+			{
+				auto shader = FindPipelineShader(key);
+				if (!shader)
+					return false;
+				switch (key.type)
+				{
+				case ShaderType::VERTEX:
+					state.vs = shader;
+					break;
+				case ShaderType::FRAGMENT:
+					state.fs = shader;
+					break;
+				case ShaderType::GEOMETRY:
+					state.gs = shader;
+					break;
+				case ShaderType::HULL:
+					state.hs = shader;
+					break;
+				case ShaderType::DOMAIN:
+					state.ds = shader;
+					break;
+				}
+			}
+			state.primType = desc.primType;
+			state.rasterizerState = desc.rasterizerState;
+			state.depthStencilState = desc.depthStencilState;
+			for (std::size_t i = 0;i < desc.inputLayoutSlots.size();++i)
+			{
+				VertexInputLayout inputLayout;
+				inputLayout.slot = desc.inputLayoutSlots[i];
+				inputLayout.components = const_cast<VertexComponent*>(desc.inputLayoutComponents[i].data());
+				inputLayout.componentCount = desc.inputLayoutComponents[i].size();
+				state.inputLayouts.push_back(inputLayout);
+			}
+			state.renderTargetBlendStates = desc.renderTargetBlendStates;
+			return true;
+		}
+
+		std::shared_ptr<IShader> Renderer::FindPipelineShader(const PipelineShaderKey& key)
+		{
+			auto defaultShader = mDevice->GetDefaultShader(key.type);
+			if (defaultShader && key.macros.empty() && defaultShader->GetName() == key.name)
+				return defaultShader;
+			auto macros = CreatePipelineShaderMacros(key);
+			return ShaderCache::Instance()->GetShader(key.type, key.name, macros.get());
+		}
+
+		void Renderer::PrewarmPipelineStates()
+		{
+			if (!mPipelineManifest.Load(PIPELINE_MANIFEST_FILE_NAME))
+				return;
+			LOG_INFO("Prewarming {0} pipeline states.", mPipelineManifest.GetCount());
+			mPipelineManifest.ForEach([this](std::size_t hash, const void* desc, std::size_t size) {
+				PipelineStateDesc stateDesc;
+				if (!stateDesc.Read(desc, size))
+					return;
+				auto prewarmState = std::make_shared<PipelinePrewarmState>();
+				prewarmState->hash = hash;
+				prewarmState->desc.assign(static_cast<const std::uint8_t*>(desc), static_cast<const std::uint8_t*>(desc) + size);
+				//one extra count keeps the state from being scheduled before all loads are issued
+				prewarmState->pendingShaderCount = stateDesc.shaders.size() + 1;
+				prewarmState->failed = false;
+				for (const auto& key : stateDesc.shaders)
+				{
+					if (FindPipelineShader(key))
+					{
+						OnPrewarmShaderLoaded(mPipelineCompileQueue, prewarmState);
+						continue;
+					}
+					mDevice->CreateShaderFromFile(key.type, key.name, CreatePipelineShaderMacros(key),
+						[this, prewarmState](const std::shared_ptr<IShader>& shader) {
+						if (!shader)
+						{
+							prewarmState->failed = true;
+						}
+						OnPrewarmShaderLoaded(mPipelineCompileQueue, prewarmState);
+					});
+				}
+				OnPrewarmShaderLoaded(mPipelineCompileQueue, prewarmState);
+			});
+		}
+
 		void Renderer::GetSemanticInfo(RenderSemantics semantic, SemanticIndex& index, std::string& name)
 		{
 			auto it = mPipelineInputSemanticInfos.find(semantic);
@@ -132,6 +367,7 @@ namespace Lightning
 				return;
 			mDevice.reset(CreateDevice());
 			mSwapChain.reset(CreateSwapChain());
+			mUploadQueue.reset(CreateUploadQueue());
 			for (size_t i = 0; i < RENDER_FRAME_COUNT; i++)
 			{
 				mFrameResources[i].fence.reset(CreateRenderFence());
@@ -152,6 +388,7 @@ namespace Lightning
 			mFrameResourceIndex = 0;
 			mRootRenderPass = std::make_unique<ForwardRenderPass>(*this);
 			mStarted = true;
+			PrewarmPipelineStates();
 		}
 
 		void Renderer::ShutDown()
@@ -159,10 +396,16 @@ namespace Lightning
 			if (!mStarted)
 				return;
 			WaitForPreviousFrame(true);
+			mPipelineCompileQueue.Wait();
+			if (mPipelineManifest.IsDirty() && !mPipelineManifest.Save(PIPELINE_MANIFEST_FILE_NAME))
+			{
+				LOG_WARNING("Failed to save pipeline state manifest {0}.", PIPELINE_MANIFEST_FILE_NAME);
+			}
 			for (std::size_t i = 0;i < RENDER_FRAME_COUNT;++i)
 			{
 				mFrameResources[i].Release();
 			}
+			mUploadQueue.reset();
 			mDevice.reset();
 			mSwapChain.reset();
 			mRootRenderPass.reset();
@@ -221,6 +464,8 @@ namespace Lightning
 				auto& frameResource = mFrameResources[resourceIndex];
 				frameResource.fence->WaitForTarget();
 				g_RenderAllocator.ReleaseFramesBefore(frameResource.frame);
+				if (mUploadQueue)
+					mUploadQueue->ReleaseFramesBefore(frameResource.frame);
 			}
 		}
 
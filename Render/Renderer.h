@@ -4,6 +4,10 @@
 #include "SwapChain.h"
 #include "Device.h"
 #include "RenderPass/IRenderPass.h"
+#include "Upload/UploadQueue.h"
+#include "Pipeline/PipelineStateManifest.h"
+#include "Pipeline/PipelineCompileQueue.h"
+#include "Pipeline/PipelineStateDesc.h"
 
 namespace Lightning
 {
@@ -18,7 +22,7 @@ namespace Lightning
 			void Release();
 		};
 
-		class Renderer : public IRenderer
+		class Renderer : public IRenderer, public IPipelineStateCompiler
 		{
 		public:
 			~Renderer()override;
@@ -39,6 +43,15 @@ namespace Lightning
 			const char* GetUniformName(RenderSemantics semantic)override;
 			void GetSemanticInfo(RenderSemantics semantic, SemanticIndex& index, std::string& name)override;
 			void Draw(const std::shared_ptr<IDrawable>& drawable, const std::shared_ptr<ICamera>& camera)override;
+			RenderProxyHandle AddRenderProxy(RenderProxyTable& proxies, const std::shared_ptr<IDrawable>& drawable)override;
+			void RemoveRenderProxy(RenderProxyTable& proxies, RenderProxyHandle handle)override;
+			void UpdateRenderProxy(RenderProxyTable& proxies, RenderProxyHandle handle, RenderProxyDirtyFlags flags)override;
+			void DrawRenderProxies(const std::shared_ptr<const RenderProxyTable>& proxies, const std::shared_ptr<ICamera>& camera)override;
+			void DrawLight(const LightData& light)override;
+			void UploadBuffer(const std::shared_ptr<IGPUBuffer>& buffer, std::size_t offset, const void* data, std::size_t size)override;
+			bool IsUploadPending(const IGPUBuffer* buffer)override;
+			void SetAsyncPipelineCompile(bool enable)override { mAsyncPipelineCompile = enable; }
+			void WaitForPipelineStates()override;
 		protected:
 			Renderer(Window::IWindow* window);
 			//Thread unsafe ,must ensure there's no concurrent execution
@@ -54,7 +67,18 @@ namespace Lightning
 			virtual Device* CreateDevice() = 0;
 			//CreateSwapChain is called in Start,ensuring the device is already created
 			virtual SwapChain* CreateSwapChain() = 0;
+			//CreateUploadQueue is called in Start after the creation of device.Returns nullptr if buffers are written directly
+			virtual UploadQueue* CreateUploadQueue() = 0;
+			//Records copies flushed from the upload queue,called after OnFrameBegin
+			virtual void ExecuteUploads(const UploadCopy* copies, std::size_t copyCount) = 0;
 			virtual bool CheckIfDepthStencilBufferNeedsResize();
+			//Backends call it when state misses their pipeline cache.state is recorded to the pipeline state manifest,and
+			//with asynchronous compilation it's scheduled on a worker thread.Returns true if the backend should compile state
+			//right away,false if draws using it must be skipped
+			bool RequestPipelineState(std::size_t hash, const PipelineState& state);
+			//Fills state with desc and its loaded shaders.Input layouts of state point into desc.Returns false if a shader
+			//is not loaded
+			bool ResolvePipelineState(const PipelineStateDesc& desc, PipelineState& state);
 		protected:
 			struct SemanticInfo
 			{
@@ -67,6 +91,8 @@ namespace Lightning
 			std::unique_ptr<Device> mDevice;
 			std::unique_ptr<SwapChain> mSwapChain;
 			std::unique_ptr<IRenderPass> mRootRenderPass;
+			std::unique_ptr<UploadQueue> mUploadQueue;
+			RenderGraph mRenderGraph;
 			FrameResource mFrameResources[RENDER_FRAME_COUNT];
 			Window::IWindow* mOutputWindow;
 			std::unordered_map<RenderSemantics, SemanticInfo> mPipelineInputSemanticInfos;
@@ -75,6 +101,12 @@ namespace Lightning
 		private:
 			void HandleWindowResize();
 			SemanticInfo ParsePipelineInputSemantics(const SemanticItem& item);
+			//Loads shaders of the states in manifest and schedules each state once its shaders are loaded
+			void PrewarmPipelineStates();
+			std::shared_ptr<IShader> FindPipelineShader(const PipelineShaderKey& key);
+			PipelineStateManifest mPipelineManifest;
+			PipelineCompileQueue mPipelineCompileQueue;
+			bool mAsyncPipelineCompile;
 			std::size_t mFrameResourceIndex;
 			bool mStarted;
 			std::uint64_t mFrameCount;
@@ -20,6 +20,18 @@ namespace Lightning
 			DOMAIN,	//domain shader
 		};
 
+		//A shader parameter location resolved from its name.Resolve it once and reuse it to avoid name lookups on every draw.
+		struct ShaderParameterBinding
+		{
+			ParameterType type;
+			//For constants,the constant buffer index.For textures/samplers,the slot index
+			std::uint32_t index;
+			//For constants,bytes from the start of the shader constant memory.Unused for textures/samplers
+			std::uint32_t offset;
+			//For constants,byte size of the value.0 for textures/samplers
+			std::uint32_t size;
+		};
+
 		struct IShader
 		{
 			virtual ~IShader() = default;
@@ -31,6 +43,11 @@ namespace Lightning
 			virtual std::string GetName()const = 0;
 			virtual bool SetParameter(const Parameter& parameter) = 0;
 			virtual ParameterType GetParameterType(const std::string& name)const = 0;
+			//Resolve parameter name into a binding.Returns false if the shader doesn't have the parameter.
+			virtual bool GetParameterBinding(const std::string& name, ShaderParameterBinding& binding)const = 0;
+			//Set parameter through a resolved binding.data points to the value whose type matches binding.type
+			//(a std::shared_ptr<ITexture> for textures and a SamplerState for samplers)
+			virtual bool SetParameter(const ShaderParameterBinding& binding, const void* data) = 0;
 			virtual std::string GetSource()const = 0;
 			virtual void GetUniformSemantics(RenderSemantics** semantics, std::uint16_t& semanticCount) = 0;
 			virtual std::size_t GetHash()const = 0;
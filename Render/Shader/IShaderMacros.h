@@ -1,10 +1,16 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace Lightning
 {
 	namespace Render
 	{
+		//Bit set of the declared feature macros a shader variant is compiled with,see ShaderMacroVocabulary
+		using ShaderVariantBits = std::uint64_t;
+
 		struct IShaderMacros
 		{
 			virtual ~IShaderMacros() = default;
@@ -13,9 +19,14 @@ namespace Lightning
 			virtual void Undefine(const std::string& macroName) = 0;
 			virtual bool GetMacroValue(const std::string& macroName, std::string& macroValue)const = 0;
 			virtual std::size_t GetMacroCount()const = 0;
+			//All macros sorted by name,so equal macro sets give equal strings in every run whatever bits they own
 			virtual std::string GetMacroString()const = 0;
+			//Sorted by name like GetMacroString
 			virtual void GetAllMacros(std::vector<std::pair<std::string, std::string>>& macros)const = 0;
 			virtual std::size_t GetHash()const = 0;
+			virtual ShaderVariantBits GetVariantBits()const = 0;
+			//Macros not stored as variant bits sorted by name
+			virtual std::string GetValueMacroString()const = 0;
 		};
 
 	}
@@ -0,0 +1,196 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include "Common.h"
+#include "ShaderBytecodeCache.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		namespace
+		{
+			template<typename T>
+			void AppendValue(std::string& buffer, const T& value)
+			{
+				buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			//length prefix keeps adjacent fields from being mistaken for one another
+			void AppendString(std::string& buffer, const std::string& value)
+			{
+				AppendValue(buffer, static_cast<std::uint64_t>(value.size()));
+				buffer.append(value);
+			}
+
+			template<typename T>
+			void WriteValue(std::ofstream& file, const T& value)
+			{
+				file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			template<typename T>
+			bool ReadValue(std::ifstream& file, T& value)
+			{
+				return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+			}
+		}
+
+		constexpr std::uint32_t ShaderBytecodeCache::FILE_MAGIC;
+		constexpr std::uint32_t ShaderBytecodeCache::FILE_VERSION;
+
+		ShaderBytecodeCache::ShaderBytecodeCache() : mStats{}
+		{
+
+		}
+
+		void ShaderBytecodeCache::SetDirectory(const std::string& directory)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mDirectory = directory;
+		}
+
+		std::shared_ptr<const ShaderBytecode> ShaderBytecodeCache::GetOrCompile(const ShaderCompileInput& input, 
+			IShaderCompiler& compiler, std::string& errors)
+		{
+			auto key = ComputeKey(input, compiler.GetVersion());
+			std::string directory;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				auto it = mByteCodes.find(key);
+				if (it != mByteCodes.end())
+				{
+					++mStats.memoryHits;
+					return it->second;
+				}
+				directory = mDirectory;
+			}
+			//file io and compiling run without the lock so that other shaders are not blocked
+			if (!directory.empty())
+			{
+				auto byteCode = LoadFile(directory, key);
+				if (byteCode)
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					++mStats.diskHits;
+					return mByteCodes.emplace(key, byteCode).first->second;
+				}
+			}
+			auto byteCode = std::make_shared<ShaderBytecode>();
+			if (!compiler.Compile(input, *byteCode, errors) || byteCode->empty())
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				++mStats.failures;
+				return nullptr;
+			}
+			if (!directory.empty())
+			{
+				SaveFile(directory, key, *byteCode);
+			}
+			std::lock_guard<std::mutex> lock(mMutex);
+			++mStats.compiles;
+			return mByteCodes.emplace(key, byteCode).first->second;
+		}
+
+		void ShaderBytecodeCache::ClearMemory()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mByteCodes.clear();
+		}
+
+		ShaderBytecodeCacheStats ShaderBytecodeCache::GetStats()const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mStats;
+		}
+
+		ShaderBytecodeKey ShaderBytecodeCache::ComputeKey(const ShaderCompileInput& input, std::uint32_t compilerVersion)
+		{
+			std::string buffer;
+			buffer.reserve(input.source.size() + 256);
+			AppendValue(buffer, compilerVersion);
+			AppendValue(buffer, input.flags);
+			AppendString(buffer, input.entry);
+			AppendString(buffer, input.target);
+			AppendString(buffer, input.macros);
+			AppendString(buffer, input.source);
+			AppendValue(buffer, static_cast<std::uint64_t>(input.includes.size()));
+			for (const auto& include : input.includes)
+			{
+				AppendString(buffer, include.first);
+				AppendString(buffer, include.second);
+			}
+			std::uint32_t hash[4];
+			Foundation::Utility::Hash(buffer.data(), buffer.size(), 0x5f3759df, hash);
+			ShaderBytecodeKey key;
+			key.low = (static_cast<std::uint64_t>(hash[1]) << 32) | hash[0];
+			key.high = (static_cast<std::uint64_t>(hash[3]) << 32) | hash[2];
+			return key;
+		}
+
+		std::string ShaderBytecodeCache::GetFileName(const ShaderBytecodeKey& key)
+		{
+			char name[40];
+			std::snprintf(name, sizeof(name), "%016llx%016llx.bin", 
+				static_cast<unsigned long long>(key.high), static_cast<unsigned long long>(key.low));
+			return name;
+		}
+
+		//File layout : magic,version,key,bytecode size and bytecode
+		std::shared_ptr<const ShaderBytecode> ShaderBytecodeCache::LoadFile(const std::string& directory, const ShaderBytecodeKey& key)const
+		{
+			auto path = boost::filesystem::path(directory) / GetFileName(key);
+			std::ifstream file(path.string(), std::ios::binary);
+			if (!file)
+				return nullptr;
+			std::uint32_t magic{ 0 }, version{ 0 };
+			ShaderBytecodeKey fileKey{};
+			std::uint64_t size{ 0 };
+			if (!ReadValue(file, magic) || !ReadValue(file, version) || !ReadValue(file, fileKey.low) 
+				|| !ReadValue(file, fileKey.high) || !ReadValue(file, size))
+				return nullptr;
+			if (magic != FILE_MAGIC || version != FILE_VERSION || !(fileKey == key) || size == 0)
+				return nullptr;
+			auto byteCode = std::make_shared<ShaderBytecode>(static_cast<std::size_t>(size));
+			if (!file.read(reinterpret_cast<char*>(byteCode->data()), byteCode->size()))
+				return nullptr;
+			return byteCode;
+		}
+
+		bool ShaderBytecodeCache::SaveFile(const std::string& directory, const ShaderBytecodeKey& key, const ShaderBytecode& byteCode)const
+		{
+			boost::system::error_code ec;
+			boost::filesystem::create_directories(directory, ec);
+			auto path = boost::filesystem::path(directory) / GetFileName(key);
+			//write to a temporary file first so that a reader never sees a partially written file,the name is unique as
+			//two threads may save the same bytecode
+			auto tempPath = path;
+			tempPath += boost::filesystem::unique_path(".%%%%%%%%.tmp");
+			{
+				std::ofstream file(tempPath.string(), std::ios::binary | std::ios::trunc);
+				if (!file)
+					return false;
+				WriteValue(file, FILE_MAGIC);
+				WriteValue(file, FILE_VERSION);
+				WriteValue(file, key.low);
+				WriteValue(file, key.high);
+				WriteValue(file, static_cast<std::uint64_t>(byteCode.size()));
+				file.write(reinterpret_cast<const char*>(byteCode.data()), byteCode.size());
+				if (!file)
+				{
+					file.close();
+					boost::filesystem::remove(tempPath, ec);
+					return false;
+				}
+			}
+			boost::filesystem::rename(tempPath, path, ec);
+			if (ec)
+			{
+				boost::filesystem::remove(tempPath, ec);
+				return false;
+			}
+			return true;
+		}
+	}
+}
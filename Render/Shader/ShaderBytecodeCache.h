@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Singleton.h"
+#include "IShaderMacros.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		using ShaderBytecode = std::vector<std::uint8_t>;
+
+		//Everything compiled bytecode of a shader variant depends on
+		struct ShaderCompileInput
+		{
+			//only used in error messages
+			std::string name;
+			std::string source;
+			//name and content of each file the source includes,a file missing here is not part of the key
+			std::vector<std::pair<std::string, std::string>> includes;
+			std::string entry;
+			//compile target such as vs_5_1
+			std::string target;
+			//see IShaderMacros::GetMacroString.Macro names are hashed instead of variant bits,which are handed out in
+			//declaration order and may stand for other macros in another run
+			std::string macros;
+			//compiler specific options such as debug and optimization flags
+			std::uint32_t flags;
+		};
+
+		struct IShaderCompiler
+		{
+			virtual ~IShaderCompiler() = default;
+			//Bytecode cached by other versions of the compiler is ignored
+			virtual std::uint32_t GetVersion()const = 0;
+			virtual bool Compile(const ShaderCompileInput& input, ShaderBytecode& byteCode, std::string& errors) = 0;
+		};
+
+		//128 bit content hash of a compile input
+		struct ShaderBytecodeKey
+		{
+			std::uint64_t low;
+			std::uint64_t high;
+			bool operator==(const ShaderBytecodeKey& other)const { return low == other.low && high == other.high; }
+		};
+
+		struct ShaderBytecodeCacheStats
+		{
+			std::size_t memoryHits;
+			std::size_t diskHits;
+			std::size_t compiles;
+			std::size_t failures;
+		};
+
+		//Keeps compiled shader bytecode in memory and in a directory on disk,keyed by a hash of the compile input and compiler
+		//version,so variants compiled by a previous run are loaded instead of compiled again.A changed source,include or
+		//macro gives a new key,stale files are never read.Two threads missing the same key at once both compile it.Thread safe
+		class ShaderBytecodeCache : public Foundation::Singleton<ShaderBytecodeCache>
+		{
+		public:
+			ShaderBytecodeCache();
+			//An empty directory keeps bytecode in memory only.The directory is created when the first bytecode is saved
+			void SetDirectory(const std::string& directory);
+			//Returns cached bytecode of input or compiles it with compiler.Returns nullptr if compiling fails,errors receives
+			//compiler output
+			std::shared_ptr<const ShaderBytecode> GetOrCompile(const ShaderCompileInput& input, IShaderCompiler& compiler, std::string& errors);
+			//Drops bytecode kept in memory,files on disk are kept
+			void ClearMemory();
+			ShaderBytecodeCacheStats GetStats()const;
+			static ShaderBytecodeKey ComputeKey(const ShaderCompileInput& input, std::uint32_t compilerVersion);
+			static std::string GetFileName(const ShaderBytecodeKey& key);
+		private:
+			struct KeyHash
+			{
+				std::size_t operator()(const ShaderBytecodeKey& key)const { return static_cast<std::size_t>(key.low ^ key.high); }
+			};
+			std::shared_ptr<const ShaderBytecode> LoadFile(const std::string& directory, const ShaderBytecodeKey& key)const;
+			bool SaveFile(const std::string& directory, const ShaderBytecodeKey& key, const ShaderBytecode& byteCode)const;
+			static constexpr std::uint32_t FILE_MAGIC = 0x4342534c;
+			static constexpr std::uint32_t FILE_VERSION = 1;
+			mutable std::mutex mMutex;
+			std::string mDirectory;
+			std::unordered_map<ShaderBytecodeKey, std::shared_ptr<const ShaderBytecode>, KeyHash> mByteCodes;
+			ShaderBytecodeCacheStats mStats;
+		};
+	}
+}
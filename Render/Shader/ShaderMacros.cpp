@@ -6,13 +6,15 @@ namespace Lightning
 {
 	namespace Render
 	{
-		ShaderMacros::ShaderMacros()
+		ShaderMacros::ShaderMacros() : mVariantBits(0)
 		{
 
 		}
 
 		bool ShaderMacros::operator==(const ShaderMacros& define)const
 		{
+			if (mVariantBits != define.mVariantBits)
+				return false;
 			if (mMacros.size() != define.mMacros.size())
 				return false;
 			for (auto it = mMacros.begin(); it != mMacros.end(); ++it)
@@ -57,6 +59,19 @@ namespace Lightning
 
 		void ShaderMacros::Combine(const ShaderMacros& shaderMacros)
 		{
+			mVariantBits |= shaderMacros.mVariantBits;
+			for (const auto& macro : shaderMacros.mMacros)
+			{
+				//a variant bit and a value of the same macro can't coexist
+				auto bit = ShaderMacroVocabulary::Instance()->GetBit(macro.first);
+				if (bit < MAX_SHADER_VARIANT_MACROS)
+					mVariantBits &= ~(ShaderVariantBits(1) << bit);
+			}
+			for (std::size_t bit = 0;bit < MAX_SHADER_VARIANT_MACROS;++bit)
+			{
+				if (shaderMacros.mVariantBits & (ShaderVariantBits(1) << bit))
+					mMacros.erase(ShaderMacroVocabulary::Instance()->GetName(bit));
+			}
 			std::for_each(shaderMacros.mMacros.begin(), shaderMacros.mMacros.end(), 
 				[&](const std::pair<std::string, std::string>& macro) {if(macro.first.length())mMacros[macro.first] = macro.second; });
 		}
@@ -68,17 +83,29 @@ namespace Lightning
 
 		bool ShaderMacros::IsDefined(const std::string& macroName)const
 		{
+			auto bit = ShaderMacroVocabulary::Instance()->GetBit(macroName);
+			if (bit < MAX_SHADER_VARIANT_MACROS && (mVariantBits & (ShaderVariantBits(1) << bit)))
+				return true;
 			return mMacros.find(macroName) != mMacros.end();
 		}
 
 		size_t ShaderMacros::GetMacroCount()const
 		{
-			return mMacros.size();
+			std::size_t bitCount{ 0 };
+			for (auto bits = mVariantBits;bits;bits &= bits - 1)
+				++bitCount;
+			return bitCount + mMacros.size();
 		}
 
 
 		bool ShaderMacros::GetMacroValue(const std::string& macroName, std::string& macroValue)const
 		{
+			auto bit = ShaderMacroVocabulary::Instance()->GetBit(macroName);
+			if (bit < MAX_SHADER_VARIANT_MACROS && (mVariantBits & (ShaderVariantBits(1) << bit)))
+			{
+				macroValue = "1";
+				return true;
+			}
 			auto it = mMacros.find(macroName);
 			if (it == mMacros.end())
 			{
@@ -94,42 +121,105 @@ namespace Lightning
 		void ShaderMacros::Define(const std::string& macroName, const std::string& macroValue)
 		{
 			assert(!macroName.empty() && "Defined macro name can't be empty!");
-			mMacros[macroName] = macroValue;
+			auto bit = GetVariantBit(macroName, macroValue);
+			if (bit < MAX_SHADER_VARIANT_MACROS)
+			{
+				mVariantBits |= ShaderVariantBits(1) << bit;
+				mMacros.erase(macroName);
+			}
+			else
+			{
+				Undefine(macroName);
+				mMacros[macroName] = macroValue;
+			}
 		}
 
 		void ShaderMacros::Undefine(const std::string& macroName)
 		{
+			auto bit = ShaderMacroVocabulary::Instance()->GetBit(macroName);
+			if (bit < MAX_SHADER_VARIANT_MACROS)
+				mVariantBits &= ~(ShaderVariantBits(1) << bit);
 			mMacros.erase(macroName);
 		}
 
 		void ShaderMacros::GetAllMacros(std::vector<std::pair<std::string, std::string>>& macros)const
 		{
-			for (auto it = mMacros.cbegin(); it != mMacros.cend();++it)
+			auto first = macros.size();
+			for (std::size_t bit = 0;bit < MAX_SHADER_VARIANT_MACROS;++bit)
 			{
-				macros.emplace_back(std::make_pair(it->first, it->second));
+				if (mVariantBits & (ShaderVariantBits(1) << bit))
+					macros.emplace_back(ShaderMacroVocabulary::Instance()->GetName(bit), "1");
+			}
+			for (const auto& macro : mMacros)
+			{
+				macros.emplace_back(macro.first, macro.second);
 			}
+			std::sort(macros.begin() + first, macros.end());
 		}
 
 		std::size_t ShaderMacros::GetHash()const
 		{
 			std::size_t seed = 0x43d6799;
+			boost::hash_combine(seed, mVariantBits);
+			//sum of entry hashes doesn't depend on iteration order of the map
+			std::size_t macroHash{ 0 };
 			for (auto it = mMacros.begin(); it != mMacros.end(); ++it)
 			{
-				boost::hash_combine(seed, it->first);
-				boost::hash_combine(seed, it->second);
+				std::size_t entrySeed{ 0 };
+				boost::hash_combine(entrySeed, it->first);
+				boost::hash_combine(entrySeed, it->second);
+				macroHash += entrySeed;
 			}
+			boost::hash_combine(seed, macroHash);
 			return seed;
 		}
 
 		std::string ShaderMacros::GetMacroString()const
 		{
+			std::vector<std::pair<std::string, std::string>> macros;
+			GetAllMacros(macros);
 			std::string macroString;
-			for (auto it = mMacros.cbegin(); it != mMacros.cend();++it)
+			for (const auto& macro : macros)
+			{
+				macroString += macro.first + " " + macro.second + "\n";
+			}
+
+			return macroString;
+		}
+
+		ShaderVariantBits ShaderMacros::GetVariantBits()const
+		{
+			return mVariantBits;
+		}
+
+		std::string ShaderMacros::GetValueMacroString()const
+		{
+			std::vector<std::pair<std::string, std::string>> macros;
+			GetSortedValueMacros(macros);
+			std::string macroString;
+			for (const auto& macro : macros)
 			{
-				macroString += it->first + " " + it->second + "\n";
+				macroString += macro.first + " " + macro.second + "\n";
 			}
 
 			return macroString;
 		}
+
+		std::size_t ShaderMacros::GetVariantBit(const std::string& macroName, const std::string& macroValue)
+		{
+			if (!macroValue.empty() && macroValue != "1")
+				return MAX_SHADER_VARIANT_MACROS;
+			return ShaderMacroVocabulary::Instance()->GetBit(macroName);
+		}
+
+		void ShaderMacros::GetSortedValueMacros(std::vector<std::pair<std::string, std::string>>& macros)const
+		{
+			auto first = macros.size();
+			for (auto it = mMacros.cbegin(); it != mMacros.cend();++it)
+			{
+				macros.emplace_back(std::make_pair(it->first, it->second));
+			}
+			std::sort(macros.begin() + first, macros.end());
+		}
 	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <string>
 #include <unordered_map>
 #include "IShaderMacros.h"
+#include "ShaderVariant.h"
 
 
 namespace Lightning
@@ -27,8 +28,14 @@ namespace Lightning
 			std::string GetMacroString()const override;
 			void GetAllMacros(std::vector<std::pair<std::string, std::string>>& macros)const override;
 			std::size_t GetHash()const override;
+			ShaderVariantBits GetVariantBits()const override;
+			std::string GetValueMacroString()const override;
 		private:
+			//bit of a declared macro whose value can be stored as a variant bit,MAX_SHADER_VARIANT_MACROS otherwise
+			static std::size_t GetVariantBit(const std::string& macroName, const std::string& macroValue);
+			void GetSortedValueMacros(std::vector<std::pair<std::string, std::string>>& macros)const;
 			std::unordered_map<std::string, std::string> mMacros;
+			ShaderVariantBits mVariantBits;
 		};
 	}
 }
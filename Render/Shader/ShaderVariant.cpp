@@ -0,0 +1,45 @@
+#include <cassert>
+#include "ShaderVariant.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		std::size_t ShaderMacroVocabulary::Declare(const std::string& macroName)
+		{
+			assert(!macroName.empty() && "Declared macro name can't be empty!");
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto it = mBits.find(macroName);
+			if (it != mBits.end())
+				return it->second;
+			if (mNames.size() >= MAX_SHADER_VARIANT_MACROS)
+				return MAX_SHADER_VARIANT_MACROS;
+			auto bit = mNames.size();
+			mNames.push_back(macroName);
+			mBits.emplace(macroName, bit);
+			return bit;
+		}
+
+		std::size_t ShaderMacroVocabulary::GetBit(const std::string& macroName)const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto it = mBits.find(macroName);
+			if (it != mBits.end())
+				return it->second;
+			return MAX_SHADER_VARIANT_MACROS;
+		}
+
+		std::string ShaderMacroVocabulary::GetName(std::size_t bit)const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			assert(bit < mNames.size() && "Shader variant bit is not declared!");
+			return mNames[bit];
+		}
+
+		std::size_t ShaderMacroVocabulary::GetCount()const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mNames.size();
+		}
+	}
+}
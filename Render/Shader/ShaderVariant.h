@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Singleton.h"
+#include "IShaderMacros.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		constexpr std::size_t MAX_SHADER_VARIANT_MACROS = sizeof(ShaderVariantBits) * 8;
+
+		//Feature switches of engine shaders,declared by the renderer at startup so they are stored as variant bits
+		const char* const EngineShaderFeatureMacros[] = {
+			"ALPHA_TEST",
+			"CLUSTERED_LIGHTING",
+			"INSTANCING",
+			"NORMAL_MAP",
+			"TEXTURE_MAP",
+			"VERTEX_COLOR",
+		};
+
+		//Feature switch macros shaders are specialized by.Each declared macro owns a bit of ShaderVariantBits,so a variant
+		//is identified by one integer instead of a set of strings.A declared macro defined with an empty value or "1" is
+		//stored as its bit,other macros keep their string values.Declare macros before shader macros referring to them are
+		//created.Thread safe
+		class ShaderMacroVocabulary : public Foundation::Singleton<ShaderMacroVocabulary>
+		{
+		public:
+			//Returns the bit of macroName,declaring it if needed.Returns MAX_SHADER_VARIANT_MACROS if the vocabulary is full
+			std::size_t Declare(const std::string& macroName);
+			//Returns MAX_SHADER_VARIANT_MACROS if macroName is not declared
+			std::size_t GetBit(const std::string& macroName)const;
+			std::string GetName(std::size_t bit)const;
+			std::size_t GetCount()const;
+		private:
+			mutable std::mutex mMutex;
+			std::vector<std::string> mNames;
+			std::unordered_map<std::string, std::size_t> mBits;
+		};
+	}
+}
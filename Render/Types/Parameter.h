@@ -22,6 +22,26 @@ namespace Lightning
 			SAMPLER,
 		};
 
+		//Returns the byte size of a constant parameter type.Textures and samplers are bound by slot so their size is 0.
+		inline std::size_t GetParameterTypeSize(ParameterType type)
+		{
+			switch (type)
+			{
+			case ParameterType::FLOAT:
+				return sizeof(float);
+			case ParameterType::FLOAT2:
+				return sizeof(Foundation::Math::Vector2f);
+			case ParameterType::FLOAT3:
+				return sizeof(Foundation::Math::Vector3f);
+			case ParameterType::FLOAT4:
+				return sizeof(Foundation::Math::Vector4f);
+			case ParameterType::MATRIX4X4F:
+				return sizeof(Foundation::Math::Matrix4f);
+			default:
+				return 0;
+			}
+		}
+
 		class Parameter
 		{
 		public:
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "UploadQueue.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		namespace
+		{
+			std::size_t AlignUp(std::size_t size)
+			{
+				return (size + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+			}
+		}
+
+		UploadQueue::UploadQueue(std::uint8_t* stagingMemory, std::size_t stagingSize, std::size_t frameBudget)
+			: mStagingMemory(stagingMemory)
+			, mStagingSize(stagingSize & ~(UPLOAD_ALIGNMENT - 1))
+			, mFrameBudget(frameBudget)
+			, mHead(0)
+			, mTail(0)
+			, mUsedSize(0)
+			, mPendingCount(0)
+			, mPendingSize(0)
+		{
+			assert(mStagingMemory && mStagingSize > 0 && "Upload queue requires staging memory!");
+		}
+
+		void UploadQueue::Enqueue(const std::shared_ptr<IGPUBuffer>& buffer, std::size_t offset, const void* data, std::size_t size)
+		{
+			assert(buffer && offset + size <= buffer->GetBufferSize() && "Upload is out of buffer range!");
+			assert(size <= mStagingSize && "Upload is larger than staging memory!");
+			if (size == 0)
+				return;
+			PendingWrite write;
+			write.buffer = buffer;
+			write.offset = offset;
+			write.data.assign(static_cast<const std::uint8_t*>(data), static_cast<const std::uint8_t*>(data) + size);
+			std::lock_guard<std::mutex> lock(mMutex);
+			++mPendingBuffers[buffer.get()];
+			mPendingSize += size;
+			mPendingWrites.push_back(std::move(write));
+			++mPendingCount;
+		}
+
+		bool UploadQueue::IsPending(const IGPUBuffer* buffer)
+		{
+			if (mPendingCount == 0)
+				return false;
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mPendingBuffers.find(buffer) != mPendingBuffers.end();
+		}
+
+		std::size_t UploadQueue::Flush(std::uint64_t frame, const CopyExecutor& executor)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			if (mPendingWrites.empty())
+				return 0;
+			//lay out writes in order until the budget or the free staging memory runs out
+			auto freeSize = GetContiguousFreeSize();
+			std::size_t layoutSize{ 0 };
+			std::size_t writeCount{ 0 };
+			const PendingWrite* previous{ nullptr };
+			for (const auto& write : mPendingWrites)
+			{
+				auto continues = previous && previous->buffer == write.buffer && previous->offset + previous->data.size() == write.offset;
+				auto start = continues ? layoutSize : AlignUp(layoutSize);
+				auto end = start + write.data.size();
+				if (end > freeSize || (end > mFrameBudget && writeCount > 0))
+					break;
+				layoutSize = end;
+				++writeCount;
+				previous = &write;
+			}
+			if (writeCount == 0)
+				return 0;
+
+			std::size_t allocatedSize{ 0 };
+			auto base = AllocateStaging(layoutSize, allocatedSize);
+			FrameMarker marker;
+			marker.frame = frame;
+			marker.end = mTail;
+			marker.size = allocatedSize;
+			mCopies.clear();
+			std::size_t offset{ 0 };
+			std::size_t flushedSize{ 0 };
+			for (std::size_t i = 0;i < writeCount;++i)
+			{
+				auto& write = mPendingWrites.front();
+				auto size = write.data.size();
+				auto continues = !mCopies.empty() && mCopies.back().destination == write.buffer.get()
+					&& mCopies.back().destinationOffset + mCopies.back().size == write.offset;
+				if (continues)
+				{
+					mCopies.back().size += size;
+				}
+				else
+				{
+					offset = AlignUp(offset);
+					mCopies.push_back(UploadCopy{ write.buffer.get(), write.offset, base + offset, size });
+					marker.buffers.push_back(write.buffer);
+				}
+				std::memcpy(mStagingMemory + base + offset, write.data.data(), size);
+				offset += size;
+				flushedSize += size;
+				auto it = mPendingBuffers.find(write.buffer.get());
+				if (--it->second == 0)
+					mPendingBuffers.erase(it);
+				mPendingWrites.pop_front();
+			}
+			mPendingSize -= flushedSize;
+			mPendingCount -= writeCount;
+			std::sort(marker.buffers.begin(), marker.buffers.end());
+			marker.buffers.erase(std::unique(marker.buffers.begin(), marker.buffers.end()), marker.buffers.end());
+			mFrameMarkers.push_back(std::move(marker));
+			lock.unlock();
+			if (executor)
+				executor(mCopies.data(), mCopies.size());
+			return flushedSize;
+		}
+
+		void UploadQueue::ReleaseFramesBefore(std::uint64_t frame)
+		{
+			while (!mFrameMarkers.empty() && mFrameMarkers.front().frame <= frame)
+			{
+				const auto& marker = mFrameMarkers.front();
+				mUsedSize -= marker.size;
+				mHead = marker.end;
+				mFrameMarkers.pop_front();
+			}
+			if (mUsedSize == 0)
+				mHead = mTail = 0;
+		}
+
+		std::size_t UploadQueue::GetPendingSize()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mPendingSize;
+		}
+
+		std::size_t UploadQueue::GetContiguousFreeSize()const
+		{
+			if (mUsedSize == 0)
+				return mStagingSize;
+			if (mUsedSize == mStagingSize)
+				return 0;
+			if (mTail > mHead)
+				return std::max(mStagingSize - mTail, mHead);
+			//mHead == mTail can only happen with an empty or a full ring
+			return mHead - mTail;
+		}
+
+		std::size_t UploadQueue::AllocateStaging(std::size_t size, std::size_t& allocatedSize)
+		{
+			size = AlignUp(size);
+			std::size_t offset{ 0 };
+			if (mUsedSize == 0)
+			{
+				mHead = mTail = 0;
+			}
+			if (mTail >= mHead && mStagingSize - mTail < size)
+			{
+				//wrap around,the end of the ring is wasted until the allocation is released
+				assert(mHead >= size && "Not enough staging memory!");
+				allocatedSize = mStagingSize - mTail + size;
+				offset = 0;
+			}
+			else
+			{
+				assert((mTail >= mHead || mHead - mTail >= size) && "Not enough staging memory!");
+				allocatedSize = size;
+				offset = mTail;
+			}
+			mTail = offset + size;
+			mUsedSize += allocatedSize;
+			return offset;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "IGPUBuffer.h"
+
+namespace Lightning
+{
+	namespace Render
+	{
+		//Staging offsets of copies that don't continue a previous write are aligned to this value
+		constexpr std::size_t UPLOAD_ALIGNMENT = 16;
+
+		//A copy of size bytes from staging memory to a GPU buffer
+		struct UploadCopy
+		{
+			IGPUBuffer* destination;
+			std::size_t destinationOffset;
+			std::size_t stagingOffset;
+			std::size_t size;
+		};
+
+		//Collects writes to GPU buffers and packs them into one allocation of a staging ring per frame,so the backend uploads
+		//them with a single batch of copy commands.A frame flushes at most its budget of bytes,the rest stays queued for later
+		//frames.Staging memory of a frame is recycled after the GPU finishes the frame.
+		//Enqueue and IsPending are thread safe,the other methods must be called from the render thread
+		class UploadQueue
+		{
+		public:
+			using CopyExecutor = std::function<void(const UploadCopy* copies, std::size_t copyCount)>;
+			//stagingMemory points to stagingSize bytes the backend can copy from,usually a persistently mapped upload buffer
+			UploadQueue(std::uint8_t* stagingMemory, std::size_t stagingSize, std::size_t frameBudget);
+			UploadQueue(const UploadQueue&) = delete;
+			UploadQueue& operator=(const UploadQueue&) = delete;
+			//Queues a write of size bytes at offset of buffer.data is copied so it can be freed after Enqueue returns
+			void Enqueue(const std::shared_ptr<IGPUBuffer>& buffer, std::size_t offset, const void* data, std::size_t size);
+			//Whether buffer has queued writes that are not flushed yet
+			bool IsPending(const IGPUBuffer* buffer);
+			//Copies queued writes in order into one staging allocation,as many as the frame budget and free staging memory allow,
+			//and passes the copies to executor in one call.Consecutive writes to adjacent ranges of a buffer become one copy.
+			//A write larger than the budget is flushed alone.Returns the number of flushed bytes
+			std::size_t Flush(std::uint64_t frame, const CopyExecutor& executor);
+			//Recycles staging memory of frames up to frame.Call it after the GPU finishes frame
+			void ReleaseFramesBefore(std::uint64_t frame);
+			void SetFrameBudget(std::size_t frameBudget) { mFrameBudget = frameBudget; }
+			std::size_t GetFrameBudget()const { return mFrameBudget; }
+			std::size_t GetPendingCount()const { return mPendingCount; }
+			std::size_t GetPendingSize();
+			std::size_t GetStagingSize()const { return mStagingSize; }
+			std::size_t GetStagingUsedSize()const { return mUsedSize; }
+		private:
+			struct PendingWrite
+			{
+				std::shared_ptr<IGPUBuffer> buffer;
+				std::size_t offset;
+				std::vector<std::uint8_t> data;
+			};
+			struct FrameMarker
+			{
+				std::uint64_t frame;
+				std::size_t end;
+				std::size_t size;
+				//destinations are kept alive until the GPU finishes copying to them
+				std::vector<std::shared_ptr<IGPUBuffer>> buffers;
+			};
+			std::size_t GetContiguousFreeSize()const;
+			std::size_t AllocateStaging(std::size_t size, std::size_t& allocatedSize);
+			std::uint8_t* mStagingMemory;
+			std::size_t mStagingSize;
+			std::size_t mFrameBudget;
+			std::size_t mHead;
+			std::size_t mTail;
+			std::size_t mUsedSize;
+			std::deque<FrameMarker> mFrameMarkers;
+			std::deque<PendingWrite> mPendingWrites;
+			//size of mPendingWrites,read without locking
+			std::atomic<std::size_t> mPendingCount;
+			std::size_t mPendingSize;
+			std::unordered_map<const IGPUBuffer*, std::size_t> mPendingBuffers;
+			std::vector<UploadCopy> mCopies;
+			std::mutex mMutex;
+		};
+	}
+}
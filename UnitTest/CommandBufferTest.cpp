@@ -0,0 +1,214 @@
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "tbb/parallel_for.h"
+#include "CommandBuffer.h"
+
+namespace
+{
+	using Lightning::Render::CommandBuffer;
+	using Lightning::Render::CommandHeader;
+	using Lightning::Render::FrameMemoryAllocator;
+
+	//Commands shaped like the ones recorded by a draw:shader constants,a buffer binding and a draw call
+	enum class TestCommandType : std::uint32_t
+	{
+		SET_CONSTANTS,
+		BIND_BUFFER,
+		DRAW
+	};
+
+	struct SetConstantsCommand
+	{
+		static constexpr TestCommandType TYPE = TestCommandType::SET_CONSTANTS;
+		std::uint64_t size;	//followed by size bytes of constants
+	};
+
+	struct BindBufferCommand
+	{
+		static constexpr TestCommandType TYPE = TestCommandType::BIND_BUFFER;
+		const void* buffer;
+		std::uint64_t slot;
+	};
+
+	struct DrawCommand
+	{
+		static constexpr TestCommandType TYPE = TestCommandType::DRAW;
+		std::uint64_t index;
+		std::uint64_t indexCount;
+	};
+
+	void RecordDraw(CommandBuffer& buffer, std::uint64_t index)
+	{
+		buffer.Begin(index);
+		float constants[16];
+		for (auto i = 0;i < 16;++i)
+		{
+			constants[i] = float(index + i);
+		}
+		auto setConstants = buffer.Write<SetConstantsCommand>(sizeof(constants));
+		setConstants->size = sizeof(constants);
+		std::memcpy(setConstants + 1, constants, sizeof(constants));
+		auto bindBuffer = buffer.Write<BindBufferCommand>();
+		bindBuffer->buffer = nullptr;
+		bindBuffer->slot = index % 4;
+		auto draw = buffer.Write<DrawCommand>();
+		draw->index = index;
+		draw->indexCount = 36;
+	}
+
+	//Replays commands against nothing,only decodes them the way a backend would
+	struct NullBackend
+	{
+		std::vector<std::uint64_t> drawIndices;
+		std::size_t commandCount{ 0 };
+		float constantSum{ 0.0f };
+		bool inOrder{ true };
+		void operator()(const CommandHeader& header, const void* payload)
+		{
+			++commandCount;
+			switch (static_cast<TestCommandType>(header.type))
+			{
+			case TestCommandType::SET_CONSTANTS:
+			{
+				auto command = static_cast<const SetConstantsCommand*>(payload);
+				constantSum += reinterpret_cast<const float*>(command + 1)[0];
+				break;
+			}
+			case TestCommandType::BIND_BUFFER:
+				break;
+			case TestCommandType::DRAW:
+			{
+				auto command = static_cast<const DrawCommand*>(payload);
+				if (!drawIndices.empty() && drawIndices.back() >= command->index)
+					inOrder = false;
+				drawIndices.push_back(command->index);
+				break;
+			}
+			}
+		}
+	};
+
+	TEST_CASE("Command buffer test", "[Command buffer test]")
+	{
+		constexpr std::size_t DrawCount = 10000;
+		FrameMemoryAllocator allocator;
+		CommandBuffer buffer(allocator);
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, DrawCount, 64),
+			[&buffer](const tbb::blocked_range<std::size_t>& range) {
+			for (auto i = range.begin();i != range.end();++i)
+			{
+				RecordDraw(buffer, i);
+			}
+		});
+		buffer.Merge();
+		REQUIRE(buffer.GetCommandCount() == DrawCount * 3);
+
+		//replay order follows segment keys no matter which thread recorded them
+		NullBackend backend;
+		buffer.ForEach(std::ref(backend));
+		REQUIRE(backend.commandCount == DrawCount * 3);
+		REQUIRE(backend.drawIndices.size() == DrawCount);
+		REQUIRE(backend.inOrder);
+		REQUIRE(backend.drawIndices.front() == 0);
+		REQUIRE(backend.drawIndices.back() == DrawCount - 1);
+
+		//a command larger than a chunk
+		CommandBuffer largeBuffer(allocator);
+		largeBuffer.Begin(1);
+		std::vector<std::uint8_t> constants(10000, 7);
+		auto command = largeBuffer.Write<SetConstantsCommand>(constants.size());
+		command->size = constants.size();
+		std::memcpy(command + 1, constants.data(), constants.size());
+		largeBuffer.Begin(0);
+		largeBuffer.Write<DrawCommand>()->index = 0;
+		largeBuffer.Merge();
+		std::vector<TestCommandType> types;
+		largeBuffer.ForEach([&types](const CommandHeader& header, const void* payload) {
+			types.push_back(static_cast<TestCommandType>(header.type));
+		});
+		REQUIRE(types.size() == 2);
+		REQUIRE(types[0] == TestCommandType::DRAW);
+		REQUIRE(types[1] == TestCommandType::SET_CONSTANTS);
+
+		//save and load
+		std::stringstream stream;
+		REQUIRE(buffer.Save(stream));
+		CommandBuffer loadedBuffer(allocator);
+		REQUIRE(loadedBuffer.Load(stream));
+		REQUIRE(loadedBuffer.GetCommandCount() == buffer.GetCommandCount());
+		REQUIRE(loadedBuffer.GetSize() == buffer.GetSize());
+		NullBackend loadedBackend;
+		loadedBuffer.ForEach(std::ref(loadedBackend));
+		REQUIRE(loadedBackend.drawIndices == backend.drawIndices);
+		REQUIRE(loadedBackend.constantSum == backend.constantSum);
+
+		//truncated stream is rejected
+		auto data = stream.str();
+		std::stringstream truncatedStream(data.substr(0, data.size() / 2));
+		REQUIRE_FALSE(loadedBuffer.Load(truncatedStream));
+		REQUIRE(loadedBuffer.GetCommandCount() == 0);
+
+		buffer.Reset();
+		buffer.Merge();
+		REQUIRE(buffer.GetCommandCount() == 0);
+		REQUIRE(buffer.GetSize() == 0);
+	}
+
+	TEST_CASE("Command buffer performance test", "[Command buffer performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t DrawCount = 100000;
+		FrameMemoryAllocator allocator;
+		CommandBuffer buffer(allocator);
+		auto record = [&buffer]() {
+			buffer.Reset();
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, DrawCount, 1024),
+				[&buffer](const tbb::blocked_range<std::size_t>& range) {
+				for (auto i = range.begin();i != range.end();++i)
+				{
+					RecordDraw(buffer, i);
+				}
+			});
+		};
+		//warm up tbb worker threads
+		record();
+
+		auto record_start = std::chrono::high_resolution_clock::now();
+		record();
+		auto record_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[command parallel record time(100k draws):] " << duration_cast<duration<double>>(record_end - record_start).count() << std::endl;
+
+		auto merge_start = std::chrono::high_resolution_clock::now();
+		buffer.Merge();
+		auto merge_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[command merge time(100k draws):] " << duration_cast<duration<double>>(merge_end - merge_start).count() << std::endl;
+
+		NullBackend backend;
+		auto replay_start = std::chrono::high_resolution_clock::now();
+		buffer.ForEach(std::ref(backend));
+		auto replay_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[command null backend replay time(100k draws):] " << duration_cast<duration<double>>(replay_end - replay_start).count() << std::endl;
+		std::cout << "[command buffer size(100k draws):] " << buffer.GetSize() << std::endl;
+		REQUIRE(backend.inOrder);
+		REQUIRE(backend.drawIndices.size() == DrawCount);
+
+		//a saved frame replays the same way
+		std::stringstream stream;
+		REQUIRE(buffer.Save(stream));
+		CommandBuffer loadedBuffer(allocator);
+		auto load_start = std::chrono::high_resolution_clock::now();
+		REQUIRE(loadedBuffer.Load(stream));
+		auto load_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[command load time(100k draws):] " << duration_cast<duration<double>>(load_end - load_start).count() << std::endl;
+		NullBackend loadedBackend;
+		loadedBuffer.ForEach(std::ref(loadedBackend));
+		REQUIRE(loadedBackend.drawIndices == backend.drawIndices);
+	}
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "catch.hpp"
+#include "tbb/parallel_for.h"
+#include "ConstantBufferAllocator.h"
+
+namespace
+{
+	using Lightning::Render::ConstantBufferAllocator;
+	using Lightning::Render::ConstantBufferAllocation;
+	using Lightning::Render::CONSTANT_BUFFER_ALIGNMENT;
+	using Lightning::Render::CONSTANT_BUFFER_CHUNK_SIZE;
+
+	//A fake mapped region standing in for an upload heap
+	constexpr std::uint64_t FakeGPUAddress = 0x100000000;
+
+	TEST_CASE("Constant buffer allocator test", "[Constant buffer allocator test]")
+	{
+		std::vector<std::uint8_t> region(8 * CONSTANT_BUFFER_CHUNK_SIZE);
+		ConstantBufferAllocator allocator(region.data(), FakeGPUAddress, region.size());
+		REQUIRE(allocator.GetChunkCount() == 8);
+
+		auto first = allocator.Allocate(100);
+		auto second = allocator.Allocate(300);
+		REQUIRE(first.cpuAddress == region.data());
+		REQUIRE(first.gpuAddress == FakeGPUAddress);
+		REQUIRE(first.size == CONSTANT_BUFFER_ALIGNMENT);
+		//allocations of a thread are packed in its chunk
+		REQUIRE(second.cpuAddress == region.data() + CONSTANT_BUFFER_ALIGNMENT);
+		REQUIRE(second.gpuAddress - FakeGPUAddress == std::size_t(second.cpuAddress - region.data()));
+		REQUIRE(second.size == 2 * CONSTANT_BUFFER_ALIGNMENT);
+		//a full chunk
+		auto large = allocator.Allocate(CONSTANT_BUFFER_CHUNK_SIZE);
+		REQUIRE(large.cpuAddress == region.data() + CONSTANT_BUFFER_CHUNK_SIZE);
+		REQUIRE(allocator.GetUsedChunkCount() == 2);
+
+		//a new frame starts in a new chunk
+		allocator.FinishFrame(1);
+		auto nextFrame = allocator.Allocate(16);
+		REQUIRE(nextFrame.cpuAddress == region.data() + 2 * CONSTANT_BUFFER_CHUNK_SIZE);
+		allocator.FinishFrame(2);
+		allocator.ReleaseFramesBefore(1);
+		REQUIRE(allocator.GetUsedChunkCount() == 1);
+
+		//fill the ring while the GPU doesn't finish any frame,then reuse it from the start
+		std::uint64_t frame{ 3 };
+		while (allocator.GetUsedChunkCount() < allocator.GetChunkCount())
+		{
+			allocator.Allocate(CONSTANT_BUFFER_CHUNK_SIZE);
+			allocator.FinishFrame(frame++);
+		}
+		allocator.ReleaseFramesBefore(frame);
+		REQUIRE(allocator.GetUsedChunkCount() == 0);
+		auto reused = allocator.Allocate(16);
+		//10 chunks were taken so far,the ring wrapped around
+		REQUIRE(reused.cpuAddress == region.data() + 2 * CONSTANT_BUFFER_CHUNK_SIZE);
+	}
+
+	TEST_CASE("Constant buffer allocator concurrency test", "[Constant buffer allocator test]")
+	{
+		constexpr std::size_t FrameCount = 50;
+		constexpr std::size_t AllocationCount = 2000;
+		constexpr std::size_t FramesInFlight = 3;
+		std::vector<std::uint8_t> region(64 * CONSTANT_BUFFER_CHUNK_SIZE);
+		ConstantBufferAllocator allocator(region.data(), FakeGPUAddress, region.size());
+		std::vector<ConstantBufferAllocation> allocations(AllocationCount);
+		for (std::size_t frame = 1;frame <= FrameCount;++frame)
+		{
+			//the renderer waits for the frame using the same frame resource
+			if (frame > FramesInFlight)
+				allocator.ReleaseFramesBefore(frame - FramesInFlight);
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, AllocationCount, 16),
+				[&allocator, &allocations](const tbb::blocked_range<std::size_t>& range) {
+				for (auto i = range.begin();i != range.end();++i)
+				{
+					auto size = 64 + (i % 7) * 100;
+					allocations[i] = allocator.Allocate(size);
+					//write the constants like a shader parameter would
+					std::fill(allocations[i].cpuAddress, allocations[i].cpuAddress + size, static_cast<std::uint8_t>(i));
+				}
+			});
+			allocator.FinishFrame(frame);
+			//allocations of a frame never overlap and stay inside the region
+			std::vector<std::pair<std::uint8_t*, std::size_t>> ranges;
+			for (std::size_t i = 0;i < AllocationCount;++i)
+			{
+				const auto& allocation = allocations[i];
+				REQUIRE(allocation.cpuAddress != nullptr);
+				REQUIRE(allocation.gpuAddress % CONSTANT_BUFFER_ALIGNMENT == 0);
+				REQUIRE(allocation.cpuAddress >= region.data());
+				REQUIRE(allocation.cpuAddress + allocation.size <= region.data() + region.size());
+				REQUIRE(allocation.cpuAddress[0] == static_cast<std::uint8_t>(i));
+				ranges.emplace_back(allocation.cpuAddress, allocation.size);
+			}
+			std::sort(ranges.begin(), ranges.end());
+			for (std::size_t i = 1;i < ranges.size();++i)
+			{
+				REQUIRE(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+			}
+		}
+		//frames in flight never need more than the ring
+		REQUIRE(allocator.GetUsedChunkCount() <= allocator.GetChunkCount());
+	}
+
+	TEST_CASE("Constant buffer allocator performance test", "[Constant buffer allocator performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t AllocationCount = 100000;
+		std::vector<std::uint8_t> region(1024 * CONSTANT_BUFFER_CHUNK_SIZE);
+		ConstantBufferAllocator allocator(region.data(), FakeGPUAddress, region.size());
+		std::uint64_t frame{ 0 };
+		auto allocate = [&allocator, &frame]() {
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, AllocationCount, 1024),
+				[&allocator](const tbb::blocked_range<std::size_t>& range) {
+				for (auto i = range.begin();i != range.end();++i)
+				{
+					//a world-view-projection matrix
+					allocator.Allocate(64);
+				}
+			});
+			allocator.FinishFrame(++frame);
+			allocator.ReleaseFramesBefore(frame);
+		};
+		//warm up tbb worker threads
+		allocate();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		allocate();
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << "[constant buffer parallel allocation time(100k):] " << duration_cast<duration<double>>(end - start).count() << std::endl;
+		REQUIRE(allocator.GetUsedChunkCount() == 0);
+	}
+}
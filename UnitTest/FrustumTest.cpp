@@ -0,0 +1,329 @@
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "tbb/parallel_for.h"
+#include "Math/Frustum.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::AABBf;
+	using Lightning::Foundation::Math::AABBfSoA;
+	using Lightning::Foundation::Math::Frustum;
+	using Lightning::Foundation::Math::CullAABBs;
+	using Lightning::Foundation::Math::CullAABBsMultiView;
+
+	//Same as Camera::UpdateProjectionMatrix for perspective camera
+	Matrix4f MakePerspective(float fov, float aspectRatio, float nearPlane, float farPlane)
+	{
+		Matrix4f projection;
+		projection.SetIdentity();
+		auto f = 1.0f / std::tan(fov * 0.5f);
+		auto d = farPlane - nearPlane;
+		projection.SetCell(0, 0, f / aspectRatio);
+		projection.SetCell(1, 1, f);
+		projection.SetCell(2, 2, farPlane / d);
+		projection.SetCell(3, 3, 0.0f);
+		projection.SetCell(2, 3, 1.0f);
+		projection.SetCell(3, 2, -nearPlane * farPlane / d);
+		return projection;
+	}
+
+	AABBf MakeBox(const Vector3f& center, float halfSize)
+	{
+		return AABBf{ Vector3f{center.x - halfSize, center.y - halfSize, center.z - halfSize},
+			Vector3f{center.x + halfSize, center.y + halfSize, center.z + halfSize} };
+	}
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	std::vector<AABBf> RandomBoxes(std::size_t count)
+	{
+		std::vector<AABBf> boxes(count);
+		for (auto& box : boxes)
+		{
+			box = MakeBox(Vector3f{ RandomFloat(-500, 500), RandomFloat(-500, 500), RandomFloat(-500, 500) }, RandomFloat(0.1f, 5.0f));
+		}
+		return boxes;
+	}
+
+	//View matrix of a camera at position looking along z axis rotated by angle around y axis
+	Matrix4f MakeView(float angle, const Vector3f& position)
+	{
+		Matrix4f view;
+		view.SetIdentity();
+		auto c = std::cos(angle);
+		auto s = std::sin(angle);
+		view.SetCell(0, 0, c);
+		view.SetCell(0, 2, -s);
+		view.SetCell(2, 0, s);
+		view.SetCell(2, 2, c);
+		view.SetCell(3, 0, -(position.x * c + position.z * s));
+		view.SetCell(3, 1, -position.y);
+		view.SetCell(3, 2, position.x * s - position.z * c);
+		return view;
+	}
+
+	std::vector<Frustum> MakeViewFrustums(std::size_t count)
+	{
+		std::vector<Frustum> frustums(count);
+		auto projection = MakePerspective(1.0472f, 1.6f, 0.1f, 300.0f);
+		for (std::size_t i = 0;i < count;++i)
+		{
+			auto angle = 6.2832f * i / count;
+			auto position = Vector3f{ RandomFloat(-100, 100), RandomFloat(-20, 20), RandomFloat(-100, 100) };
+			frustums[i] = Frustum::FromMatrix(MakeView(angle, position) * projection);
+		}
+		return frustums;
+	}
+
+	TEST_CASE("AABB test", "[AABB test]")
+	{
+		const Vector3f points[] = { {1.0f, -2.0f, 3.0f}, {-1.0f, 4.0f, 0.0f}, {0.5f, 0.5f, -6.0f} };
+		auto box = AABBf::FromPoints(points, 3);
+		REQUIRE(box.min == Vector3f({ -1.0f, -2.0f, -6.0f }));
+		REQUIRE(box.max == Vector3f({ 1.0f, 4.0f, 3.0f }));
+		REQUIRE(AABBf::Empty().IsEmpty());
+		REQUIRE(AABBf::Infinite().IsInfinite());
+
+		Matrix4f matrix;
+		matrix.SetIdentity();
+		//scale x by 2 and translate (10, 0, 0)
+		matrix.SetCell(0, 0, 2.0f);
+		matrix.SetCell(3, 0, 10.0f);
+		auto transformed = box.Transformed(matrix);
+		REQUIRE(transformed.min.x == Approx(8.0f));
+		REQUIRE(transformed.max.x == Approx(12.0f));
+		REQUIRE(transformed.min.y == Approx(-2.0f));
+		REQUIRE(transformed.max.z == Approx(3.0f));
+	}
+
+	TEST_CASE("Frustum test", "[Frustum test]")
+	{
+		//camera at origin looking at +z
+		auto frustum = Frustum::FromMatrix(MakePerspective(1.0472f, 1.0f, 0.1f, 100.0f));
+		REQUIRE(frustum.Intersects(MakeBox(Vector3f{ 0.0f, 0.0f, 10.0f }, 1.0f)));
+		REQUIRE_FALSE(frustum.Intersects(MakeBox(Vector3f{ 0.0f, 0.0f, -10.0f }, 1.0f)));
+		REQUIRE_FALSE(frustum.Intersects(MakeBox(Vector3f{ 0.0f, 0.0f, 200.0f }, 1.0f)));
+		REQUIRE_FALSE(frustum.Intersects(MakeBox(Vector3f{ 50.0f, 0.0f, 10.0f }, 1.0f)));
+		REQUIRE_FALSE(frustum.Intersects(MakeBox(Vector3f{ 0.0f, -50.0f, 10.0f }, 1.0f)));
+		//straddles the right plane
+		REQUIRE(frustum.Intersects(MakeBox(Vector3f{ 6.5f, 0.0f, 10.0f }, 1.0f)));
+		REQUIRE(frustum.Intersects(AABBf::Infinite()));
+		REQUIRE(frustum.Intersects(Vector3f{ 0.0f, 0.0f, 50.0f }, 1.0f));
+		REQUIRE_FALSE(frustum.Intersects(Vector3f{ 0.0f, 0.0f, -50.0f }, 1.0f));
+	}
+
+	TEST_CASE("Batch frustum culling test", "[Frustum culling test]")
+	{
+		//odd count so that AVX, SSE and scalar tail are all exercised
+		constexpr std::size_t BoxCount = 1003;
+		auto frustum = Frustum::FromMatrix(MakePerspective(1.0472f, 1.6f, 0.1f, 300.0f));
+		auto boxes = RandomBoxes(BoxCount);
+		boxes[5] = AABBf::Infinite();
+		std::vector<float> data(AABBfSoA::GetRequiredSize(BoxCount));
+		AABBfSoA soa{ data.data(), BoxCount };
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			soa.Set(i, boxes[i]);
+		}
+		std::vector<std::uint8_t> visibilities(BoxCount, 2);
+		CullAABBs(frustum, soa, 0, 501, visibilities.data());
+		CullAABBs(frustum, soa, 501, BoxCount, visibilities.data());
+		std::size_t visibleCount{ 0 };
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			CAPTURE(i);
+			REQUIRE(visibilities[i] == (frustum.Intersects(boxes[i]) ? 1 : 0));
+			visibleCount += visibilities[i];
+		}
+		REQUIRE(visibilities[5] == 1);
+		REQUIRE(visibleCount > 1);
+		REQUIRE(visibleCount < BoxCount);
+	}
+
+	TEST_CASE("Batch frustum culling empty box test", "[Frustum culling test]")
+	{
+		//the origin is in view,so an empty box stored as a point there would be reported visible
+		auto frustum = Frustum::FromMatrix(MakeView(0.0f, Vector3f{ 0.0f, 0.0f, -10.0f }) * MakePerspective(1.0472f, 1.6f, 0.1f, 300.0f));
+		REQUIRE(frustum.Intersects(Vector3f{ 0.0f, 0.0f, 0.0f }, 0.0f));
+		REQUIRE_FALSE(frustum.Intersects(AABBf::Empty()));
+		//empty boxes in AVX, SSE and scalar tail lanes
+		constexpr std::size_t BoxCount = 15;
+		std::vector<AABBf> boxes(BoxCount, MakeBox(Vector3f{ 0.0f, 0.0f, 0.0f }, 1.0f));
+		boxes[2] = boxes[9] = boxes[14] = AABBf::Empty();
+		std::vector<float> data(AABBfSoA::GetRequiredSize(BoxCount));
+		AABBfSoA soa{ data.data(), BoxCount };
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			soa.Set(i, boxes[i]);
+		}
+		std::vector<std::uint8_t> visibilities(BoxCount, 2);
+		CullAABBs(frustum, soa, 0, BoxCount, visibilities.data());
+		std::vector<std::uint32_t> masks(BoxCount, 0xffffffff);
+		CullAABBsMultiView(&frustum, 1, soa, 0, BoxCount, masks.data());
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			CAPTURE(i);
+			REQUIRE(visibilities[i] == (frustum.Intersects(boxes[i]) ? 1 : 0));
+			REQUIRE(masks[i] == visibilities[i]);
+		}
+		REQUIRE(visibilities[2] == 0);
+		REQUIRE(visibilities[0] == 1);
+	}
+
+	TEST_CASE("Batch frustum culling performance test", "[Frustum culling performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t BoxCount = 100000;
+		auto frustum = Frustum::FromMatrix(MakePerspective(1.0472f, 1.6f, 0.1f, 300.0f));
+		auto boxes = RandomBoxes(BoxCount);
+		std::vector<float> data(AABBfSoA::GetRequiredSize(BoxCount));
+		AABBfSoA soa{ data.data(), BoxCount };
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			soa.Set(i, boxes[i]);
+		}
+		std::vector<std::uint8_t> scalarVisibilities(BoxCount);
+		std::vector<std::uint8_t> batchVisibilities(BoxCount);
+		std::vector<std::uint8_t> parallelVisibilities(BoxCount);
+
+		auto scalar_start = std::chrono::high_resolution_clock::now();
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			scalarVisibilities[i] = frustum.Intersects(boxes[i]) ? 1 : 0;
+		}
+		auto scalar_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[scalar culling time(100k):] " << duration_cast<duration<double>>(scalar_end - scalar_start).count() << std::endl;
+
+		auto batch_start = std::chrono::high_resolution_clock::now();
+		CullAABBs(frustum, soa, 0, BoxCount, batchVisibilities.data());
+		auto batch_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[batch culling time(100k):] " << duration_cast<duration<double>>(batch_end - batch_start).count() << std::endl;
+
+		auto parallelCull = [&frustum, &soa, &parallelVisibilities]() {
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, BoxCount, 1024),
+				[&frustum, &soa, &parallelVisibilities](const tbb::blocked_range<std::size_t>& range) {
+				CullAABBs(frustum, soa, range.begin(), range.end(), parallelVisibilities.data());
+			});
+		};
+		//warm up tbb worker threads
+		parallelCull();
+		auto parallel_start = std::chrono::high_resolution_clock::now();
+		parallelCull();
+		auto parallel_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[parallel batch culling time(100k):] " << duration_cast<duration<double>>(parallel_end - parallel_start).count() << std::endl;
+
+		REQUIRE(scalarVisibilities == batchVisibilities);
+		REQUIRE(scalarVisibilities == parallelVisibilities);
+	}
+
+	TEST_CASE("Multi view frustum culling test", "[Frustum culling test]")
+	{
+		constexpr std::size_t BoxCount = 1003;
+		constexpr std::size_t ViewCount = 5;
+		auto frustums = MakeViewFrustums(ViewCount);
+		auto boxes = RandomBoxes(BoxCount);
+		boxes[5] = AABBf::Infinite();
+		boxes[6] = AABBf::Empty();
+		std::vector<float> data(AABBfSoA::GetRequiredSize(BoxCount));
+		AABBfSoA soa{ data.data(), BoxCount };
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			soa.Set(i, boxes[i]);
+		}
+		std::vector<std::uint32_t> masks(BoxCount, 0xffffffff);
+		CullAABBsMultiView(frustums.data(), ViewCount, soa, 0, 501, masks.data());
+		CullAABBsMultiView(frustums.data(), ViewCount, soa, 501, BoxCount, masks.data());
+		std::vector<std::uint8_t> visibilities(BoxCount);
+		for (std::size_t v = 0;v < ViewCount;++v)
+		{
+			CullAABBs(frustums[v], soa, 0, BoxCount, visibilities.data());
+			std::size_t visibleCount{ 0 };
+			for (std::size_t i = 0;i < BoxCount;++i)
+			{
+				CAPTURE(v);
+				CAPTURE(i);
+				REQUIRE(((masks[i] >> v) & 1) == visibilities[i]);
+				visibleCount += visibilities[i];
+			}
+			REQUIRE(visibleCount > 1);
+		}
+		REQUIRE(masks[5] == (1u << ViewCount) - 1);
+		REQUIRE(masks[6] == 0);
+		//no bits beyond view count
+		for (auto mask : masks)
+		{
+			REQUIRE((mask >> ViewCount) == 0);
+		}
+	}
+
+	TEST_CASE("Multi view frustum culling performance test", "[Frustum culling performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t BoxCount = 100000;
+		auto boxes = RandomBoxes(BoxCount);
+		std::vector<float> data(AABBfSoA::GetRequiredSize(BoxCount));
+		AABBfSoA soa{ data.data(), BoxCount };
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			soa.Set(i, boxes[i]);
+		}
+		for (std::size_t viewCount : { 1, 4, 16 })
+		{
+			auto frustums = MakeViewFrustums(viewCount);
+			std::vector<std::uint8_t> visibilities(BoxCount * viewCount);
+			std::vector<std::uint32_t> masks(BoxCount);
+			//one pass over the boxes for each view
+			auto perViewCull = [&]() {
+				for (std::size_t v = 0;v < viewCount;++v)
+				{
+					tbb::parallel_for(tbb::blocked_range<std::size_t>(0, BoxCount, 1024),
+						[&, v](const tbb::blocked_range<std::size_t>& range) {
+						CullAABBs(frustums[v], soa, range.begin(), range.end(), visibilities.data() + v * BoxCount);
+					});
+				}
+			};
+			//one pass over the boxes for all views
+			auto multiViewCull = [&]() {
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(0, BoxCount, 1024),
+					[&](const tbb::blocked_range<std::size_t>& range) {
+					CullAABBsMultiView(frustums.data(), viewCount, soa, range.begin(), range.end(), masks.data());
+				});
+			};
+			//warm up tbb worker threads
+			perViewCull();
+			multiViewCull();
+
+			auto per_view_start = std::chrono::high_resolution_clock::now();
+			perViewCull();
+			auto per_view_end = std::chrono::high_resolution_clock::now();
+			std::cout << "[per view culling time(100k, " << viewCount << " views):] " 
+				<< duration_cast<duration<double>>(per_view_end - per_view_start).count() << std::endl;
+
+			auto multi_view_start = std::chrono::high_resolution_clock::now();
+			multiViewCull();
+			auto multi_view_end = std::chrono::high_resolution_clock::now();
+			std::cout << "[multi view culling time(100k, " << viewCount << " views):] " 
+				<< duration_cast<duration<double>>(multi_view_end - multi_view_start).count() << std::endl;
+
+			for (std::size_t v = 0;v < viewCount;++v)
+			{
+				for (std::size_t i = 0;i < BoxCount;++i)
+				{
+					if (((masks[i] >> v) & 1) != visibilities[v * BoxCount + i])
+						FAIL("multi view culling differs from per view culling");
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "catch.hpp"
+#include "tbb/parallel_for.h"
+#include "GeometryRegistry.h"
+
+namespace
+{
+	using Lightning::Render::GeometryRegistry;
+	using Lightning::Render::IGPUBuffer;
+
+	//A buffer backed by system memory standing in for a device buffer
+	class NullBuffer : public IGPUBuffer
+	{
+	public:
+		NullBuffer(std::size_t size) : mData(size){}
+		std::uint8_t* Lock(std::size_t start, std::size_t size)override { return mData.data() + start; }
+		void Unlock(std::size_t start, std::size_t size)override{}
+		void Commit()override{}
+		std::uint32_t GetBufferSize()const override { return static_cast<std::uint32_t>(mData.size()); }
+		const std::vector<std::uint8_t>& GetData()const { return mData; }
+	private:
+		std::vector<std::uint8_t> mData;
+	};
+
+	//A null device counting buffer creations
+	struct NullDevice
+	{
+		std::size_t createdBufferCount{ 0 };
+		std::size_t createdBytes{ 0 };
+		GeometryRegistry::BufferFactory GetFactory()
+		{
+			return [this](std::size_t size) {
+				++createdBufferCount;
+				createdBytes += size;
+				return std::make_shared<NullBuffer>(size);
+			};
+		}
+	};
+
+	//interleaved position and normal of the 24 cube vertices and its 36 indices
+	struct CubeGeometry
+	{
+		CubeGeometry()
+		{
+			for (auto i = 0;i < 144;++i)
+			{
+				vertices[i] = float(i % 7) * 0.5f - 1.0f;
+			}
+			for (auto i = 0;i < 36;++i)
+			{
+				indices[i] = static_cast<std::uint16_t>(i % 24);
+			}
+		}
+		float vertices[144];
+		std::uint16_t indices[36];
+	};
+
+	constexpr std::uint64_t VertexLayout = 1;
+	constexpr std::uint64_t IndexLayout = 2;
+
+	TEST_CASE("Geometry registry test", "[Geometry registry test]")
+	{
+		constexpr std::size_t CubeCount = 200;
+		CubeGeometry cube;
+		GeometryRegistry registry;
+		NullDevice device;
+		auto factory = device.GetFactory();
+		std::vector<std::shared_ptr<IGPUBuffer>> vertexBuffers, indexBuffers;
+		for (std::size_t i = 0;i < CubeCount;++i)
+		{
+			vertexBuffers.push_back(registry.GetBuffer(VertexLayout, cube.vertices, sizeof(cube.vertices), factory));
+			indexBuffers.push_back(registry.GetBuffer(IndexLayout, cube.indices, sizeof(cube.indices), factory));
+		}
+		REQUIRE(device.createdBufferCount == 2);
+		REQUIRE(registry.GetCreatedBufferCount() == 2);
+		REQUIRE(registry.GetBufferCount() == 2);
+		REQUIRE(registry.GetUploadedBytes() == sizeof(cube.vertices) + sizeof(cube.indices));
+		for (std::size_t i = 1;i < CubeCount;++i)
+		{
+			REQUIRE(vertexBuffers[i] == vertexBuffers[0]);
+			REQUIRE(indexBuffers[i] == indexBuffers[0]);
+		}
+		REQUIRE(vertexBuffers[0] != indexBuffers[0]);
+		//content is uploaded
+		const auto& data = static_cast<NullBuffer*>(vertexBuffers[0].get())->GetData();
+		REQUIRE(data.size() == sizeof(cube.vertices));
+		REQUIRE(std::memcmp(data.data(), cube.vertices, sizeof(cube.vertices)) == 0);
+		auto naiveBytes = CubeCount * (sizeof(cube.vertices) + sizeof(cube.indices));
+		std::cout << "[geometry registry uploaded bytes(200 cubes,naive/shared):] " << naiveBytes
+			<< "/" << registry.GetUploadedBytes() << std::endl;
+
+		//the same bytes with another layout get a buffer of their own
+		auto otherLayout = registry.GetBuffer(IndexLayout + 1, cube.indices, sizeof(cube.indices), factory);
+		REQUIRE(otherLayout != indexBuffers[0]);
+		//different content gets a buffer of its own
+		CubeGeometry otherCube;
+		otherCube.vertices[0] = 100.0f;
+		auto otherContent = registry.GetBuffer(VertexLayout, otherCube.vertices, sizeof(otherCube.vertices), factory);
+		REQUIRE(otherContent != vertexBuffers[0]);
+		REQUIRE(device.createdBufferCount == 4);
+
+		//entries go away with their last user and are created again when needed
+		otherLayout.reset();
+		otherContent.reset();
+		REQUIRE(registry.GetBufferCount() == 2);
+		vertexBuffers.clear();
+		REQUIRE(registry.GetBufferCount() == 1);
+		auto vertexBuffer = registry.GetBuffer(VertexLayout, cube.vertices, sizeof(cube.vertices), factory);
+		REQUIRE(device.createdBufferCount == 5);
+		REQUIRE(registry.GetBufferCount() == 2);
+	}
+
+	TEST_CASE("Geometry registry concurrency test", "[Geometry registry test]")
+	{
+		constexpr std::size_t RequestCount = 10000;
+		CubeGeometry cube;
+		GeometryRegistry registry;
+		NullDevice device;
+		auto factory = device.GetFactory();
+		std::vector<std::shared_ptr<IGPUBuffer>> buffers(RequestCount);
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, RequestCount),
+			[&](const tbb::blocked_range<std::size_t>& range) {
+			for (auto i = range.begin();i != range.end();++i)
+			{
+				buffers[i] = registry.GetBuffer(VertexLayout, cube.vertices, sizeof(cube.vertices), factory);
+			}
+		});
+		REQUIRE(device.createdBufferCount == 1);
+		for (const auto& buffer : buffers)
+		{
+			REQUIRE(buffer == buffers[0]);
+		}
+	}
+}
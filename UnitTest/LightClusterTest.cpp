@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "LightCluster.h"
+
+namespace
+{
+	using Lightning::Render::LightClusterBuilder;
+	using Lightning::Render::LightClusterView;
+	using Lightning::Render::LightBounds;
+	using Lightning::Render::LightCluster;
+	using Lightning::Render::FrameMemoryAllocator;
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	//Camera at the origin looking along z axis
+	LightClusterView MakeView()
+	{
+		LightClusterView view;
+		view.viewMatrix.SetIdentity();
+		view.fov = 1.0472f;
+		view.aspectRatio = 16.0f / 9.0f;
+		view.nearPlane = 0.1f;
+		view.farPlane = 500.0f;
+		return view;
+	}
+
+	std::vector<LightBounds> RandomLights(std::size_t count)
+	{
+		std::vector<LightBounds> lights(count);
+		for (auto& light : lights)
+		{
+			light.center = Vector3f{ RandomFloat(-200, 200), RandomFloat(-100, 100), RandomFloat(-50, 450) };
+			light.radius = RandomFloat(1.0f, 20.0f);
+		}
+		return lights;
+	}
+
+	bool ClusterHasLight(const LightClusterBuilder& builder, std::size_t cluster, std::size_t light)
+	{
+		const auto& lightCluster = builder.GetClusters()[cluster];
+		auto begin = builder.GetLightIndices() + lightCluster.offset;
+		return std::binary_search(begin, begin + lightCluster.count, static_cast<std::uint16_t>(light));
+	}
+
+	TEST_CASE("Light cluster test", "[Light cluster test]")
+	{
+		constexpr std::size_t LightCount = 1000;
+		FrameMemoryAllocator allocator;
+		LightClusterBuilder builder(allocator);
+		auto view = MakeView();
+		auto lights = RandomLights(LightCount);
+		//a light behind the camera and a light beyond far plane are never binned
+		lights[0] = LightBounds{ Vector3f{ 0.0f, 0.0f, -30.0f }, 10.0f };
+		lights[1] = LightBounds{ Vector3f{ 0.0f, 0.0f, 600.0f }, 50.0f };
+		//a light around the camera touches all clusters of the first slice
+		lights[2] = LightBounds{ Vector3f{ 0.0f, 0.0f, 0.0f }, 1.0f };
+		builder.Build(view, lights.data(), LightCount);
+		REQUIRE(builder.GetClusterCount() == 16 * 9 * 24);
+
+		//index lists are packed,each one sorted by light index
+		std::size_t indexCount{ 0 };
+		for (std::size_t i = 0;i < builder.GetClusterCount();++i)
+		{
+			const auto& cluster = builder.GetClusters()[i];
+			REQUIRE(cluster.offset == indexCount);
+			indexCount += cluster.count;
+			auto begin = builder.GetLightIndices() + cluster.offset;
+			REQUIRE(std::is_sorted(begin, begin + cluster.count));
+			REQUIRE(std::find(begin, begin + cluster.count, 0) == begin + cluster.count);
+			REQUIRE(std::find(begin, begin + cluster.count, 1) == begin + cluster.count);
+		}
+		REQUIRE(indexCount == builder.GetLightIndexCount());
+		REQUIRE(indexCount > 0);
+		for (std::size_t y = 0;y < builder.GetDimY();++y)
+		{
+			for (std::size_t x = 0;x < builder.GetDimX();++x)
+			{
+				REQUIRE(ClusterHasLight(builder, builder.GetClusterIndex(x, y, 0), 2));
+			}
+		}
+
+		//every point inside the frustum and a light sphere finds the light in its cluster
+		auto tanHalfY = std::tan(view.fov * 0.5f);
+		auto tanHalfX = tanHalfY * view.aspectRatio;
+		std::size_t sampleCount{ 0 };
+		for (std::size_t i = 0;i < LightCount;++i)
+		{
+			const auto& light = lights[i];
+			for (auto s = 0;s < 20;++s)
+			{
+				Vector3f offset{ RandomFloat(-1, 1), RandomFloat(-1, 1), RandomFloat(-1, 1) };
+				if (offset.Length() > 1.0f)
+					continue;
+				Vector3f point{ light.center.x + offset.x * light.radius, light.center.y + offset.y * light.radius,
+					light.center.z + offset.z * light.radius };
+				if (point.z <= view.nearPlane || point.z >= view.farPlane)
+					continue;
+				auto ndcX = point.x / (point.z * tanHalfX);
+				auto ndcY = point.y / (point.z * tanHalfY);
+				if (std::abs(ndcX) >= 1.0f || std::abs(ndcY) >= 1.0f)
+					continue;
+				auto x = static_cast<std::size_t>((ndcX + 1.0f) * 0.5f * builder.GetDimX());
+				auto y = static_cast<std::size_t>((1.0f - ndcY) * 0.5f * builder.GetDimY());
+				auto cluster = builder.GetClusterIndex(x, y, builder.GetSlice(point.z));
+				CAPTURE(i);
+				CAPTURE(cluster);
+				REQUIRE(ClusterHasLight(builder, cluster, i));
+				++sampleCount;
+			}
+		}
+		REQUIRE(sampleCount > LightCount);
+
+		//a small light far right and low on screen only touches clusters there
+		std::vector<LightBounds> corner{ LightBounds{ Vector3f{ 100.0f * tanHalfX * 0.95f, -100.0f * tanHalfY * 0.95f, 100.0f }, 0.5f } };
+		builder.Build(view, corner.data(), 1);
+		REQUIRE(builder.GetLightIndexCount() > 0);
+		for (std::size_t z = 0;z < builder.GetDimZ();++z)
+		{
+			for (std::size_t y = 0;y < builder.GetDimY();++y)
+			{
+				for (std::size_t x = 0;x < builder.GetDimX();++x)
+				{
+					if (builder.GetClusters()[builder.GetClusterIndex(x, y, z)].count > 0)
+					{
+						REQUIRE(x == builder.GetDimX() - 1);
+						REQUIRE(y == builder.GetDimY() - 1);
+						REQUIRE(z == builder.GetSlice(100.0f));
+					}
+				}
+			}
+		}
+	}
+
+	TEST_CASE("Light cluster performance test", "[Light cluster performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t LightCount = 1000;
+		FrameMemoryAllocator allocator;
+		LightClusterBuilder builder(allocator, 16, 9, 24);
+		auto view = MakeView();
+		auto lights = RandomLights(LightCount);
+		//warm up tbb worker threads
+		builder.Build(view, lights.data(), LightCount);
+
+		auto build_start = std::chrono::high_resolution_clock::now();
+		builder.Build(view, lights.data(), LightCount);
+		auto build_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[light clustering time(1k lights, 16x9x24):] " << duration_cast<duration<double>>(build_end - build_start).count() << std::endl;
+		std::cout << "[light cluster indices(1k lights, 16x9x24):] " << builder.GetLightIndexCount() << std::endl;
+		REQUIRE(builder.GetLightIndexCount() > 0);
+	}
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "MeshSimplifier.h"
+#include "LodSelector.h"
+
+namespace
+{
+	using Lightning::Tools::MeshSimplifier;
+	using Lightning::Render::LodChain;
+	using Lightning::Render::LodInstance;
+	using Lightning::Render::LodSelector;
+	using Lightning::Render::LodSelectionStats;
+	using Lightning::Render::Vector3f;
+	using Lightning::Render::MAX_LOD_LEVELS;
+
+	struct TestMesh
+	{
+		std::vector<float> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	//Closed sphere,rings share the seam vertex so the mesh has no border
+	TestMesh MakeSphere(float radius, std::uint32_t rings, std::uint32_t segments)
+	{
+		TestMesh mesh;
+		auto addVertex = [&mesh](float x, float y, float z) {
+			mesh.positions.push_back(x);
+			mesh.positions.push_back(y);
+			mesh.positions.push_back(z);
+		};
+		addVertex(0.0f, radius, 0.0f);
+		for (std::uint32_t i = 1;i < rings;++i)
+		{
+			auto theta = 3.14159265f * i / rings;
+			for (std::uint32_t j = 0;j < segments;++j)
+			{
+				auto phi = 6.2831853f * j / segments;
+				addVertex(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi));
+			}
+		}
+		addVertex(0.0f, -radius, 0.0f);
+		const auto bottom = static_cast<std::uint32_t>(mesh.positions.size() / 3 - 1);
+		auto ringVertex = [segments](std::uint32_t ring, std::uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+		for (std::uint32_t j = 0;j < segments;++j)
+		{
+			mesh.indices.insert(mesh.indices.end(), { 0, ringVertex(1, j + 1), ringVertex(1, j) });
+			mesh.indices.insert(mesh.indices.end(), { bottom, ringVertex(rings - 1, j), ringVertex(rings - 1, j + 1) });
+		}
+		for (std::uint32_t i = 1;i + 1 < rings;++i)
+		{
+			for (std::uint32_t j = 0;j < segments;++j)
+			{
+				mesh.indices.insert(mesh.indices.end(), { ringVertex(i, j), ringVertex(i, j + 1), ringVertex(i + 1, j) });
+				mesh.indices.insert(mesh.indices.end(), { ringVertex(i + 1, j), ringVertex(i, j + 1), ringVertex(i + 1, j + 1) });
+			}
+		}
+		return mesh;
+	}
+
+	//Flat square grid in xz plane
+	TestMesh MakeGrid(std::uint32_t size)
+	{
+		TestMesh mesh;
+		for (std::uint32_t i = 0;i <= size;++i)
+		{
+			for (std::uint32_t j = 0;j <= size;++j)
+			{
+				mesh.positions.insert(mesh.positions.end(), { float(j), 0.0f, float(i) });
+			}
+		}
+		for (std::uint32_t i = 0;i < size;++i)
+		{
+			for (std::uint32_t j = 0;j < size;++j)
+			{
+				auto v = i * (size + 1) + j;
+				mesh.indices.insert(mesh.indices.end(), { v, v + size + 1, v + 1 });
+				mesh.indices.insert(mesh.indices.end(), { v + 1, v + size + 1, v + size + 2 });
+			}
+		}
+		return mesh;
+	}
+
+	void CheckIndices(const std::vector<std::uint32_t>& indices, std::size_t vertexCount)
+	{
+		REQUIRE(indices.size() % 3 == 0);
+		for (std::size_t i = 0;i < indices.size();i += 3)
+		{
+			REQUIRE(indices[i] < vertexCount);
+			REQUIRE(indices[i + 1] < vertexCount);
+			REQUIRE(indices[i + 2] < vertexCount);
+			REQUIRE(indices[i] != indices[i + 1]);
+			REQUIRE(indices[i + 1] != indices[i + 2]);
+			REQUIRE(indices[i] != indices[i + 2]);
+		}
+	}
+
+	TEST_CASE("Mesh simplifier test", "[LOD test]")
+	{
+		auto sphere = MakeSphere(1.0f, 32, 64);
+		auto vertexCount = sphere.positions.size() / 3;
+		MeshSimplifier simplifier(sphere.positions.data(), vertexCount, sphere.indices.data(), sphere.indices.size());
+		auto indexCount = sphere.indices.size();
+		//each level has about half the triangles of the previous one
+		for (auto level = 0;level < 4;++level)
+		{
+			auto targetIndexCount = indexCount / 6 * 3;
+			auto lod = simplifier.Simplify(targetIndexCount);
+			CAPTURE(level);
+			CheckIndices(lod, vertexCount);
+			REQUIRE(lod.size() <= targetIndexCount);
+			REQUIRE(lod.size() > 0);
+			//vertices stay on the sphere,so only the flattening between them adds error
+			REQUIRE(simplifier.GetError() < 0.05f);
+			indexCount = lod.size();
+		}
+		std::cout << "[simplified sphere triangles(full/coarsest):] " << sphere.indices.size() / 3 << "/" << indexCount / 3 << std::endl;
+
+		//error bound stops simplification
+		auto bounded = simplifier.Simplify(0, 1e-6f);
+		REQUIRE(bounded.size() > 0);
+		REQUIRE(simplifier.GetError() <= 1e-6f);
+
+		//interior of a plane collapses without error,the border is kept
+		auto grid = MakeGrid(16);
+		MeshSimplifier gridSimplifier(grid.positions.data(), grid.positions.size() / 3, grid.indices.data(), grid.indices.size());
+		auto flat = gridSimplifier.Simplify(0);
+		CheckIndices(flat, grid.positions.size() / 3);
+		REQUIRE(flat.size() < grid.indices.size() / 4);
+		REQUIRE(gridSimplifier.GetError() < 1e-6f);
+		//the area of the plane is unchanged
+		double area{ 0.0 };
+		for (std::size_t i = 0;i < flat.size();i += 3)
+		{
+			auto p0 = &grid.positions[3 * flat[i]];
+			auto p1 = &grid.positions[3 * flat[i + 1]];
+			auto p2 = &grid.positions[3 * flat[i + 2]];
+			area += 0.5 * std::abs((p1[0] - p0[0]) * (p2[2] - p0[2]) - (p2[0] - p0[0]) * (p1[2] - p0[2]));
+		}
+		REQUIRE(std::abs(area - 256.0) < 1e-3);
+	}
+
+	LodChain MakeChain()
+	{
+		LodChain chain{};
+		chain.levelCount = 4;
+		std::uint32_t triangleCounts[] = { 4096, 1024, 256, 64 };
+		float screenSizes[] = { 0.4f, 0.1f, 0.025f, 0.0f };
+		for (std::size_t i = 0;i < chain.levelCount;++i)
+		{
+			chain.triangleCounts[i] = triangleCounts[i];
+			chain.screenSizes[i] = screenSizes[i];
+		}
+		return chain;
+	}
+
+	TEST_CASE("LOD selection test", "[LOD test]")
+	{
+		auto chain = MakeChain();
+		LodSelector selector;
+		selector.SetHysteresis(0.1f);
+		LodInstance instances[] = { { &chain, 0.8f }, { &chain, 0.2f }, { &chain, 0.05f }, { &chain, 0.001f } };
+		std::uint8_t levels[4] = { MAX_LOD_LEVELS, MAX_LOD_LEVELS, MAX_LOD_LEVELS, MAX_LOD_LEVELS };
+		auto stats = selector.Select(instances, 4, levels);
+		REQUIRE(levels[0] == 0);
+		REQUIRE(levels[1] == 1);
+		REQUIRE(levels[2] == 2);
+		REQUIRE(levels[3] == 3);
+		REQUIRE(stats.submittedTriangles == 4096 + 1024 + 256 + 64);
+		REQUIRE(stats.fullDetailTriangles == 4 * 4096);
+		REQUIRE(stats.budgetCoarsenedInstances == 0);
+
+		//slightly below the threshold the level is kept,well below it switches
+		instances[0].screenSize = 0.38f;
+		instances[1].screenSize = 0.08f;
+		selector.Select(instances, 4, levels);
+		REQUIRE(levels[0] == 0);
+		REQUIRE(levels[1] == 2);
+		//slightly above the threshold the coarser level is kept
+		instances[1].screenSize = 0.105f;
+		selector.Select(instances, 4, levels);
+		REQUIRE(levels[1] == 2);
+		instances[1].screenSize = 0.2f;
+		selector.Select(instances, 4, levels);
+		REQUIRE(levels[1] == 1);
+
+		//budget coarsens the smallest instances first
+		std::fill(levels, levels + 4, std::uint8_t(MAX_LOD_LEVELS));
+		instances[0].screenSize = 0.8f;
+		selector.SetTriangleBudget(4096 + 256 + 64 + 64);
+		stats = selector.Select(instances, 4, levels);
+		REQUIRE(stats.submittedTriangles <= selector.GetTriangleBudget());
+		REQUIRE(levels[0] == 0);
+		REQUIRE(levels[1] == 2);
+		REQUIRE(levels[2] == 3);
+		REQUIRE(levels[3] == 3);
+		REQUIRE(stats.budgetCoarsenedInstances == 2);
+		//an unreachable budget ends at the coarsest levels
+		selector.SetTriangleBudget(1);
+		stats = selector.Select(instances, 4, levels);
+		REQUIRE(stats.submittedTriangles == 4 * 64);
+
+		REQUIRE(LodSelector::ComputeScreenSize(Vector3f{ 0.0f, 0.0f, 10.0f }, 1.0f, Vector3f{ 0.0f, 0.0f, 0.0f }, 2.0f) == Approx(0.2f));
+		REQUIRE(LodSelector::ComputeScreenSize(Vector3f{ 0.0f, 0.0f, 0.5f }, 1.0f, Vector3f{ 0.0f, 0.0f, 0.0f }, 2.0f) == 1.0f);
+	}
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	TEST_CASE("LOD selection performance test", "[LOD performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t InstanceCount = 100000;
+		auto chain = MakeChain();
+		//a far field scene,most instances are hundreds of meters away
+		const Vector3f cameraPosition{ 0.0f, 0.0f, 0.0f };
+		std::vector<LodInstance> instances(InstanceCount);
+		for (auto& instance : instances)
+		{
+			Vector3f center{ RandomFloat(-1000, 1000), RandomFloat(-50, 50), RandomFloat(-1000, 1000) };
+			instance.chain = &chain;
+			instance.screenSize = LodSelector::ComputeScreenSize(center, 2.0f, cameraPosition, 1.732f);
+		}
+		std::vector<std::uint8_t> levels(InstanceCount, std::uint8_t(MAX_LOD_LEVELS));
+		LodSelector selector;
+		selector.SetTriangleBudget(6500000);
+		auto select_start = std::chrono::high_resolution_clock::now();
+		auto stats = selector.Select(instances.data(), InstanceCount, levels.data());
+		auto select_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[lod selection time(100k):] " << duration_cast<duration<double>>(select_end - select_start).count() << std::endl;
+		std::cout << "[lod triangles(full detail/submitted):] " << stats.fullDetailTriangles << "/" << stats.submittedTriangles
+			<< " budget coarsened " << stats.budgetCoarsenedInstances << std::endl;
+		REQUIRE(stats.submittedTriangles <= selector.GetTriangleBudget());
+		REQUIRE(stats.submittedTriangles < stats.fullDetailTriangles / 10);
+	}
+}
@@ -0,0 +1,309 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "Math/Matrix.h"
+#include "Math/Quaternion.h"
+#include "Math/Transform.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4;
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector4;
+	using Lightning::Foundation::Math::Vector4f;
+	using Lightning::Foundation::Math::Vector3;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::Quaternion;
+	using Lightning::Foundation::Math::Quaternionf;
+	using Lightning::Foundation::Math::Transform;
+	using Lightning::Foundation::Math::AffineMatrix;
+	//double operations always take the scalar path,so they are the reference of float SIMD ones
+	using Matrix4d = Matrix4<double>;
+	using Vector4d = Vector4<double>;
+	using Vector3d = Vector3<double>;
+	using Quaterniond = Quaternion<double>;
+
+	float RandomFloat()
+	{
+		return static_cast<float>(std::rand() % 2000 - 1000) / 1000.0f;
+	}
+
+	Matrix4f RandomMatrix()
+	{
+		Matrix4f matrix;
+		for (auto i = 0;i < 16;++i)
+		{
+			matrix.m[i] = RandomFloat();
+		}
+		return matrix;
+	}
+
+	Quaternionf RandomQuaternion()
+	{
+		return Quaternionf{ RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat() };
+	}
+
+	Matrix4d ToDouble(const Matrix4f& matrix)
+	{
+		Matrix4d res;
+		for (auto i = 0;i < 16;++i)
+		{
+			res.m[i] = matrix.m[i];
+		}
+		return res;
+	}
+
+	void RequireEqual(const Matrix4f& matrix, const Matrix4d& expected, double margin)
+	{
+		for (auto i = 0;i < 16;++i)
+		{
+			CAPTURE(i);
+			REQUIRE(matrix.m[i] == Approx(expected.m[i]).margin(margin));
+		}
+	}
+
+	TEST_CASE("SIMD matrix test", "[Math SIMD test]")
+	{
+		for (auto n = 0;n < 100;++n)
+		{
+			auto m1 = RandomMatrix();
+			auto m2 = RandomMatrix();
+			auto expected = ToDouble(m1) * ToDouble(m2);
+			RequireEqual(m1 * m2, expected, 1e-5);
+			//result may alias either operand
+			auto aliased = m1;
+			aliased.MultMatrix(m2, aliased);
+			RequireEqual(aliased, expected, 1e-5);
+			aliased = m2;
+			m1.MultMatrix(aliased, aliased);
+			RequireEqual(aliased, expected, 1e-5);
+			aliased = m1;
+			aliased *= m2;
+			RequireEqual(aliased, expected, 1e-5);
+
+			auto transposed = m1.Transposed();
+			for (unsigned i = 0;i < 4;++i)
+			{
+				for (unsigned j = 0;j < 4;++j)
+					REQUIRE(transposed.GetCell(i, j) == m1.GetCell(j, i));
+			}
+
+			auto inversed = m1.Inversed();
+			auto expectedInversed = ToDouble(m1).Inversed();
+			for (auto i = 0;i < 16;++i)
+			{
+				//random matrices may be ill conditioned,so error is relative to the magnitude of inverse
+				REQUIRE(inversed.m[i] == Approx(expectedInversed.m[i]).epsilon(1e-3).margin(1e-4));
+			}
+			Matrix4d identity;
+			identity.SetIdentity();
+			Matrix4f scaled = m1;
+			for (auto i = 0;i < 16;++i)
+				scaled.m[i] += i % 5 == 0 ? 4.0f : 0.0f;
+			RequireEqual(scaled * scaled.Inversed(), identity, 1e-5);
+
+			Vector4f v{ RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat() };
+			Vector4d vd{ v.x, v.y, v.z, v.w };
+			auto md = ToDouble(m1);
+			auto rowResult = v * m1;
+			auto rowExpected = vd * md;
+			REQUIRE(rowResult.x == Approx(rowExpected.x).margin(1e-5));
+			REQUIRE(rowResult.y == Approx(rowExpected.y).margin(1e-5));
+			REQUIRE(rowResult.z == Approx(rowExpected.z).margin(1e-5));
+			REQUIRE(rowResult.w == Approx(rowExpected.w).margin(1e-5));
+			auto columnResult = m1 * v;
+			auto columnExpected = md * vd;
+			REQUIRE(columnResult.x == Approx(columnExpected.x).margin(1e-5));
+			REQUIRE(columnResult.y == Approx(columnExpected.y).margin(1e-5));
+			REQUIRE(columnResult.z == Approx(columnExpected.z).margin(1e-5));
+			REQUIRE(columnResult.w == Approx(columnExpected.w).margin(1e-5));
+		}
+	}
+
+	TEST_CASE("SIMD quaternion test", "[Math SIMD test]")
+	{
+		for (auto n = 0;n < 100;++n)
+		{
+			//not normalized on purpose,results must match scalar formulas for any quaternion
+			auto q1 = RandomQuaternion();
+			auto q2 = RandomQuaternion();
+			Quaterniond qd1{ q1.x, q1.y, q1.z, q1.w };
+			Quaterniond qd2{ q2.x, q2.y, q2.z, q2.w };
+			auto product = q1 * q2;
+			auto expected = qd1 * qd2;
+			REQUIRE(product.x == Approx(expected.x).margin(1e-5));
+			REQUIRE(product.y == Approx(expected.y).margin(1e-5));
+			REQUIRE(product.z == Approx(expected.z).margin(1e-5));
+			REQUIRE(product.w == Approx(expected.w).margin(1e-5));
+
+			Vector3f v{ RandomFloat(), RandomFloat(), RandomFloat() };
+			Vector3d vd{ v.x, v.y, v.z };
+			auto rotated = q1 * v;
+			auto expectedRotated = qd1 * vd;
+			REQUIRE(rotated.x == Approx(expectedRotated.x).margin(1e-5));
+			REQUIRE(rotated.y == Approx(expectedRotated.y).margin(1e-5));
+			REQUIRE(rotated.z == Approx(expectedRotated.z).margin(1e-5));
+
+			//a unit quaternion keeps length
+			q1.Normalize();
+			REQUIRE(q1.RotateVector(v).Length() == Approx(v.Length()).epsilon(1e-4));
+		}
+	}
+
+	Transform RandomTransform()
+	{
+		//random rotations are slightly off unit length,which would skew the rotation matrix
+		auto rotation = Transform::RandomRotation();
+		rotation.Normalize();
+		return Transform(Vector3f{ RandomFloat() * 10, RandomFloat() * 10, RandomFloat() * 10 },
+			Vector3f{ 1.5f + RandomFloat(), 1.5f + RandomFloat(), 1.5f + RandomFloat() }, rotation);
+	}
+
+	//scale * rotation * translation
+	Matrix4d ComposeTRS(const Transform& transform)
+	{
+		auto position = transform.GetPosition();
+		auto scale = transform.GetScale();
+		auto rotation = transform.GetRotation();
+		Matrix4d matScale, matRotation, matTrans;
+		matScale.SetIdentity();
+		matScale.SetCell(0, 0, scale.x);
+		matScale.SetCell(1, 1, scale.y);
+		matScale.SetCell(2, 2, scale.z);
+		Quaterniond{ rotation.x, rotation.y, rotation.z, rotation.w }.ToMatrix(matRotation);
+		matTrans.SetIdentity();
+		matTrans.SetRow(3, Vector4d{ position.x, position.y, position.z, 1.0 });
+		return matScale * matRotation * matTrans;
+	}
+
+	TEST_CASE("SIMD transform test", "[Math SIMD test]")
+	{
+		for (auto n = 0;n < 100;++n)
+		{
+			auto transform = RandomTransform();
+			auto expected = ComposeTRS(transform);
+			RequireEqual(transform.LocalToGlobalMatrix4(), expected, 1e-4);
+			//analytic inverse matches the general one
+			RequireEqual(transform.GlobalToLocalMatrix4(), expected.Inversed(), 1e-4);
+			auto affine = transform.GetAffineMatrix();
+			RequireEqual(affine.ToMatrix4(), expected, 1e-4);
+
+			//compose then decompose yields the same matrix,the quaternion may be negated
+			auto decomposed = Transform::FromAffineMatrix(affine);
+			RequireEqual(decomposed.GetMatrix(), expected, 1e-4);
+			REQUIRE(decomposed.GetRotation().Length() == Approx(1.0f).epsilon(1e-4));
+
+			auto other = RandomTransform();
+			auto product = affine * other.GetAffineMatrix();
+			RequireEqual(product.ToMatrix4(), expected * ComposeTRS(other), 1e-3);
+			Vector3f point{ RandomFloat(), RandomFloat(), RandomFloat() };
+			auto transformed = product.TransformPoint(point);
+			auto expectedPoint = Vector4d{ point.x, point.y, point.z, 1.0 } * (expected * ComposeTRS(other));
+			REQUIRE(transformed.x == Approx(expectedPoint.x).margin(1e-3));
+			REQUIRE(transformed.y == Approx(expectedPoint.y).margin(1e-3));
+			REQUIRE(transformed.z == Approx(expectedPoint.z).margin(1e-3));
+
+			//a product with non uniform scale has shear,forward is kept and up stays in the plane of up and forward
+			auto forward = Vector3f{ product.GetCell(2, 0), product.GetCell(2, 1), product.GetCell(2, 2) };
+			auto up = Vector3f{ product.GetCell(1, 0), product.GetCell(1, 1), product.GetCell(1, 2) };
+			auto sheared = Transform::FromAffineMatrix(product);
+			REQUIRE(sheared.GetScale().z == Approx(forward.Length()).epsilon(1e-4));
+			forward.Normalize();
+			REQUIRE(sheared.Forward().Dot(forward) == Approx(1.0f).epsilon(1e-4));
+			REQUIRE(sheared.Right().Dot(up) == Approx(0.0f).margin(1e-4));
+			REQUIRE(sheared.Up().Dot(up) > 0.0f);
+		}
+	}
+
+	template<typename Function>
+	void Benchmark(const char* name, Function&& function)
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		auto start = std::chrono::high_resolution_clock::now();
+		function();
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << "[" << name << "(1M ops):] " << duration_cast<duration<double>>(end - start).count() << std::endl;
+	}
+
+	TEST_CASE("SIMD math performance test", "[Math SIMD performance]")
+	{
+		constexpr std::size_t OperationCount = 1000000;
+		constexpr std::size_t InputCount = 1024;
+		std::vector<Matrix4f> matrices(InputCount);
+		std::vector<Vector4f> vectors(InputCount);
+		std::vector<Vector3f> vectors3(InputCount);
+		std::vector<Quaternionf> quaternions(InputCount);
+		for (std::size_t i = 0;i < InputCount;++i)
+		{
+			matrices[i] = RandomMatrix();
+			for (auto j = 0;j < 16;j += 5)
+				matrices[i].m[j] += 4.0f;
+			vectors[i] = Vector4f{ RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat() };
+			vectors3[i] = Vector3f{ RandomFloat(), RandomFloat(), RandomFloat() };
+			quaternions[i] = RandomQuaternion();
+			quaternions[i].Normalize();
+		}
+		//results are stored so that the operations can't be optimized away
+		std::vector<Matrix4f> matrixResults(InputCount);
+		std::vector<Vector4f> vectorResults(InputCount);
+		std::vector<Vector3f> vector3Results(InputCount);
+		std::vector<Quaternionf> quaternionResults(InputCount);
+		std::vector<Transform> transforms(InputCount), transformResults(InputCount);
+		std::vector<AffineMatrix> affineMatrices(InputCount);
+		//kept apart from matrixResults,which is checked against the inverse benchmark
+		std::vector<Matrix4f> composedMatrices(InputCount);
+		for (std::size_t i = 0;i < InputCount;++i)
+		{
+			transforms[i] = RandomTransform();
+			affineMatrices[i] = transforms[i].GetAffineMatrix();
+		}
+		Benchmark("matrix multiply", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				matrixResults[i % InputCount] = matrices[i % InputCount] * matrices[(i + 1) % InputCount];
+		});
+		Benchmark("matrix transpose", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				matrixResults[i % InputCount] = matrices[i % InputCount].Transposed();
+		});
+		Benchmark("matrix inverse", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				matrixResults[i % InputCount] = matrices[i % InputCount].Inversed();
+		});
+		Benchmark("vector * matrix", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				vectorResults[i % InputCount] = vectors[i % InputCount] * matrices[(i + 1) % InputCount];
+		});
+		Benchmark("matrix * vector", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				vectorResults[i % InputCount] = matrices[(i + 1) % InputCount] * vectors[i % InputCount];
+		});
+		Benchmark("quaternion multiply", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				quaternionResults[i % InputCount] = quaternions[i % InputCount] * quaternions[(i + 1) % InputCount];
+		});
+		Benchmark("quaternion rotate", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				vector3Results[i % InputCount] = quaternions[(i + 1) % InputCount] * vectors3[i % InputCount];
+		});
+		Benchmark("transform compose", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+			{
+				auto& transform = transformResults[i % InputCount];
+				transform.SetPosition(vectors3[i % InputCount]);
+				composedMatrices[i % InputCount] = transform.GlobalToLocalMatrix4();
+			}
+		});
+		Benchmark("transform decompose", [&]() {
+			for (std::size_t i = 0;i < OperationCount;++i)
+				transformResults[i % InputCount] = Transform::FromAffineMatrix(affineMatrices[i % InputCount]);
+		});
+		auto expected = matrices[0].Inversed();
+		REQUIRE(matrixResults[0].m[5] == expected.m[5]);
+		REQUIRE(vectorResults[0].x == (matrices[1] * vectors[0]).x);
+		REQUIRE(vector3Results[0].x == (quaternions[1] * vectors3[0]).x);
+		REQUIRE(quaternionResults[0].w == (quaternions[0] * quaternions[1]).w);
+	}
+}
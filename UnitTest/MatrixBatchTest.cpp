@@ -0,0 +1,107 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "Math/MatrixBatch.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Matrix4fSoA;
+	using Lightning::Foundation::Math::BatchMultiplyMatrix;
+
+	Matrix4f RandomMatrix()
+	{
+		Matrix4f matrix;
+		for (auto i = 0;i < 16;++i)
+		{
+			matrix.m[i] = static_cast<float>(std::rand() % 200 - 100) / 100.0f;
+		}
+		return matrix;
+	}
+
+	TEST_CASE("Batch matrix multiply test", "[Matrix batch test]")
+	{
+		//odd count so that AVX, SSE and scalar tail are all exercised
+		constexpr std::size_t MatrixCount = 23;
+		std::vector<Matrix4f> worlds(MatrixCount);
+		std::vector<float> cells(Matrix4fSoA::GetRequiredSize(MatrixCount));
+		Matrix4fSoA soa{ cells.data(), MatrixCount };
+		for (std::size_t i = 0;i < MatrixCount;++i)
+		{
+			worlds[i] = RandomMatrix();
+			soa.Set(i, worlds[i]);
+		}
+		Matrix4f stored;
+		soa.Get(7, stored);
+		for (auto i = 0;i < 16;++i)
+		{
+			REQUIRE(stored.m[i] == worlds[7].m[i]);
+		}
+
+		const auto viewProjection = RandomMatrix() * RandomMatrix();
+		std::vector<Matrix4f> results(MatrixCount);
+		SECTION("Whole range")
+		{
+			BatchMultiplyMatrix(soa, viewProjection, results.data(), 0, MatrixCount);
+		}
+		SECTION("Split ranges")
+		{
+			BatchMultiplyMatrix(soa, viewProjection, results.data(), 0, 5);
+			BatchMultiplyMatrix(soa, viewProjection, results.data(), 5, 18);
+			BatchMultiplyMatrix(soa, viewProjection, results.data(), 18, MatrixCount);
+		}
+		for (std::size_t i = 0;i < MatrixCount;++i)
+		{
+			auto expected = worlds[i] * viewProjection;
+			CAPTURE(i);
+			for (auto j = 0;j < 16;++j)
+			{
+				REQUIRE(results[i].m[j] == Approx(expected.m[j]).epsilon(1e-4));
+			}
+		}
+	}
+
+	TEST_CASE("Batch matrix multiply performance test", "[Matrix batch performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t MatrixCount = 100000;
+		std::vector<Matrix4f> worlds(MatrixCount);
+		std::vector<float> cells(Matrix4fSoA::GetRequiredSize(MatrixCount));
+		Matrix4fSoA soa{ cells.data(), MatrixCount };
+		for (std::size_t i = 0;i < MatrixCount;++i)
+		{
+			worlds[i] = RandomMatrix();
+			soa.Set(i, worlds[i]);
+		}
+		const auto view = RandomMatrix();
+		const auto projection = RandomMatrix();
+		std::vector<Matrix4f> scalarResults(MatrixCount);
+		std::vector<Matrix4f> batchResults(MatrixCount);
+
+		//What DrawCommand used to do : world * view * projection for every draw
+		auto scalar_start = std::chrono::high_resolution_clock::now();
+		for (std::size_t i = 0;i < MatrixCount;++i)
+		{
+			scalarResults[i] = worlds[i] * view * projection;
+		}
+		auto scalar_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[scalar WVP time(100k):] " << duration_cast<duration<double>>(scalar_end - scalar_start).count() << std::endl;
+
+		auto batch_start = std::chrono::high_resolution_clock::now();
+		const auto viewProjection = view * projection;
+		BatchMultiplyMatrix(soa, viewProjection, batchResults.data(), 0, MatrixCount);
+		auto batch_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[batch WVP time(100k):] " << duration_cast<duration<double>>(batch_end - batch_start).count() << std::endl;
+
+		for (std::size_t i = 0;i < MatrixCount;i += 997)
+		{
+			for (auto j = 0;j < 16;++j)
+			{
+				REQUIRE(batchResults[i].m[j] == Approx(scalarResults[i].m[j]).epsilon(1e-3));
+			}
+		}
+	}
+}
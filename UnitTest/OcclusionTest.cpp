@@ -0,0 +1,192 @@
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "tbb/parallel_for.h"
+#include "OcclusionBuffer.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::AABBf;
+	using Lightning::Render::OcclusionBuffer;
+	using Lightning::Render::OccluderGeometry;
+
+	Matrix4f MakePerspective(float fov, float aspectRatio, float nearPlane, float farPlane)
+	{
+		Matrix4f projection;
+		projection.SetIdentity();
+		auto f = 1.0f / std::tan(fov * 0.5f);
+		auto d = farPlane - nearPlane;
+		projection.SetCell(0, 0, f / aspectRatio);
+		projection.SetCell(1, 1, f);
+		projection.SetCell(2, 2, farPlane / d);
+		projection.SetCell(3, 3, 0.0f);
+		projection.SetCell(2, 3, 1.0f);
+		projection.SetCell(3, 2, -nearPlane * farPlane / d);
+		return projection;
+	}
+
+	//camera looking at +z
+	Matrix4f MakeViewProjection(const Vector3f& cameraPosition)
+	{
+		Matrix4f view;
+		view.SetIdentity();
+		view.SetCell(3, 0, -cameraPosition.x);
+		view.SetCell(3, 1, -cameraPosition.y);
+		view.SetCell(3, 2, -cameraPosition.z);
+		return view * MakePerspective(1.0472f, 2.0f, 0.1f, 500.0f);
+	}
+
+	Matrix4f MakeWorldMatrix(const Vector3f& position, const Vector3f& scale)
+	{
+		Matrix4f world;
+		world.SetIdentity();
+		world.SetCell(0, 0, scale.x);
+		world.SetCell(1, 1, scale.y);
+		world.SetCell(2, 2, scale.z);
+		world.SetCell(3, 0, position.x);
+		world.SetCell(3, 1, position.y);
+		world.SetCell(3, 2, position.z);
+		return world;
+	}
+
+	AABBf MakeBox(const Vector3f& center, float halfSize)
+	{
+		return AABBf{ Vector3f{center.x - halfSize, center.y - halfSize, center.z - halfSize},
+			Vector3f{center.x + halfSize, center.y + halfSize, center.z + halfSize} };
+	}
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	//unit cube centered at origin
+	const Vector3f CubeVertices[] = {
+		{-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f},
+		{-0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}
+	};
+	const std::uint16_t CubeIndices[] = {
+		0, 1, 2, 0, 2, 3,
+		4, 6, 5, 4, 7, 6,
+		0, 4, 5, 0, 5, 1,
+		3, 2, 6, 3, 6, 7,
+		0, 3, 7, 0, 7, 4,
+		1, 5, 6, 1, 6, 2
+	};
+	const OccluderGeometry CubeGeometry{ CubeVertices, 8, sizeof(Vector3f), CubeIndices, 36 };
+
+	TEST_CASE("Occlusion buffer test", "[Occlusion test]")
+	{
+		OcclusionBuffer buffer(250, 120);
+		REQUIRE(buffer.GetWidth() == 256);
+		REQUIRE(buffer.GetHeight() == 128);
+		buffer.Begin(MakeViewProjection(Vector3f{ 0.0f, 0.0f, 0.0f }));
+		//a 10x10 wall at z = 10
+		buffer.AddOccluder(CubeGeometry, MakeWorldMatrix(Vector3f{ 0.0f, 0.0f, 10.0f }, Vector3f{ 10.0f, 10.0f, 0.5f }));
+		REQUIRE(buffer.GetTriangleCount() > 0);
+		buffer.Rasterize();
+
+		//center pixel is covered by the wall,corner pixel is not
+		REQUIRE(buffer.GetDepth(128, 64) < 1.0f);
+		REQUIRE(buffer.GetDepth(0, 0) == 1.0f);
+		//behind the wall
+		REQUIRE_FALSE(buffer.IsVisible(MakeBox(Vector3f{ 0.0f, 0.0f, 30.0f }, 1.0f)));
+		REQUIRE_FALSE(buffer.IsVisible(MakeBox(Vector3f{ 1.0f, -2.0f, 50.0f }, 2.0f)));
+		//in front of the wall
+		REQUIRE(buffer.IsVisible(MakeBox(Vector3f{ 0.0f, 0.0f, 5.0f }, 1.0f)));
+		//intersects the wall
+		REQUIRE(buffer.IsVisible(MakeBox(Vector3f{ 0.0f, 0.0f, 10.0f }, 1.0f)));
+		//behind the wall but sticks out of its silhouette
+		REQUIRE(buffer.IsVisible(MakeBox(Vector3f{ 16.0f, 0.0f, 30.0f }, 2.0f)));
+		//behind the camera
+		REQUIRE(buffer.IsVisible(MakeBox(Vector3f{ 0.0f, 0.0f, 0.0f }, 1.0f)));
+		REQUIRE(buffer.IsVisible(AABBf::Infinite()));
+		REQUIRE_FALSE(buffer.IsVisible(AABBf::Empty()));
+
+		//a new frame without occluders hides nothing
+		buffer.Begin(MakeViewProjection(Vector3f{ 0.0f, 0.0f, 0.0f }));
+		buffer.Rasterize();
+		REQUIRE(buffer.GetDepth(128, 64) == 1.0f);
+		REQUIRE(buffer.IsVisible(MakeBox(Vector3f{ 0.0f, 0.0f, 30.0f }, 1.0f)));
+	}
+
+	//A city like scene:a grid of buildings used as occluders and a lot of small props scattered between them
+	TEST_CASE("Occlusion culling performance test", "[Occlusion performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t BoxCount = 100000;
+		constexpr int GridSize = 20;
+		std::vector<Matrix4f> buildings;
+		for (int i = 0;i < GridSize;++i)
+		{
+			for (int j = 0;j < GridSize;++j)
+			{
+				auto height = RandomFloat(10.0f, 40.0f);
+				buildings.push_back(MakeWorldMatrix(Vector3f{ (i - GridSize / 2) * 20.0f, height * 0.5f, j * 20.0f + 15.0f },
+					Vector3f{ 14.0f, height, 14.0f }));
+			}
+		}
+		std::vector<AABBf> boxes(BoxCount);
+		for (auto& box : boxes)
+		{
+			box = MakeBox(Vector3f{ RandomFloat(-200.0f, 200.0f), RandomFloat(0.5f, 3.0f), RandomFloat(5.0f, 400.0f) }, RandomFloat(0.2f, 1.0f));
+		}
+		OcclusionBuffer buffer;
+		auto viewProjection = MakeViewProjection(Vector3f{ 0.0f, 2.0f, 0.0f });
+		std::vector<std::uint8_t> visibilities(BoxCount);
+		auto cull = [&]() {
+			buffer.Begin(viewProjection);
+			for (const auto& building : buildings)
+			{
+				buffer.AddOccluder(CubeGeometry, building);
+			}
+			buffer.Rasterize();
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, BoxCount, 1024),
+				[&](const tbb::blocked_range<std::size_t>& range) {
+				for (auto i = range.begin();i != range.end();++i)
+				{
+					visibilities[i] = buffer.IsVisible(boxes[i]) ? 1 : 0;
+				}
+			});
+		};
+		//warm up tbb worker threads
+		cull();
+
+		auto rasterize_start = std::chrono::high_resolution_clock::now();
+		buffer.Begin(viewProjection);
+		for (const auto& building : buildings)
+		{
+			buffer.AddOccluder(CubeGeometry, building);
+		}
+		buffer.Rasterize();
+		auto rasterize_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[occluder rasterization time(400 occluders):] " << duration_cast<duration<double>>(rasterize_end - rasterize_start).count() << std::endl;
+
+		auto test_start = std::chrono::high_resolution_clock::now();
+		tbb::parallel_for(tbb::blocked_range<std::size_t>(0, BoxCount, 1024),
+			[&](const tbb::blocked_range<std::size_t>& range) {
+			for (auto i = range.begin();i != range.end();++i)
+			{
+				visibilities[i] = buffer.IsVisible(boxes[i]) ? 1 : 0;
+			}
+		});
+		auto test_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[occludee test time(100k):] " << duration_cast<duration<double>>(test_end - test_start).count() << std::endl;
+
+		std::size_t visibleCount{ 0 };
+		for (auto visible : visibilities)
+		{
+			visibleCount += visible;
+		}
+		std::cout << "[occlusion culled:] " << BoxCount - visibleCount << "/" << BoxCount << std::endl;
+		REQUIRE(visibleCount < BoxCount);
+		REQUIRE(visibleCount > 0);
+		REQUIRE(buffer.SaveDepthImage("occlusion_depth.pgm"));
+	}
+}
@@ -0,0 +1,213 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "PipelineStateManifest.h"
+#include "PipelineCompileQueue.h"
+
+namespace
+{
+	using Lightning::Render::PipelineStateManifest;
+	using Lightning::Render::PipelineCompileQueue;
+	using Lightning::Render::PipelineCompileStatus;
+	using Lightning::Render::IPipelineStateCompiler;
+
+	//Descriptions starting with 0xff fail to compile
+	class StubPipelineCompiler : public IPipelineStateCompiler
+	{
+	public:
+		StubPipelineCompiler(std::chrono::microseconds compileTime = std::chrono::microseconds(0))
+			: mCompileTime(compileTime), mCompileCount(0){}
+		bool CompilePipelineState(const void* desc, std::size_t size)override
+		{
+			//busy wait like a driver compiling shaders
+			auto start = std::chrono::high_resolution_clock::now();
+			while (std::chrono::high_resolution_clock::now() - start < mCompileTime);
+			++mCompileCount;
+			return size > 0 && *static_cast<const std::uint8_t*>(desc) != 0xff;
+		}
+		int GetCompileCount()const { return mCompileCount; }
+	private:
+		std::chrono::microseconds mCompileTime;
+		std::atomic<int> mCompileCount;
+	};
+
+	std::vector<std::uint8_t> MakeDesc(std::size_t size, std::uint8_t value)
+	{
+		return std::vector<std::uint8_t>(size, value);
+	}
+
+	TEST_CASE("Pipeline state manifest test", "[Pipeline cache test]")
+	{
+		const char* path = "PipelineStatesTest.manifest";
+		PipelineStateManifest manifest;
+		REQUIRE(!manifest.IsDirty());
+		for (std::size_t i = 0;i < 16;++i)
+		{
+			auto desc = MakeDesc(i * 7 + 1, static_cast<std::uint8_t>(i));
+			REQUIRE(manifest.Add(i * 1000, desc.data(), desc.size()));
+		}
+		auto duplicate = MakeDesc(3, 1);
+		REQUIRE(!manifest.Add(5000, duplicate.data(), duplicate.size()));
+		REQUIRE(manifest.GetCount() == 16);
+		REQUIRE(manifest.Contains(3000));
+		REQUIRE(!manifest.Contains(3001));
+		REQUIRE(manifest.IsDirty());
+		REQUIRE(manifest.Save(path));
+		REQUIRE(!manifest.IsDirty());
+
+		//states come back in the order they are added
+		PipelineStateManifest loaded;
+		REQUIRE(loaded.Load(path));
+		REQUIRE(loaded.GetCount() == 16);
+		REQUIRE(!loaded.IsDirty());
+		std::size_t index{ 0 };
+		loaded.ForEach([&index](std::size_t hash, const void* desc, std::size_t size) {
+			REQUIRE(hash == index * 1000);
+			REQUIRE(size == index * 7 + 1);
+			auto bytes = static_cast<const std::uint8_t*>(desc);
+			for (std::size_t i = 0;i < size;++i)
+			{
+				REQUIRE(bytes[i] == index);
+			}
+			++index;
+		});
+		REQUIRE(index == 16);
+
+		//a truncated file is rejected as a whole
+		std::vector<char> content;
+		{
+			std::ifstream file(path, std::ios::binary);
+			content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(content.data(), content.size() - 5);
+		}
+		REQUIRE(!loaded.Load(path));
+		REQUIRE(loaded.GetCount() == 0);
+		//so is a file of another version
+		content[4] = static_cast<char>(PipelineStateManifest::FILE_VERSION + 1);
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(content.data(), content.size());
+		}
+		REQUIRE(!loaded.Load(path));
+		REQUIRE(!loaded.Load("MissingPipelineStates.manifest"));
+		std::remove(path);
+	}
+
+	TEST_CASE("Pipeline compile queue test", "[Pipeline cache test]")
+	{
+		StubPipelineCompiler compiler;
+		PipelineCompileQueue queue(compiler);
+		REQUIRE(queue.GetStatus(1) == PipelineCompileStatus::NONE);
+		auto desc = MakeDesc(8, 1);
+		auto badDesc = MakeDesc(8, 0xff);
+		REQUIRE(queue.Request(1, desc.data(), desc.size()) != PipelineCompileStatus::NONE);
+		REQUIRE(queue.Request(2, badDesc.data(), badDesc.size()) != PipelineCompileStatus::NONE);
+		//a state is compiled once no matter how many times it's requested
+		for (auto i = 0;i < 100;++i)
+		{
+			queue.Request(1, desc.data(), desc.size());
+		}
+		queue.Wait();
+		REQUIRE(compiler.GetCompileCount() == 2);
+		REQUIRE(queue.GetStatus(1) == PipelineCompileStatus::READY);
+		REQUIRE(queue.GetStatus(2) == PipelineCompileStatus::FAILED);
+		REQUIRE(queue.Request(1, desc.data(), desc.size()) == PipelineCompileStatus::READY);
+		REQUIRE(queue.GetPendingCount() == 0);
+		REQUIRE(queue.GetReadyCount() == 1);
+		REQUIRE(queue.GetFailedCount() == 1);
+
+		//states of a manifest requested from several threads
+		PipelineStateManifest manifest;
+		for (std::size_t i = 0;i < 200;++i)
+		{
+			auto stateDesc = MakeDesc(16, static_cast<std::uint8_t>(i % 200));
+			manifest.Add(100 + i, stateDesc.data(), stateDesc.size());
+		}
+		std::vector<std::thread> threads;
+		for (auto t = 0;t < 4;++t)
+		{
+			threads.emplace_back([&manifest, &queue]() {
+				manifest.ForEach([&queue](std::size_t hash, const void* stateDesc, std::size_t size) {
+					queue.Request(hash, stateDesc, size);
+				});
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		queue.Wait();
+		REQUIRE(compiler.GetCompileCount() == 202);
+		manifest.ForEach([&queue](std::size_t hash, const void* stateDesc, std::size_t size) {
+			REQUIRE(queue.GetStatus(hash) == PipelineCompileStatus::READY);
+		});
+	}
+
+	TEST_CASE("Pipeline compile queue wait test", "[Pipeline cache test]")
+	{
+		StubPipelineCompiler compiler(std::chrono::milliseconds(20));
+		PipelineCompileQueue queue(compiler);
+		REQUIRE(queue.Wait(1) == PipelineCompileStatus::NONE);
+		auto desc = MakeDesc(8, 1);
+		auto badDesc = MakeDesc(8, 0xff);
+		REQUIRE(queue.Request(1, desc.data(), desc.size()) == PipelineCompileStatus::PENDING);
+		queue.Request(2, badDesc.data(), badDesc.size());
+		//other requests rehashing the statuses while waiting
+		std::thread requester([&queue, &desc]() {
+			for (std::size_t i = 0;i < 100;++i)
+			{
+				queue.Request(100 + i, desc.data(), desc.size());
+			}
+		});
+		//waiting for a pending state doesn't compile it again
+		REQUIRE(queue.Wait(1) == PipelineCompileStatus::READY);
+		REQUIRE(queue.Wait(2) == PipelineCompileStatus::FAILED);
+		requester.join();
+		queue.Wait();
+		REQUIRE(compiler.GetCompileCount() == 102);
+	}
+
+	TEST_CASE("Pipeline prewarm performance test", "[Pipeline cache performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t StateCount = 64;
+		const std::chrono::microseconds compileTime(2000);
+		PipelineStateManifest manifest;
+		for (std::size_t i = 0;i < StateCount;++i)
+		{
+			auto desc = MakeDesc(64, static_cast<std::uint8_t>(i));
+			manifest.Add(i, desc.data(), desc.size());
+		}
+		//compiling on the render thread as states are first drawn
+		StubPipelineCompiler serialCompiler(compileTime);
+		auto serial_start = std::chrono::high_resolution_clock::now();
+		manifest.ForEach([&serialCompiler](std::size_t hash, const void* desc, std::size_t size) {
+			serialCompiler.CompilePipelineState(desc, size);
+		});
+		auto serial_end = std::chrono::high_resolution_clock::now();
+
+		StubPipelineCompiler compiler(compileTime);
+		PipelineCompileQueue queue(compiler);
+		auto prewarm_start = std::chrono::high_resolution_clock::now();
+		manifest.ForEach([&queue](std::size_t hash, const void* desc, std::size_t size) {
+			queue.Request(hash, desc, size);
+		});
+		auto request_end = std::chrono::high_resolution_clock::now();
+		queue.Wait();
+		auto prewarm_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[pipeline compile time(64 states, serial):] " << duration_cast<duration<double>>(serial_end - serial_start).count() << std::endl;
+		std::cout << "[pipeline prewarm time(64 states, request/total):] " << duration_cast<duration<double>>(request_end - prewarm_start).count()
+			<< "/" << duration_cast<duration<double>>(prewarm_end - prewarm_start).count() << std::endl;
+		REQUIRE(queue.GetReadyCount() == StateCount);
+	}
+}
@@ -0,0 +1,162 @@
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "Math/PositionBatch.h"
+#include "Math/MatrixBatch.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Matrix4fSoA;
+	using Lightning::Foundation::Math::Vector3d;
+	using Lightning::Foundation::Math::Vector3dSoA;
+	using Lightning::Foundation::Math::BatchToRelativePositions;
+
+	double RandomDouble(double low, double high)
+	{
+		return low + (high - low) * static_cast<double>(std::rand()) / RAND_MAX;
+	}
+
+	Vector3d RandomVector(double low, double high)
+	{
+		return Vector3d{ RandomDouble(low, high), RandomDouble(low, high), RandomDouble(low, high) };
+	}
+
+	TEST_CASE("Batch to relative positions test", "[Position batch test]")
+	{
+		//odd count so that AVX, SSE and scalar tail are all exercised
+		constexpr std::size_t PositionCount = 23;
+		//a camera far away from the origin,e.g.on the surface of a planet
+		auto origin = RandomVector(1e8, 1e9);
+		std::vector<double> components(Vector3dSoA::GetRequiredSize(PositionCount));
+		Vector3dSoA positions{ components.data(), PositionCount };
+		std::vector<Vector3d> expected(PositionCount);
+		for (std::size_t i = 0;i < PositionCount;++i)
+		{
+			auto offset = RandomVector(-1000, 1000);
+			positions.Set(i, Vector3d{ origin.x + offset.x, origin.y + offset.y, origin.z + offset.z });
+			Vector3d position;
+			positions.Get(i, position);
+			expected[i] = Vector3d{ position.x - origin.x, position.y - origin.y, position.z - origin.z };
+		}
+		std::vector<float> x(PositionCount), y(PositionCount), z(PositionCount);
+		float* const results[3] = { x.data(), y.data(), z.data() };
+		SECTION("Whole range")
+		{
+			BatchToRelativePositions(positions, origin, results, 0, PositionCount);
+		}
+		SECTION("Split ranges")
+		{
+			BatchToRelativePositions(positions, origin, results, 0, 5);
+			BatchToRelativePositions(positions, origin, results, 5, 18);
+			BatchToRelativePositions(positions, origin, results, 18, PositionCount);
+		}
+		for (std::size_t i = 0;i < PositionCount;++i)
+		{
+			CAPTURE(i);
+			REQUIRE(x[i] == static_cast<float>(expected[i].x));
+			REQUIRE(y[i] == static_cast<float>(expected[i].y));
+			REQUIRE(z[i] == static_cast<float>(expected[i].z));
+		}
+
+		//subtracting in float loses everything below the float spacing of the positions(several units at 1e9)
+		Vector3d position;
+		positions.Get(0, position);
+		auto naive = static_cast<float>(position.x) - static_cast<float>(origin.x);
+		REQUIRE(std::abs(x[0] - expected[0].x) < 1e-3);
+		REQUIRE(std::abs(naive - expected[0].x) > std::abs(x[0] - expected[0].x));
+	}
+
+	TEST_CASE("Batch to relative positions into matrix translations test", "[Position batch test]")
+	{
+		constexpr std::size_t Count = 13;
+		Vector3d origin{ -4e8, 2e7, 6e8 };
+		std::vector<double> components(Vector3dSoA::GetRequiredSize(Count));
+		Vector3dSoA positions{ components.data(), Count };
+		std::vector<float> cells(Matrix4fSoA::GetRequiredSize(Count));
+		Matrix4fSoA matrices{ cells.data(), Count };
+		Matrix4f identity;
+		identity.SetIdentity();
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			positions.Set(i, Vector3d{ origin.x + double(i), origin.y - 0.25 * i, origin.z + 0.5 });
+			matrices.Set(i, identity);
+		}
+		//translation row is in cells 3, 7 and 11 in column major layout
+		float* const translations[3] = { matrices.cells + 3 * Count, matrices.cells + 7 * Count, matrices.cells + 11 * Count };
+		BatchToRelativePositions(positions, origin, translations, 0, Count);
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			CAPTURE(i);
+			Matrix4f matrix;
+			matrices.Get(i, matrix);
+			REQUIRE(matrix.GetCell(3, 0) == float(i));
+			REQUIRE(matrix.GetCell(3, 1) == -0.25f * i);
+			REQUIRE(matrix.GetCell(3, 2) == 0.5f);
+			REQUIRE(matrix.GetCell(0, 0) == 1.0f);
+			REQUIRE(matrix.GetCell(3, 3) == 1.0f);
+		}
+	}
+
+	template<typename Function>
+	double Measure(Function&& function)
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		//best of a few runs,the first one also warms up caches
+		double best{ 0.0 };
+		for (auto i = 0;i < 5;++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto end = std::chrono::high_resolution_clock::now();
+			auto time = duration_cast<duration<double>>(end - start).count();
+			if (i == 0 || time < best)
+				best = time;
+		}
+		return best;
+	}
+
+	void Report(const char* name, double time, std::size_t count, std::size_t bytesPerElement)
+	{
+		std::cout << "[" << name << " time:] " << time << std::endl;
+		std::cout << "[" << name << " elements/s:] " << count / time << std::endl;
+		std::cout << "[" << name << " GB/s:] " << count * bytesPerElement / time / 1e9 << std::endl;
+	}
+
+	TEST_CASE("Batch to relative positions performance test", "[Position batch performance]")
+	{
+		constexpr std::size_t Count = 1000000;
+		auto origin = RandomVector(1e8, 1e9);
+		std::vector<Vector3d> aosPositions(Count);
+		std::vector<double> components(Vector3dSoA::GetRequiredSize(Count));
+		Vector3dSoA positions{ components.data(), Count };
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			auto offset = RandomVector(-1e4, 1e4);
+			aosPositions[i] = Vector3d{ origin.x + offset.x, origin.y + offset.y, origin.z + offset.z };
+			positions.Set(i, aosPositions[i]);
+		}
+		std::vector<float> x(Count), y(Count), z(Count);
+		float* const results[3] = { x.data(), y.data(), z.data() };
+		constexpr auto BytesPerElement = sizeof(Vector3d) + sizeof(float) * 3;
+
+		//what a per drawable conversion would do
+		Report("scalar to relative positions(1M)", Measure([&]() {
+			for (std::size_t i = 0;i < Count;++i)
+			{
+				x[i] = static_cast<float>(aosPositions[i].x - origin.x);
+				y[i] = static_cast<float>(aosPositions[i].y - origin.y);
+				z[i] = static_cast<float>(aosPositions[i].z - origin.z);
+			}
+		}), Count, BytesPerElement);
+		auto scalarX = x[7];
+		Report("batch to relative positions(1M)", Measure([&]() {
+			BatchToRelativePositions(positions, origin, results, 0, Count);
+		}), Count, BytesPerElement);
+		REQUIRE(x[7] == scalarX);
+	}
+}
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "RenderGraph.h"
+
+namespace
+{
+	using Lightning::Render::RenderGraph;
+	using Lightning::Render::RenderGraphHandle;
+	using Lightning::Render::RenderGraphTextureDesc;
+	using Lightning::Render::INVALID_RENDER_GRAPH_HANDLE;
+
+	//A deferred shading frame:shadow and gbuffer passes feed SSAO and lighting,followed by a bloom chain,tone mapping and FXAA.
+	//The debug pass writes a texture nobody reads so it's culled
+	struct SampleGraph
+	{
+		RenderGraphHandle shadow, gbuffer, ssao, lighting, bloomDown, bloomBlur, toneMapping, fxaa, debug, ui;
+		std::vector<RenderGraphHandle> textures;
+	};
+
+	SampleGraph BuildSampleGraph(RenderGraph& graph, std::vector<RenderGraphHandle>* recorded, std::vector<RenderGraphHandle>* executed)
+	{
+		SampleGraph sample;
+		auto backBuffer = graph.ImportResource("BackBuffer");
+		auto shadowMap = graph.CreateTexture("ShadowMap", RenderGraphTextureDesc{ 2048, 2048, 4 });
+		auto albedo = graph.CreateTexture("GBufferAlbedo", RenderGraphTextureDesc{ 1920, 1080, 4 });
+		auto normal = graph.CreateTexture("GBufferNormal", RenderGraphTextureDesc{ 1920, 1080, 8 });
+		auto depth = graph.CreateTexture("GBufferDepth", RenderGraphTextureDesc{ 1920, 1080, 4 });
+		auto ao = graph.CreateTexture("SSAO", RenderGraphTextureDesc{ 1920, 1080, 1 });
+		auto hdr = graph.CreateTexture("HDR", RenderGraphTextureDesc{ 1920, 1080, 8 });
+		auto bloomA = graph.CreateTexture("BloomA", RenderGraphTextureDesc{ 960, 540, 8 });
+		auto bloomB = graph.CreateTexture("BloomB", RenderGraphTextureDesc{ 960, 540, 8 });
+		auto ldr = graph.CreateTexture("LDR", RenderGraphTextureDesc{ 1920, 1080, 4 });
+		auto debugView = graph.CreateTexture("DebugView", RenderGraphTextureDesc{ 1920, 1080, 4 });
+		sample.textures = { shadowMap, albedo, normal, depth, ao, hdr, bloomA, bloomB, ldr, debugView };
+
+		auto addPass = [&](const std::string& name) {
+			RenderGraphHandle handle = static_cast<RenderGraphHandle>(graph.GetPassCount());
+			RenderGraph::PassFunction record, execute;
+			if (recorded)
+			{
+				record = [recorded, handle]() {
+					//passes of a level are recorded in parallel
+					static std::mutex mutex;
+					std::lock_guard<std::mutex> lock(mutex);
+					recorded->push_back(handle);
+				};
+			}
+			if (executed)
+			{
+				execute = [executed, handle]() { executed->push_back(handle); };
+			}
+			return graph.AddPass(name, record, execute);
+		};
+		sample.shadow = addPass("Shadow");
+		graph.Write(sample.shadow, shadowMap);
+		sample.gbuffer = addPass("GBuffer");
+		graph.Write(sample.gbuffer, albedo);
+		graph.Write(sample.gbuffer, normal);
+		graph.Write(sample.gbuffer, depth);
+		sample.ssao = addPass("SSAO");
+		graph.Read(sample.ssao, normal);
+		graph.Read(sample.ssao, depth);
+		graph.Write(sample.ssao, ao);
+		sample.debug = addPass("Debug");
+		graph.Read(sample.debug, normal);
+		graph.Write(sample.debug, debugView);
+		sample.lighting = addPass("Lighting");
+		graph.Read(sample.lighting, albedo);
+		graph.Read(sample.lighting, normal);
+		graph.Read(sample.lighting, depth);
+		graph.Read(sample.lighting, shadowMap);
+		graph.Read(sample.lighting, ao);
+		graph.Write(sample.lighting, hdr);
+		sample.bloomDown = addPass("BloomDownsample");
+		graph.Read(sample.bloomDown, hdr);
+		graph.Write(sample.bloomDown, bloomA);
+		sample.bloomBlur = addPass("BloomBlur");
+		graph.Read(sample.bloomBlur, bloomA);
+		graph.Write(sample.bloomBlur, bloomB);
+		sample.toneMapping = addPass("ToneMapping");
+		graph.Read(sample.toneMapping, hdr);
+		graph.Read(sample.toneMapping, bloomB);
+		graph.Write(sample.toneMapping, ldr);
+		sample.fxaa = addPass("FXAA");
+		graph.Read(sample.fxaa, ldr);
+		graph.Write(sample.fxaa, backBuffer);
+		sample.ui = addPass("UI");
+		graph.Write(sample.ui, backBuffer);
+		return sample;
+	}
+
+	TEST_CASE("Render graph schedule test", "[Render graph test]")
+	{
+		RenderGraph graph;
+		std::vector<RenderGraphHandle> recorded, executed;
+		auto sample = BuildSampleGraph(graph, &recorded, &executed);
+		REQUIRE(graph.GetResourceHandle("HDR") == sample.textures[5]);
+		REQUIRE(graph.GetResourceHandle("Unknown") == INVALID_RENDER_GRAPH_HANDLE);
+		graph.Compile();
+
+		REQUIRE(graph.IsPassCulled(sample.debug));
+		REQUIRE_FALSE(graph.IsResourceUsed(sample.textures.back()));
+		REQUIRE(graph.GetPassOrder().size() == graph.GetPassCount() - 1);
+		//independent passes share a level
+		REQUIRE(graph.GetPassLevel(sample.shadow) == 0);
+		REQUIRE(graph.GetPassLevel(sample.gbuffer) == 0);
+		REQUIRE(graph.GetPassLevel(sample.ssao) == 1);
+		REQUIRE(graph.GetPassLevel(sample.lighting) == 2);
+		REQUIRE(graph.GetPassLevel(sample.toneMapping) == 5);
+		//UI writes the back buffer after FXAA
+		REQUIRE(graph.GetPassLevel(sample.fxaa) == 6);
+		REQUIRE(graph.GetPassLevel(sample.ui) == 7);
+		REQUIRE(graph.GetLevelCount() == 8);
+		//levels never decrease along the pass order
+		const auto& order = graph.GetPassOrder();
+		for (std::size_t i = 1;i < order.size();++i)
+		{
+			REQUIRE(graph.GetPassLevel(order[i - 1]) <= graph.GetPassLevel(order[i]));
+		}
+
+		//textures alive at the same time never share memory
+		for (auto lhs : sample.textures)
+		{
+			for (auto rhs : sample.textures)
+			{
+				if (lhs == rhs || !graph.IsResourceUsed(lhs) || !graph.IsResourceUsed(rhs))
+					continue;
+				auto lifetimesOverlap = graph.GetResourceFirstUse(lhs) <= graph.GetResourceLastUse(rhs)
+					&& graph.GetResourceFirstUse(rhs) <= graph.GetResourceLastUse(lhs);
+				auto memoryOverlaps = graph.GetResourceOffset(lhs) < graph.GetResourceOffset(rhs) + graph.GetResourceSize(rhs)
+					&& graph.GetResourceOffset(rhs) < graph.GetResourceOffset(lhs) + graph.GetResourceSize(lhs);
+				CAPTURE(lhs);
+				CAPTURE(rhs);
+				REQUIRE_FALSE((lifetimesOverlap && memoryOverlaps));
+			}
+		}
+		REQUIRE(graph.GetTransientMemorySize() < graph.GetUnaliasedMemorySize());
+		std::cout << "[render graph transient memory(unaliased/aliased):] " << graph.GetUnaliasedMemorySize()
+			<< "/" << graph.GetTransientMemorySize() << " saved " << graph.GetUnaliasedMemorySize() - graph.GetTransientMemorySize()
+			<< " bytes" << std::endl;
+
+		graph.Execute();
+		REQUIRE(executed == order);
+		REQUIRE(recorded.size() == order.size());
+		//recording of a level finishes before the next level starts
+		for (std::size_t i = 1;i < recorded.size();++i)
+		{
+			REQUIRE(graph.GetPassLevel(recorded[i - 1]) <= graph.GetPassLevel(recorded[i]));
+		}
+	}
+
+	TEST_CASE("Render graph culling test", "[Render graph test]")
+	{
+		RenderGraph graph;
+		auto output = graph.ImportResource("Output");
+		auto a = graph.CreateTexture("A", RenderGraphTextureDesc{ 256, 256, 4 });
+		auto b = graph.CreateTexture("B", RenderGraphTextureDesc{ 256, 256, 4 });
+		auto producer = graph.AddPass("Producer", nullptr, nullptr);
+		graph.Write(producer, a);
+		//only read by a culled pass
+		auto unused = graph.AddPass("Unused", nullptr, nullptr);
+		graph.Read(unused, a);
+		graph.Write(unused, b);
+		auto sideEffect = graph.AddPass("SideEffect", nullptr, nullptr);
+		graph.SetSideEffect(sideEffect);
+		graph.Compile();
+		REQUIRE(graph.IsPassCulled(producer));
+		REQUIRE(graph.IsPassCulled(unused));
+		REQUIRE_FALSE(graph.IsPassCulled(sideEffect));
+		REQUIRE(graph.GetTransientMemorySize() == 0);
+
+		//reading the chain from a pass writing an imported resource keeps it
+		auto present = graph.AddPass("Present", nullptr, nullptr);
+		graph.Read(present, b);
+		graph.Write(present, output);
+		graph.Compile();
+		REQUIRE_FALSE(graph.IsPassCulled(producer));
+		REQUIRE_FALSE(graph.IsPassCulled(unused));
+		REQUIRE(graph.GetPassLevel(present) == 2);
+		//a and b are both alive while Unused runs
+		REQUIRE(graph.GetTransientMemorySize() == graph.GetUnaliasedMemorySize());
+		graph.Execute();
+
+		graph.Reset();
+		REQUIRE(graph.GetPassCount() == 0);
+		REQUIRE(graph.GetResourceHandle("A") == INVALID_RENDER_GRAPH_HANDLE);
+	}
+}
@@ -0,0 +1,219 @@
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "RenderProxyTable.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::Vector3d;
+	using Lightning::Foundation::Math::AABBf;
+	using Lightning::Foundation::Math::AABBfSoA;
+	using Lightning::Foundation::Math::Frustum;
+	using Lightning::Render::RenderProxyTable;
+	using Lightning::Render::RenderProxyHandle;
+
+	Matrix4f MakeTranslation(const Vector3f& position)
+	{
+		Matrix4f matrix;
+		matrix.SetIdentity();
+		matrix.SetCell(3, 0, position.x);
+		matrix.SetCell(3, 1, position.y);
+		matrix.SetCell(3, 2, position.z);
+		return matrix;
+	}
+
+	Matrix4f MakePerspective(float fov, float aspectRatio, float nearPlane, float farPlane)
+	{
+		Matrix4f projection;
+		projection.SetIdentity();
+		auto f = 1.0f / std::tan(fov * 0.5f);
+		auto d = farPlane - nearPlane;
+		projection.SetCell(0, 0, f / aspectRatio);
+		projection.SetCell(1, 1, f);
+		projection.SetCell(2, 2, farPlane / d);
+		projection.SetCell(3, 3, 0.0f);
+		projection.SetCell(2, 3, 1.0f);
+		projection.SetCell(3, 2, -nearPlane * farPlane / d);
+		return projection;
+	}
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	const AABBf UnitBox{ Vector3f{-0.5f, -0.5f, -0.5f}, Vector3f{0.5f, 0.5f, 0.5f} };
+
+	void RequireSoAMatches(const RenderProxyTable& table)
+	{
+		auto soa = table.GetWorldBoundingBoxSoA();
+		for (std::size_t i = 0;i < table.GetCount();++i)
+		{
+			auto center = table.GetWorldBoundingBox(i).GetCenter();
+			REQUIRE(soa.data[i] == Approx(center.x));
+			REQUIRE(soa.data[soa.stride + i] == Approx(center.y));
+			REQUIRE(soa.data[2 * soa.stride + i] == Approx(center.z));
+		}
+	}
+
+	TEST_CASE("Render proxy table test", "[Render proxy test]")
+	{
+		RenderProxyTable table;
+		std::vector<RenderProxyHandle> handles;
+		for (int i = 0;i < 100;++i)
+		{
+			auto world = MakeTranslation(Vector3f{ float(i), 0.0f, 0.0f });
+			handles.push_back(table.Add(nullptr, nullptr, world, UnitBox.Transformed(world)));
+		}
+		REQUIRE(table.GetCount() == 100);
+		RequireSoAMatches(table);
+
+		//removing moves the last proxy into the hole,other handles keep pointing to their proxies
+		table.Remove(handles[10]);
+		REQUIRE_FALSE(table.IsValid(handles[10]));
+		REQUIRE(table.GetCount() == 99);
+		REQUIRE(table.GetIndex(handles[99]) == 10);
+		REQUIRE(table.GetHandle(10) == handles[99]);
+		for (int i = 0;i < 100;++i)
+		{
+			if (i == 10)
+				continue;
+			CAPTURE(i);
+			REQUIRE(table.IsValid(handles[i]));
+			REQUIRE(table.GetWorldMatrix(table.GetIndex(handles[i])).GetCell(3, 0) == float(i));
+		}
+		RequireSoAMatches(table);
+
+		auto world = MakeTranslation(Vector3f{ 0.0f, 5.0f, 0.0f });
+		table.SetTransform(handles[99], world, UnitBox.Transformed(world));
+		REQUIRE(table.GetWorldBoundingBox(10).GetCenter().y == Approx(5.0f));
+		RequireSoAMatches(table);
+
+		//handles are recycled
+		auto handle = table.Add(nullptr, nullptr, world, UnitBox);
+		REQUIRE(handle == handles[10]);
+		REQUIRE(table.GetIndex(handle) == 99);
+
+		table.Remove(handle);
+		table.Remove(handles[0]);
+		REQUIRE(table.GetCount() == 98);
+		RequireSoAMatches(table);
+		table.Clear();
+		REQUIRE(table.GetCount() == 0);
+	}
+
+	TEST_CASE("Render proxy precise position test", "[Render proxy test]")
+	{
+		RenderProxyTable table;
+		auto world = MakeTranslation(Vector3f{ 1.0f, 2.0f, 3.0f });
+		//without a precise position the translation of world matrix is used
+		auto first = table.Add(nullptr, nullptr, world, UnitBox.Transformed(world));
+		REQUIRE(table.GetPrecisePosition(0).x == 1.0);
+		REQUIRE(table.GetPrecisePosition(0).z == 3.0);
+
+		const Vector3d position{ 1e9 + 0.5, -2e8 + 0.25, 3.0 };
+		world = MakeTranslation(Vector3f{ float(position.x), float(position.y), float(position.z) });
+		auto second = table.Add(nullptr, nullptr, world, UnitBox.Transformed(world), position);
+		REQUIRE(table.GetPrecisePosition(1).x == position.x);
+		//moved into the hole on removal
+		table.Remove(first);
+		REQUIRE(table.GetIndex(second) == 0);
+		REQUIRE(table.GetPrecisePosition(0).x == position.x);
+		REQUIRE(table.GetPrecisePosition(0).y == position.y);
+
+		table.SetTransform(second, world, UnitBox.Transformed(world), Vector3d{ position.x + 1.0, position.y, position.z });
+		REQUIRE(table.GetPrecisePosition(0).x == position.x + 1.0);
+		table.SetTransform(second, world, UnitBox.Transformed(world));
+		REQUIRE(table.GetPrecisePosition(0).x == double(float(position.x)));
+	}
+
+	//A static scene of 100k objects where 1% of them move every frame.
+	//Immediate mode rebuilds the culling input from every object each frame,while retained mode only updates moved proxies.
+	TEST_CASE("Render proxy performance test", "[Render proxy performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t ObjectCount = 100000;
+		constexpr std::size_t MovingCount = ObjectCount / 100;
+		constexpr std::size_t FrameCount = 10;
+		struct Object
+		{
+			Matrix4f world;
+			AABBf localBoundingBox;
+		};
+		std::vector<Object> objects(ObjectCount);
+		for (auto& object : objects)
+		{
+			object.world = MakeTranslation(Vector3f{ RandomFloat(-500, 500), RandomFloat(-500, 500), RandomFloat(-500, 500) });
+			object.localBoundingBox = UnitBox;
+		}
+		std::vector<std::size_t> movingObjects(MovingCount);
+		for (auto& index : movingObjects)
+		{
+			index = std::rand() % ObjectCount;
+		}
+		auto move = [&objects, &movingObjects]() {
+			for (auto index : movingObjects)
+			{
+				objects[index].world.SetCell(3, 1, objects[index].world.GetCell(3, 1) + 0.1f);
+			}
+		};
+		const auto frustum = Frustum::FromMatrix(MakePerspective(1.0472f, 1.6f, 0.1f, 300.0f));
+		std::vector<std::uint8_t> immediateVisibilities(ObjectCount);
+		std::vector<std::uint8_t> retainedVisibilities(ObjectCount);
+
+		//immediate mode:world boxes of all objects are gathered every frame
+		std::vector<float> boxData(AABBfSoA::GetRequiredSize(ObjectCount));
+		std::vector<Matrix4f> worldMatrices(ObjectCount);
+		AABBfSoA boxes{ boxData.data(), ObjectCount };
+		auto immediate_start = std::chrono::high_resolution_clock::now();
+		for (std::size_t frame = 0;frame < FrameCount;++frame)
+		{
+			move();
+			for (std::size_t i = 0;i < ObjectCount;++i)
+			{
+				worldMatrices[i] = objects[i].world;
+				boxes.Set(i, objects[i].localBoundingBox.Transformed(objects[i].world));
+			}
+			Lightning::Foundation::Math::CullAABBs(frustum, boxes, 0, ObjectCount, immediateVisibilities.data());
+		}
+		auto immediate_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[immediate mode frame time(100k, 1% moving):] "
+			<< duration_cast<duration<double>>(immediate_end - immediate_start).count() / FrameCount << std::endl;
+
+		//retained mode:proxies are registered once and only moved objects are updated
+		RenderProxyTable table;
+		std::vector<RenderProxyHandle> handles(ObjectCount);
+		for (std::size_t i = 0;i < ObjectCount;++i)
+		{
+			handles[i] = table.Add(nullptr, nullptr, objects[i].world, objects[i].localBoundingBox.Transformed(objects[i].world));
+		}
+		auto retained_start = std::chrono::high_resolution_clock::now();
+		for (std::size_t frame = 0;frame < FrameCount;++frame)
+		{
+			move();
+			for (auto index : movingObjects)
+			{
+				const auto& object = objects[index];
+				table.SetTransform(handles[index], object.world, object.localBoundingBox.Transformed(object.world));
+			}
+			Lightning::Foundation::Math::CullAABBs(frustum, table.GetWorldBoundingBoxSoA(), 0, table.GetCount(), retainedVisibilities.data());
+		}
+		auto retained_end = std::chrono::high_resolution_clock::now();
+		std::cout << "[retained mode frame time(100k, 1% moving):] "
+			<< duration_cast<duration<double>>(retained_end - retained_start).count() / FrameCount << std::endl;
+
+		//proxies were added in object order and never removed so indices match
+		for (std::size_t i = 0;i < ObjectCount;++i)
+		{
+			boxes.Set(i, objects[i].localBoundingBox.Transformed(objects[i].world));
+		}
+		Lightning::Foundation::Math::CullAABBs(frustum, boxes, 0, ObjectCount, immediateVisibilities.data());
+		REQUIRE(immediateVisibilities == retainedVisibilities);
+	}
+}
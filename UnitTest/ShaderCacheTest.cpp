@@ -0,0 +1,261 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <boost/filesystem.hpp>
+#include "catch.hpp"
+#include "ShaderMacros.h"
+#include "ShaderVariant.h"
+#include "ShaderBytecodeCache.h"
+
+namespace
+{
+	using Lightning::Render::ShaderMacros;
+	using Lightning::Render::ShaderMacroVocabulary;
+	using Lightning::Render::ShaderVariantBits;
+	using Lightning::Render::ShaderBytecode;
+	using Lightning::Render::ShaderBytecodeCache;
+	using Lightning::Render::ShaderCompileInput;
+	using Lightning::Render::IShaderCompiler;
+	using Lightning::Render::MAX_SHADER_VARIANT_MACROS;
+
+	//Bytecode is the source followed by the macros,sources containing "error" fail to compile
+	class StubShaderCompiler : public IShaderCompiler
+	{
+	public:
+		StubShaderCompiler(std::uint32_t version = 1, std::chrono::microseconds compileTime = std::chrono::microseconds(0))
+			: mVersion(version), mCompileTime(compileTime), mCompileCount(0){}
+		std::uint32_t GetVersion()const override { return mVersion; }
+		bool Compile(const ShaderCompileInput& input, ShaderBytecode& byteCode, std::string& errors)override
+		{
+			//busy wait like a real compiler
+			auto start = std::chrono::high_resolution_clock::now();
+			while (std::chrono::high_resolution_clock::now() - start < mCompileTime);
+			++mCompileCount;
+			if (input.source.find("error") != std::string::npos)
+			{
+				errors = input.name + " : syntax error";
+				return false;
+			}
+			byteCode.assign(input.source.begin(), input.source.end());
+			byteCode.insert(byteCode.end(), input.macros.begin(), input.macros.end());
+			return true;
+		}
+		int GetCompileCount()const { return mCompileCount; }
+	private:
+		std::uint32_t mVersion;
+		std::chrono::microseconds mCompileTime;
+		std::atomic<int> mCompileCount;
+	};
+
+	ShaderCompileInput MakeInput(const std::string& source, const std::string& macros)
+	{
+		ShaderCompileInput input;
+		input.name = "test.vs";
+		input.source = source;
+		input.entry = "main";
+		input.target = "vs_5_1";
+		input.macros = macros;
+		input.flags = 0;
+		return input;
+	}
+
+	TEST_CASE("Shader variant macros test", "[Shader cache test]")
+	{
+		auto vocabulary = ShaderMacroVocabulary::Instance();
+		auto normalMapBit = vocabulary->Declare("TEST_NORMAL_MAP");
+		auto skinningBit = vocabulary->Declare("TEST_SKINNING");
+		REQUIRE(normalMapBit < MAX_SHADER_VARIANT_MACROS);
+		REQUIRE(skinningBit != normalMapBit);
+		REQUIRE(vocabulary->Declare("TEST_NORMAL_MAP") == normalMapBit);
+		REQUIRE(vocabulary->GetName(skinningBit) == "TEST_SKINNING");
+		REQUIRE(vocabulary->GetBit("TEST_UNDECLARED") == MAX_SHADER_VARIANT_MACROS);
+
+		//declared flags become bits,values and undeclared macros stay strings
+		ShaderMacros macros;
+		macros.Define("TEST_NORMAL_MAP", "");
+		macros.Define("TEST_SKINNING", "1");
+		macros.Define("TEST_UNDECLARED", "");
+		macros.Define("TEST_LIGHT_COUNT", "4");
+		REQUIRE(macros.GetVariantBits() == ((ShaderVariantBits(1) << normalMapBit) | (ShaderVariantBits(1) << skinningBit)));
+		REQUIRE(macros.GetMacroCount() == 4);
+		REQUIRE(macros.IsDefined("TEST_SKINNING"));
+		std::string value;
+		REQUIRE(macros.GetMacroValue("TEST_NORMAL_MAP", value));
+		REQUIRE(value == "1");
+		REQUIRE(macros.GetMacroValue("TEST_LIGHT_COUNT", value));
+		REQUIRE(value == "4");
+		REQUIRE(macros.GetValueMacroString() == "TEST_LIGHT_COUNT 4\nTEST_UNDECLARED \n");
+
+		//a declared macro with a value is not a bit
+		macros.Define("TEST_SKINNING", "2");
+		REQUIRE(macros.GetVariantBits() == (ShaderVariantBits(1) << normalMapBit));
+		REQUIRE(macros.GetMacroValue("TEST_SKINNING", value));
+		REQUIRE(value == "2");
+		macros.Undefine("TEST_SKINNING");
+		macros.Undefine("TEST_NORMAL_MAP");
+		REQUIRE(!macros.IsDefined("TEST_SKINNING"));
+		REQUIRE(macros.GetVariantBits() == 0);
+		REQUIRE(macros.GetMacroCount() == 2);
+
+		//definition order doesn't change equality,hash and macro string
+		ShaderMacros first, second;
+		const char* names[] = { "TEST_A", "TEST_B", "TEST_C", "TEST_D", "TEST_E", "TEST_F" };
+		for (auto i = 0;i < 6;++i)
+		{
+			first.Define(names[i], std::to_string(i));
+			second.Define(names[5 - i], std::to_string(5 - i));
+		}
+		first.Define("TEST_SKINNING", "");
+		second.Define("TEST_SKINNING", "");
+		REQUIRE(first == second);
+		REQUIRE(first.GetHash() == second.GetHash());
+		REQUIRE(first.GetMacroString() == second.GetMacroString());
+		second.Define("TEST_NORMAL_MAP", "");
+		REQUIRE(!(first == second));
+		REQUIRE(first.GetHash() != second.GetHash());
+
+		//macro strings are sorted by name whatever bits the macros own
+		vocabulary->Declare("TEST_Z_FLAG");
+		vocabulary->Declare("TEST_A_FLAG");
+		ShaderMacros flags;
+		flags.Define("TEST_Z_FLAG", "");
+		flags.Define("TEST_LIGHT_COUNT", "4");
+		flags.Define("TEST_A_FLAG", "");
+		REQUIRE(flags.GetMacroString() == "TEST_A_FLAG 1\nTEST_LIGHT_COUNT 4\nTEST_Z_FLAG 1\n");
+	}
+
+	TEST_CASE("Shader bytecode cache test", "[Shader cache test]")
+	{
+		const std::string directory = "ShaderCacheTest";
+		boost::filesystem::remove_all(directory);
+		std::string errors;
+		{
+			StubShaderCompiler compiler;
+			ShaderBytecodeCache cache;
+			cache.SetDirectory(directory);
+			auto input = MakeInput("float4 main() : SV_POSITION { return 0; }", "NORMAL_MAP 1\nSKINNING 1\n");
+			auto byteCode = cache.GetOrCompile(input, compiler, errors);
+			REQUIRE(byteCode);
+			REQUIRE(byteCode->size() == input.source.size() + input.macros.size());
+			REQUIRE(cache.GetOrCompile(input, compiler, errors) == byteCode);
+			REQUIRE(compiler.GetCompileCount() == 1);
+			REQUIRE(boost::filesystem::exists(boost::filesystem::path(directory) 
+				/ ShaderBytecodeCache::GetFileName(ShaderBytecodeCache::ComputeKey(input, compiler.GetVersion()))));
+
+			//every part of the input is part of the key
+			auto variant = input;
+			variant.macros = "SKINNING 1\n";
+			REQUIRE(*cache.GetOrCompile(variant, compiler, errors) != *byteCode);
+			variant = input;
+			variant.includes.emplace_back("Lighting.hlsl", "float3 Shade();");
+			cache.GetOrCompile(variant, compiler, errors);
+			variant.includes.back().second = "float3 Shade(float3 n);";
+			cache.GetOrCompile(variant, compiler, errors);
+			variant = input;
+			variant.macros = "LIGHT_COUNT 4\nNORMAL_MAP 1\nSKINNING 1\n";
+			cache.GetOrCompile(variant, compiler, errors);
+			variant = input;
+			variant.target = "ps_5_1";
+			cache.GetOrCompile(variant, compiler, errors);
+			variant = input;
+			variant.flags = 1;
+			cache.GetOrCompile(variant, compiler, errors);
+			REQUIRE(compiler.GetCompileCount() == 7);
+			//a source and an include can't be mixed up
+			auto left = MakeInput("ab", "");
+			left.includes.emplace_back("c", "d");
+			auto right = MakeInput("a", "");
+			right.includes.emplace_back("bc", "d");
+			REQUIRE(!(ShaderBytecodeCache::ComputeKey(left, 1) == ShaderBytecodeCache::ComputeKey(right, 1)));
+
+			//failures are not cached
+			auto broken = MakeInput("syntax error", "");
+			REQUIRE(!cache.GetOrCompile(broken, compiler, errors));
+			REQUIRE(errors == "test.vs : syntax error");
+			REQUIRE(!cache.GetOrCompile(broken, compiler, errors));
+			auto stats = cache.GetStats();
+			REQUIRE(stats.compiles == 7);
+			REQUIRE(stats.memoryHits == 1);
+			REQUIRE(stats.diskHits == 0);
+			REQUIRE(stats.failures == 2);
+		}
+		{
+			//a new run loads bytecode from disk
+			StubShaderCompiler compiler;
+			ShaderBytecodeCache cache;
+			cache.SetDirectory(directory);
+			auto input = MakeInput("float4 main() : SV_POSITION { return 0; }", "NORMAL_MAP 1\nSKINNING 1\n");
+			auto byteCode = cache.GetOrCompile(input, compiler, errors);
+			REQUIRE(byteCode);
+			REQUIRE(compiler.GetCompileCount() == 0);
+			REQUIRE(std::string(byteCode->begin(), byteCode->begin() + input.source.size()) == input.source);
+			REQUIRE(cache.GetStats().diskHits == 1);
+			//bytecode of another compiler version is not used
+			StubShaderCompiler newCompiler(2);
+			cache.GetOrCompile(input, newCompiler, errors);
+			REQUIRE(newCompiler.GetCompileCount() == 1);
+			//a corrupted file is compiled again
+			cache.ClearMemory();
+			auto path = boost::filesystem::path(directory) / ShaderBytecodeCache::GetFileName(ShaderBytecodeCache::ComputeKey(input, 1));
+			boost::filesystem::resize_file(path, 10);
+			REQUIRE(cache.GetOrCompile(input, compiler, errors));
+			REQUIRE(compiler.GetCompileCount() == 1);
+		}
+		{
+			//an empty directory keeps bytecode in memory
+			StubShaderCompiler compiler;
+			ShaderBytecodeCache cache;
+			auto input = MakeInput("memory only", "");
+			REQUIRE(cache.GetOrCompile(input, compiler, errors));
+			REQUIRE(!boost::filesystem::exists(boost::filesystem::path(directory) 
+				/ ShaderBytecodeCache::GetFileName(ShaderBytecodeCache::ComputeKey(input, compiler.GetVersion()))));
+		}
+		boost::filesystem::remove_all(directory);
+	}
+
+	TEST_CASE("Shader bytecode cache performance test", "[Shader cache performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t VariantCount = 256;
+		const std::string directory = "ShaderCachePerformanceTest";
+		boost::filesystem::remove_all(directory);
+		std::string source(16 * 1024, ' ');
+		source += "float4 main() : SV_POSITION { return 0; }";
+		std::string errors;
+		double compileTime{ 0.0 };
+		{
+			//a cold start compiles every variant
+			StubShaderCompiler compiler(1, std::chrono::microseconds(2000));
+			ShaderBytecodeCache cache;
+			cache.SetDirectory(directory);
+			auto compile_start = std::chrono::high_resolution_clock::now();
+			for (std::size_t i = 0;i < VariantCount;++i)
+			{
+				REQUIRE(cache.GetOrCompile(MakeInput(source, "VARIANT " + std::to_string(i) + "\n"), compiler, errors));
+			}
+			auto compile_end = std::chrono::high_resolution_clock::now();
+			compileTime = duration_cast<duration<double>>(compile_end - compile_start).count();
+			REQUIRE(compiler.GetCompileCount() == VariantCount);
+		}
+		//a warm start loads them from disk
+		StubShaderCompiler compiler(1, std::chrono::microseconds(2000));
+		ShaderBytecodeCache cache;
+		cache.SetDirectory(directory);
+		auto load_start = std::chrono::high_resolution_clock::now();
+		for (std::size_t i = 0;i < VariantCount;++i)
+		{
+			REQUIRE(cache.GetOrCompile(MakeInput(source, "VARIANT " + std::to_string(i) + "\n"), compiler, errors));
+		}
+		auto load_end = std::chrono::high_resolution_clock::now();
+		auto loadTime = duration_cast<duration<double>>(load_end - load_start).count();
+		REQUIRE(compiler.GetCompileCount() == 0);
+		std::cout << "[shader variant compile time(256 variants, 2ms each):] " << compileTime << std::endl;
+		std::cout << "[shader variant disk cache load time(256 variants):] " << loadTime << std::endl;
+		REQUIRE(loadTime < compileTime);
+		boost::filesystem::remove_all(directory);
+	}
+}
@@ -0,0 +1,782 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include "catch.hpp"
+#include "tbb/combinable.h"
+#include "tbb/parallel_for.h"
+#include "SpaceObject.h"
+#include "RenderableSpaceObject.h"
+
+namespace Lightning
+{
+	namespace Plugins
+	{
+		struct IRenderPlugin;
+	}
+	namespace World
+	{
+		//space objects are tested without a renderer
+		Plugins::IRenderPlugin* gRenderPlugin{ nullptr };
+	}
+}
+
+namespace
+{
+	using Lightning::World::ISpaceObject;
+	using Lightning::World::IRenderable;
+	using Lightning::World::RenderableSpaceObject;
+	using Lightning::World::RenderableRegistry;
+	using Lightning::World::SpaceObject;
+	using Lightning::World::SpaceObjectManager;
+	using Lightning::World::SpaceObjectTraversalPolocy;
+	using Lightning::World::SpatialHandle;
+	using Lightning::World::INVALID_SPATIAL_HANDLE;
+	using Lightning::Foundation::Math::Transform;
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::Vector3d;
+	using Lightning::Foundation::Math::Vector4f;
+	using Lightning::Foundation::Math::Quaternionf;
+	using Lightning::Foundation::Math::AABBf;
+
+	struct ITestObject : virtual ISpaceObject
+	{
+	};
+
+	class TestObject : public SpaceObject<ITestObject, TestObject>
+	{
+	};
+
+	//Scene roots are told apart by their registries
+	class TestScene : public SpaceObject<ITestObject, TestScene>
+	{
+	public:
+		TestScene() : mRegistry(std::make_shared<RenderableRegistry>()){}
+		std::shared_ptr<RenderableRegistry> GetRenderableRegistry()const override { return mRegistry; }
+	private:
+		std::shared_ptr<RenderableRegistry> mRegistry;
+	};
+
+	struct ITestRenderable : IRenderable, virtual ISpaceObject
+	{
+	};
+
+	class TestRenderable : public RenderableSpaceObject<ITestRenderable, TestRenderable>
+	{
+	public:
+		Lightning::Render::PrimitiveType GetPrimitiveType()const override { return Lightning::Render::PrimitiveType::TRIANGLE_LIST; }
+	protected:
+		void UpdateRenderResources()override{}
+	};
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	Transform RandomTransform()
+	{
+		return Transform(Vector3f{ RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10) }, 
+			Vector3f{ 1.0f, 1.0f, 1.0f }, Transform::RandomRotation());
+	}
+
+	//Global transform computed from scratch the way it was before caching
+	Transform ComputeGlobalTransform(const std::vector<Transform>& locals, const std::vector<int>& parents, int index)
+	{
+		if (parents[index] < 0)
+			return locals[index];
+		auto matrix = locals[index].LocalToGlobalMatrix4() * ComputeGlobalTransform(locals, parents, parents[index]).LocalToGlobalMatrix4();
+		auto globalPosition = Vector3f{ matrix.GetCell(3, 0), matrix.GetCell(3, 1), matrix.GetCell(3, 2) };
+		auto globalForward = Vector3f{ matrix.GetCell(2, 0), matrix.GetCell(2, 1), matrix.GetCell(2, 2) };
+		auto globalUp = Vector3f{ matrix.GetCell(1, 0), matrix.GetCell(1, 1), matrix.GetCell(1, 2) };
+		auto globalRight = Vector3f{ matrix.GetCell(0, 0), matrix.GetCell(0, 1), matrix.GetCell(0, 2) };
+		Transform globalTransform;
+		globalTransform.SetScale(Vector3f{ globalRight.Length(), globalUp.Length(), globalForward.Length() });
+		globalTransform.OrientTo(globalForward, globalUp);
+		globalTransform.SetPosition(globalPosition);
+		return globalTransform;
+	}
+
+	//Local transforms have unit scale,so the product of local matrices is exactly the global matrix
+	Matrix4f ComputeGlobalMatrix(const std::vector<Transform>& locals, const std::vector<int>& parents, int index)
+	{
+		if (parents[index] < 0)
+			return locals[index].LocalToGlobalMatrix4();
+		return locals[index].LocalToGlobalMatrix4() * ComputeGlobalMatrix(locals, parents, parents[index]);
+	}
+
+	struct TestHierarchy
+	{
+		std::vector<std::shared_ptr<TestObject>> objects;
+		std::vector<Transform> locals;
+		std::vector<int> parents;
+	};
+
+	//Every level has about the same number of objects,each object has a random parent in the level above
+	TestHierarchy MakeHierarchy(std::size_t objectCount, std::size_t levelCount)
+	{
+		TestHierarchy hierarchy;
+		hierarchy.objects.push_back(std::make_shared<TestObject>());
+		hierarchy.locals.push_back(Transform());
+		hierarchy.parents.push_back(-1);
+		auto levelSize = (objectCount - 1) / (levelCount - 1);
+		std::size_t levelBegin{ 0 }, levelEnd{ 1 };
+		for (std::size_t level = 1;level < levelCount;++level)
+		{
+			for (std::size_t i = 0;i < levelSize;++i)
+			{
+				auto parent = static_cast<int>(levelBegin + std::rand() % (levelEnd - levelBegin));
+				auto object = std::make_shared<TestObject>();
+				auto local = RandomTransform();
+				object->GetLocalTransform() = local;
+				hierarchy.objects[parent]->AddChild(object);
+				hierarchy.objects.push_back(object);
+				hierarchy.locals.push_back(local);
+				hierarchy.parents.push_back(parent);
+			}
+			levelBegin = levelEnd;
+			levelEnd = hierarchy.objects.size();
+		}
+		SpaceObjectManager::Instance()->Synchronize();
+		return hierarchy;
+	}
+
+	void CheckGlobalTransform(const TestHierarchy& hierarchy, int index)
+	{
+		auto expected = ComputeGlobalMatrix(hierarchy.locals, hierarchy.parents, index);
+		auto actual = hierarchy.objects[index]->GetGlobalTransform().GetMatrix();
+		for (auto row = 0;row < 4;++row)
+		{
+			for (auto column = 0;column < 4;++column)
+			{
+				REQUIRE(actual.GetCell(row, column) == Approx(expected.GetCell(row, column)).epsilon(1e-3));
+			}
+		}
+	}
+
+	TEST_CASE("Cached global transform test", "[Space object test]")
+	{
+		auto hierarchy = MakeHierarchy(1 + 4 * 50, 5);
+		hierarchy.objects[0]->UpdateGlobalTransforms();
+		for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+		{
+			CheckGlobalTransform(hierarchy, static_cast<int>(i));
+		}
+
+		//moving an object moves its descendants,with or without a per frame update
+		for (auto frame = 0;frame < 4;++frame)
+		{
+			for (auto i = 0;i < 10;++i)
+			{
+				auto index = std::rand() % hierarchy.objects.size();
+				hierarchy.locals[index] = RandomTransform();
+				hierarchy.objects[index]->GetLocalTransform() = hierarchy.locals[index];
+			}
+			if (frame % 2 == 0)
+				hierarchy.objects[0]->UpdateGlobalTransforms();
+			for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+			{
+				CheckGlobalTransform(hierarchy, static_cast<int>(i));
+			}
+		}
+
+		//global setters are relative to the cached parent transform
+		auto& object = hierarchy.objects.back();
+		object->SetGlobalPosition(Vector3f{ 1.0f, 2.0f, 3.0f });
+		auto position = object->GetGlobalTransform().GetPosition();
+		REQUIRE(position.x == Approx(1.0f).epsilon(1e-3));
+		REQUIRE(position.y == Approx(2.0f).epsilon(1e-3));
+		REQUIRE(position.z == Approx(3.0f).epsilon(1e-3));
+		hierarchy.locals.back() = object->GetLocalTransform();
+
+		//a moved subtree follows its new parent
+		auto child = hierarchy.objects[1 + 50];
+		auto oldParent = hierarchy.objects[hierarchy.parents[1 + 50]];
+		auto newParent = hierarchy.objects[2];
+		hierarchy.objects[0]->UpdateGlobalTransforms();
+		REQUIRE(oldParent->RemoveChild(child));
+		REQUIRE(newParent->AddChild(child));
+		SpaceObjectManager::Instance()->Synchronize();
+		hierarchy.parents[1 + 50] = 2;
+		hierarchy.objects[0]->UpdateGlobalTransforms();
+		for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+		{
+			CheckGlobalTransform(hierarchy, static_cast<int>(i));
+		}
+	}
+
+	TEST_CASE("Cached global transform performance test", "[Space object performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t ObjectCount = 100000;
+		constexpr std::size_t MovingObjectCount = ObjectCount / 20;
+		constexpr int FrameCount = 10;
+		auto hierarchy = MakeHierarchy(ObjectCount, 10);
+		hierarchy.objects[0]->UpdateGlobalTransforms();
+		std::vector<std::size_t> moving(MovingObjectCount);
+		for (auto& index : moving)
+		{
+			index = std::rand() % hierarchy.objects.size();
+		}
+		//each frame moves 5% of the objects and reads the global transform of every object like render proxies do
+		float checksum{ 0.0f };
+		auto frame_start = std::chrono::high_resolution_clock::now();
+		for (auto frame = 0;frame < FrameCount;++frame)
+		{
+			for (auto index : moving)
+			{
+				hierarchy.objects[index]->GetLocalTransform().SetPosition(Vector3f{ float(frame), 0.0f, 0.0f });
+			}
+			hierarchy.objects[0]->UpdateGlobalTransforms();
+			for (const auto& object : hierarchy.objects)
+			{
+				checksum += object->GetGlobalTransform().GetPosition().x;
+			}
+		}
+		auto frame_end = std::chrono::high_resolution_clock::now();
+
+		//the same reads computing every global transform recursively from the root
+		auto uncached_start = std::chrono::high_resolution_clock::now();
+		for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+		{
+			checksum += ComputeGlobalTransform(hierarchy.locals, hierarchy.parents, static_cast<int>(i)).GetPosition().x;
+		}
+		auto uncached_end = std::chrono::high_resolution_clock::now();
+		auto cachedTime = duration_cast<duration<double>>(frame_end - frame_start).count() / FrameCount;
+		auto uncachedTime = duration_cast<duration<double>>(uncached_end - uncached_start).count();
+		std::cout << "[cached global transform frame time(100k objects, 10 levels, 5% moving):] " << cachedTime << std::endl;
+		std::cout << "[uncached global transform frame time(100k objects, 10 levels):] " << uncachedTime << std::endl;
+		REQUIRE(std::isfinite(checksum));
+		REQUIRE(cachedTime < uncachedTime);
+	}
+
+	Quaternionf RandomRotation()
+	{
+		auto rotation = Transform::RandomRotation();
+		rotation.Normalize();
+		return rotation;
+	}
+
+	void RequireEqual(const Vector3f& v, const Vector3f& expected)
+	{
+		REQUIRE(v.x == Approx(expected.x).margin(1e-3));
+		REQUIRE(v.y == Approx(expected.y).margin(1e-3));
+		REQUIRE(v.z == Approx(expected.z).margin(1e-3));
+	}
+
+	TEST_CASE("Global transform setters test", "[Space object test]")
+	{
+		for (auto uniformScale : { true, false })
+		{
+			auto parent = std::make_shared<TestObject>();
+			auto child = std::make_shared<TestObject>();
+			auto parentScale = uniformScale ? Vector3f{ 2.0f, 2.0f, 2.0f } : Vector3f{ 0.5f, 2.0f, 3.0f };
+			parent->GetLocalTransform() = Transform(Vector3f{ 1.0f, -2.0f, 3.0f }, parentScale, RandomRotation());
+			child->GetLocalTransform() = Transform(Vector3f{ 4.0f, 0.0f, -1.0f }, Vector3f{ 1.5f, 0.5f, 1.0f }, RandomRotation());
+			REQUIRE(parent->AddChild(child));
+			SpaceObjectManager::Instance()->Synchronize();
+			for (auto i = 0;i < 20;++i)
+			{
+				auto rotation = RandomRotation();
+				child->SetGlobalRotation(rotation);
+				auto global = child->GetGlobalTransform();
+				RequireEqual(global.Forward(), rotation * Vector3f::forward());
+				if (uniformScale)
+				{
+					RequireEqual(global.Up(), rotation * Vector3f::up());
+				}
+				else
+				{
+					//with shear up stays in the plane of desired up and forward
+					REQUIRE(global.Right().Dot(rotation * Vector3f::up()) == Approx(0.0f).margin(1e-3));
+				}
+
+				Vector3f scale{ RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f) };
+				child->SetGlobalScale(scale);
+				RequireEqual(child->GetGlobalTransform().GetScale(), scale);
+
+				Vector3f position{ RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10) };
+				child->SetGlobalPosition(position);
+				RequireEqual(child->GetGlobalTransform().GetPosition(), position);
+
+				Transform transform(position, scale, rotation);
+				child->SetGlobalTransform(transform);
+				global = child->GetGlobalTransform();
+				RequireEqual(global.GetPosition(), position);
+				RequireEqual(global.GetScale(), scale);
+				RequireEqual(global.Forward(), rotation * Vector3f::forward());
+			}
+		}
+	}
+
+	TEST_CASE("Precise position test", "[Space object test]")
+	{
+		//far enough from the origin that float spacing is larger than the offsets below
+		const Vector3d rootPosition{ 1e9 + 0.125, -3e8 + 0.5, 7.25e8 + 0.75 };
+		auto root = std::make_shared<TestObject>();
+		auto child = std::make_shared<TestObject>();
+		auto grandChild = std::make_shared<TestObject>();
+		root->SetPrecisePosition(rootPosition);
+		child->GetLocalTransform().SetPosition(Vector3f{ 1.5f, -2.0f, 0.25f });
+		grandChild->SetPrecisePosition(Vector3d{ 0.5, 0.0, -0.125 });
+		REQUIRE(root->AddChild(child));
+		REQUIRE(child->AddChild(grandChild));
+		SpaceObjectManager::Instance()->Synchronize();
+
+		auto rootGlobal = root->GetPreciseGlobalPosition();
+		REQUIRE(rootGlobal.x == rootPosition.x);
+		REQUIRE(rootGlobal.y == rootPosition.y);
+		REQUIRE(rootGlobal.z == rootPosition.z);
+		REQUIRE(root->GetGlobalTransform().GetPosition().x == float(rootPosition.x));
+		//offsets are exact in double while they are lost in the float global transform
+		auto grandChildGlobal = grandChild->GetPreciseGlobalPosition();
+		REQUIRE(grandChildGlobal.x == rootPosition.x + 2.0);
+		REQUIRE(grandChildGlobal.y == rootPosition.y - 2.0);
+		REQUIRE(grandChildGlobal.z == rootPosition.z + 0.125);
+		REQUIRE(grandChild->GetGlobalTransform().GetPosition().z == float(rootPosition.z + 0.125));
+
+		//rotated and scaled parent
+		auto rotation = RandomRotation();
+		child->GetLocalTransform() = Transform(Vector3f{ 1.5f, -2.0f, 0.25f }, Vector3f{ 2.0f, 0.5f, 3.0f }, rotation);
+		auto childMatrix = child->GetGlobalTransform().GetAffineMatrix();
+		auto offset = childMatrix.TransformDirection(Vector3f{ 0.5f, 0.0f, -0.125f });
+		grandChildGlobal = grandChild->GetPreciseGlobalPosition();
+		REQUIRE(grandChildGlobal.x == Approx(rootPosition.x + 1.5 + offset.x).epsilon(0).margin(1e-4));
+		REQUIRE(grandChildGlobal.y == Approx(rootPosition.y - 2.0 + offset.y).epsilon(0).margin(1e-4));
+		REQUIRE(grandChildGlobal.z == Approx(rootPosition.z + 0.25 + offset.z).epsilon(0).margin(1e-4));
+
+		//moving through float setters drops the precise position
+		root->GetLocalTransform().SetPosition(Vector3f{ 10.0f, 20.0f, 30.0f });
+		rootGlobal = root->GetPreciseGlobalPosition();
+		REQUIRE(rootGlobal.x == 10.0);
+		REQUIRE(rootGlobal.y == 20.0);
+		REQUIRE(rootGlobal.z == 30.0);
+		RequireEqual(child->GetGlobalTransform().GetPosition(), Vector3f{ 11.5f, 18.0f, 30.25f });
+	}
+
+	//Setters the way they were written before,orienting through global to local matrices
+	void ReferenceSetGlobalRotation(Transform& local, const Quaternionf& rotation, const Transform& parentGlobalTransform)
+	{
+		auto globalForward = rotation * Vector3f::forward();
+		auto globalUp = rotation * Vector3f::up();
+		auto localForward = Vector4f{ globalForward.x, globalForward.y, globalForward.z, 0.f } * parentGlobalTransform.GlobalToLocalMatrix4();
+		auto localUp = Vector4f{ globalUp.x, globalUp.y, globalUp.z, 0.f } * parentGlobalTransform.GlobalToLocalMatrix4();
+		local.OrientTo(Vector3f{ localForward.x, localForward.y, localForward.z }, Vector3f{ localUp.x, localUp.y, localUp.z });
+	}
+
+	void ReferenceSetGlobalScale(Transform& local, const Vector3f& scale, const Transform& parentGlobalTransform)
+	{
+		auto matrix = local.LocalToGlobalMatrix4() * parentGlobalTransform.LocalToGlobalMatrix4();
+		auto globalForward = Vector4f{ 0.f, 0.f, 1.f, 0.f } * matrix;
+		auto globalUp = Vector4f{ 0.f, 1.f, 0.f, 0.f } * matrix;
+		auto globalRight = Vector4f{ 1.f, 0.f, 0.f, 0.f } * matrix;
+		local.SetScale(Vector3f{ scale.x / globalRight.Length(), scale.y / globalUp.Length(), scale.z / globalForward.Length() });
+	}
+
+	TEST_CASE("Global transform setters performance test", "[Space object performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t ObjectCount = 100000;
+		auto parent = std::make_shared<TestObject>();
+		parent->GetLocalTransform() = Transform(Vector3f{ 1.0f, -2.0f, 3.0f }, Vector3f{ 2.0f, 2.0f, 2.0f }, RandomRotation());
+		std::vector<std::shared_ptr<TestObject>> objects(ObjectCount);
+		std::vector<Transform> locals(ObjectCount);
+		std::vector<Quaternionf> rotations(ObjectCount);
+		std::vector<Vector3f> scales(ObjectCount);
+		for (std::size_t i = 0;i < ObjectCount;++i)
+		{
+			objects[i] = std::make_shared<TestObject>();
+			locals[i] = RandomTransform();
+			objects[i]->GetLocalTransform() = locals[i];
+			parent->AddChild(objects[i]);
+			rotations[i] = RandomRotation();
+			scales[i] = Vector3f{ RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f) };
+		}
+		SpaceObjectManager::Instance()->Synchronize();
+		auto parentGlobalTransform = parent->GetGlobalTransform();
+		//best of a few runs,setting the same values again is as expensive as the first time
+		auto benchmark = [](const char* name, const std::function<void()>& function) {
+			double best{ 0.0 };
+			for (auto i = 0;i < 3;++i)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				function();
+				auto end = std::chrono::high_resolution_clock::now();
+				auto time = duration_cast<duration<double>>(end - start).count();
+				if (i == 0 || time < best)
+					best = time;
+			}
+			std::cout << "[" << name << "(100k objects):] " << best << std::endl;
+		};
+		//object setters include dirty marking and copying the parent global transform,references are the math only
+		benchmark("set global rotation", [&]() {
+			for (std::size_t i = 0;i < ObjectCount;++i)
+				objects[i]->SetGlobalRotation(rotations[i]);
+		});
+		benchmark("reference set global rotation", [&]() {
+			for (std::size_t i = 0;i < ObjectCount;++i)
+				ReferenceSetGlobalRotation(locals[i], rotations[i], parentGlobalTransform);
+		});
+		benchmark("set global scale", [&]() {
+			for (std::size_t i = 0;i < ObjectCount;++i)
+				objects[i]->SetGlobalScale(scales[i]);
+		});
+		benchmark("reference set global scale", [&]() {
+			for (std::size_t i = 0;i < ObjectCount;++i)
+				ReferenceSetGlobalScale(locals[i], scales[i], parentGlobalTransform);
+		});
+		benchmark("set global transform", [&]() {
+			for (std::size_t i = 0;i < ObjectCount;++i)
+				objects[i]->SetGlobalTransform(Transform(scales[i], scales[i], rotations[i]));
+		});
+		benchmark("update global transforms", [&]() {
+			//getting the local transform of parent marks all objects dirty
+			parent->GetLocalTransform();
+			parent->UpdateGlobalTransforms();
+		});
+		//parent is transform 0 of the reference hierarchy
+		std::vector<Transform> transforms(1, parentGlobalTransform);
+		transforms.insert(transforms.end(), locals.begin(), locals.end());
+		std::vector<int> parents(ObjectCount + 1, 0);
+		parents[0] = -1;
+		float checksum{ 0.0f };
+		benchmark("reference update global transforms", [&]() {
+			for (std::size_t i = 1;i <= ObjectCount;++i)
+				checksum += ComputeGlobalTransform(transforms, parents, static_cast<int>(i)).GetPosition().x;
+		});
+		REQUIRE(std::isfinite(checksum));
+		for (std::size_t i = 0;i < ObjectCount;i += ObjectCount / 10)
+		{
+			RequireEqual(objects[i]->GetGlobalTransform().GetPosition(), scales[i]);
+			RequireEqual(objects[i]->GetGlobalTransform().Forward(), rotations[i] * Vector3f::forward());
+		}
+	}
+
+	TEST_CASE("Space object traversal test", "[Space object test]")
+	{
+		auto hierarchy = MakeHierarchy(1 + 6 * 500, 7);
+		std::unordered_map<const ISpaceObject*, int> indices;
+		for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+		{
+			indices[hierarchy.objects[i].get()] = static_cast<int>(i);
+		}
+		//Returns the order objects are visited in
+		auto visitOrder = [&hierarchy, &indices](SpaceObjectTraversalPolocy policy, bool useFunction) {
+			std::vector<std::atomic<int>> order(hierarchy.objects.size());
+			for (auto& position : order)
+				position = -1;
+			std::atomic<int> visitCount{ 0 };
+			std::atomic<int> revisitCount{ 0 };
+			//objects may be visited by worker threads,which must not use REQUIRE
+			auto visit = [&order, &indices, &visitCount, &revisitCount](const ISpaceObject& object) {
+				if (order[indices.at(&object)].exchange(visitCount++) != -1)
+					++revisitCount;
+			};
+			if (useFunction)
+				hierarchy.objects[0]->Traverse([&visit](const std::shared_ptr<ISpaceObject>& object) { visit(*object); }, policy);
+			else
+				hierarchy.objects[0]->Visit(visit, policy);
+			REQUIRE(revisitCount == 0);
+			std::vector<int> result(order.begin(), order.end());
+			return result;
+		};
+		//objects of level l are [1 + (l - 1) * 500, 1 + l * 500)
+		auto level = [](std::size_t index) { return index == 0 ? 0 : 1 + (index - 1) / 500; };
+		for (auto useFunction : { false, true })
+		{
+			auto sequential = visitOrder(SpaceObjectTraversalPolocy::Sequential, useFunction);
+			auto breadthFirst = visitOrder(SpaceObjectTraversalPolocy::BreadthFirst, useFunction);
+			auto concurrent = visitOrder(SpaceObjectTraversalPolocy::Concurrent, useFunction);
+			for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+			{
+				REQUIRE(sequential[i] >= 0);
+				REQUIRE(breadthFirst[i] >= 0);
+				REQUIRE(concurrent[i] >= 0);
+				if (i == 0)
+					continue;
+				auto parent = hierarchy.parents[i];
+				REQUIRE(sequential[parent] < sequential[i]);
+				REQUIRE(breadthFirst[parent] < breadthFirst[i]);
+				REQUIRE(concurrent[parent] < concurrent[i]);
+			}
+			//depth first visits every subtree contiguously
+			std::vector<int> subtreeSizes(hierarchy.objects.size(), 1);
+			std::vector<int> lastVisited(sequential);
+			for (auto i = hierarchy.objects.size() - 1;i > 0;--i)
+			{
+				auto parent = hierarchy.parents[i];
+				subtreeSizes[parent] += subtreeSizes[i];
+				lastVisited[parent] = std::max(lastVisited[parent], lastVisited[i]);
+			}
+			for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+			{
+				REQUIRE(lastVisited[i] - sequential[i] + 1 == subtreeSizes[i]);
+			}
+			//breadth first visits all objects of a level before the next level
+			std::vector<int> levelFirst(7, static_cast<int>(hierarchy.objects.size())), levelLast(7, -1);
+			for (std::size_t i = 0;i < hierarchy.objects.size();++i)
+			{
+				levelFirst[level(i)] = std::min(levelFirst[level(i)], breadthFirst[i]);
+				levelLast[level(i)] = std::max(levelLast[level(i)], breadthFirst[i]);
+			}
+			for (std::size_t i = 1;i < levelFirst.size();++i)
+			{
+				REQUIRE(levelLast[i - 1] < levelFirst[i]);
+			}
+		}
+	}
+
+	TEST_CASE("Space object traversal performance test", "[Space object performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t ObjectCount = 200000;
+		constexpr int RunCount = 5;
+		struct TreeShape
+		{
+			const char* name;
+			std::size_t levelCount;
+		};
+		//all objects are children of the root in the wide tree,the deep tree has 1000 levels of 200 objects
+		for (const auto& shape : { TreeShape{ "wide", 2 }, TreeShape{ "deep", 1000 } })
+		{
+			auto hierarchy = MakeHierarchy(ObjectCount, shape.levelCount);
+			auto& root = hierarchy.objects[0];
+			std::uint64_t expected{ 0 };
+			for (const auto& object : hierarchy.objects)
+			{
+				expected += object->GetID();
+			}
+			auto measure = [&shape, expected](const char* label, const std::function<std::uint64_t()>& traverse) {
+				auto start = std::chrono::high_resolution_clock::now();
+				for (auto run = 0;run < RunCount;++run)
+				{
+					REQUIRE(traverse() == expected);
+				}
+				auto end = std::chrono::high_resolution_clock::now();
+				std::cout << "[" << label << " traversal time(200k objects, " << shape.name << "):] "
+					<< duration_cast<duration<double>>(end - start).count() / RunCount << std::endl;
+			};
+			measure("std::function sequential", [&root]() {
+				std::uint64_t sum{ 0 };
+				root->Traverse([&sum](const std::shared_ptr<ISpaceObject>& object) { sum += object->GetID(); }, SpaceObjectTraversalPolocy::Sequential);
+				return sum;
+			});
+			measure("std::function concurrent", [&root]() {
+				tbb::combinable<std::uint64_t> sums([]() { return std::uint64_t(0); });
+				root->Traverse([&sums](const std::shared_ptr<ISpaceObject>& object) { sums.local() += object->GetID(); }, SpaceObjectTraversalPolocy::Concurrent);
+				return sums.combine([](std::uint64_t a, std::uint64_t b) { return a + b; });
+			});
+			for (auto policy : { SpaceObjectTraversalPolocy::Sequential, SpaceObjectTraversalPolocy::BreadthFirst })
+			{
+				measure(policy == SpaceObjectTraversalPolocy::Sequential ? "visitor sequential" : "visitor breadth first", [&root, policy]() {
+					std::uint64_t sum{ 0 };
+					root->Visit([&sum](ISpaceObject& object) { sum += object.GetID(); }, policy);
+					return sum;
+				});
+			}
+			measure("visitor concurrent", [&root]() {
+				tbb::combinable<std::uint64_t> sums([]() { return std::uint64_t(0); });
+				root->Visit([&sums](ISpaceObject& object) { sums.local() += object.GetID(); }, SpaceObjectTraversalPolocy::Concurrent);
+				return sums.combine([](std::uint64_t a, std::uint64_t b) { return a + b; });
+			});
+		}
+	}
+
+	TEST_CASE("Batched children operations test", "[Space object test]")
+	{
+		constexpr std::size_t ParentCount = 16;
+		constexpr std::size_t ChildCount = 4000;
+		std::vector<std::shared_ptr<TestObject>> parents(ParentCount), children(ChildCount);
+		for (auto& parent : parents)
+			parent = std::make_shared<TestObject>();
+		for (auto& child : children)
+			child = std::make_shared<TestObject>();
+		auto checkChildren = [&parents, &children](const std::vector<int>& expectedParents) {
+			std::vector<std::size_t> childrenCounts(ParentCount, 0);
+			for (std::size_t i = 0;i < ChildCount;++i)
+			{
+				if (expectedParents[i] < 0)
+				{
+					REQUIRE(children[i]->GetParent() == nullptr);
+					continue;
+				}
+				REQUIRE(children[i]->GetParent() == parents[expectedParents[i]]);
+				++childrenCounts[expectedParents[i]];
+			}
+			for (std::size_t i = 0;i < ParentCount;++i)
+			{
+				REQUIRE(parents[i]->GetChildrenCount() == childrenCounts[i]);
+				//children are listed once
+				std::vector<const ISpaceObject*> listed;
+				parents[i]->Visit([&listed](ISpaceObject& object) { listed.push_back(&object); }, SpaceObjectTraversalPolocy::Sequential);
+				std::sort(listed.begin(), listed.end());
+				REQUIRE(std::unique(listed.begin(), listed.end()) == listed.end());
+			}
+		};
+
+		//children are added by several threads
+		std::vector<int> expectedParents(ChildCount);
+		tbb::parallel_for(std::size_t(0), ChildCount, [&parents, &children](std::size_t i) {
+			parents[i % ParentCount]->AddChild(children[i]);
+		});
+		for (std::size_t i = 0;i < ChildCount;++i)
+			expectedParents[i] = static_cast<int>(i % ParentCount);
+		SpaceObjectManager::Instance()->Synchronize();
+		checkChildren(expectedParents);
+
+		//removal,reparenting,removal followed by addition and addition followed by removal in one batch
+		for (std::size_t i = 0;i < ChildCount;++i)
+		{
+			auto& parent = parents[expectedParents[i]];
+			switch (i % 5)
+			{
+			case 0:
+				REQUIRE(parent->RemoveChild(children[i]));
+				expectedParents[i] = -1;
+				break;
+			case 1:
+				REQUIRE(parent->RemoveChild(children[i]));
+				expectedParents[i] = (expectedParents[i] + 1) % ParentCount;
+				REQUIRE(parents[expectedParents[i]]->AddChild(children[i]));
+				break;
+			case 2:
+				REQUIRE(parent->RemoveChild(children[i]));
+				REQUIRE(parent->AddChild(children[i]));
+				break;
+			case 3:
+			{
+				auto temporary = std::make_shared<TestObject>();
+				REQUIRE(parent->AddChild(temporary));
+				REQUIRE(parent->RemoveChild(temporary));
+				break;
+			}
+			default:
+				break;
+			}
+		}
+		SpaceObjectManager::Instance()->Synchronize();
+		checkChildren(expectedParents);
+
+		for (std::size_t i = 0;i < ChildCount;++i)
+		{
+			if (expectedParents[i] >= 0)
+				REQUIRE(parents[expectedParents[i]]->RemoveChild(children[i]));
+			expectedParents[i] = -1;
+		}
+		SpaceObjectManager::Instance()->Synchronize();
+		checkChildren(expectedParents);
+	}
+
+	//Without a renderer no render proxies are created,but renderables still join and leave registries the same way
+	TEST_CASE("Renderable registry test", "[Space object test]")
+	{
+		auto scene = std::make_shared<TestScene>();
+		auto otherScene = std::make_shared<TestScene>();
+		auto group = std::make_shared<TestObject>();
+		auto renderable = std::make_shared<TestRenderable>();
+		auto child = std::make_shared<TestRenderable>();
+		//registered renderables are indexed by the spatial index of the registry
+		auto requireRegistry = [&renderable, &child](const std::shared_ptr<RenderableRegistry>& registry) {
+			for (const auto& object : { renderable, child })
+			{
+				REQUIRE(object->GetRegistry() == registry);
+				auto handle = object->GetSpatialHandle();
+				REQUIRE((handle != INVALID_SPATIAL_HANDLE) == bool(registry));
+				if (registry)
+					REQUIRE(registry->GetIndexedRenderable(handle) == object);
+			}
+		};
+		REQUIRE(renderable->AddChild(child));
+		REQUIRE(group->AddChild(renderable));
+		SpaceObjectManager::Instance()->Synchronize();
+		//a subtree outside of scenes is not registered
+		requireRegistry(nullptr);
+
+		REQUIRE(scene->AddChild(group));
+		SpaceObjectManager::Instance()->Synchronize();
+		requireRegistry(scene->GetRenderableRegistry());
+
+		//bounds follow the renderable in the index of its scene
+		renderable->SetGlobalPosition(Vector3f{ 100.0f, 0.0f, 0.0f });
+		SpaceObjectManager::Instance()->Synchronize();
+		std::vector<SpatialHandle> handles;
+		scene->GetRenderableRegistry()->GetSpatialIndex().QueryBox(AABBf{ Vector3f{ 99.0f, -1.0f, -1.0f }, Vector3f{ 101.0f, 1.0f, 1.0f } }, handles);
+		std::sort(handles.begin(), handles.end());
+		std::vector<SpatialHandle> expectedHandles{ renderable->GetSpatialHandle(), child->GetSpatialHandle() };
+		std::sort(expectedHandles.begin(), expectedHandles.end());
+		REQUIRE(handles == expectedHandles);
+		REQUIRE(otherScene->GetRenderableRegistry()->GetSpatialIndex().GetCount() == 0);
+
+		//moved to another scene in one batch
+		REQUIRE(scene->RemoveChild(group));
+		REQUIRE(otherScene->AddChild(group));
+		SpaceObjectManager::Instance()->Synchronize();
+		requireRegistry(otherScene->GetRenderableRegistry());
+
+		//detached from the scene
+		REQUIRE(group->RemoveChild(renderable));
+		SpaceObjectManager::Instance()->Synchronize();
+		requireRegistry(nullptr);
+		REQUIRE(otherScene->GetRenderableRegistry()->GetSpatialIndex().GetCount() == 0);
+
+		//objects of a destroyed scene are no longer registered and may join another scene
+		REQUIRE(group->AddChild(renderable));
+		SpaceObjectManager::Instance()->Synchronize();
+		requireRegistry(otherScene->GetRenderableRegistry());
+		std::weak_ptr<RenderableRegistry> destroyedRegistry = otherScene->GetRenderableRegistry();
+		otherScene.reset();
+		REQUIRE(destroyedRegistry.expired());
+		requireRegistry(nullptr);
+		REQUIRE(scene->AddChild(group));
+		SpaceObjectManager::Instance()->Synchronize();
+		requireRegistry(scene->GetRenderableRegistry());
+	}
+
+	TEST_CASE("Bulk spawn and despawn performance test", "[Space object performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t ObjectCount = 50000;
+		//objects spread over many parents are applied in parallel,objects of a single parent are appended in one go
+		for (std::size_t parentCount : { std::size_t(500), std::size_t(1) })
+		{
+			std::vector<std::shared_ptr<TestObject>> parents(parentCount), objects(ObjectCount);
+			for (auto& parent : parents)
+				parent = std::make_shared<TestObject>();
+			for (auto& object : objects)
+				object = std::make_shared<TestObject>();
+
+			auto spawn_start = std::chrono::high_resolution_clock::now();
+			tbb::parallel_for(std::size_t(0), ObjectCount, [&parents, &objects, parentCount](std::size_t i) {
+				parents[i % parentCount]->AddChild(objects[i]);
+			});
+			SpaceObjectManager::Instance()->Synchronize();
+			auto spawn_end = std::chrono::high_resolution_clock::now();
+
+			auto despawn_start = std::chrono::high_resolution_clock::now();
+			tbb::parallel_for(std::size_t(0), ObjectCount, [&parents, &objects, parentCount](std::size_t i) {
+				parents[i % parentCount]->RemoveChild(objects[i]);
+			});
+			SpaceObjectManager::Instance()->Synchronize();
+			auto despawn_end = std::chrono::high_resolution_clock::now();
+			for (const auto& parent : parents)
+			{
+				REQUIRE(parent->GetChildrenCount() == 0);
+			}
+			auto spawnTime = duration_cast<duration<double>>(spawn_end - spawn_start).count();
+			auto despawnTime = duration_cast<duration<double>>(despawn_end - despawn_start).count();
+			std::cout << "[bulk spawn objects per second(50k objects, " << parentCount << " parents):] " << ObjectCount / spawnTime << std::endl;
+			std::cout << "[bulk despawn objects per second(50k objects, " << parentCount << " parents):] " << ObjectCount / despawnTime << std::endl;
+		}
+	}
+}
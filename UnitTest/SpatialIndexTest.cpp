@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "SpatialIndex.h"
+
+namespace
+{
+	using Lightning::World::SpatialIndex;
+	using Lightning::World::SpatialHandle;
+	using Lightning::World::SpatialSphere;
+	using Lightning::World::SpatialRay;
+	using Lightning::World::SpatialRayHit;
+	using Lightning::World::INVALID_SPATIAL_HANDLE;
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::AABBf;
+	using Lightning::Foundation::Math::Frustum;
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	Vector3f RandomPoint(float extent)
+	{
+		return Vector3f{ RandomFloat(-extent, extent), RandomFloat(-extent, extent), RandomFloat(-extent, extent) };
+	}
+
+	AABBf MakeBox(const Vector3f& center, float halfSize)
+	{
+		return AABBf{ Vector3f{center.x - halfSize, center.y - halfSize, center.z - halfSize},
+			Vector3f{center.x + halfSize, center.y + halfSize, center.z + halfSize} };
+	}
+
+	AABBf RandomBox(float extent)
+	{
+		return MakeBox(RandomPoint(extent), RandomFloat(0.1f, 5.0f));
+	}
+
+	Matrix4f MakePerspective(float fov, float aspectRatio, float nearPlane, float farPlane)
+	{
+		Matrix4f projection;
+		projection.SetIdentity();
+		auto f = 1.0f / std::tan(fov * 0.5f);
+		auto d = farPlane - nearPlane;
+		projection.SetCell(0, 0, f / aspectRatio);
+		projection.SetCell(1, 1, f);
+		projection.SetCell(2, 2, farPlane / d);
+		projection.SetCell(3, 3, 0.0f);
+		projection.SetCell(2, 3, 1.0f);
+		projection.SetCell(3, 2, -nearPlane * farPlane / d);
+		return projection;
+	}
+
+	//Camera at position looking along z axis rotated by angle around y axis
+	Frustum MakeFrustum(float angle, const Vector3f& position, float farPlane)
+	{
+		Matrix4f view;
+		view.SetIdentity();
+		auto c = std::cos(angle);
+		auto s = std::sin(angle);
+		view.SetCell(0, 0, c);
+		view.SetCell(0, 2, -s);
+		view.SetCell(2, 0, s);
+		view.SetCell(2, 2, c);
+		view.SetCell(3, 0, -(position.x * c + position.z * s));
+		view.SetCell(3, 1, -position.y);
+		view.SetCell(3, 2, position.x * s - position.z * c);
+		return Frustum::FromMatrix(view * MakePerspective(1.0472f, 1.6f, 0.1f, farPlane));
+	}
+
+	SpatialRay RandomRay(float extent)
+	{
+		auto target = RandomPoint(extent * 0.5f);
+		auto origin = RandomPoint(extent);
+		auto direction = Vector3f{ target.x - origin.x, target.y - origin.y, target.z - origin.z };
+		return SpatialRay{ origin, direction * (1.0f / direction.Length()), extent * 4.0f };
+	}
+
+	//Distance at which ray enters box,negative if it misses
+	float IntersectRay(const AABBf& box, const SpatialRay& ray)
+	{
+		const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+		const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+		const float min[3] = { box.min.x, box.min.y, box.min.z };
+		const float max[3] = { box.max.x, box.max.y, box.max.z };
+		auto enter = 0.0f;
+		auto exit = ray.maxDistance;
+		for (auto i = 0;i < 3;++i)
+		{
+			if (direction[i] == 0.0f)
+			{
+				if (origin[i] < min[i] || origin[i] > max[i])
+					return -1.0f;
+				continue;
+			}
+			auto t0 = (min[i] - origin[i]) / direction[i];
+			auto t1 = (max[i] - origin[i]) / direction[i];
+			enter = std::max(enter, std::min(t0, t1));
+			exit = std::min(exit, std::max(t0, t1));
+		}
+		return enter <= exit ? enter : -1.0f;
+	}
+
+	bool IntersectSphere(const AABBf& box, const SpatialSphere& sphere)
+	{
+		auto clamp = [](float v, float low, float high) { return std::max(low, std::min(high, v)); };
+		Vector3f closest{ clamp(sphere.center.x, box.min.x, box.max.x), clamp(sphere.center.y, box.min.y, box.max.y),
+			clamp(sphere.center.z, box.min.z, box.max.z) };
+		auto offset = closest - sphere.center;
+		return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= sphere.radius * sphere.radius;
+	}
+
+	//Objects tracked by the test along with their current bounds
+	struct TestScene
+	{
+		SpatialIndex index;
+		std::vector<SpatialHandle> handles;
+		std::vector<AABBf> bounds;
+	};
+
+	template<typename Predicate>
+	std::vector<SpatialHandle> BruteForce(const TestScene& scene, const Predicate& predicate)
+	{
+		std::vector<SpatialHandle> results;
+		for (auto handle : scene.handles)
+		{
+			if (predicate(scene.index.GetFatBounds(handle)))
+				results.push_back(handle);
+		}
+		std::sort(results.begin(), results.end());
+		return results;
+	}
+
+	std::vector<SpatialHandle> Sorted(std::vector<SpatialHandle> handles)
+	{
+		std::sort(handles.begin(), handles.end());
+		return handles;
+	}
+
+	void CheckQueries(const TestScene& scene)
+	{
+		REQUIRE(scene.index.GetCount() == scene.handles.size());
+		//enlarged bounds always contain the bounds
+		for (std::size_t i = 0;i < scene.handles.size();++i)
+		{
+			auto fatBounds = scene.index.GetFatBounds(scene.handles[i]);
+			REQUIRE(fatBounds.Contains(scene.bounds[i].min));
+			REQUIRE(fatBounds.Contains(scene.bounds[i].max));
+		}
+		for (auto i = 0;i < 20;++i)
+		{
+			auto box = MakeBox(RandomPoint(500.0f), RandomFloat(1.0f, 100.0f));
+			std::vector<SpatialHandle> results;
+			scene.index.QueryBox(box, results);
+			REQUIRE(Sorted(results) == BruteForce(scene, [&box](const AABBf& bounds) { return bounds.Intersects(box); }));
+
+			SpatialSphere sphere{ RandomPoint(500.0f), RandomFloat(1.0f, 100.0f) };
+			results.clear();
+			scene.index.QuerySphere(sphere, results);
+			REQUIRE(Sorted(results) == BruteForce(scene, [&sphere](const AABBf& bounds) { return IntersectSphere(bounds, sphere); }));
+
+			auto frustum = MakeFrustum(RandomFloat(0.0f, 6.2832f), RandomPoint(300.0f), 300.0f);
+			results.clear();
+			scene.index.QueryFrustum(frustum, results);
+			REQUIRE(Sorted(results) == BruteForce(scene, [&frustum](const AABBf& bounds) { return frustum.Intersects(bounds); }));
+
+			auto ray = RandomRay(500.0f);
+			results.clear();
+			scene.index.QueryRay(ray, results);
+			auto expected = BruteForce(scene, [&ray](const AABBf& bounds) { return IntersectRay(bounds, ray) >= 0; });
+			REQUIRE(Sorted(results) == expected);
+			auto hit = scene.index.RayCastClosest(ray);
+			if (expected.empty())
+			{
+				REQUIRE(hit.handle == INVALID_SPATIAL_HANDLE);
+			}
+			else
+			{
+				auto closest = ray.maxDistance;
+				for (auto handle : expected)
+				{
+					closest = std::min(closest, IntersectRay(scene.index.GetFatBounds(handle), ray));
+				}
+				REQUIRE(hit.handle != INVALID_SPATIAL_HANDLE);
+				REQUIRE(hit.distance == Approx(closest).epsilon(1e-4));
+			}
+		}
+	}
+
+	TEST_CASE("Spatial index test", "[Spatial index test]")
+	{
+		constexpr std::size_t ObjectCount = 5000;
+		TestScene scene;
+		for (std::size_t i = 0;i < ObjectCount;++i)
+		{
+			scene.bounds.push_back(RandomBox(500.0f));
+			scene.handles.push_back(scene.index.Insert(scene.bounds.back()));
+		}
+		CheckQueries(scene);
+		//rotations keep the tree balanced
+		REQUIRE(scene.index.GetHeight() <= 2 * 13);
+
+		//small moves stay inside enlarged bounds,large moves reinsert leaves
+		std::size_t reinsertCount{ 0 };
+		for (std::size_t i = 0;i < ObjectCount;++i)
+		{
+			auto& bounds = scene.bounds[i];
+			auto offset = i % 2 == 0 ? Vector3f{ 0.05f, -0.05f, 0.0f } : RandomPoint(50.0f);
+			bounds.min = bounds.min + offset;
+			bounds.max = bounds.max + offset;
+			if (scene.index.Update(scene.handles[i], bounds))
+				++reinsertCount;
+		}
+		REQUIRE(reinsertCount <= ObjectCount / 2);
+		REQUIRE(reinsertCount > ObjectCount / 4);
+		CheckQueries(scene);
+
+		//an object shrinking a lot is reinserted
+		auto shrunk = MakeBox(scene.bounds[0].GetCenter(), 0.01f);
+		REQUIRE(scene.index.Update(scene.handles[0], MakeBox(scene.bounds[0].GetCenter(), 50.0f)));
+		REQUIRE(scene.index.Update(scene.handles[0], shrunk));
+		scene.bounds[0] = shrunk;
+
+		//removed handles are reused
+		for (std::size_t i = 0;i < ObjectCount / 2;++i)
+		{
+			auto victim = static_cast<std::size_t>(std::rand()) % scene.handles.size();
+			scene.index.Remove(scene.handles[victim]);
+			scene.handles[victim] = scene.handles.back();
+			scene.bounds[victim] = scene.bounds.back();
+			scene.handles.pop_back();
+			scene.bounds.pop_back();
+		}
+		for (std::size_t i = 0;i < ObjectCount / 4;++i)
+		{
+			scene.bounds.push_back(RandomBox(500.0f));
+			scene.handles.push_back(scene.index.Insert(scene.bounds.back()));
+			REQUIRE(scene.handles.back() < 2 * ObjectCount);
+		}
+		CheckQueries(scene);
+
+		//objects with unknown bounds are found by every query
+		scene.bounds.push_back(AABBf::Infinite());
+		auto infinite = scene.index.Insert(scene.bounds.back());
+		std::vector<SpatialHandle> results;
+		scene.index.QueryBox(MakeBox(Vector3f{ 1.0e6f, 0.0f, 0.0f }, 1.0f), results);
+		REQUIRE(results == std::vector<SpatialHandle>{ infinite });
+		scene.index.Remove(infinite);
+		scene.bounds.pop_back();
+
+		//batched queries match single ones
+		std::vector<SpatialSphere> spheres;
+		std::vector<Frustum> frustums;
+		std::vector<SpatialRay> rays;
+		for (auto i = 0;i < 32;++i)
+		{
+			spheres.push_back(SpatialSphere{ RandomPoint(500.0f), RandomFloat(1.0f, 100.0f) });
+			frustums.push_back(MakeFrustum(RandomFloat(0.0f, 6.2832f), RandomPoint(300.0f), 300.0f));
+			rays.push_back(RandomRay(500.0f));
+		}
+		std::vector<std::vector<SpatialHandle>> sphereResults(spheres.size()), frustumResults(frustums.size());
+		std::vector<SpatialRayHit> hits(rays.size());
+		scene.index.QuerySpheres(spheres.data(), spheres.size(), sphereResults.data());
+		scene.index.QueryFrustums(frustums.data(), frustums.size(), frustumResults.data());
+		scene.index.RayCastClosest(rays.data(), rays.size(), hits.data());
+		for (std::size_t i = 0;i < spheres.size();++i)
+		{
+			results.clear();
+			scene.index.QuerySphere(spheres[i], results);
+			REQUIRE(sphereResults[i] == results);
+			results.clear();
+			scene.index.QueryFrustum(frustums[i], results);
+			REQUIRE(frustumResults[i] == results);
+			auto hit = scene.index.RayCastClosest(rays[i]);
+			REQUIRE(hits[i].handle == hit.handle);
+		}
+
+		for (auto handle : scene.handles)
+		{
+			scene.index.Remove(handle);
+		}
+		REQUIRE(scene.index.GetCount() == 0);
+		REQUIRE(scene.index.GetHeight() == 0);
+		results.clear();
+		scene.index.QueryBox(AABBf::Infinite(), results);
+		REQUIRE(results.empty());
+	}
+
+	void RunSpatialIndexBenchmark(std::size_t objectCount, const char* label)
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		using std::chrono::high_resolution_clock;
+		constexpr std::size_t QueryCount = 1000;
+		//object density is kept the same for all counts
+		auto extent = 1000.0f * std::cbrt(objectCount / 100000.0f);
+		std::vector<AABBf> bounds(objectCount);
+		for (auto& box : bounds)
+		{
+			box = MakeBox(RandomPoint(extent), RandomFloat(0.5f, 2.0f));
+		}
+		SpatialIndex index;
+		std::vector<SpatialHandle> handles(objectCount);
+		auto build_start = high_resolution_clock::now();
+		for (std::size_t i = 0;i < objectCount;++i)
+		{
+			handles[i] = index.Insert(bounds[i]);
+		}
+		auto build_end = high_resolution_clock::now();
+		std::cout << "[spatial index build time(" << label << "):] " << duration_cast<duration<double>>(build_end - build_start).count()
+			<< " height " << index.GetHeight() << " area ratio " << index.GetAreaRatio() << std::endl;
+
+		std::vector<AABBf> boxes(QueryCount);
+		std::vector<SpatialSphere> spheres(QueryCount);
+		std::vector<Frustum> frustums(QueryCount);
+		std::vector<SpatialRay> rays(QueryCount);
+		for (std::size_t i = 0;i < QueryCount;++i)
+		{
+			boxes[i] = MakeBox(RandomPoint(extent), 20.0f);
+			spheres[i] = SpatialSphere{ RandomPoint(extent), 20.0f };
+			frustums[i] = MakeFrustum(RandomFloat(0.0f, 6.2832f), RandomPoint(extent), 100.0f);
+			rays[i] = RandomRay(extent);
+		}
+		std::vector<std::vector<SpatialHandle>> results(QueryCount);
+		std::vector<SpatialRayHit> hits(QueryCount);
+		auto report = [label](const char* query, high_resolution_clock::time_point start, high_resolution_clock::time_point end,
+			std::size_t resultCount) {
+			auto seconds = duration_cast<duration<double>>(end - start).count();
+			std::cout << "[spatial index " << query << " queries per second(" << label << "):] " << QueryCount / seconds
+				<< " results " << resultCount << std::endl;
+		};
+		auto countResults = [&results]() {
+			std::size_t count{ 0 };
+			for (const auto& result : results)
+				count += result.size();
+			return count;
+		};
+
+		auto start = high_resolution_clock::now();
+		for (std::size_t i = 0;i < QueryCount;++i)
+		{
+			results[i].clear();
+			index.QueryBox(boxes[i], results[i]);
+		}
+		auto end = high_resolution_clock::now();
+		report("box", start, end, countResults());
+
+		start = high_resolution_clock::now();
+		for (std::size_t i = 0;i < QueryCount;++i)
+		{
+			results[i].clear();
+			index.QuerySphere(spheres[i], results[i]);
+		}
+		end = high_resolution_clock::now();
+		report("sphere", start, end, countResults());
+
+		start = high_resolution_clock::now();
+		for (std::size_t i = 0;i < QueryCount;++i)
+		{
+			results[i].clear();
+			index.QueryFrustum(frustums[i], results[i]);
+		}
+		end = high_resolution_clock::now();
+		report("frustum", start, end, countResults());
+		REQUIRE(countResults() > 0);
+
+		start = high_resolution_clock::now();
+		std::size_t hitCount{ 0 };
+		for (std::size_t i = 0;i < QueryCount;++i)
+		{
+			hits[i] = index.RayCastClosest(rays[i]);
+			hitCount += hits[i].handle != INVALID_SPATIAL_HANDLE ? 1 : 0;
+		}
+		end = high_resolution_clock::now();
+		report("closest ray", start, end, hitCount);
+
+		start = high_resolution_clock::now();
+		index.QueryFrustums(frustums.data(), QueryCount, results.data());
+		end = high_resolution_clock::now();
+		report("batched frustum", start, end, countResults());
+
+		start = high_resolution_clock::now();
+		index.RayCastClosest(rays.data(), QueryCount, hits.data());
+		end = high_resolution_clock::now();
+		report("batched closest ray", start, end, hitCount);
+
+		//10% of objects move a little every frame,some of them out of their enlarged bounds
+		auto update_start = high_resolution_clock::now();
+		std::size_t reinsertCount{ 0 };
+		for (std::size_t i = 0;i < objectCount;i += 10)
+		{
+			auto offset = Vector3f{ RandomFloat(-0.2f, 0.2f), RandomFloat(-0.2f, 0.2f), RandomFloat(-0.2f, 0.2f) };
+			bounds[i].min = bounds[i].min + offset;
+			bounds[i].max = bounds[i].max + offset;
+			if (index.Update(handles[i], bounds[i]))
+				++reinsertCount;
+		}
+		auto update_end = high_resolution_clock::now();
+		std::cout << "[spatial index update time(" << label << ", 10% moved):] " << duration_cast<duration<double>>(update_end - update_start).count()
+			<< " reinserted " << reinsertCount << std::endl;
+
+		//brute force frustum culling for comparison
+		start = high_resolution_clock::now();
+		std::size_t bruteForceCount{ 0 };
+		for (std::size_t i = 0;i < 10;++i)
+		{
+			for (const auto& box : bounds)
+			{
+				bruteForceCount += frustums[i].Intersects(box) ? 1 : 0;
+			}
+		}
+		end = high_resolution_clock::now();
+		std::cout << "[brute force frustum queries per second(" << label << "):] " << 10 / duration_cast<duration<double>>(end - start).count()
+			<< " results " << bruteForceCount << std::endl;
+	}
+
+	TEST_CASE("Spatial index performance test", "[Spatial index performance]")
+	{
+		RunSpatialIndexBenchmark(100000, "100k");
+		RunSpatialIndexBenchmark(1000000, "1M");
+	}
+}
@@ -0,0 +1,275 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "Math/TransformBatch.h"
+
+namespace
+{
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::Vector4f;
+	using Lightning::Foundation::Math::Quaternionf;
+	using Lightning::Foundation::Math::AABBf;
+	using Lightning::Foundation::Math::Vector3fSoA;
+	using Lightning::Foundation::Math::BatchTransformPoints;
+	using Lightning::Foundation::Math::BatchTransformAABBs;
+	using Lightning::Foundation::Math::BatchQuaternionToMatrix;
+	using Lightning::Foundation::Math::BatchComposeTRS;
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	Vector3f RandomVector(float low, float high)
+	{
+		return Vector3f{ RandomFloat(low, high), RandomFloat(low, high), RandomFloat(low, high) };
+	}
+
+	Quaternionf RandomRotation()
+	{
+		Quaternionf rotation{ RandomFloat(-1, 1), RandomFloat(-1, 1), RandomFloat(-1, 1), RandomFloat(-1, 1) };
+		rotation.Normalize();
+		return rotation;
+	}
+
+	//scale * rotation * translation like Transform does
+	Matrix4f ComposeTRS(const Vector3f& position, const Quaternionf& rotation, const Vector3f& scale)
+	{
+		Matrix4f matScale, matRotation, matTrans;
+		matScale.SetIdentity();
+		matScale.SetCell(0, 0, scale.x);
+		matScale.SetCell(1, 1, scale.y);
+		matScale.SetCell(2, 2, scale.z);
+		rotation.ToMatrix(matRotation);
+		matTrans.SetIdentity();
+		matTrans.SetRow(3, Vector4f{ position.x, position.y, position.z, 1.0f });
+		return matScale * matRotation * matTrans;
+	}
+
+	Vector3f TransformPoint(const Matrix4f& matrix, const Vector3f& point)
+	{
+		auto res = Vector4f{ point.x, point.y, point.z, 1.0f } * matrix;
+		return Vector3f{ res.x, res.y, res.z };
+	}
+
+	void RequireEqual(const Vector3f& v, const Vector3f& expected)
+	{
+		REQUIRE(v.x == Approx(expected.x).epsilon(1e-4).margin(1e-4));
+		REQUIRE(v.y == Approx(expected.y).epsilon(1e-4).margin(1e-4));
+		REQUIRE(v.z == Approx(expected.z).epsilon(1e-4).margin(1e-4));
+	}
+
+	void RequireEqual(const Matrix4f& matrix, const Matrix4f& expected)
+	{
+		for (auto i = 0;i < 16;++i)
+		{
+			CAPTURE(i);
+			REQUIRE(matrix.m[i] == Approx(expected.m[i]).epsilon(1e-4).margin(1e-5));
+		}
+	}
+
+	TEST_CASE("Batch transform points test", "[Transform batch test]")
+	{
+		//odd count so that AVX, SSE and scalar tail are all exercised
+		constexpr std::size_t PointCount = 23;
+		auto matrix = ComposeTRS(RandomVector(-100, 100), RandomRotation(), RandomVector(0.5f, 2.0f));
+		std::vector<Vector3f> points(PointCount);
+		std::vector<float> components(Vector3fSoA::GetRequiredSize(PointCount));
+		std::vector<float> resultComponents(Vector3fSoA::GetRequiredSize(PointCount));
+		Vector3fSoA soa{ components.data(), PointCount };
+		Vector3fSoA soaResults{ resultComponents.data(), PointCount };
+		for (std::size_t i = 0;i < PointCount;++i)
+		{
+			points[i] = RandomVector(-10, 10);
+			soa.Set(i, points[i]);
+		}
+		std::vector<Vector3f> results(PointCount);
+		SECTION("Whole range")
+		{
+			BatchTransformPoints(matrix, points.data(), results.data(), 0, PointCount);
+			BatchTransformPoints(matrix, soa, soaResults, 0, PointCount);
+		}
+		SECTION("Split ranges")
+		{
+			BatchTransformPoints(matrix, points.data(), results.data(), 0, 5);
+			BatchTransformPoints(matrix, points.data(), results.data(), 5, 18);
+			BatchTransformPoints(matrix, points.data(), results.data(), 18, PointCount);
+			BatchTransformPoints(matrix, soa, soaResults, 0, 9);
+			BatchTransformPoints(matrix, soa, soaResults, 9, PointCount);
+		}
+		for (std::size_t i = 0;i < PointCount;++i)
+		{
+			CAPTURE(i);
+			auto expected = TransformPoint(matrix, points[i]);
+			RequireEqual(results[i], expected);
+			Vector3f soaResult;
+			soaResults.Get(i, soaResult);
+			RequireEqual(soaResult, expected);
+		}
+
+		//in place
+		auto inPlace = points;
+		BatchTransformPoints(matrix, inPlace.data(), inPlace.data(), 0, PointCount);
+		for (std::size_t i = 0;i < PointCount;++i)
+		{
+			RequireEqual(inPlace[i], results[i]);
+		}
+	}
+
+	TEST_CASE("Batch transform AABBs test", "[Transform batch test]")
+	{
+		constexpr std::size_t BoxCount = 23;
+		auto matrix = ComposeTRS(RandomVector(-100, 100), RandomRotation(), RandomVector(0.5f, 2.0f));
+		std::vector<AABBf> boxes(BoxCount);
+		for (auto& box : boxes)
+		{
+			auto center = RandomVector(-50, 50);
+			auto extents = RandomVector(0.1f, 5.0f);
+			box = AABBf{ center - extents, center + extents };
+		}
+		//empty and infinite boxes are passed through
+		boxes[3] = AABBf::Empty();
+		boxes[4] = AABBf::Infinite();
+		std::vector<AABBf> results(BoxCount);
+		BatchTransformAABBs(matrix, boxes.data(), results.data(), 0, BoxCount);
+		for (std::size_t i = 0;i < BoxCount;++i)
+		{
+			CAPTURE(i);
+			auto expected = boxes[i].Transformed(matrix);
+			if (i == 3 || i == 4)
+			{
+				REQUIRE(results[i].min.x == expected.min.x);
+				REQUIRE(results[i].max.x == expected.max.x);
+				continue;
+			}
+			RequireEqual(results[i].min, expected.min);
+			RequireEqual(results[i].max, expected.max);
+		}
+		BatchTransformAABBs(matrix, boxes.data(), boxes.data(), 0, BoxCount);
+		for (std::size_t i = 5;i < BoxCount;++i)
+		{
+			RequireEqual(boxes[i].min, results[i].min);
+			RequireEqual(boxes[i].max, results[i].max);
+		}
+	}
+
+	TEST_CASE("Batch quaternion to matrix and TRS compose test", "[Transform batch test]")
+	{
+		constexpr std::size_t Count = 23;
+		std::vector<Vector3f> positions(Count), scales(Count);
+		std::vector<Quaternionf> rotations(Count);
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			positions[i] = RandomVector(-100, 100);
+			rotations[i] = RandomRotation();
+			scales[i] = RandomVector(0.1f, 10.0f);
+		}
+		std::vector<Matrix4f> results(Count);
+		BatchQuaternionToMatrix(rotations.data(), results.data(), 0, Count);
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			CAPTURE(i);
+			Matrix4f expected;
+			rotations[i].ToMatrix(expected);
+			RequireEqual(results[i], expected);
+		}
+		BatchComposeTRS(positions.data(), rotations.data(), scales.data(), results.data(), 0, 11);
+		BatchComposeTRS(positions.data(), rotations.data(), scales.data(), results.data(), 11, Count);
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			CAPTURE(i);
+			RequireEqual(results[i], ComposeTRS(positions[i], rotations[i], scales[i]));
+		}
+	}
+
+	template<typename Function>
+	double Measure(Function&& function)
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		//best of a few runs,the first one also warms up caches
+		double best{ 0.0 };
+		for (auto i = 0;i < 5;++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto end = std::chrono::high_resolution_clock::now();
+			auto time = duration_cast<duration<double>>(end - start).count();
+			if (i == 0 || time < best)
+				best = time;
+		}
+		return best;
+	}
+
+	void Report(const char* name, double time, std::size_t count, std::size_t bytesPerElement)
+	{
+		std::cout << "[" << name << " time:] " << time << std::endl;
+		std::cout << "[" << name << " elements/s:] " << count / time << std::endl;
+		std::cout << "[" << name << " GB/s:] " << count * bytesPerElement / time / 1e9 << std::endl;
+	}
+
+	TEST_CASE("Batch transform performance test", "[Transform batch performance]")
+	{
+		constexpr std::size_t Count = 1000000;
+		auto matrix = ComposeTRS(RandomVector(-100, 100), RandomRotation(), RandomVector(0.5f, 2.0f));
+		std::vector<Vector3f> points(Count), results(Count), positions(Count), scales(Count);
+		std::vector<Quaternionf> rotations(Count);
+		std::vector<AABBf> boxes(Count), boxResults(Count);
+		std::vector<Matrix4f> matrices(Count);
+		std::vector<float> components(Vector3fSoA::GetRequiredSize(Count)), resultComponents(Vector3fSoA::GetRequiredSize(Count));
+		Vector3fSoA soa{ components.data(), Count };
+		Vector3fSoA soaResults{ resultComponents.data(), Count };
+		for (std::size_t i = 0;i < Count;++i)
+		{
+			points[i] = RandomVector(-10, 10);
+			soa.Set(i, points[i]);
+			positions[i] = RandomVector(-100, 100);
+			scales[i] = RandomVector(0.5f, 2.0f);
+			rotations[i] = RandomRotation();
+			boxes[i] = AABBf{ points[i], points[i] + scales[i] };
+		}
+
+		//scalar loops use the single value API
+		Report("scalar transform points(1M)", Measure([&]() {
+			for (std::size_t i = 0;i < Count;++i)
+				results[i] = TransformPoint(matrix, points[i]);
+		}), Count, sizeof(Vector3f) * 2);
+		Report("batch transform points(1M)", Measure([&]() {
+			BatchTransformPoints(matrix, points.data(), results.data(), 0, Count);
+		}), Count, sizeof(Vector3f) * 2);
+		Report("batch transform SoA points(1M)", Measure([&]() {
+			BatchTransformPoints(matrix, soa, soaResults, 0, Count);
+		}), Count, sizeof(Vector3f) * 2);
+
+		Report("scalar transform AABBs(1M)", Measure([&]() {
+			for (std::size_t i = 0;i < Count;++i)
+				boxResults[i] = boxes[i].Transformed(matrix);
+		}), Count, sizeof(AABBf) * 2);
+		Report("batch transform AABBs(1M)", Measure([&]() {
+			BatchTransformAABBs(matrix, boxes.data(), boxResults.data(), 0, Count);
+		}), Count, sizeof(AABBf) * 2);
+
+		Report("scalar quaternion to matrix(1M)", Measure([&]() {
+			for (std::size_t i = 0;i < Count;++i)
+				rotations[i].ToMatrix(matrices[i]);
+		}), Count, sizeof(Quaternionf) + sizeof(Matrix4f));
+		Report("batch quaternion to matrix(1M)", Measure([&]() {
+			BatchQuaternionToMatrix(rotations.data(), matrices.data(), 0, Count);
+		}), Count, sizeof(Quaternionf) + sizeof(Matrix4f));
+
+		Report("scalar compose TRS(1M)", Measure([&]() {
+			for (std::size_t i = 0;i < Count;++i)
+				matrices[i] = ComposeTRS(positions[i], rotations[i], scales[i]);
+		}), Count, sizeof(Vector3f) * 2 + sizeof(Quaternionf) + sizeof(Matrix4f));
+		Report("batch compose TRS(1M)", Measure([&]() {
+			BatchComposeTRS(positions.data(), rotations.data(), scales.data(), matrices.data(), 0, Count);
+		}), Count, sizeof(Vector3f) * 2 + sizeof(Quaternionf) + sizeof(Matrix4f));
+
+		Vector3f soaResult;
+		soaResults.Get(7, soaResult);
+		RequireEqual(soaResult, results[7]);
+	}
+}
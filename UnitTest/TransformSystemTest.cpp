@@ -0,0 +1,299 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include "catch.hpp"
+#include "TransformSystem.h"
+#include "SpaceObject.h"
+
+namespace
+{
+	using Lightning::World::TransformSystem;
+	using Lightning::World::TransformHandle;
+	using Lightning::World::INVALID_TRANSFORM_HANDLE;
+	using Lightning::World::ISpaceObject;
+	using Lightning::World::SpaceObject;
+	using Lightning::World::SpaceObjectManager;
+	using Lightning::Foundation::Math::Transform;
+	using Lightning::Foundation::Math::Matrix4f;
+	using Lightning::Foundation::Math::Vector3f;
+
+	struct ITestTransformObject : virtual ISpaceObject
+	{
+	};
+
+	class TestTransformObject : public SpaceObject<ITestTransformObject, TestTransformObject>
+	{
+	};
+
+	float RandomFloat(float low, float high)
+	{
+		return low + (high - low) * static_cast<float>(std::rand()) / RAND_MAX;
+	}
+
+	Transform RandomTransform()
+	{
+		return Transform(Vector3f{ RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10) },
+			Vector3f{ RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f) }, Transform::RandomRotation());
+	}
+
+	//parents[i] < i,so world matrices can be computed in index order
+	Matrix4f ComputeWorldMatrix(const std::vector<Transform>& locals, const std::vector<int>& parents, int index)
+	{
+		if (parents[index] < 0)
+			return locals[index].GetMatrix();
+		return locals[index].GetMatrix() * ComputeWorldMatrix(locals, parents, parents[index]);
+	}
+
+	void CheckWorldMatrices(const TransformSystem& system, const std::vector<TransformHandle>& handles, 
+		const std::vector<Transform>& locals, const std::vector<int>& parents)
+	{
+		for (std::size_t i = 0;i < handles.size();++i)
+		{
+			if (handles[i] == INVALID_TRANSFORM_HANDLE)
+				continue;
+			auto expected = ComputeWorldMatrix(locals, parents, static_cast<int>(i));
+			const auto& actual = system.GetWorldMatrix(handles[i]);
+			for (auto cell = 0;cell < 16;++cell)
+			{
+				CAPTURE(i);
+				REQUIRE(actual.m[cell] == Approx(expected.m[cell]).epsilon(1e-3));
+			}
+		}
+	}
+
+	TEST_CASE("Transform system test", "[Transform system test]")
+	{
+		constexpr int TransformCount = 1000;
+		TransformSystem system;
+		std::vector<TransformHandle> handles;
+		std::vector<Transform> locals;
+		std::vector<int> parents;
+		for (auto i = 0;i < TransformCount;++i)
+		{
+			auto parent = i == 0 || std::rand() % 10 == 0 ? -1 : std::rand() % i;
+			handles.push_back(system.Create(parent < 0 ? INVALID_TRANSFORM_HANDLE : handles[parent]));
+			locals.push_back(RandomTransform());
+			parents.push_back(parent);
+			system.SetLocalTransform(handles.back(), locals.back());
+		}
+		system.Update();
+		REQUIRE(system.GetCount() == TransformCount);
+		REQUIRE(system.GetLevelCount() > 2);
+		CheckWorldMatrices(system, handles, locals, parents);
+		REQUIRE(system.GetLocalScale(handles[5]).x == locals[5].GetScale().x);
+
+		//changes reach descendants
+		for (auto frame = 0;frame < 3;++frame)
+		{
+			for (auto i = 0;i < 20;++i)
+			{
+				auto index = std::rand() % TransformCount;
+				locals[index] = RandomTransform();
+				system.SetLocalTransform(handles[index], locals[index]);
+			}
+			system.Update();
+			CheckWorldMatrices(system, handles, locals, parents);
+		}
+
+		//reparenting moves subtrees between levels
+		for (auto i = 0;i < 50;++i)
+		{
+			auto index = 1 + std::rand() % (TransformCount - 1);
+			auto parent = std::rand() % index;
+			system.SetParent(handles[index], handles[parent]);
+			parents[index] = parent;
+		}
+		system.Update();
+		CheckWorldMatrices(system, handles, locals, parents);
+		for (auto i = 0;i < TransformCount;++i)
+		{
+			REQUIRE(system.GetParent(handles[i]) == (parents[i] < 0 ? INVALID_TRANSFORM_HANDLE : handles[parents[i]]));
+		}
+
+		//children of destroyed transforms become roots and destroyed handles are reused
+		for (auto i = 0;i < 100;++i)
+		{
+			auto index = std::rand() % TransformCount;
+			if (handles[index] == INVALID_TRANSFORM_HANDLE)
+				continue;
+			system.Destroy(handles[index]);
+			handles[index] = INVALID_TRANSFORM_HANDLE;
+			for (auto& parent : parents)
+			{
+				if (parent == index)
+					parent = -1;
+			}
+		}
+		system.Update();
+		CheckWorldMatrices(system, handles, locals, parents);
+		auto liveCount = system.GetCount();
+		auto handle = system.Create();
+		REQUIRE(handle < TransformCount);
+		system.Update();
+		REQUIRE(system.GetCount() == liveCount + 1);
+		for (auto cell = 0;cell < 16;++cell)
+		{
+			REQUIRE(system.GetWorldMatrix(handle).m[cell] == (cell % 5 == 0 ? 1.0f : 0.0f));
+		}
+	}
+
+	TEST_CASE("Transform system reparent under destroyed ancestor test", "[Transform system test]")
+	{
+		TransformSystem system;
+		auto grandParent = system.Create();
+		auto parent = system.Create(grandParent);
+		auto child = system.Create();
+		system.SetLocalPosition(parent, Vector3f{ 1.0f, 2.0f, 3.0f });
+		system.Update();
+		//the ancestors of the new parent are walked before the destroyed one is detached by Update
+		system.Destroy(grandParent);
+		system.SetParent(child, parent);
+		system.Update();
+		REQUIRE(system.GetParent(parent) == INVALID_TRANSFORM_HANDLE);
+		REQUIRE(system.GetParent(child) == parent);
+		REQUIRE(system.GetWorldMatrix(child).GetCell(3, 0) == 1.0f);
+		REQUIRE(system.GetWorldMatrix(child).GetCell(3, 2) == 3.0f);
+	}
+
+	void RequireEqual(const Matrix4f& actual, const Matrix4f& expected)
+	{
+		for (auto cell = 0;cell < 16;++cell)
+		{
+			REQUIRE(actual.m[cell] == Approx(expected.m[cell]).epsilon(1e-3));
+		}
+	}
+
+	TEST_CASE("Space object transform handle test", "[Transform system test]")
+	{
+		auto& system = SpaceObjectManager::Instance()->GetTransformSystem();
+		auto root = std::make_shared<TestTransformObject>();
+		auto parent = std::make_shared<TestTransformObject>();
+		auto child = std::make_shared<TestTransformObject>();
+		REQUIRE(root->AddChild(parent));
+		REQUIRE(parent->AddChild(child));
+		SpaceObjectManager::Instance()->Synchronize();
+		REQUIRE(child->GetTransformHandle() == INVALID_TRANSFORM_HANDLE);
+		//global transforms can't hold the shear of non uniform scales under rotations,so scales are uniform
+		for (const auto& object : { root, parent, child })
+		{
+			auto scale = RandomFloat(0.5f, 2.0f);
+			object->GetLocalTransform() = Transform(Vector3f{ RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10) },
+				Vector3f{ scale, scale, scale }, Transform::RandomRotation());
+		}
+		root->UpdateGlobalTransforms();
+		auto childHandle = child->GetTransformHandle();
+		REQUIRE(childHandle != INVALID_TRANSFORM_HANDLE);
+		REQUIRE(system.GetParent(childHandle) == parent->GetTransformHandle());
+		auto expected = child->GetLocalTransform().GetMatrix() * parent->GetLocalTransform().GetMatrix() 
+			* root->GetLocalTransform().GetMatrix();
+		RequireEqual(system.GetWorldMatrix(childHandle), expected);
+		RequireEqual(child->GetGlobalTransform().GetMatrix(), expected);
+
+		//moved objects are sent to the transform system,the ones read before the update compute their own global transforms
+		parent->SetGlobalPosition(Vector3f{ 5.0f, 0.0f, 0.0f });
+		REQUIRE(parent->GetGlobalTransform().GetPosition().x == Approx(5.0f));
+		root->UpdateGlobalTransforms();
+		expected = child->GetLocalTransform().GetMatrix() * parent->GetLocalTransform().GetMatrix() 
+			* root->GetLocalTransform().GetMatrix();
+		RequireEqual(system.GetWorldMatrix(childHandle), expected);
+		RequireEqual(child->GetGlobalTransform().GetMatrix(), expected);
+		REQUIRE(system.GetWorldMatrix(parent->GetTransformHandle()).GetCell(3, 0) == Approx(5.0f));
+
+		//reparented subtrees follow their new parents
+		REQUIRE(parent->RemoveChild(child));
+		REQUIRE(root->AddChild(child));
+		SpaceObjectManager::Instance()->Synchronize();
+		root->UpdateGlobalTransforms();
+		REQUIRE(system.GetParent(childHandle) == root->GetTransformHandle());
+		expected = child->GetLocalTransform().GetMatrix() * root->GetLocalTransform().GetMatrix();
+		RequireEqual(system.GetWorldMatrix(childHandle), expected);
+		RequireEqual(child->GetGlobalTransform().GetMatrix(), expected);
+
+		//transforms of destroyed objects are released at next update
+		REQUIRE(root->RemoveChild(parent));
+		SpaceObjectManager::Instance()->Synchronize();
+		auto count = system.GetCount();
+		parent.reset();
+		root->UpdateGlobalTransforms();
+		REQUIRE(system.GetCount() == count - 1);
+	}
+
+	TEST_CASE("Transform system performance test", "[Transform system performance]")
+	{
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		constexpr std::size_t TransformCount = 1000000;
+		constexpr std::size_t LevelCount = 10;
+		constexpr std::size_t LevelSize = TransformCount / LevelCount;
+		//the same random hierarchy in both layouts,every level has the same size
+		std::vector<int> parents(TransformCount, -1);
+		for (std::size_t i = LevelSize;i < TransformCount;++i)
+		{
+			auto levelBegin = (i / LevelSize - 1) * LevelSize;
+			parents[i] = static_cast<int>(levelBegin + std::rand() % LevelSize);
+		}
+		std::vector<std::size_t> moving(TransformCount / 20);
+		for (auto& index : moving)
+		{
+			index = std::rand() % TransformCount;
+		}
+
+		TransformSystem system;
+		std::vector<TransformHandle> handles(TransformCount);
+		for (std::size_t i = 0;i < TransformCount;++i)
+		{
+			handles[i] = system.Create(parents[i] < 0 ? INVALID_TRANSFORM_HANDLE : handles[parents[i]]);
+			system.SetLocalTransform(handles[i], RandomTransform());
+		}
+		auto system_full_start = std::chrono::high_resolution_clock::now();
+		system.Update();
+		auto system_full_end = std::chrono::high_resolution_clock::now();
+		for (auto index : moving)
+		{
+			system.SetLocalPosition(handles[index], Vector3f{ 1.0f, 0.0f, 0.0f });
+		}
+		auto system_partial_start = std::chrono::high_resolution_clock::now();
+		system.Update();
+		auto system_partial_end = std::chrono::high_resolution_clock::now();
+
+		std::vector<std::shared_ptr<TestTransformObject>> objects(TransformCount);
+		for (std::size_t i = 0;i < TransformCount;++i)
+		{
+			objects[i] = std::make_shared<TestTransformObject>();
+			objects[i]->GetLocalTransform() = RandomTransform();
+			if (parents[i] >= 0)
+				objects[parents[i]]->AddChild(objects[i]);
+		}
+		SpaceObjectManager::Instance()->Synchronize();
+		//roots are children of a scene like object
+		auto root = std::make_shared<TestTransformObject>();
+		for (std::size_t i = 0;i < LevelSize;++i)
+		{
+			root->AddChild(objects[i]);
+		}
+		SpaceObjectManager::Instance()->Synchronize();
+		auto object_full_start = std::chrono::high_resolution_clock::now();
+		root->UpdateGlobalTransforms();
+		auto object_full_end = std::chrono::high_resolution_clock::now();
+		for (auto index : moving)
+		{
+			objects[index]->GetLocalTransform().SetPosition(Vector3f{ 1.0f, 0.0f, 0.0f });
+		}
+		auto object_partial_start = std::chrono::high_resolution_clock::now();
+		root->UpdateGlobalTransforms();
+		auto object_partial_end = std::chrono::high_resolution_clock::now();
+
+		auto systemFullTime = duration_cast<duration<double>>(system_full_end - system_full_start).count();
+		auto objectFullTime = duration_cast<duration<double>>(object_full_end - object_full_start).count();
+		std::cout << "[transform system full update time(1M transforms, 10 levels):] " << systemFullTime << std::endl;
+		std::cout << "[transform system 5% update time(1M transforms, 10 levels):] " 
+			<< duration_cast<duration<double>>(system_partial_end - system_partial_start).count() << std::endl;
+		std::cout << "[space object full update time(1M objects, 10 levels):] " << objectFullTime << std::endl;
+		std::cout << "[space object 5% update time(1M objects, 10 levels):] " 
+			<< duration_cast<duration<double>>(object_partial_end - object_partial_start).count() << std::endl;
+		REQUIRE(systemFullTime < objectFullTime);
+	}
+}
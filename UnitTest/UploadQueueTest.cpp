@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "catch.hpp"
+#include "UploadQueue.h"
+
+namespace
+{
+	using Lightning::Render::IGPUBuffer;
+	using Lightning::Render::UploadCopy;
+	using Lightning::Render::UploadQueue;
+	using Lightning::Render::UPLOAD_ALIGNMENT;
+
+	//A buffer backed by system memory standing in for a device buffer
+	class NullBuffer : public IGPUBuffer
+	{
+	public:
+		NullBuffer(std::size_t size) : mData(size, 0){}
+		std::uint8_t* Lock(std::size_t start, std::size_t size)override { return mData.data() + start; }
+		void Unlock(std::size_t start, std::size_t size)override{}
+		void Commit()override{}
+		std::uint32_t GetBufferSize()const override { return static_cast<std::uint32_t>(mData.size()); }
+		const std::vector<std::uint8_t>& GetData()const { return mData; }
+	private:
+		std::vector<std::uint8_t> mData;
+	};
+
+	//Executes copies the way a backend would record copy commands
+	struct NullBackend
+	{
+		NullBackend(const std::vector<std::uint8_t>& staging) : stagingMemory(staging){}
+		void operator()(const UploadCopy* copies, std::size_t copyCount)
+		{
+			++batchCount;
+			for (std::size_t i = 0;i < copyCount;++i)
+			{
+				const auto& copy = copies[i];
+				REQUIRE(copy.stagingOffset % UPLOAD_ALIGNMENT == 0);
+				REQUIRE(copy.stagingOffset + copy.size <= stagingMemory.size());
+				std::memcpy(copy.destination->Lock(copy.destinationOffset, copy.size), stagingMemory.data() + copy.stagingOffset, copy.size);
+				copy.destination->Unlock(copy.destinationOffset, copy.size);
+				++executedCopyCount;
+			}
+		}
+		const std::vector<std::uint8_t>& stagingMemory;
+		std::size_t batchCount{ 0 };
+		std::size_t executedCopyCount{ 0 };
+	};
+
+	std::vector<std::uint8_t> MakeData(std::size_t size, std::uint8_t seed)
+	{
+		std::vector<std::uint8_t> data(size);
+		for (std::size_t i = 0;i < size;++i)
+		{
+			data[i] = static_cast<std::uint8_t>(seed + i * 7);
+		}
+		return data;
+	}
+
+	TEST_CASE("Upload queue coalescing test", "[Upload queue test]")
+	{
+		std::vector<std::uint8_t> staging(64 * 1024);
+		UploadQueue queue(staging.data(), staging.size(), staging.size());
+		NullBackend backend(staging);
+		//10 buffers each written by 10 adjacent small writes
+		std::vector<std::shared_ptr<NullBuffer>> buffers;
+		std::vector<std::vector<std::uint8_t>> contents;
+		for (std::uint8_t i = 0;i < 10;++i)
+		{
+			buffers.push_back(std::make_shared<NullBuffer>(100));
+			contents.push_back(MakeData(100, i));
+			for (std::size_t j = 0;j < 10;++j)
+			{
+				queue.Enqueue(buffers.back(), j * 10, contents.back().data() + j * 10, 10);
+			}
+		}
+		REQUIRE(queue.GetPendingCount() == 100);
+		REQUIRE(queue.GetPendingSize() == 1000);
+		REQUIRE(queue.IsPending(buffers[3].get()));
+		auto flushedSize = queue.Flush(1, std::ref(backend));
+		REQUIRE(flushedSize == 1000);
+		REQUIRE(backend.batchCount == 1);
+		REQUIRE(backend.executedCopyCount == 10);
+		REQUIRE(queue.GetPendingCount() == 0);
+		REQUIRE_FALSE(queue.IsPending(buffers[3].get()));
+		for (std::size_t i = 0;i < buffers.size();++i)
+		{
+			REQUIRE(buffers[i]->GetData() == contents[i]);
+		}
+		//nothing left to flush
+		REQUIRE(queue.Flush(2, std::ref(backend)) == 0);
+		REQUIRE(backend.batchCount == 1);
+		queue.ReleaseFramesBefore(2);
+		REQUIRE(queue.GetStagingUsedSize() == 0);
+
+		//later writes to the same range win
+		auto buffer = std::make_shared<NullBuffer>(16);
+		auto first = MakeData(16, 1);
+		auto second = MakeData(16, 2);
+		queue.Enqueue(buffer, 0, first.data(), first.size());
+		queue.Enqueue(buffer, 0, second.data(), second.size());
+		queue.Flush(3, std::ref(backend));
+		REQUIRE(buffer->GetData() == second);
+	}
+
+	TEST_CASE("Upload queue budget test", "[Upload queue test]")
+	{
+		constexpr std::size_t ObjectCount = 1000;
+		constexpr std::size_t ObjectSize = 1000;
+		constexpr std::size_t FrameBudget = 64 * 1024;
+		std::vector<std::uint8_t> staging(1024 * 1024);
+		UploadQueue queue(staging.data(), staging.size(), FrameBudget);
+		NullBackend backend(staging);
+		//a burst of newly spawned objects
+		std::vector<std::shared_ptr<NullBuffer>> buffers;
+		auto content = MakeData(ObjectSize, 3);
+		for (std::size_t i = 0;i < ObjectCount;++i)
+		{
+			buffers.push_back(std::make_shared<NullBuffer>(ObjectSize));
+			queue.Enqueue(buffers.back(), 0, content.data(), content.size());
+		}
+		//a renderer keeping 3 frames in flight
+		std::uint64_t frame{ 0 };
+		std::size_t maxFlushedSize{ 0 };
+		while (queue.GetPendingCount() > 0)
+		{
+			++frame;
+			if (frame > 3)
+				queue.ReleaseFramesBefore(frame - 3);
+			auto flushedSize = queue.Flush(frame, std::ref(backend));
+			REQUIRE(flushedSize > 0);
+			maxFlushedSize = std::max(maxFlushedSize, flushedSize);
+			//buffers are flushed in the order they are queued
+			auto flushedCount = ObjectCount - queue.GetPendingCount();
+			REQUIRE_FALSE(queue.IsPending(buffers[flushedCount - 1].get()));
+			if (flushedCount < ObjectCount)
+				REQUIRE(queue.IsPending(buffers[flushedCount].get()));
+		}
+		REQUIRE(maxFlushedSize <= FrameBudget);
+		//writes are 1008 bytes apart with alignment,so 65 of them fit in the budget
+		REQUIRE(frame == (ObjectCount + 64) / 65);
+		std::cout << "[upload queue frames to flush 1000 objects of 1000 bytes(64KB budget):] " << frame << std::endl;
+		for (const auto& buffer : buffers)
+		{
+			REQUIRE(buffer->GetData() == content);
+		}
+
+		//a write larger than the budget is flushed alone
+		auto largeBuffer = std::make_shared<NullBuffer>(FrameBudget * 2);
+		auto largeContent = MakeData(FrameBudget * 2, 5);
+		queue.Enqueue(largeBuffer, 0, largeContent.data(), largeContent.size());
+		queue.Enqueue(buffers[0], 0, content.data(), content.size());
+		REQUIRE(queue.Flush(++frame, std::ref(backend)) == largeContent.size());
+		REQUIRE(largeBuffer->GetData() == largeContent);
+		REQUIRE(queue.GetPendingCount() == 1);
+	}
+
+	TEST_CASE("Upload queue ring test", "[Upload queue test]")
+	{
+		constexpr std::size_t WriteSize = 3000;
+		std::vector<std::uint8_t> staging(16 * 1024);
+		UploadQueue queue(staging.data(), staging.size(), WriteSize);
+		NullBackend backend(staging);
+		std::vector<std::shared_ptr<NullBuffer>> buffers;
+		std::vector<std::vector<std::uint8_t>> contents;
+		for (std::uint8_t i = 0;i < 20;++i)
+		{
+			buffers.push_back(std::make_shared<NullBuffer>(WriteSize));
+			contents.push_back(MakeData(WriteSize, i));
+			queue.Enqueue(buffers.back(), 0, contents.back().data(), WriteSize);
+		}
+		//the GPU never finishes a frame,so the ring fills up
+		std::uint64_t frame{ 0 };
+		while (queue.Flush(++frame, std::ref(backend)) > 0);
+		auto flushedCount = 20 - queue.GetPendingCount();
+		REQUIRE(flushedCount == staging.size() / 3008);
+		REQUIRE(queue.GetStagingUsedSize() == flushedCount * 3008);
+		//finishing the first two frames frees enough memory for one more write at the start of the ring
+		queue.ReleaseFramesBefore(2);
+		REQUIRE(queue.Flush(++frame, std::ref(backend)) == WriteSize);
+		//keep the GPU two frames behind until everything is flushed,wrapping around several times
+		while (queue.GetPendingCount() > 0)
+		{
+			queue.ReleaseFramesBefore(frame - 2);
+			queue.Flush(++frame, std::ref(backend));
+			REQUIRE(queue.GetStagingUsedSize() <= queue.GetStagingSize());
+		}
+		for (std::size_t i = 0;i < buffers.size();++i)
+		{
+			REQUIRE(buffers[i]->GetData() == contents[i]);
+		}
+		queue.ReleaseFramesBefore(frame);
+		REQUIRE(queue.GetStagingUsedSize() == 0);
+	}
+}
@@ -0,0 +1,423 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "WorldPartition.h"
+
+namespace
+{
+	using Lightning::World::WorldPartition;
+	using Lightning::World::WorldPartitionSettings;
+	using Lightning::World::WorldCellState;
+	using Lightning::World::WorldCellCoord;
+	using Lightning::World::WorldCellData;
+	using Lightning::World::WorldCellObject;
+	using Lightning::World::WorldCellSerializer;
+	using Lightning::World::IWorldCellHandler;
+	using Lightning::Foundation::IFile;
+	using Lightning::Foundation::IFileSystem;
+	using Lightning::Foundation::FileAccess;
+	using Lightning::Foundation::FileSize;
+	using Lightning::Foundation::FilePointerType;
+	using Lightning::Foundation::FileAnchor;
+	using Lightning::Loading::ILoader;
+	using Lightning::Loading::ISerializer;
+	using Lightning::Loading::ISerializeBuffer;
+	using Lightning::Foundation::Math::Vector3f;
+	using Lightning::Foundation::Math::Quaternionf;
+
+	class FakeFile : public IFile
+	{
+	public:
+		FakeFile(const std::string& path, const std::vector<char>& content) : mPath(path), mContent(content), mPosition(0){}
+		FileSize GetSize()override { return static_cast<FileSize>(mContent.size()); }
+		FileSize Read(char* buf, FileSize length)override
+		{
+			auto size = std::min<FileSize>(length, static_cast<FileSize>(mContent.size() - mPosition));
+			std::memcpy(buf, mContent.data() + mPosition, static_cast<std::size_t>(size));
+			mPosition += static_cast<std::size_t>(size);
+			return size;
+		}
+		void SetFilePointer(FilePointerType type, FileAnchor anchor, FileSize offset)override
+		{
+			auto base = anchor == FileAnchor::Begin ? 0 : anchor == FileAnchor::End ? mContent.size() : mPosition;
+			mPosition = static_cast<std::size_t>(base + offset);
+		}
+		void Close()override {}
+		bool IsOpen()const override { return true; }
+		std::string GetPath()const override { return mPath; }
+		std::string GetName()const override { return mPath; }
+	private:
+		std::string mPath;
+		std::vector<char> mContent;
+		std::size_t mPosition;
+	};
+
+	class FakeFileSystem : public IFileSystem
+	{
+	public:
+		std::shared_ptr<IFile> FindFile(const std::string& filename, FileAccess bitmask)override
+		{
+			auto it = mFiles.find(filename);
+			if (it == mFiles.end())
+				return nullptr;
+			return std::make_shared<FakeFile>(filename, it->second);
+		}
+		bool SetRoot(const std::string& root_path)override { return true; }
+		std::string GetRoot()const override { return ""; }
+		std::map<std::string, std::vector<char>> mFiles;
+	};
+
+	class FakeBuffer : public ISerializeBuffer
+	{
+	public:
+		FakeBuffer(std::size_t size) : mBuffer(size){}
+		char* GetBuffer()override { return mBuffer.data(); }
+		std::size_t GetBufferSize()const override { return mBuffer.size(); }
+	private:
+		std::vector<char> mBuffer;
+	};
+
+	//Requests are kept until Pump,so tests decide when loads finish.Missing files are dropped like Loader does
+	class FakeLoader : public ILoader
+	{
+	public:
+		FakeLoader(IFileSystem& fileSystem) : mFileSystem(fileSystem){}
+		void Finalize()override {}
+		void Load(const std::string& path, const std::shared_ptr<ISerializer>& serializer)override
+		{
+			mRequests.emplace_back(path, serializer);
+		}
+		void Pump(std::size_t count = SIZE_MAX)
+		{
+			while (count-- > 0 && !mRequests.empty())
+			{
+				auto request = mRequests.front();
+				mRequests.pop_front();
+				auto file = mFileSystem.FindFile(request.first, FileAccess::READ);
+				if (!file)
+					continue;
+				auto buffer = std::make_shared<FakeBuffer>(static_cast<std::size_t>(file->GetSize()));
+				file->Read(buffer->GetBuffer(), file->GetSize());
+				request.second->Deserialize(file.get(), buffer);
+			}
+		}
+		std::size_t GetPendingCount()const { return mRequests.size(); }
+	private:
+		IFileSystem& mFileSystem;
+		std::deque<std::pair<std::string, std::shared_ptr<ISerializer>>> mRequests;
+	};
+
+	class RecordingHandler : public IWorldCellHandler
+	{
+	public:
+		void OnCellLoaded(const WorldCellData& cell)override
+		{
+			auto inserted = mCells.insert(std::make_pair(cell.coord.x, cell.coord.z)).second;
+			if (!inserted)
+				++mErrors;
+			mObjectCount += cell.objects.size();
+		}
+		void OnCellUnloaded(const WorldCellCoord& coord)override
+		{
+			if (mCells.erase(std::make_pair(coord.x, coord.z)) == 0)
+				++mErrors;
+		}
+		std::set<std::pair<int, int>> mCells;
+		std::size_t mObjectCount{ 0 };
+		std::size_t mErrors{ 0 };
+	};
+
+	constexpr float CellSize = 100.0f;
+	constexpr int GridSize = 16;
+
+	std::string GetCellPath(int x, int z)
+	{
+		return "world/cell_" + std::to_string(x) + "_" + std::to_string(z) + ".wcell";
+	}
+
+	WorldCellData MakeCell(int x, int z)
+	{
+		WorldCellData cell;
+		cell.coord = WorldCellCoord{ x, z };
+		for (auto i = 0;i < 4;++i)
+		{
+			WorldCellObject object;
+			object.type = i;
+			object.position = Vector3f{ x * CellSize + i, 0.0f, z * CellSize + i };
+			object.rotation = Quaternionf{ 0.0f, 0.0f, 0.0f, 1.0f };
+			object.scale = Vector3f{ 1.0f, 1.0f, 1.0f };
+			object.data = "meshes/rock.mesh";
+			cell.objects.push_back(object);
+		}
+		return cell;
+	}
+
+	//Synthetic world of GridSize x GridSize cells,all chunks have the same size.Returns the chunk size
+	std::size_t BuildWorld(FakeFileSystem& fileSystem, WorldPartition& partition)
+	{
+		std::size_t chunkSize{ 0 };
+		for (auto z = 0;z < GridSize;++z)
+		{
+			for (auto x = 0;x < GridSize;++x)
+			{
+				auto& chunk = fileSystem.mFiles[GetCellPath(x, z)];
+				Lightning::World::WriteWorldCell(MakeCell(x, z), chunk);
+				chunkSize = chunk.size();
+				partition.RegisterCell(WorldCellCoord{ x, z }, GetCellPath(x, z), chunk.size());
+			}
+		}
+		return chunkSize;
+	}
+
+	//Cells whose squares are within radius of viewer on the XZ plane
+	std::set<std::pair<int, int>> CellsInRange(const Vector3f& viewer, float radius)
+	{
+		std::set<std::pair<int, int>> cells;
+		for (auto z = 0;z < GridSize;++z)
+		{
+			for (auto x = 0;x < GridSize;++x)
+			{
+				auto dx = std::max(std::max(x * CellSize - viewer.x, viewer.x - (x + 1) * CellSize), 0.0f);
+				auto dz = std::max(std::max(z * CellSize - viewer.z, viewer.z - (z + 1) * CellSize), 0.0f);
+				if (dx * dx + dz * dz <= radius * radius)
+					cells.insert(std::make_pair(x, z));
+			}
+		}
+		return cells;
+	}
+
+	//Updates until nothing is in flight,loader finishes all requests between updates
+	void Settle(WorldPartition& partition, FakeLoader& loader, const Vector3f* viewers, std::size_t viewerCount)
+	{
+		for (auto i = 0;i < 1000;++i)
+		{
+			partition.Update(viewers, viewerCount);
+			if (loader.GetPendingCount() == 0 && partition.GetStats().loadingCellCount == 0)
+				break;
+			loader.Pump();
+		}
+	}
+
+	WorldPartitionSettings MakeSettings()
+	{
+		WorldPartitionSettings settings;
+		settings.cellSize = CellSize;
+		settings.loadRadius = 150.0f;
+		settings.unloadRadius = 250.0f;
+		settings.maxInFlightLoads = 3;
+		settings.memoryBudget = 1024 * 1024;
+		settings.loadTimeoutUpdates = 5;
+		return settings;
+	}
+
+	TEST_CASE("World cell chunk test", "[World partition test]")
+	{
+		auto cell = MakeCell(-3, 7);
+		cell.objects[1].data.clear();
+		std::vector<char> chunk;
+		Lightning::World::WriteWorldCell(cell, chunk);
+
+		WorldCellData result;
+		REQUIRE(Lightning::World::ReadWorldCell(chunk.data(), chunk.size(), result));
+		REQUIRE(result.coord == cell.coord);
+		REQUIRE(result.objects.size() == cell.objects.size());
+		for (std::size_t i = 0;i < cell.objects.size();++i)
+		{
+			REQUIRE(result.objects[i].type == cell.objects[i].type);
+			REQUIRE(result.objects[i].position == cell.objects[i].position);
+			REQUIRE(result.objects[i].rotation.w == cell.objects[i].rotation.w);
+			REQUIRE(result.objects[i].scale == cell.objects[i].scale);
+			REQUIRE(result.objects[i].data == cell.objects[i].data);
+		}
+
+		//truncated and corrupted chunks are rejected
+		for (std::size_t size = 0;size < chunk.size();++size)
+		{
+			REQUIRE_FALSE(Lightning::World::ReadWorldCell(chunk.data(), size, result));
+		}
+		auto corrupted = chunk;
+		corrupted[0] ^= 0x1;
+		REQUIRE_FALSE(Lightning::World::ReadWorldCell(corrupted.data(), corrupted.size(), result));
+		corrupted = chunk;
+		//object count
+		corrupted[16] = '\x7f';
+		REQUIRE_FALSE(Lightning::World::ReadWorldCell(corrupted.data(), corrupted.size(), result));
+
+		//serializer writes a chunk and reads it back through a file,a chunk of another cell is rejected
+		auto saver = std::make_shared<WorldCellSerializer>(std::make_shared<WorldCellData>(cell));
+		auto buffer = saver->Serialize();
+		REQUIRE(buffer->GetBufferSize() == chunk.size());
+		REQUIRE(std::equal(chunk.begin(), chunk.end(), buffer->GetBuffer()));
+		FakeFile file("cell.wcell", chunk);
+		std::shared_ptr<WorldCellData> loaded;
+		std::size_t loadedSize{ 0 };
+		WorldCellSerializer loader(cell.coord, [&loaded, &loadedSize](const std::shared_ptr<WorldCellData>& data, std::size_t size) {
+			loaded = data;
+			loadedSize = size;
+		});
+		loader.Deserialize(&file, buffer);
+		REQUIRE(loaded);
+		REQUIRE(loaded->objects.size() == cell.objects.size());
+		REQUIRE(loadedSize == chunk.size());
+		WorldCellSerializer otherLoader(WorldCellCoord{ 0, 0 }, [&loaded](const std::shared_ptr<WorldCellData>& data, std::size_t size) {
+			loaded = data;
+		});
+		otherLoader.Deserialize(&file, buffer);
+		REQUIRE_FALSE(loaded);
+	}
+
+	TEST_CASE("World partition streaming test", "[World partition test]")
+	{
+		FakeFileSystem fileSystem;
+		FakeLoader loader(fileSystem);
+		RecordingHandler handler;
+		auto settings = MakeSettings();
+		WorldPartition partition(settings, loader, handler);
+		BuildWorld(fileSystem, partition);
+
+		//nearest cells are requested first and requests in flight are capped
+		Vector3f viewer{ 450.0f, 0.0f, 450.0f };
+		partition.Update(&viewer, 1);
+		REQUIRE(partition.GetStats().loadingCellCount == settings.maxInFlightLoads);
+		REQUIRE(loader.GetPendingCount() == settings.maxInFlightLoads);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ 4, 4 }) == WorldCellState::LOADING);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ 0, 0 }) == WorldCellState::UNLOADED);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ -1, 0 }) == WorldCellState::UNREGISTERED);
+		//cells are handed to handler in update,not on loader threads
+		loader.Pump();
+		REQUIRE(handler.mCells.empty());
+		partition.Update(&viewer, 1);
+		REQUIRE(handler.mCells.size() == settings.maxInFlightLoads);
+		REQUIRE(handler.mCells.count(std::make_pair(4, 4)) == 1);
+
+		Settle(partition, loader, &viewer, 1);
+		auto expected = CellsInRange(viewer, settings.loadRadius);
+		REQUIRE(handler.mCells == expected);
+		REQUIRE(partition.GetStats().loadedCellCount == expected.size());
+		REQUIRE(handler.mObjectCount == expected.size() * 4);
+
+		//moving a little doesn't unload cells within unload radius
+		Vector3f moved{ 520.0f, 0.0f, 450.0f };
+		Settle(partition, loader, &moved, 1);
+		for (const auto& cell : expected)
+		{
+			REQUIRE(handler.mCells.count(cell) == 1);
+		}
+		auto inRange = CellsInRange(moved, settings.loadRadius);
+		for (const auto& cell : inRange)
+		{
+			REQUIRE(handler.mCells.count(cell) == 1);
+		}
+
+		//two viewers keep the union of their cells,far cells are unloaded
+		Vector3f viewers[] = { Vector3f{ 1450.0f, 0.0f, 150.0f }, Vector3f{ 150.0f, 0.0f, 1450.0f } };
+		Settle(partition, loader, viewers, 2);
+		expected = CellsInRange(viewers[0], settings.loadRadius);
+		auto second = CellsInRange(viewers[1], settings.loadRadius);
+		expected.insert(second.begin(), second.end());
+		REQUIRE(handler.mCells == expected);
+		REQUIRE(handler.mErrors == 0);
+
+		partition.UnloadAll();
+		REQUIRE(handler.mCells.empty());
+		REQUIRE(partition.GetStats().residentMemory == 0);
+		REQUIRE(partition.GetStats().loadingMemory == 0);
+	}
+
+	TEST_CASE("World partition memory budget test", "[World partition test]")
+	{
+		FakeFileSystem fileSystem;
+		FakeLoader loader(fileSystem);
+		RecordingHandler handler;
+		auto settings = MakeSettings();
+		settings.loadRadius = 250.0f;
+		settings.unloadRadius = 400.0f;
+		std::vector<char> chunk;
+		Lightning::World::WriteWorldCell(MakeCell(0, 0), chunk);
+		//room for the 9 nearest cells
+		settings.memoryBudget = chunk.size() * 9;
+		WorldPartition partition(settings, loader, handler);
+		auto chunkSize = BuildWorld(fileSystem, partition);
+		REQUIRE(chunkSize == chunk.size());
+
+		Vector3f viewer{ 750.0f, 0.0f, 750.0f };
+		for (auto step = 0;step < 20;++step)
+		{
+			partition.Update(&viewer, 1);
+			const auto& stats = partition.GetStats();
+			REQUIRE(stats.residentMemory + stats.loadingMemory <= settings.memoryBudget);
+			loader.Pump(1);
+		}
+		Settle(partition, loader, &viewer, 1);
+		REQUIRE(handler.mCells == CellsInRange(viewer, CellSize * 0.75f));
+		REQUIRE(partition.GetStats().residentMemory == chunkSize * 9);
+
+		//walking away evicts farther cells in favor of the cells around viewer
+		for (auto step = 0;step < 40;++step)
+		{
+			viewer.x += 10.0f;
+			partition.Update(&viewer, 1);
+			const auto& stats = partition.GetStats();
+			REQUIRE(stats.residentMemory + stats.loadingMemory <= settings.memoryBudget);
+			loader.Pump();
+		}
+		Settle(partition, loader, &viewer, 1);
+		REQUIRE(handler.mCells == CellsInRange(viewer, CellSize * 0.75f));
+		REQUIRE(partition.GetStats().evictions > 0);
+		REQUIRE(handler.mErrors == 0);
+	}
+
+	TEST_CASE("World partition failure test", "[World partition test]")
+	{
+		FakeFileSystem fileSystem;
+		FakeLoader loader(fileSystem);
+		RecordingHandler handler;
+		auto settings = MakeSettings();
+		WorldPartition partition(settings, loader, handler);
+		BuildWorld(fileSystem, partition);
+		//a missing chunk is never answered by loader and a corrupted one fails to parse
+		fileSystem.mFiles.erase(GetCellPath(4, 4));
+		fileSystem.mFiles[GetCellPath(5, 4)].pop_back();
+
+		Vector3f viewer{ 450.0f, 0.0f, 450.0f };
+		Settle(partition, loader, &viewer, 1);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ 4, 4 }) == WorldCellState::UNLOADED);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ 5, 4 }) == WorldCellState::UNLOADED);
+		REQUIRE(partition.GetStats().failedLoads >= 2);
+		REQUIRE(partition.GetStats().loadingMemory == 0);
+		auto expected = CellsInRange(viewer, settings.loadRadius);
+		expected.erase(std::make_pair(4, 4));
+		expected.erase(std::make_pair(5, 4));
+		REQUIRE(handler.mCells == expected);
+
+		//failed cells are retried later
+		WorldCellData cell = MakeCell(4, 4);
+		Lightning::World::WriteWorldCell(cell, fileSystem.mFiles[GetCellPath(4, 4)]);
+		for (std::size_t i = 0;i <= settings.loadTimeoutUpdates;++i)
+		{
+			partition.Update(&viewer, 1);
+			loader.Pump();
+		}
+		Settle(partition, loader, &viewer, 1);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ 4, 4 }) == WorldCellState::LOADED);
+		REQUIRE(handler.mCells.count(std::make_pair(4, 4)) == 1);
+
+		//loads finishing after viewer left are discarded,loads of unregistered cells are ignored
+		Vector3f far{ 1450.0f, 0.0f, 1450.0f };
+		partition.Update(&far, 1);
+		REQUIRE(loader.GetPendingCount() > 0);
+		partition.UnregisterCell(WorldCellCoord{ 14, 14 });
+		Vector3f back{ 450.0f, 0.0f, 450.0f };
+		auto discarded = partition.GetStats().discardedLoads;
+		Settle(partition, loader, &back, 1);
+		REQUIRE(partition.GetStats().discardedLoads == discarded + settings.maxInFlightLoads - 1);
+		REQUIRE(partition.GetCellState(WorldCellCoord{ 14, 14 }) == WorldCellState::UNREGISTERED);
+		REQUIRE(handler.mErrors == 0);
+	}
+}
@@ -6,6 +6,6 @@ namespace Lightning
 	namespace Asset
 	{
 		constexpr std::uint32_t MESH_IDENTITY = 0x7b222177;	//just a random number
-		constexpr std::uint32_t MESH_VERSION = 1;
+		constexpr std::uint32_t MESH_VERSION = 2;
 	}
 }
\ No newline at end of file
@@ -9,6 +9,8 @@ namespace Lightning
 		//Maximum number of vertex streams.Note position/normal/tangent/bitangent also accounts to stream count.
 		//eg.Position + Normal + Tangents + Bitangents + Other vertex attributes cannot exceed MaxVertexStreams.
 		constexpr std::uint8_t MaxVertexStreams = 16u;
+		//Maximum number of simplified levels stored with a mesh,not counting the mesh itself
+		constexpr std::uint8_t MaxLodLevels = 4u;
 
 		struct MeshesHeader
 		{
@@ -26,6 +28,16 @@ namespace Lightning
 
 		static_assert(std::is_pod<VertexStream>::value, "VertexStream must be a POD type.");
 
+		//A simplified level of a mesh.Levels share the vertex streams of the mesh and only have index data of their own
+		struct MeshLod
+		{
+			std::uint32_t IndexOffset;		//measured in offset from file begin
+			std::uint32_t IndexCount;
+			float Error;					//largest distance between the level and the full mesh surface,in mesh units
+		};
+
+		static_assert(std::is_pod<MeshLod>::value, "MeshLod must be a POD type.");
+
 		struct MeshHeader
 		{
 			std::uint8_t PrimitiveType;		//Triangle?Or other types of primitives
@@ -39,6 +51,8 @@ namespace Lightning
 			VertexStream Tangents;			//point to the start of tangent data, measured in offset from file begin, 0 if not present
 			VertexStream Bitagents;			
 			VertexStream MiscStreams[MaxVertexStreams];	//streams other than the above position/normal/tagent/bitangent streams, can be color stream, uv stream etc.
+			std::uint8_t LodCount;			//number of valid entries in Lods
+			MeshLod Lods[MaxLodLevels];		//simplified levels from fine to coarse,index data has the same IndexSize as the mesh
 		};
 		
 		static_assert(std::is_pod<MeshHeader>::value, "MeshHeader must be a POD type.");
@@ -26,6 +26,8 @@ namespace Lightning
 			Matrix4f GetViewMatrix()const override{ return mTransform.GlobalToLocalMatrix4(); }
 			Matrix4f GetProjectionMatrix()const override{ return mProjectionMatrix; }
 			Matrix4f GetInvViewMatrix()const override{ return mTransform.LocalToGlobalMatrix4(); }
+			//view matrix is built from local transform as well
+			Foundation::Math::Vector3d GetPrecisePosition()const override{ return GetPreciseLocalPosition(); }
 			void SetNear(const float nearPlane)override;
 			void SetFar(const float farPlane)override;
 			float GetNear()const override{ return mNearPlane; }
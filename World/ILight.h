@@ -0,0 +1,30 @@
+#pragma once
+#include "ISpaceObject.h"
+#include "Light/LightData.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		using Render::LightType;
+		using Render::LightData;
+		using Render::ColorF;
+		//A dynamic light lit from its global position along its forward direction
+		struct ILight : virtual ISpaceObject
+		{
+			virtual void SetLightType(LightType type) = 0;
+			virtual LightType GetLightType()const = 0;
+			virtual void SetColor(const ColorF& color) = 0;
+			virtual ColorF GetColor()const = 0;
+			virtual void SetIntensity(const float intensity) = 0;
+			virtual float GetIntensity()const = 0;
+			virtual void SetRange(const float range) = 0;
+			virtual float GetRange()const = 0;
+			//Set half angle of spot light cone in degrees
+			virtual void SetSpotAngle(const float angle) = 0;
+			virtual float GetSpotAngle()const = 0;
+			//Light parameters in world space submitted to renderer
+			virtual LightData GetLightData()const = 0;
+		};
+	}
+}
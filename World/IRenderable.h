@@ -2,6 +2,8 @@
 #include "IDrawable.h"
 #include "IRenderer.h"
 #include "ICamera.h"
+#include "SpatialIndex.h"
+#include "RenderableRegistry.h"
 
 namespace Lightning
 {
@@ -15,6 +17,21 @@ namespace Lightning
 			virtual bool NeedRender()const = 0;
 			//Send render request to the renderer.A draw called is expected to be issued by the underlying renderer after this call.
 			virtual void Render(Render::IRenderer& renderer, const std::shared_ptr<Render::ICamera>& camera) = 0;
+			//Retained mode.While the renderable is attached under a scene root it's in the registry of the scene,from AddToRegistry
+			//to RemoveFromRegistry.It keeps its world bounds in the spatial index of the registry,and a render proxy if a renderer
+			//is passed.SyncRenderProxy and SyncSpatialBounds send what changed since last sync.These methods are thread unsafe.
+			virtual void AddToRegistry(const std::shared_ptr<RenderableRegistry>& registry, Render::IRenderer* renderer) = 0;
+			virtual void RemoveFromRegistry(Render::IRenderer* renderer) = 0;
+			virtual void SyncRenderProxy(Render::IRenderer& renderer) = 0;
+			virtual void SyncSpatialBounds() = 0;
+			//nullptr if the renderable is not in a registry or the scene of the registry is destroyed
+			virtual std::shared_ptr<RenderableRegistry> GetRegistry()const = 0;
+			//INVALID_SPATIAL_HANDLE if the renderable is not in a spatial index
+			virtual SpatialHandle GetSpatialHandle()const = 0;
+			//Occluders are rasterized into the CPU occlusion buffer to hide drawables behind them.
+			//Only large,simple and static objects such as walls and buildings should be occluders.
+			virtual void SetOccluder(bool occluder) = 0;
+			virtual bool IsOccluder()const = 0;
 		};
 	}
 }
\ No newline at end of file
@@ -2,17 +2,29 @@
 #include <cstdint>
 #include "ISpaceCamera.h"
 #include "ISpaceObject.h"
+#include "ILight.h"
+#include "WorldPartition.h"
+#include "SpatialIndex.h"
 
 namespace Lightning
 {
 	namespace World
 	{
 		using Render::ICamera;
+		struct IRenderable;
 		struct IScene : virtual ISpaceObject
 		{
 			virtual void Tick() = 0;
 			virtual ISpaceCamera* GetActiveCamera() = 0;
 			virtual ISpaceCamera* CreateCamera() = 0;
+			virtual ILight* CreateLight(LightType type) = 0;
+			//Cells of partition are streamed around cameras of scene every tick.Pass nullptr to stop streaming
+			virtual void SetWorldPartition(const std::shared_ptr<WorldPartition>& partition) = 0;
+			//World bounds of renderables attached under the scene,up to date after SpaceObjectManager::Synchronize.
+			//Queries must not run concurrently with Synchronize
+			virtual const SpatialIndex& GetSpatialIndex()const = 0;
+			//Renderable of a handle returned by spatial index queries
+			virtual std::shared_ptr<IRenderable> GetIndexedRenderable(SpatialHandle handle)const = 0;
 		};
 	}
 }
\ No newline at end of file
@@ -11,11 +11,17 @@ namespace Lightning
 		using Foundation::Math::Transform;
 		using Foundation::Math::Matrix4f;
 		using Foundation::Math::Vector3f;
+		using Foundation::Math::Vector3d;
 		using Foundation::Math::Quaternionf;
+		//Parents are visited before their children with all policies
 		enum class SpaceObjectTraversalPolocy
 		{
+			//depth first on the calling thread
 			Sequential,
-			Concurrent
+			//subtrees are visited by worker threads,so the visitor must be thread safe
+			Concurrent,
+			//level by level on the calling thread
+			BreadthFirst
 		};
 
 		struct ISpaceObject
@@ -35,6 +41,11 @@ namespace Lightning
 			virtual void SetGlobalPosition(const Vector3f& position) = 0;
 			virtual void SetGlobalRotation(const Quaternionf& rotation) = 0;
 			virtual void SetGlobalScale(const Vector3f& scale) = 0;
+			//Sets local position in double precision for large worlds.Local transform gets the position rounded to float,
+			//the precise one is used as long as the position of local transform isn't changed by other means
+			virtual void SetPrecisePosition(const Vector3d& position) = 0;
+			//Global position in double precision,the position of global transform is this value rounded to float
+			virtual Vector3d GetPreciseGlobalPosition()const = 0;
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <cassert>
+#include "Light.h"
+#include "Common.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		using Foundation::Math::DegreesToRadians;
+
+		Light::Light(LightType type) : mType(type), mColor{ 1.0f, 1.0f, 1.0f, 1.0f }, mIntensity(1.0f), mRange(10.0f),
+			mSpotAngle(DegreesToRadians(30.0f))
+		{
+
+		}
+
+		Light::~Light()
+		{
+
+		}
+
+		void Light::SetRange(const float range)
+		{
+			assert(range > 0 && "Light range must be positive!");
+			mRange = range;
+		}
+
+		void Light::SetSpotAngle(const float angle)
+		{
+			assert(angle > 0 && angle < 90.0f && "Spot angle must be in (0, 90) degrees!");
+			mSpotAngle = DegreesToRadians(angle);
+		}
+
+		LightData Light::GetLightData()const
+		{
+			auto transform = GetGlobalTransform();
+			LightData data;
+			data.type = mType;
+			data.position = transform.GetPosition();
+			data.direction = transform.Forward();
+			data.color = mColor;
+			data.intensity = mIntensity;
+			data.range = mRange;
+			data.spotAngle = mSpotAngle;
+			return data;
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "ILight.h"
+#include "SpaceObject.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		class Light : public SpaceObject<ILight, Light>
+		{
+		public:
+			Light(LightType type = LightType::POINT);
+			~Light()override;
+			void SetLightType(LightType type)override { mType = type; }
+			LightType GetLightType()const override { return mType; }
+			void SetColor(const ColorF& color)override { mColor = color; }
+			ColorF GetColor()const override { return mColor; }
+			void SetIntensity(const float intensity)override { mIntensity = intensity; }
+			float GetIntensity()const override { return mIntensity; }
+			void SetRange(const float range)override;
+			float GetRange()const override { return mRange; }
+			//Set half angle of spot light cone in degrees
+			void SetSpotAngle(const float angle)override;
+			float GetSpotAngle()const override{ return Foundation::Math::RadiansToDegrees(mSpotAngle); }
+			LightData GetLightData()const override;
+		protected:
+			LightType mType;
+			ColorF mColor;
+			float mIntensity;
+			float mRange;
+			//half angle in radians
+			float mSpotAngle;
+		};
+	}
+}
@@ -42,7 +42,7 @@ namespace Lightning
 		void Primitive::SetColor(const Color32& color)
 		{
 			mColor = color;
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::SetColor(std::uint32_t color)
@@ -51,7 +51,7 @@ namespace Lightning
 			mColor.r = static_cast<std::uint8_t>((color & 0x00ff0000) >> 16);
 			mColor.g = static_cast<std::uint8_t>((color & 0x0000ff00) >> 8);
 			mColor.b = static_cast<std::uint8_t>(color & 0x000000ff);
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::SetColor(float a, float r, float g, float b)
@@ -60,7 +60,7 @@ namespace Lightning
 			mColor.r = static_cast<std::uint8_t>(r * 255);
 			mColor.g = static_cast<std::uint8_t>(g * 255);
 			mColor.b = static_cast<std::uint8_t>(b * 255);
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::GetColor(float& a, float& r, float& g, float& b)
@@ -74,25 +74,25 @@ namespace Lightning
 		void Primitive::SetTransparency(std::uint8_t transparency)
 		{
 			mColor.a = transparency;
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::SetTransparency(float transparency)
 		{
 			mColor.a = static_cast<std::uint8_t>(255 * transparency);
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::SetTexture(const std::string& name, const std::shared_ptr<ITexture>& texture)
 		{
 			mMaterial->SetParameter(name, texture);
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::SetSamplerState(const std::string& name, const SamplerState& state)
 		{
 			mMaterial->SetParameter(name, state);
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
 		}
 
 		void Primitive::SetShader(const std::shared_ptr<IShader>& shader)
@@ -100,7 +100,20 @@ namespace Lightning
 			if (!shader)
 				return;
 			mMaterial->SetShader(shader->GetType(), shader);
-			mRenderResourceDirty = true;
+			SetRenderResourceDirty();
+		}
+
+		bool Primitive::GetOccluderGeometry(Render::OccluderGeometry& geometry)const
+		{
+			if (!mOccluder)
+				return false;
+			//vertices are interleaved position and normal
+			geometry.positions = GetVertices();
+			geometry.stride = 2 * sizeof(Vector3f);
+			geometry.vertexCount = GetVertexBufferSize() / geometry.stride;
+			geometry.indices = GetIndices();
+			geometry.indexCount = GetIndexBufferSize() / sizeof(std::uint16_t);
+			return true;
 		}
 
 		void Primitive::UpdateRenderResources()
@@ -128,16 +141,14 @@ namespace Lightning
 			auto ibSize = GetIndexBufferSize();
 			descriptor.components = &components[0];
 			descriptor.componentCount = components.size();
-			mVertexBuffers.emplace_back(pDevice->CreateVertexBuffer(static_cast<std::uint32_t>(vbSize), descriptor));
-			mIndexBuffer = pDevice->CreateIndexBuffer(static_cast<std::uint32_t>(ibSize), Render::IndexType::UINT16);
-			
-			auto mem = mVertexBuffers.back()->Lock(0, vbSize);
-			std::memcpy(mem, GetVertices(), vbSize);
-			mVertexBuffers.back()->Unlock(0, vbSize);
+			//primitives of the same type share geometry,size is applied by the transform
+			mVertexBuffers.clear();
+			mVertexBuffers.emplace_back(pDevice->GetSharedVertexBuffer(GetVertices(), static_cast<std::uint32_t>(vbSize), descriptor));
+			mIndexBuffer = pDevice->GetSharedIndexBuffer(GetIndices(), static_cast<std::uint32_t>(ibSize), Render::IndexType::UINT16);
 
-			mem = mIndexBuffer->Lock(0, ibSize);
-			std::memcpy(mem, GetIndices(), ibSize);
-			mIndexBuffer->Unlock(0, ibSize);
+			//vertices are interleaved position and normal
+			mLocalBoundingBox = Foundation::Math::AABBf::FromPoints(GetVertices(), 
+				vbSize / (2 * sizeof(Vector3f)), 2 * sizeof(Vector3f));
 
 			float a, r, g, b;
 			GetColor(a, r, g, b);
@@ -145,7 +156,6 @@ namespace Lightning
 			mMaterial->SetParameter("light", Vector3f{ 3, 3, 3 });
 
 			mMaterial->EnableBlend(mColor.a != 0xff);
-			mTransform.SetScale(GetScale());
 		}
 
 		//Cube
@@ -225,6 +235,7 @@ namespace Lightning
 			mWidth(width), mHeight(height), mThickness(thickness)
 		{
 			assert(mWidth > 0 && mHeight > 0 && mThickness > 0 && "The size of the cube must be greater than 0!");
+			GetLocalTransform().SetScale(GetScale());
 		}
 
 		void Cube::UpdateRenderResources()
@@ -245,11 +256,7 @@ namespace Lightning
 				compTexcoord.semantic = Render::RenderSemantics::TEXCOORD0;
 				components.push_back(compTexcoord);
 				auto pDevice = renderer->GetDevice();
-				auto uvBufferSize = sizeof(Vector2f) * 24;
-				descriptor.components = &components[0];
-				descriptor.componentCount = components.size();
-				mVertexBuffers.emplace_back(pDevice->CreateVertexBuffer(static_cast<std::uint32_t>(uvBufferSize), descriptor));
-				auto uv = reinterpret_cast<Vector2f*>(mVertexBuffers.back()->Lock(0, uvBufferSize));
+				Vector2f uv[24];
 				for (auto i = 0;i < 24;i += 4)
 				{
 					uv[i].x = 0.f; uv[i].y = 0.f; 
@@ -257,8 +264,9 @@ namespace Lightning
 					uv[i + 2].x = 1.f; uv[i + 2].y = 1.f;
 					uv[i + 3].x = 0.f; uv[i + 3].y = 1.f;
 				}
-
-				mVertexBuffers.back()->Unlock(0, uvBufferSize);
+				descriptor.components = &components[0];
+				descriptor.componentCount = components.size();
+				mVertexBuffers.emplace_back(pDevice->GetSharedVertexBuffer(uv, static_cast<std::uint32_t>(sizeof(uv)), descriptor));
 				//apply texture to material
 			}
 		}
@@ -347,6 +355,7 @@ namespace Lightning
 		Cylinder::Cylinder(float height, float radius) :mHeight(height), mRadius(radius)
 		{
 			assert(height > 0 && radius > 0 && "height and radius of a cylinder must be positive!");
+			GetLocalTransform().SetScale(GetScale());
 		}
 		//Cylinder
 
@@ -355,6 +364,7 @@ namespace Lightning
 		Hemisphere::Hemisphere(float radius) :mRadius(radius)
 		{
 			assert(radius > 0 && "radius must be positive");
+			GetLocalTransform().SetScale(GetScale());
 		}
 
 		Hemisphere::HemisphereDataSource::HemisphereDataSource()
@@ -28,13 +28,15 @@ namespace Lightning
 			void SetTexture(const std::string& name, const std::shared_ptr<ITexture>& texture)override;
 			void SetSamplerState(const std::string& name, const SamplerState& state)override;
 			void SetShader(const std::shared_ptr<IShader>& shader)override;
+			bool GetOccluderGeometry(Render::OccluderGeometry& geometry)const override;
 		protected:
 			void UpdateRenderResources()override;
-			virtual std::uint8_t *GetVertices() = 0;
-			virtual std::uint16_t *GetIndices() = 0;
+			virtual std::uint8_t *GetVertices()const = 0;
+			virtual std::uint16_t *GetIndices()const = 0;
+			//size of the shape,set as the local scale once on creation so later scaling by users is kept
 			virtual Vector3f GetScale() = 0;
-			virtual std::size_t GetVertexBufferSize() = 0;
-			virtual std::size_t GetIndexBufferSize() = 0;
+			virtual std::size_t GetVertexBufferSize()const = 0;
+			virtual std::size_t GetIndexBufferSize()const = 0;
 			Color32 mColor;
 		};
 
@@ -58,11 +60,11 @@ namespace Lightning
 			Cube(float width = 1.0f, float height = 1.0f, float thickness = 1.0f);
 		protected:
 			void UpdateRenderResources()override;
-			std::uint8_t *GetVertices() override { return sDataSource.vertices; }
-			std::uint16_t *GetIndices() override { return sDataSource.indices; }
+			std::uint8_t *GetVertices()const override { return sDataSource.vertices; }
+			std::uint16_t *GetIndices()const override { return sDataSource.indices; }
 			Vector3f GetScale() override { return Vector3f{mWidth, mHeight, mThickness}; }
-			std::size_t GetVertexBufferSize() override { return sizeof(Vector3f) * 48; }
-			std::size_t GetIndexBufferSize() override { return sizeof(std::uint16_t) * 36; }
+			std::size_t GetVertexBufferSize()const override { return sizeof(Vector3f) * 48; }
+			std::size_t GetIndexBufferSize()const override { return sizeof(std::uint16_t) * 36; }
 			float mWidth;
 			float mHeight;
 			float mThickness;
@@ -75,11 +77,11 @@ namespace Lightning
 		public:
 			Cylinder(float height, float radius);
 		protected:
-			std::uint8_t *GetVertices() override { return sDataSource.vertices; }
-			std::uint16_t *GetIndices() override { return sDataSource.indices; }
+			std::uint8_t *GetVertices()const override { return sDataSource.vertices; }
+			std::uint16_t *GetIndices()const override { return sDataSource.indices; }
 			Vector3f GetScale() override { return Vector3f{mRadius, mHeight, mRadius}; }
-			std::size_t GetVertexBufferSize() override { return 2 * sizeof(Vector3f) * GetVertexCount(); }
-			std::size_t GetIndexBufferSize() override { return sizeof(std::uint16_t) * GetIndexCount(); }
+			std::size_t GetVertexBufferSize()const override { return 2 * sizeof(Vector3f) * GetVertexCount(); }
+			std::size_t GetIndexBufferSize()const override { return sizeof(std::uint16_t) * GetIndexCount(); }
 			float mHeight;
 			float mRadius;
 			struct CylinderDataSource : PrimitiveDataSource { CylinderDataSource(); };
@@ -95,11 +97,11 @@ namespace Lightning
 		public:
 			Hemisphere(float radius = 1.0f);
 		protected:
-			std::uint8_t *GetVertices() override { return sDataSource.vertices; }
-			std::uint16_t *GetIndices() override { return sDataSource.indices; }
+			std::uint8_t *GetVertices()const override { return sDataSource.vertices; }
+			std::uint16_t *GetIndices()const override { return sDataSource.indices; }
 			Vector3f GetScale() override { return Vector3f{mRadius, mRadius, mRadius}; }
-			std::size_t GetVertexBufferSize() override { return 2 * sizeof(Vector3f) * GetVertexCount(); }
-			std::size_t GetIndexBufferSize() override { return sizeof(std::uint16_t) * GetIndexCount(); }
+			std::size_t GetVertexBufferSize()const override { return 2 * sizeof(Vector3f) * GetVertexCount(); }
+			std::size_t GetIndexBufferSize()const override { return sizeof(std::uint16_t) * GetIndexCount(); }
 			float mRadius;
 			struct HemisphereDataSource : PrimitiveDataSource { HemisphereDataSource(); };
 			static HemisphereDataSource sDataSource;
@@ -119,10 +121,10 @@ namespace Lightning
 		public:
 			Sphere(float radius = 1.0f);
 		protected:
-			std::uint8_t *GetVertices() override { return vertices; }
-			std::uint16_t *GetIndices() override { return indices; }
-			std::size_t GetVertexBufferSize() override { return Hemisphere::GetVertexBufferSize() * 2; }
-			std::size_t GetIndexBufferSize() override { return Hemisphere::GetIndexBufferSize() * 2; }
+			std::uint8_t *GetVertices()const override { return vertices; }
+			std::uint16_t *GetIndices()const override { return indices; }
+			std::size_t GetVertexBufferSize()const override { return Hemisphere::GetVertexBufferSize() * 2; }
+			std::size_t GetIndexBufferSize()const override { return Hemisphere::GetIndexBufferSize() * 2; }
 			void InitVerticeAndIndice();
 			static std::uint8_t *vertices;
 			static std::uint16_t *indices;
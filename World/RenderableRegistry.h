@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Proxy/RenderProxyTable.h"
+#include "SpatialIndex.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		struct IRenderable;
+		//Render proxies and spatial index entries of the renderables attached under a scene root.Each scene owns one and
+		//renderables only keep a weak reference to it,so the entries of a destroyed scene are released along with it.Thread unsafe
+		class RenderableRegistry
+		{
+		public:
+			RenderableRegistry() : mRenderProxies(std::make_shared<Render::RenderProxyTable>()){}
+			//Shared with render passes,which hold it until the frames it's drawn in are rendered
+			const std::shared_ptr<Render::RenderProxyTable>& GetRenderProxies()const { return mRenderProxies; }
+			//World bounds of the renderables,up to date after SpaceObjectManager::Synchronize.
+			//Queries must not run concurrently with Synchronize
+			const SpatialIndex& GetSpatialIndex()const { return mSpatialIndex; }
+			//Renderable of a handle returned by spatial index queries
+			std::shared_ptr<IRenderable> GetIndexedRenderable(SpatialHandle handle)const
+			{
+				if (handle >= mIndexedRenderables.size())
+					return nullptr;
+				return mIndexedRenderables[handle].lock();
+			}
+			//The following methods are used by renderables to keep their bounds in the spatial index
+			SpatialHandle Insert(const std::shared_ptr<IRenderable>& renderable, const AABBf& bounds)
+			{
+				auto handle = mSpatialIndex.Insert(bounds);
+				if (handle >= mIndexedRenderables.size())
+					mIndexedRenderables.resize(handle + 1);
+				mIndexedRenderables[handle] = renderable;
+				return handle;
+			}
+			void Remove(SpatialHandle handle)
+			{
+				mSpatialIndex.Remove(handle);
+				mIndexedRenderables[handle].reset();
+			}
+			void Update(SpatialHandle handle, const AABBf& bounds)
+			{
+				mSpatialIndex.Update(handle, bounds);
+			}
+		private:
+			std::shared_ptr<Render::RenderProxyTable> mRenderProxies;
+			SpatialIndex mSpatialIndex;
+			//indexed by spatial handle
+			std::vector<std::weak_ptr<IRenderable>> mIndexedRenderables;
+		};
+	}
+}
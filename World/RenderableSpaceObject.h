@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include "SpaceObject.h"
 #include "IRenderable.h"
 
@@ -11,9 +12,19 @@ namespace Lightning
 		{
 			static_assert(std::is_base_of<IRenderable, Interface>::value, "Interface must be a subclass of IRenderable.");
 		public:
-			RenderableSpaceObject() : mRenderResourceDirty(true){}
+			RenderableSpaceObject() : mLocalBoundingBox(Foundation::Math::AABBf::Infinite()), mRenderResourceDirty(true), mOccluder(false)
+				, mRenderProxy(Render::INVALID_RENDER_PROXY_HANDLE), mRenderProxyDirtyFlags(0)
+				, mSpatialHandle(INVALID_SPATIAL_HANDLE), mSpatialBoundsDirty(false){}
 			bool NeedRender()const override { return true; }
-			const Transform GetDrawTransform()const override { return GetGlobalTransform(); }
+			const Transform GetDrawTransform()const override { return this->GetCachedGlobalTransform(); }
+			Foundation::Math::Vector3d GetPreciseDrawPosition()const override { return this->GetCachedPreciseGlobalPosition(); }
+			Foundation::Math::AABBf GetWorldBoundingBox()const override
+			{
+				return mLocalBoundingBox.Transformed(this->GetCachedGlobalTransform().GetMatrix());
+			}
+			bool GetOccluderGeometry(Render::OccluderGeometry& geometry)const override { return false; }
+			void SetOccluder(bool occluder)override { mOccluder = occluder; }
+			bool IsOccluder()const override { return mOccluder; }
 			std::shared_ptr<Render::IIndexBuffer> GetIndexBuffer()const override { return mIndexBuffer; }
 			const std::vector<std::shared_ptr<Render::IVertexBuffer>>& GetVertexBuffers()const override
 			{
@@ -31,12 +42,118 @@ namespace Lightning
 				}
 				renderer.Draw(shared_from_this(), camera);
 			}
+			void AddToRegistry(const std::shared_ptr<RenderableRegistry>& registry, Render::IRenderer* renderer)override
+			{
+				//handles of a destroyed registry are stale,so they are simply overwritten
+				assert(!GetRegistry() && "Renderable must be removed from its registry first!");
+				mRegistry = registry;
+				mRenderProxy = Render::INVALID_RENDER_PROXY_HANDLE;
+				//the proxy is added first since adding it builds render resources along with local bounds
+				if (renderer)
+				{
+					if (mRenderResourceDirty)
+					{
+						mRenderResourceDirty = false;
+						UpdateRenderResources();
+					}
+					mRenderProxyDirtyFlags = 0;
+					mRenderProxy = renderer->AddRenderProxy(*registry->GetRenderProxies(), shared_from_this());
+				}
+				mSpatialBoundsDirty = false;
+				mSpatialHandle = registry->Insert(shared_from_this(), GetSpatialBounds());
+			}
+			void RemoveFromRegistry(Render::IRenderer* renderer)override
+			{
+				auto registry = mRegistry.lock();
+				if (registry)
+				{
+					if (renderer && mRenderProxy != Render::INVALID_RENDER_PROXY_HANDLE)
+						renderer->RemoveRenderProxy(*registry->GetRenderProxies(), mRenderProxy);
+					registry->Remove(mSpatialHandle);
+				}
+				mRenderProxy = Render::INVALID_RENDER_PROXY_HANDLE;
+				mSpatialHandle = INVALID_SPATIAL_HANDLE;
+				mRegistry.reset();
+			}
+			void SyncRenderProxy(Render::IRenderer& renderer)override
+			{
+				auto flags = static_cast<Render::RenderProxyDirtyFlags>(mRenderProxyDirtyFlags.exchange(0));
+				auto registry = mRegistry.lock();
+				if (!registry || mRenderProxy == Render::INVALID_RENDER_PROXY_HANDLE)
+					return;
+				if (mRenderResourceDirty)
+				{
+					mRenderResourceDirty = false;
+					UpdateRenderResources();
+					//local bounds may be changed along with vertices
+					flags |= Render::RenderProxyDirtyFlags::TRANSFORM;
+					MarkSpatialBoundsDirty();
+				}
+				renderer.UpdateRenderProxy(*registry->GetRenderProxies(), mRenderProxy, flags);
+			}
+			std::shared_ptr<RenderableRegistry> GetRegistry()const override { return mRegistry.lock(); }
+			void SyncSpatialBounds()override
+			{
+				mSpatialBoundsDirty = false;
+				auto registry = mRegistry.lock();
+				if (!registry || mSpatialHandle == INVALID_SPATIAL_HANDLE)
+					return;
+				registry->Update(mSpatialHandle, GetSpatialBounds());
+			}
+			//the handle is stale once the scene of the registry is destroyed
+			SpatialHandle GetSpatialHandle()const override { return mRegistry.expired() ? INVALID_SPATIAL_HANDLE : mSpatialHandle; }
 		protected:
 			virtual void UpdateRenderResources() = 0;
+			void OnTransformChanged()override
+			{
+				MarkRenderProxyDirty(Render::RenderProxyDirtyFlags::TRANSFORM);
+				MarkSpatialBoundsDirty();
+			}
+			//Render resources are rebuilt at next Render or SyncRenderProxy
+			void SetRenderResourceDirty()
+			{
+				mRenderResourceDirty = true;
+				MarkRenderProxyDirty(Render::RenderProxyDirtyFlags::MATERIAL);
+			}
+			//Queues the object for SyncRenderProxy when it's marked dirty for the first time since last sync.Thread safe
+			void MarkRenderProxyDirty(Render::RenderProxyDirtyFlags flags)
+			{
+				auto previousFlags = mRenderProxyDirtyFlags.fetch_or(static_cast<std::uint8_t>(flags));
+				if (previousFlags == 0 && mRenderProxy != Render::INVALID_RENDER_PROXY_HANDLE)
+				{
+					SpaceObjectManager::Instance()->AddDirtyRenderable(shared_from_this());
+				}
+			}
+			//Queues the object for SyncSpatialBounds when it moves for the first time since last sync.Thread safe
+			void MarkSpatialBoundsDirty()
+			{
+				if (mSpatialHandle != INVALID_SPATIAL_HANDLE && !mSpatialBoundsDirty.exchange(true))
+				{
+					SpaceObjectManager::Instance()->AddMovedRenderable(shared_from_this());
+				}
+			}
+			//Objects without vertices are indexed as points at their positions
+			Foundation::Math::AABBf GetSpatialBounds()const
+			{
+				auto bounds = GetWorldBoundingBox();
+				if (!bounds.IsEmpty())
+					return bounds;
+				auto position = this->GetCachedGlobalTransform().GetPosition();
+				return Foundation::Math::AABBf{ position, position };
+			}
 			std::shared_ptr<Render::IIndexBuffer> mIndexBuffer;
 			std::vector<std::shared_ptr<Render::IVertexBuffer>> mVertexBuffers;
 			std::shared_ptr<Render::IMaterial> mMaterial;
+			//bounds of vertices in local space.Should be updated by subclasses along with render resources
+			Foundation::Math::AABBf mLocalBoundingBox;
 			bool mRenderResourceDirty;
+			bool mOccluder;
+			//registry of the scene the renderable is attached to,owned by the scene
+			std::weak_ptr<RenderableRegistry> mRegistry;
+			Render::RenderProxyHandle mRenderProxy;
+			std::atomic<std::uint8_t> mRenderProxyDirtyFlags;
+			SpatialHandle mSpatialHandle;
+			std::atomic<bool> mSpatialBoundsDirty;
 		};
 	}
 }
@@ -3,13 +3,14 @@
 #include "IRenderPlugin.h"
 #include "IRenderable.h"
 #include "Camera.h"
+#include "Light.h"
 
 namespace Lightning
 {
 	namespace World
 	{
 		extern Plugins::IRenderPlugin* gRenderPlugin;
-		Scene::Scene()
+		Scene::Scene() : mRenderables(std::make_shared<RenderableRegistry>())
 		{
 		}
 
@@ -32,9 +33,39 @@ namespace Lightning
 			return camera.get();
 		}
 
+		ILight* Scene::CreateLight(LightType type)
+		{
+			auto light = std::make_shared<Light>(type);
+			AddChild(light);
+			mLights.emplace_back(light);
+			return light.get();
+		}
+
+		void Scene::SetWorldPartition(const std::shared_ptr<WorldPartition>& partition)
+		{
+			mWorldPartition = partition;
+		}
+
 		void Scene::Tick()
 		{
 			auto renderer = gRenderPlugin->GetRenderer();
+			if (mWorldPartition)
+			{
+				//Cells loaded during this tick are spawned before global transforms are updated
+				mViewerPositions.clear();
+				for (const auto& camera : mCameras)
+				{
+					mViewerPositions.push_back(camera->GetGlobalTransform().GetPosition());
+				}
+				mWorldPartition->Update(mViewerPositions.data(), mViewerPositions.size());
+			}
+			//World matrices changed since last frame are computed once here by the transform system,render proxies read them
+			UpdateGlobalTransforms();
+			//Lights are binned into clusters of the view by render passes
+			for (const auto& light : mLights)
+			{
+				renderer->DrawLight(light->GetLightData());
+			}
 			for (const auto& camera : mCameras)
 			{
 				auto window = renderer->GetOutputWindow();
@@ -45,12 +76,9 @@ namespace Lightning
 					auto aspectRatio = float(width) / height;
 					camera->SetAspectRatio(aspectRatio);
 				}
-				Traverse([this, renderer, &camera](const std::shared_ptr<ISpaceObject>& spaceObject) {
-					if (auto renderable = std::dynamic_pointer_cast<IRenderable>(spaceObject))
-					{
-						renderable->Render(*renderer, camera);
-					}
-				}, SpaceObjectTraversalPolocy::Concurrent);
+				//Renderables keep render proxies in the registry of the scene,so there's no need to traverse the scene every frame.
+				//Proxies of all cameras are culled together by render passes
+				renderer->DrawRenderProxies(mRenderables->GetRenderProxies(), camera);
 			}
 		}
 	}
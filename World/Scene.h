@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <vector>
 #include "SpaceObject.h"
+#include "RenderableRegistry.h"
 #include "IScene.h"
 
 namespace Lightning
@@ -16,8 +17,18 @@ namespace Lightning
 			void Tick()override;
 			ISpaceCamera* GetActiveCamera()override;
 			ISpaceCamera* CreateCamera()override;
+			ILight* CreateLight(LightType type)override;
+			void SetWorldPartition(const std::shared_ptr<WorldPartition>& partition)override;
+			const SpatialIndex& GetSpatialIndex()const override { return mRenderables->GetSpatialIndex(); }
+			std::shared_ptr<IRenderable> GetIndexedRenderable(SpatialHandle handle)const override { return mRenderables->GetIndexedRenderable(handle); }
 		protected:
+			std::shared_ptr<RenderableRegistry> GetRenderableRegistry()const override { return mRenderables; }
+			//Renderables attached under the scene,released with the scene
+			std::shared_ptr<RenderableRegistry> mRenderables;
 			std::vector<std::shared_ptr<ISpaceCamera>> mCameras;
+			std::vector<std::shared_ptr<ILight>> mLights;
+			std::shared_ptr<WorldPartition> mWorldPartition;
+			std::vector<Vector3f> mViewerPositions;
 		};
 	}
 }
@@ -21,6 +21,7 @@ namespace Lightning
 			auto it = mScenes.find(sceneId);
 			if (it != mScenes.end())
 			{
+				//render proxies of the scene are released along with its renderable registry
 				mScenes.erase(it);
 			}
 		}
@@ -28,7 +29,9 @@ namespace Lightning
 		SceneManager::SceneManager()
 			: mForegroundSceneID(0)
 		{
-
+			//Space objects release their transforms to SpaceObjectManager when scenes are destroyed along with this manager,
+			//so it's constructed first to be destroyed last
+			SpaceObjectManager::Instance();
 		}
 
 		SceneManager::~SceneManager()
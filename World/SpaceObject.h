@@ -1,7 +1,8 @@
 #pragma once
 #include <cassert>
-#include <list>
 #include <unordered_map>
+#include <vector>
+#include "tbb/task_group.h"
 #include "ISpaceObject.h"
 #include "SpaceObjectManager.h"
 
@@ -12,20 +13,288 @@ namespace Lightning
 		using Foundation::Math::Vector3f;
 		using Foundation::Math::Vector4f;
 		using Foundation::Math::Quaternionf;
+		//objects visited by a task of concurrent traversal,counting grandchildren
+		constexpr std::size_t SPACE_OBJECT_TRAVERSAL_GRAIN_SIZE = 32;
+		class RenderableRegistry;
 
+		//Global transforms are cached and marked dirty hierarchically.Changing a transform marks the object and its descendants
+		//dirty and marks its ancestors as having dirty descendants,so UpdateGlobalTransforms only visits the changed branches.
+		//UpdateGlobalTransforms computes world matrices in the transform system of SpaceObjectManager,where each object holds
+		//a handle,and they are decomposed into global transforms on first read.Objects read before the update compute their
+		//global transforms from their parents on their own.The cache is thread unsafe
 		class SpaceObjectBase : public virtual ISpaceObject
 		{
 		public:
 			SpaceObjectBase() : mID(SpaceObjectManager::Instance()->GetNextSpaceObjectID())
+				, mPreciseLocalPosition{ 0.0, 0.0, 0.0 }, mPreciseGlobalPosition{ 0.0, 0.0, 0.0 }
+				, mGlobalTransformDirty(true), mDescendantTransformDirty(false), mHasPrecisePosition(false)
+				, mTransformHandle(INVALID_TRANSFORM_HANDLE), mGlobalTransformPending(false), mTransformSystemDirty(true)
 			{
 			}
+			~SpaceObjectBase()override
+			{
+				if (mTransformHandle != INVALID_TRANSFORM_HANDLE)
+					SpaceObjectManager::Instance()->ReleaseTransform(mTransformHandle);
+			}
 			const std::uint64_t GetID()const override { return mID; }
+			//INVALID_TRANSFORM_HANDLE until UpdateGlobalTransforms reaches the object.The world matrix of the handle in
+			//SpaceObjectManager::GetTransformSystem is up to date after UpdateGlobalTransforms
+			TransformHandle GetTransformHandle()const { return mTransformHandle; }
+			//Notifies this object and all its descendants that their global transforms are changed
+			void NotifyTransformChanged()
+			{
+				MarkTransformDirty();
+				auto parent = mParent.lock();
+				while (parent && !parent->mDescendantTransformDirty)
+				{
+					parent->mDescendantTransformDirty = true;
+					parent = parent->mParent.lock();
+				}
+			}
+			//Sends changed local transforms of this object,its ancestors and descendants to the transform system,which computes
+			//world matrices level by level in parallel.Should be invoked once per frame on the root object,not concurrently
+			void UpdateGlobalTransforms()
+			{
+				auto manager = SpaceObjectManager::Instance();
+				manager->DestroyReleasedTransforms();
+				auto& transforms = manager->GetTransformSystem();
+				SendChangedTransforms(transforms, SendAncestorTransforms(transforms));
+				transforms.Update();
+			}
+			//Invokes visitor(ISpaceObject&) for this object and its descendants.Unlike Traverse it neither wraps visitor in
+			//std::function nor creates shared pointers.Children must not be added or removed during the traversal
+			template<typename Visitor>
+			void Visit(Visitor&& visitor, SpaceObjectTraversalPolocy policy)
+			{
+				visitor(static_cast<ISpaceObject&>(*this));
+				VisitDescendants([&visitor](const std::shared_ptr<SpaceObjectBase>& object) {
+					visitor(static_cast<ISpaceObject&>(*object));
+				}, policy);
+			}
 		protected:
 			friend class SpaceObjectManager;
+			using ChildIterator = std::vector<std::shared_ptr<SpaceObjectBase>>::const_iterator;
+			template<typename Visitor>
+			void VisitDescendants(const Visitor& visitor, SpaceObjectTraversalPolocy policy)
+			{
+				switch (policy)
+				{
+				case SpaceObjectTraversalPolocy::Concurrent:
+					VisitDescendantsConcurrent(visitor);
+					break;
+				case SpaceObjectTraversalPolocy::BreadthFirst:
+					VisitDescendantsBreadthFirst(visitor);
+					break;
+				default:
+					VisitDescendantsDepthFirst(visitor);
+					break;
+				}
+			}
+			template<typename Visitor>
+			void VisitDescendantsDepthFirst(const Visitor& visitor)
+			{
+				for (const auto& child : mChildren)
+				{
+					visitor(child);
+					child->VisitDescendantsDepthFirst(visitor);
+				}
+			}
+			template<typename Visitor>
+			void VisitDescendantsBreadthFirst(const Visitor& visitor)
+			{
+				std::vector<SpaceObjectBase*> level{ this };
+				std::vector<SpaceObjectBase*> nextLevel;
+				while (!level.empty())
+				{
+					for (auto object : level)
+					{
+						for (const auto& child : object->mChildren)
+						{
+							visitor(child);
+							if (!child->mChildren.empty())
+								nextLevel.push_back(child.get());
+						}
+					}
+					level.swap(nextLevel);
+					nextLevel.clear();
+				}
+			}
+			//Children are split into ranges of about SPACE_OBJECT_TRAVERSAL_GRAIN_SIZE objects counting grandchildren,each range
+			//is a task which idle worker threads steal.The last range is visited by the calling thread
+			template<typename Visitor>
+			void VisitDescendantsConcurrent(const Visitor& visitor)
+			{
+				std::size_t weight{ 0 };
+				for (const auto& child : mChildren)
+				{
+					weight += 1 + child->mChildren.size();
+				}
+				if (weight < SPACE_OBJECT_TRAVERSAL_GRAIN_SIZE)
+				{
+					VisitChildrenConcurrent(mChildren.cbegin(), mChildren.cend(), visitor);
+					return;
+				}
+				tbb::task_group group;
+				auto begin = mChildren.cbegin();
+				weight = 0;
+				for (auto it = mChildren.cbegin();it != mChildren.cend();)
+				{
+					weight += 1 + (*it)->mChildren.size();
+					++it;
+					if (weight >= SPACE_OBJECT_TRAVERSAL_GRAIN_SIZE && it != mChildren.cend())
+					{
+						group.run([begin, it, &visitor]() { VisitChildrenConcurrent(begin, it, visitor); });
+						begin = it;
+						weight = 0;
+					}
+				}
+				VisitChildrenConcurrent(begin, mChildren.cend(), visitor);
+				group.wait();
+			}
+			template<typename Visitor>
+			static void VisitChildrenConcurrent(ChildIterator begin, ChildIterator end, const Visitor& visitor)
+			{
+				for (auto it = begin;it != end;++it)
+				{
+					visitor(*it);
+					(*it)->VisitDescendantsConcurrent(visitor);
+				}
+			}
+			//Returns the handle of parent
+			TransformHandle SendAncestorTransforms(TransformSystem& transforms)
+			{
+				auto parent = mParent.lock();
+				if (!parent)
+					return INVALID_TRANSFORM_HANDLE;
+				auto grandParentHandle = parent->SendAncestorTransforms(transforms);
+				if (parent->mTransformSystemDirty)
+				{
+					parent->SendTransform(transforms, grandParentHandle);
+				}
+				return parent->mTransformHandle;
+			}
+			void SendChangedTransforms(TransformSystem& transforms, TransformHandle parentHandle)
+			{
+				if (mTransformSystemDirty)
+				{
+					SendTransform(transforms, parentHandle);
+				}
+				if (!mDescendantTransformDirty)
+					return;
+				mDescendantTransformDirty = false;
+				for (const auto& child : mChildren)
+				{
+					child->SendChangedTransforms(transforms, mTransformHandle);
+				}
+			}
+			//The global transform is read from the transform system after its update
+			void SendTransform(TransformSystem& transforms, TransformHandle parentHandle)
+			{
+				if (mTransformHandle == INVALID_TRANSFORM_HANDLE)
+					mTransformHandle = transforms.Create(parentHandle);
+				else
+					transforms.SetParent(mTransformHandle, parentHandle);
+				transforms.SetLocalTransform(mTransformHandle, mTransform);
+				mTransformSystemDirty = false;
+				mGlobalTransformDirty = false;
+				mGlobalTransformPending = true;
+			}
+			virtual void OnTransformChanged(){}
+			//Scene roots return the registry that renderables attached under them are added to
+			virtual std::shared_ptr<RenderableRegistry> GetRenderableRegistry()const { return nullptr; }
+			//Descendants of a dirty object are always dirty,because global transforms are computed parents first
+			void MarkTransformDirty()
+			{
+				OnTransformChanged();
+				if (mGlobalTransformDirty)
+					return;
+				mGlobalTransformDirty = true;
+				mTransformSystemDirty = true;
+				if (mChildren.empty())
+					return;
+				mDescendantTransformDirty = true;
+				for (const auto& child : mChildren)
+				{
+					child->MarkTransformDirty();
+				}
+			}
+			const Transform& GetCachedGlobalTransform()const
+			{
+				if (mGlobalTransformDirty || mGlobalTransformPending)
+				{
+					UpdateGlobalTransform();
+				}
+				return mGlobalTransform;
+			}
+			const Vector3d& GetCachedPreciseGlobalPosition()const
+			{
+				if (mGlobalTransformDirty || mGlobalTransformPending)
+				{
+					UpdateGlobalTransform();
+				}
+				return mPreciseGlobalPosition;
+			}
+			//The precise position is dropped once local transform is moved by float setters
+			Vector3d GetPreciseLocalPosition()const
+			{
+				auto position = mTransform.GetPosition();
+				if (mHasPrecisePosition && float(mPreciseLocalPosition.x) == position.x
+					&& float(mPreciseLocalPosition.y) == position.y && float(mPreciseLocalPosition.z) == position.z)
+					return mPreciseLocalPosition;
+				return Vector3d{ position.x, position.y, position.z };
+			}
+			//Combines local transform with the global transform of parent,updating the parent first if it's dirty.
+			//Pending global transforms are decomposed from the world matrices computed by the transform system instead
+			void UpdateGlobalTransform()const
+			{
+				auto parent = mParent.lock();
+				auto localPosition = GetPreciseLocalPosition();
+				if (!parent)
+				{
+					mGlobalTransform = mTransform;
+					mPreciseGlobalPosition = localPosition;
+				}
+				else
+				{
+					//rows of the affine product are global right, up, forward scaled by global scale and global position
+					auto parentMatrix = parent->GetCachedGlobalTransform().GetAffineMatrix();
+					if (mGlobalTransformDirty)
+					{
+						mGlobalTransform = Transform::FromAffineMatrix(mTransform.GetAffineMatrix() * parentMatrix);
+					}
+					else
+					{
+						const auto& world = SpaceObjectManager::Instance()->GetTransformSystem().GetWorldMatrix(mTransformHandle);
+						mGlobalTransform = Transform::FromAffineMatrix(Foundation::Math::AffineMatrix::FromMatrix4(world));
+					}
+					//local position is scaled and rotated by parent in double,parent position is already precise
+					mPreciseGlobalPosition = parent->mPreciseGlobalPosition + Vector3d{
+						localPosition.x * parentMatrix.m[0] + localPosition.y * parentMatrix.m[1] + localPosition.z * parentMatrix.m[2],
+						localPosition.x * parentMatrix.m[4] + localPosition.y * parentMatrix.m[5] + localPosition.z * parentMatrix.m[6],
+						localPosition.x * parentMatrix.m[8] + localPosition.y * parentMatrix.m[9] + localPosition.z * parentMatrix.m[10] };
+				}
+				//matrices are computed once here instead of in every copy handed out
+				mGlobalTransform.GetMatrix();
+				mGlobalTransformDirty = false;
+				mGlobalTransformPending = false;
+			}
 			Transform mTransform;
-			std::weak_ptr<ISpaceObject> mParent;
-			std::list<std::shared_ptr<ISpaceObject>> mChildren;
+			std::weak_ptr<SpaceObjectBase> mParent;
+			//reserved in bulk by SpaceObjectManager when children are added
+			std::vector<std::shared_ptr<SpaceObjectBase>> mChildren;
 			const std::uint64_t mID;
+			Vector3d mPreciseLocalPosition;
+			mutable Vector3d mPreciseGlobalPosition;
+			mutable Transform mGlobalTransform;
+			mutable bool mGlobalTransformDirty;
+			//some descendants have dirty global transforms
+			bool mDescendantTransformDirty;
+			bool mHasPrecisePosition;
+			TransformHandle mTransformHandle;
+			//the global transform is computed by the transform system but not decomposed yet
+			mutable bool mGlobalTransformPending;
+			//local transform or parent changed since it was last sent to the transform system
+			bool mTransformSystemDirty;
 		};
 
 		namespace Detail
@@ -34,7 +303,12 @@ namespace Lightning
 			class SpaceObjectImpl : public SpaceObjectBase, public std::enable_shared_from_this<Derived>
 			{
 			public:
-				Transform& GetLocalTransform()override { return mTransform; }
+				//The returned transform may be modified by caller,so the transform is treated as changed
+				Transform& GetLocalTransform()override
+				{
+					NotifyTransformChanged();
+					return mTransform;
+				}
 				std::shared_ptr<ISpaceObject> GetParent()const override { return mParent.lock(); }
 				std::size_t GetChildrenCount()const override { return mChildren.size(); }
 
@@ -51,44 +325,18 @@ namespace Lightning
 				void Traverse(std::function<void(const std::shared_ptr<ISpaceObject>& object)> visitor, 
 					SpaceObjectTraversalPolocy policy)override
 				{
-					//TODO : implement traversal based on policy setting
 					visitor(shared_from_this());
-					for (const auto& child : mChildren)
-					{
-						child->Traverse(visitor, policy);
-					}
+					VisitDescendants([&visitor](const std::shared_ptr<SpaceObjectBase>& object) { visitor(object); }, policy);
 				}
 
 				Transform GetGlobalTransform()const override
 				{
-					auto parent = GetParent();
-					if (!parent)
-					{
-						return mTransform;
-					}
-					auto matrix = mTransform.LocalToGlobalMatrix4() * parent->GetGlobalTransform().LocalToGlobalMatrix4();
-
-					//Convert Vector4{0, 0, 0, 1} with matrix yields the global position
-					auto globalPosition = Vector3f{ matrix.GetCell(3, 0), matrix.GetCell(3, 1), matrix.GetCell(3, 2) };
-					//Convert Vector4{0, 0, 1, 0} with matrix yields the global forward
-					auto globalForward = Vector3f{ matrix.GetCell(2, 0), matrix.GetCell(2, 1), matrix.GetCell(2, 2) };
-					//Convert Vector4{0, 1, 0, 0} with matrix yields the global up
-					auto globalUp = Vector3f{ matrix.GetCell(1, 0), matrix.GetCell(1, 1), matrix.GetCell(1, 2) };
-					//Convert Vector4{1, 0, 0, 0} with matrix yields the global right
-					auto globalRight = Vector3f{ matrix.GetCell(0, 0), matrix.GetCell(0, 1), matrix.GetCell(0, 2) };
-
-					Vector3f globalScale{ globalRight.Length(), globalUp.Length(), globalForward.Length() };
-
-					Transform globalTransform;
-					globalTransform.SetScale(globalScale);
-					globalTransform.OrientTo(globalForward, globalUp);
-					globalTransform.SetPosition(globalPosition);
-
-					return globalTransform;
+					return GetCachedGlobalTransform();
 				}
 
 				void SetGlobalTransform(const Transform& transform)override
 				{
+					NotifyTransformChanged();
 					auto parent = GetParent();
 					if (!parent)
 					{
@@ -96,13 +344,15 @@ namespace Lightning
 						return;
 					}
 					auto parentGlobalTransform = parent->GetGlobalTransform();
-					SetGlobalScale(transform.GetScale(), parentGlobalTransform);
+					//global scale depends on local rotation if parent scale is not uniform,so rotation is set first
 					SetGlobalRotation(transform.GetRotation(), parentGlobalTransform);
+					SetGlobalScale(transform.GetScale(), parentGlobalTransform);
 					SetGlobalPosition(transform.GetPosition(), parentGlobalTransform);
 				}
 
 				void SetGlobalPosition(const Vector3f& position)override
 				{
+					NotifyTransformChanged();
 					auto parent = GetParent();
 					if (!parent)
 					{
@@ -114,6 +364,7 @@ namespace Lightning
 
 				void SetGlobalRotation(const Quaternionf& rotation)override
 				{
+					NotifyTransformChanged();
 					auto parent = GetParent();
 					if (!parent)
 					{
@@ -125,6 +376,7 @@ namespace Lightning
 
 				void SetGlobalScale(const Vector3f& scale)override
 				{
+					NotifyTransformChanged();
 					auto parent = GetParent();
 					if (!parent)
 					{
@@ -133,28 +385,61 @@ namespace Lightning
 					}
 					SetGlobalScale(scale, parent->GetGlobalTransform());
 				}
+
+				void SetPrecisePosition(const Vector3d& position)override
+				{
+					NotifyTransformChanged();
+					mPreciseLocalPosition = position;
+					mHasPrecisePosition = true;
+					mTransform.SetPosition(Vector3f{ float(position.x), float(position.y), float(position.z) });
+				}
+
+				Vector3d GetPreciseGlobalPosition()const override
+				{
+					return GetCachedPreciseGlobalPosition();
+				}
 			protected:
+				//Parent relative setters work on parent TRS directly.The inverse matrix of parent global transform is computed
+				//from its TRS when it's cached,so no matrix is ever inverted
 				void SetGlobalPosition(const Vector3f& position, const Transform& parentGlobalTransform)
 				{
-					auto localPosition = Vector4f{ position.x, position.y, position.z, 1.0f } * parentGlobalTransform.GlobalToLocalMatrix4();
-					mTransform.SetPosition(Vector3f{ localPosition.x, localPosition.y, localPosition.z });
+					mTransform.SetPosition(parentGlobalTransform.GlobalPointToLocal(position));
 				}
 				void SetGlobalRotation(const Quaternionf& rotation, const Transform& parentGlobalTransform)
 				{
-					auto globalForward = rotation * Vector3f::forward();
-					auto globalUp = rotation * Vector3f::up();
-					auto localForward = Vector4f{ globalForward.x, globalForward.y, globalForward.z, 0.f } * parentGlobalTransform.GlobalToLocalMatrix4();
-					auto localUp = Vector4f{ globalUp.x, globalUp.y, globalUp.z, 0.f } * parentGlobalTransform.GlobalToLocalMatrix4();
-					mTransform.OrientTo(Vector3f{localForward.x, localForward.y, localForward.z}, Vector3f{ localUp.x, localUp.y, localUp.z });
+					auto parentScale = parentGlobalTransform.GetScale();
+					auto inverseParentRotation = parentGlobalTransform.GetRotation().Inversed();
+					if (parentScale.x == parentScale.y && parentScale.x == parentScale.z)
+					{
+						//uniform scale keeps directions,so global rotation is parent rotation * local rotation
+						auto localRotation = inverseParentRotation * rotation;
+						localRotation.Normalize();
+						mTransform.SetRotation(localRotation);
+						return;
+					}
+					//Global axes are local axes scaled by parent scale then rotated by parent rotation,so desired global axes
+					//are mapped back the other way.Forward is kept exactly and up is made orthogonal to it like OrientTo does
+					auto localForward = inverseParentRotation * (rotation * Vector3f::forward());
+					auto localUp = inverseParentRotation * (rotation * Vector3f::up());
+					localForward = Vector3f{ localForward.x / parentScale.x, localForward.y / parentScale.y, localForward.z / parentScale.z };
+					localUp = Vector3f{ localUp.x / parentScale.x, localUp.y / parentScale.y, localUp.z / parentScale.z };
+					localForward.Normalize();
+					auto localRight = localUp.Cross(localForward);
+					localRight.Normalize();
+					mTransform.SetRotation(Quaternionf::FromAxes(localRight, localForward.Cross(localRight), localForward));
 				}
 				void SetGlobalScale(const Vector3f& scale, const Transform& parentGlobalTransform)
 				{
-					auto matrix = mTransform.LocalToGlobalMatrix4() * parentGlobalTransform.LocalToGlobalMatrix4();
-					auto globalForward = Vector4f{ 0.f, 0.f, 1.f, 0.f } * matrix;
-					auto globalUp = Vector4f{ 0.f, 1.f, 0.f, 0.f } * matrix;
-					auto globalRight = Vector4f{ 1.f, 0.f, 0.f, 0.f } * matrix;
-
-					mTransform.SetScale(Vector3f{ scale.x / globalRight.Length(), scale.y / globalUp.Length(), scale.z / globalForward.Length() });
+					//global length of local axis i is local scale i times the length of the axis scaled by parent scale.
+					//Local axes are the rows of the local rotation matrix
+					auto parentScale = parentGlobalTransform.GetScale();
+					Matrix4f rotation;
+					mTransform.GetRotation().ToMatrix(rotation);
+					auto axisScale = [&parentScale, &rotation](unsigned axis) {
+						return Vector3f{ rotation.GetCell(axis, 0) * parentScale.x, rotation.GetCell(axis, 1) * parentScale.y,
+							rotation.GetCell(axis, 2) * parentScale.z }.Length();
+					};
+					mTransform.SetScale(Vector3f{ scale.x / axisScale(0), scale.y / axisScale(1), scale.z / axisScale(2) });
 				}
 			};
 		}
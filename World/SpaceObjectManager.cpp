@@ -1,11 +1,18 @@
 #include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 #include "SpaceObjectManager.h"
 #include "SpaceObject.h"
+#include "IRenderable.h"
+#include "IRenderPlugin.h"
 
 namespace Lightning
 {
 	namespace World
 	{
+		extern Plugins::IRenderPlugin* gRenderPlugin;
 		std::uint64_t SpaceObjectManager::GetNextSpaceObjectID()
 		{
 			return mNextSpaceObjectID.fetch_add(1, std::memory_order_relaxed);
@@ -22,7 +29,7 @@ namespace Lightning
 				return false;
 			if (parent == child)
 				return false;
-			mOperations.emplace(Operation::Add, parent, child);
+			mOperationBuffers.local().emplace_back(Operation::Add, parent, child);
 			child->mParent = parent;
 			return true;
 		}
@@ -35,27 +42,192 @@ namespace Lightning
 				return false;
 			if (child->GetParent() != parent)
 				return false;
-			mOperations.emplace(Operation::Remove, parent, child);
+			mOperationBuffers.local().emplace_back(Operation::Remove, parent, child);
 			child->mParent.reset();
 			return true;
 		}
 
+		void SpaceObjectManager::AddDirtyRenderable(const std::shared_ptr<IRenderable>& renderable)
+		{
+			mDirtyRenderables.push(renderable);
+		}
+
+		void SpaceObjectManager::AddMovedRenderable(const std::shared_ptr<IRenderable>& renderable)
+		{
+			mMovedRenderables.push(renderable);
+		}
+
+		void SpaceObjectManager::ReleaseTransform(TransformHandle handle)
+		{
+			mReleasedTransforms.push(handle);
+		}
+
+		void SpaceObjectManager::DestroyReleasedTransforms()
+		{
+			TransformHandle handle;
+			while (mReleasedTransforms.try_pop(handle))
+			{
+				mTransformSystem.Destroy(handle);
+			}
+		}
+
+		void SpaceObjectManager::MergeOperations()
+		{
+			std::size_t count{ 0 };
+			for (const auto& buffer : mOperationBuffers)
+			{
+				count += buffer.size();
+			}
+			mMergedOperations.reserve(count);
+			for (auto& buffer : mOperationBuffers)
+			{
+				std::move(buffer.begin(), buffer.end(), std::back_inserter(mMergedOperations));
+				buffer.clear();
+			}
+		}
+
+		void SpaceObjectManager::ApplyChildrenOperations()
+		{
+			if (mMergedOperations.empty())
+				return;
+			mOperationOrder.resize(mMergedOperations.size());
+			for (std::size_t i = 0;i < mOperationOrder.size();++i)
+			{
+				mOperationOrder[i] = static_cast<std::uint32_t>(i);
+			}
+			//operations of a parent stay in the issued order
+			std::sort(mOperationOrder.begin(), mOperationOrder.end(), [this](std::uint32_t a, std::uint32_t b) {
+				auto parentA = mMergedOperations[a].parent.get();
+				auto parentB = mMergedOperations[b].parent.get();
+				return parentA < parentB || (parentA == parentB && a < b);
+			});
+			mParentRanges.clear();
+			std::uint32_t begin{ 0 };
+			for (std::uint32_t i = 1;i <= mOperationOrder.size();++i)
+			{
+				if (i == mOperationOrder.size() ||
+					mMergedOperations[mOperationOrder[i]].parent != mMergedOperations[mOperationOrder[begin]].parent)
+				{
+					mParentRanges.emplace_back(begin, i);
+					begin = i;
+				}
+			}
+			//each task owns the children lists of its parents
+			tbb::parallel_for(tbb::blocked_range<std::size_t>(0, mParentRanges.size()), [this](const tbb::blocked_range<std::size_t>& range) {
+				for (auto i = range.begin();i != range.end();++i)
+				{
+					const auto& parentRange = mParentRanges[i];
+					ApplyChildrenOperations(mOperationOrder.data() + parentRange.first, parentRange.second - parentRange.first);
+				}
+			});
+		}
+
+		void SpaceObjectManager::ApplyChildrenOperations(const std::uint32_t* operations, std::size_t count)
+		{
+			auto& children = mMergedOperations[operations[0]].parent->mChildren;
+			//A removal removes all occurrences of the child,including the ones added before it in this batch.
+			//So children removed at least once are erased in one pass and only additions after their last removal are kept
+			std::size_t additionCount{ 0 };
+			for (std::size_t i = 0;i < count;++i)
+			{
+				if (mMergedOperations[operations[i]].operation == Operation::Add)
+					++additionCount;
+			}
+			std::unordered_map<const SpaceObjectBase*, std::size_t> lastRemovals;
+			if (additionCount < count)
+			{
+				lastRemovals.reserve(count - additionCount);
+				for (std::size_t i = 0;i < count;++i)
+				{
+					const auto& operation = mMergedOperations[operations[i]];
+					if (operation.operation == Operation::Remove)
+						lastRemovals[operation.child.get()] = i;
+				}
+				children.erase(std::remove_if(children.begin(), children.end(), [&lastRemovals](const std::shared_ptr<SpaceObjectBase>& child) {
+					return lastRemovals.find(child.get()) != lastRemovals.end();
+				}), children.end());
+			}
+			//capacity still grows geometrically when a few children are added every frame
+			auto requiredSize = children.size() + additionCount;
+			if (children.capacity() < requiredSize)
+				children.reserve(std::max(requiredSize, children.capacity() * 2));
+			for (std::size_t i = 0;i < count;++i)
+			{
+				const auto& operation = mMergedOperations[operations[i]];
+				if (operation.operation != Operation::Add)
+					continue;
+				auto removal = lastRemovals.find(operation.child.get());
+				if (removal == lastRemovals.end() || removal->second < i)
+					children.push_back(operation.child);
+			}
+		}
+
+		std::shared_ptr<RenderableRegistry> SpaceObjectManager::FindRenderableRegistry(std::shared_ptr<SpaceObjectBase> object)
+		{
+			while (auto parent = object->mParent.lock())
+			{
+				object = std::move(parent);
+			}
+			return object->GetRenderableRegistry();
+		}
+
+		void SpaceObjectManager::OnChildAttachmentChanged(const std::shared_ptr<SpaceObjectBase>& child, Render::IRenderer* renderer)
+		{
+			//Renderables are in the registry of the scene they are attached under,so they get render proxies and spatial index
+			//entries when their subtree joins a scene and lose them when it leaves
+			auto registry = FindRenderableRegistry(child);
+			auto update = [&registry, renderer](const std::shared_ptr<SpaceObjectBase>& object) {
+				auto renderable = std::dynamic_pointer_cast<IRenderable>(object);
+				if (!renderable)
+					return;
+				auto currentRegistry = renderable->GetRegistry();
+				if (currentRegistry != registry)
+				{
+					if (currentRegistry)
+						renderable->RemoveFromRegistry(renderer);
+					if (registry)
+						renderable->AddToRegistry(registry, renderer);
+				}
+			};
+			update(child);
+			child->VisitDescendantsDepthFirst(update);
+		}
+
 		void SpaceObjectManager::Synchronize()
 		{
-			SpaceObjectOperation operation;
-			while (mOperations.try_pop(operation))
+			auto renderer = gRenderPlugin ? gRenderPlugin->GetRenderer() : nullptr;
+			MergeOperations();
+			ApplyChildrenOperations();
+			//The rest touches ancestors,render proxies and spatial index,so it's done on this thread in the issued order
+			for (const auto& operation : mMergedOperations)
 			{
 				if (operation.operation == Operation::Add)
-				{
 					operation.child->mParent = operation.parent;
-					operation.parent->mChildren.push_back(operation.child);
-				}
 				else
-				{
 					operation.child->mParent.reset();
-					operation.parent->mChildren.remove(operation.child);
+				//cached global transforms of the moved subtree are relative to the old parent
+				operation.child->NotifyTransformChanged();
+			}
+			//Scenes of moved subtrees are looked up once all parents are set,so every subtree ends up in the scene it's under
+			//after the batch whatever order the operations were issued in
+			for (const auto& operation : mMergedOperations)
+			{
+				OnChildAttachmentChanged(operation.child, renderer);
+			}
+			mMergedOperations.clear();
+			std::shared_ptr<IRenderable> renderable;
+			while (mDirtyRenderables.try_pop(renderable))
+			{
+				if (renderer)
+				{
+					renderable->SyncRenderProxy(*renderer);
 				}
 			}
+			//after render proxies,whose synchronization may change local bounds
+			while (mMovedRenderables.try_pop(renderable))
+			{
+				renderable->SyncSpatialBounds();
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -1,24 +1,56 @@
 #pragma once
 #include <atomic>
+#include <memory>
+#include <vector>
 #include "tbb/concurrent_queue.h"
+#include "tbb/enumerable_thread_specific.h"
 #include "Singleton.h"
+#include "TransformSystem.h"
 
 namespace Lightning
 {
+	namespace Render
+	{
+		struct IRenderer;
+	}
 	namespace World
 	{
 		class SpaceObjectBase;
+		class RenderableRegistry;
+		struct IRenderable;
 		class SpaceObjectManager : public Foundation::Singleton<SpaceObjectManager>
 		{
 		public:
 			std::uint64_t GetNextSpaceObjectID();
+			//Children are added and removed at next Synchronize.These methods are thread safe but must not be invoked
+			//while Synchronize is running
 			bool AddChild(const std::shared_ptr<SpaceObjectBase>& parent, const std::shared_ptr<SpaceObjectBase>& child);
 			bool RemoveChild(const std::shared_ptr<SpaceObjectBase>& parent, const std::shared_ptr<SpaceObjectBase>& child);
-			//synchronize children add/remove operations,thread unsafe,must be invoke by only one thread!
+			//Queues a renderable whose render proxy needs to be synchronized,thread safe
+			void AddDirtyRenderable(const std::shared_ptr<IRenderable>& renderable);
+			//Queues a renderable whose bounds in spatial index need to be synchronized,thread safe
+			void AddMovedRenderable(const std::shared_ptr<IRenderable>& renderable);
+			//Transforms of space objects laid out flat by depth.Thread unsafe,used while global transforms are updated
+			TransformSystem& GetTransformSystem() { return mTransformSystem; }
+			//Queues the transform of a destroyed space object,thread safe
+			void ReleaseTransform(TransformHandle handle);
+			//Destroys transforms queued by ReleaseTransform,thread unsafe
+			void DestroyReleasedTransforms();
+			//synchronize children add/remove operations and render proxies,thread unsafe,must be invoke by only one thread!
+			//Operations of all threads are applied in bulk,children lists of different parents are modified in parallel
 			void Synchronize();
 		private:
 			friend class Foundation::Singleton<SpaceObjectManager>;
 			SpaceObjectManager();
+			//Moves operations buffered by all threads into mMergedOperations
+			void MergeOperations();
+			//Applies mMergedOperations to children lists,grouped by parent
+			void ApplyChildrenOperations();
+			//operations are indices of mMergedOperations of the same parent in the order they were issued
+			void ApplyChildrenOperations(const std::uint32_t* operations, std::size_t count);
+			void OnChildAttachmentChanged(const std::shared_ptr<SpaceObjectBase>& child, Render::IRenderer* renderer);
+			//Registry of the scene root object is attached under,nullptr if its root is not a scene
+			static std::shared_ptr<RenderableRegistry> FindRenderableRegistry(std::shared_ptr<SpaceObjectBase> object);
 			enum class Operation
 			{
 				Add,
@@ -34,7 +66,18 @@ namespace Lightning
 				std::shared_ptr<SpaceObjectBase> parent;
 				std::shared_ptr<SpaceObjectBase> child;
 			};
-			tbb::concurrent_queue<SpaceObjectOperation> mOperations;
+			//each thread appends operations to its own buffer without synchronization
+			tbb::enumerable_thread_specific<std::vector<SpaceObjectOperation>> mOperationBuffers;
+			//the following containers are kept between synchronizations to reuse memory
+			std::vector<SpaceObjectOperation> mMergedOperations;
+			//indices of mMergedOperations sorted by parent
+			std::vector<std::uint32_t> mOperationOrder;
+			//[begin, end) ranges of mOperationOrder with the same parent
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> mParentRanges;
+			tbb::concurrent_queue<std::shared_ptr<IRenderable>> mDirtyRenderables;
+			tbb::concurrent_queue<std::shared_ptr<IRenderable>> mMovedRenderables;
+			tbb::concurrent_queue<TransformHandle> mReleasedTransforms;
+			TransformSystem mTransformSystem;
 			std::atomic<std::uint64_t> mNextSpaceObjectID;
 		};
 	}
@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <cassert>
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "SpatialIndex.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		namespace
+		{
+			//an object whose enlarged bounds are this many times larger than needed is reinserted to keep the tree tight
+			constexpr float SHRINK_AREA_RATIO = 4.0f;
+
+			float ClampExtent(float value)
+			{
+				return std::max(-SPATIAL_INDEX_MAX_EXTENT, std::min(SPATIAL_INDEX_MAX_EXTENT, value));
+			}
+
+			template<typename Query>
+			void RunBatch(std::size_t count, const Query& query)
+			{
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(0, count), [&query](const tbb::blocked_range<std::size_t>& range) {
+					for (auto i = range.begin();i != range.end();++i)
+					{
+						query(i);
+					}
+				});
+			}
+		}
+
+		constexpr std::uint32_t SpatialIndex::INVALID_NODE;
+
+		SpatialIndex::SpatialIndex(float margin) : mRoot(INVALID_NODE), mFreeList(INVALID_NODE), mCount(0), mMargin(margin)
+		{
+			assert(margin >= 0.0f);
+		}
+
+		SpatialHandle SpatialIndex::Insert(const AABBf& bounds)
+		{
+			assert(!bounds.IsEmpty());
+			auto leaf = AllocateNode();
+			auto& node = mNodes[leaf];
+			node.children[0] = node.children[1] = INVALID_NODE;
+			SetBounds(leaf, bounds);
+			mHeights[leaf] = 0;
+			InsertLeaf(leaf);
+			++mCount;
+			return static_cast<SpatialHandle>(leaf);
+		}
+
+		void SpatialIndex::Remove(SpatialHandle handle)
+		{
+			assert(handle < mNodes.size() && mNodes[handle].IsLeaf() && mHeights[handle] == 0);
+			RemoveLeaf(handle);
+			FreeNode(handle);
+			--mCount;
+		}
+
+		bool SpatialIndex::Update(SpatialHandle handle, const AABBf& bounds)
+		{
+			assert(handle < mNodes.size() && mNodes[handle].IsLeaf() && mHeights[handle] == 0);
+			assert(!bounds.IsEmpty());
+			const auto& node = mNodes[handle];
+			if (node.min[0] <= bounds.min.x && node.min[1] <= bounds.min.y && node.min[2] <= bounds.min.z &&
+				node.max[0] >= bounds.max.x && node.max[1] >= bounds.max.y && node.max[2] >= bounds.max.z)
+			{
+				float min[3] = { bounds.min.x - mMargin, bounds.min.y - mMargin, bounds.min.z - mMargin };
+				float max[3] = { bounds.max.x + mMargin, bounds.max.y + mMargin, bounds.max.z + mMargin };
+				if (GetArea(node.min, node.max) <= SHRINK_AREA_RATIO * GetArea(min, max))
+					return false;
+			}
+			RemoveLeaf(handle);
+			SetBounds(handle, bounds);
+			InsertLeaf(handle);
+			return true;
+		}
+
+		void SpatialIndex::Clear()
+		{
+			mNodes.clear();
+			mParents.clear();
+			mHeights.clear();
+			mRoot = INVALID_NODE;
+			mFreeList = INVALID_NODE;
+			mCount = 0;
+		}
+
+		AABBf SpatialIndex::GetFatBounds(SpatialHandle handle)const
+		{
+			assert(handle < mNodes.size() && mNodes[handle].IsLeaf() && mHeights[handle] == 0);
+			return GetBounds(handle);
+		}
+
+		std::size_t SpatialIndex::GetHeight()const
+		{
+			return mRoot == INVALID_NODE ? 0 : static_cast<std::size_t>(mHeights[mRoot]);
+		}
+
+		float SpatialIndex::GetAreaRatio()const
+		{
+			if (mRoot == INVALID_NODE)
+				return 0.0f;
+			double totalArea{ 0.0 };
+			for (std::size_t i = 0;i < mNodes.size();++i)
+			{
+				if (mHeights[i] > 0)
+					totalArea += GetArea(mNodes[i].min, mNodes[i].max);
+			}
+			auto rootArea = GetArea(mNodes[mRoot].min, mNodes[mRoot].max);
+			return rootArea > 0.0f ? static_cast<float>(totalArea / rootArea) : 0.0f;
+		}
+
+		void SpatialIndex::QueryBox(const AABBf& box, std::vector<SpatialHandle>& results)const
+		{
+			QueryBox(box, [&results](SpatialHandle handle) { results.push_back(handle); });
+		}
+
+		void SpatialIndex::QuerySphere(const SpatialSphere& sphere, std::vector<SpatialHandle>& results)const
+		{
+			QuerySphere(sphere, [&results](SpatialHandle handle) { results.push_back(handle); });
+		}
+
+		void SpatialIndex::QueryFrustum(const Frustum& frustum, std::vector<SpatialHandle>& results)const
+		{
+			QueryFrustum(frustum, [&results](SpatialHandle handle) { results.push_back(handle); });
+		}
+
+		void SpatialIndex::QueryRay(const SpatialRay& ray, std::vector<SpatialHandle>& results)const
+		{
+			RayCast(ray, [&results, &ray](SpatialHandle handle, float distance) {
+				results.push_back(handle);
+				return ray.maxDistance;
+			});
+		}
+
+		SpatialRayHit SpatialIndex::RayCastClosest(const SpatialRay& ray)const
+		{
+			SpatialRayHit hit{ INVALID_SPATIAL_HANDLE, ray.maxDistance };
+			RayCast(ray, [&hit](SpatialHandle handle, float distance) {
+				if (hit.handle == INVALID_SPATIAL_HANDLE || distance < hit.distance)
+				{
+					hit.handle = handle;
+					hit.distance = distance;
+				}
+				return hit.distance;
+			});
+			return hit;
+		}
+
+		void SpatialIndex::QueryBoxes(const AABBf* boxes, std::size_t count, std::vector<SpatialHandle>* results)const
+		{
+			RunBatch(count, [this, boxes, results](std::size_t i) {
+				results[i].clear();
+				QueryBox(boxes[i], results[i]);
+			});
+		}
+
+		void SpatialIndex::QuerySpheres(const SpatialSphere* spheres, std::size_t count, std::vector<SpatialHandle>* results)const
+		{
+			RunBatch(count, [this, spheres, results](std::size_t i) {
+				results[i].clear();
+				QuerySphere(spheres[i], results[i]);
+			});
+		}
+
+		void SpatialIndex::QueryFrustums(const Frustum* frustums, std::size_t count, std::vector<SpatialHandle>* results)const
+		{
+			RunBatch(count, [this, frustums, results](std::size_t i) {
+				results[i].clear();
+				QueryFrustum(frustums[i], results[i]);
+			});
+		}
+
+		void SpatialIndex::RayCastClosest(const SpatialRay* rays, std::size_t count, SpatialRayHit* hits)const
+		{
+			RunBatch(count, [this, rays, hits](std::size_t i) {
+				hits[i] = RayCastClosest(rays[i]);
+			});
+		}
+
+		std::uint32_t SpatialIndex::AllocateNode()
+		{
+			if (mFreeList != INVALID_NODE)
+			{
+				auto node = mFreeList;
+				mFreeList = mNodes[node].children[1];
+				mParents[node] = INVALID_NODE;
+				return node;
+			}
+			auto node = static_cast<std::uint32_t>(mNodes.size());
+			mNodes.emplace_back();
+			mParents.push_back(INVALID_NODE);
+			mHeights.push_back(-1);
+			return node;
+		}
+
+		void SpatialIndex::FreeNode(std::uint32_t node)
+		{
+			mNodes[node].children[0] = INVALID_NODE;
+			mNodes[node].children[1] = mFreeList;
+			mHeights[node] = -1;
+			mFreeList = node;
+		}
+
+		void SpatialIndex::InsertLeaf(std::uint32_t leaf)
+		{
+			if (mRoot == INVALID_NODE)
+			{
+				mRoot = leaf;
+				mParents[leaf] = INVALID_NODE;
+				return;
+			}
+			//Descend to the sibling with the lowest cost.The cost of a subtree is the area of the new parent node
+			//plus the areas its ancestors grow by
+			auto bounds = GetBounds(leaf);
+			auto index = mRoot;
+			while (!mNodes[index].IsLeaf())
+			{
+				const auto& node = mNodes[index];
+				auto area = GetArea(node.min, node.max);
+				auto unionArea = GetUnionArea(node, bounds);
+				//cost of making a new parent of this node and the leaf
+				auto cost = 2.0f * unionArea;
+				//cost pushed down to children
+				auto inheritanceCost = 2.0f * (unionArea - area);
+				float childCosts[2];
+				for (auto i = 0;i < 2;++i)
+				{
+					const auto& child = mNodes[node.children[i]];
+					childCosts[i] = GetUnionArea(child, bounds) + inheritanceCost;
+					if (!child.IsLeaf())
+						childCosts[i] -= GetArea(child.min, child.max);
+				}
+				if (cost < childCosts[0] && cost < childCosts[1])
+					break;
+				index = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+			}
+
+			auto sibling = index;
+			auto oldParent = mParents[sibling];
+			auto newParent = AllocateNode();
+			mParents[newParent] = oldParent;
+			mNodes[newParent].children[0] = sibling;
+			mNodes[newParent].children[1] = leaf;
+			mParents[sibling] = newParent;
+			mParents[leaf] = newParent;
+			SetUnion(newParent, sibling, leaf);
+			mHeights[newParent] = mHeights[sibling] + 1;
+			if (oldParent != INVALID_NODE)
+				ReplaceChild(oldParent, sibling, newParent);
+			else
+				mRoot = newParent;
+			RefitAncestors(oldParent);
+		}
+
+		void SpatialIndex::RemoveLeaf(std::uint32_t leaf)
+		{
+			if (leaf == mRoot)
+			{
+				mRoot = INVALID_NODE;
+				return;
+			}
+			auto parent = mParents[leaf];
+			auto grandParent = mParents[parent];
+			auto sibling = mNodes[parent].children[0] == leaf ? mNodes[parent].children[1] : mNodes[parent].children[0];
+			mParents[sibling] = grandParent;
+			if (grandParent != INVALID_NODE)
+				ReplaceChild(grandParent, parent, sibling);
+			else
+				mRoot = sibling;
+			FreeNode(parent);
+			mParents[leaf] = INVALID_NODE;
+			RefitAncestors(grandParent);
+		}
+
+		void SpatialIndex::RefitAncestors(std::uint32_t node)
+		{
+			while (node != INVALID_NODE)
+			{
+				node = Balance(node);
+				auto child0 = mNodes[node].children[0];
+				auto child1 = mNodes[node].children[1];
+				mHeights[node] = 1 + std::max(mHeights[child0], mHeights[child1]);
+				SetUnion(node, child0, child1);
+				node = mParents[node];
+			}
+		}
+
+		std::uint32_t SpatialIndex::Balance(std::uint32_t a)
+		{
+			if (mNodes[a].IsLeaf() || mHeights[a] < 2)
+				return a;
+			auto b = mNodes[a].children[0];
+			auto c = mNodes[a].children[1];
+			auto balance = mHeights[c] - mHeights[b];
+			if (balance >= -1 && balance <= 1)
+				return a;
+			//index of the higher child,which becomes the parent of a
+			auto up = balance > 1 ? c : b;
+			auto kept = balance > 1 ? b : c;
+			auto upSide = balance > 1 ? 1 : 0;
+			auto f = mNodes[up].children[0];
+			auto g = mNodes[up].children[1];
+
+			//up takes the place of a
+			mParents[up] = mParents[a];
+			if (mParents[up] != INVALID_NODE)
+				ReplaceChild(mParents[up], a, up);
+			else
+				mRoot = up;
+			mParents[a] = up;
+
+			//the higher grandchild stays under up,the lower one replaces up under a
+			auto higher = mHeights[f] > mHeights[g] ? f : g;
+			auto lower = mHeights[f] > mHeights[g] ? g : f;
+			mNodes[up].children[0] = a;
+			mNodes[up].children[1] = higher;
+			mNodes[a].children[upSide] = lower;
+			mParents[lower] = a;
+			SetUnion(a, kept, lower);
+			mHeights[a] = 1 + std::max(mHeights[kept], mHeights[lower]);
+			SetUnion(up, a, higher);
+			mHeights[up] = 1 + std::max(mHeights[a], mHeights[higher]);
+			return up;
+		}
+
+		void SpatialIndex::ReplaceChild(std::uint32_t parent, std::uint32_t oldChild, std::uint32_t newChild)
+		{
+			auto& node = mNodes[parent];
+			if (node.children[0] == oldChild)
+			{
+				node.children[0] = newChild;
+			}
+			else
+			{
+				assert(node.children[1] == oldChild);
+				node.children[1] = newChild;
+			}
+		}
+
+		void SpatialIndex::SetUnion(std::uint32_t node, std::uint32_t child0, std::uint32_t child1)
+		{
+			auto& target = mNodes[node];
+			const auto& first = mNodes[child0];
+			const auto& second = mNodes[child1];
+			for (auto i = 0;i < 3;++i)
+			{
+				target.min[i] = std::min(first.min[i], second.min[i]);
+				target.max[i] = std::max(first.max[i], second.max[i]);
+			}
+		}
+
+		void SpatialIndex::SetBounds(std::uint32_t node, const AABBf& bounds)
+		{
+			auto& target = mNodes[node];
+			target.min[0] = ClampExtent(bounds.min.x - mMargin);
+			target.min[1] = ClampExtent(bounds.min.y - mMargin);
+			target.min[2] = ClampExtent(bounds.min.z - mMargin);
+			target.max[0] = ClampExtent(bounds.max.x + mMargin);
+			target.max[1] = ClampExtent(bounds.max.y + mMargin);
+			target.max[2] = ClampExtent(bounds.max.z + mMargin);
+		}
+
+		AABBf SpatialIndex::GetBounds(std::uint32_t node)const
+		{
+			const auto& source = mNodes[node];
+			AABBf bounds;
+			bounds.min = Vector3f{ source.min[0], source.min[1], source.min[2] };
+			bounds.max = Vector3f{ source.max[0], source.max[1], source.max[2] };
+			return bounds;
+		}
+
+		float SpatialIndex::GetArea(const float* min, const float* max)
+		{
+			//half of the surface area,only ratios of areas matter
+			auto dx = max[0] - min[0];
+			auto dy = max[1] - min[1];
+			auto dz = max[2] - min[2];
+			return dx * dy + dy * dz + dz * dx;
+		}
+
+		float SpatialIndex::GetUnionArea(const Node& node, const AABBf& bounds)
+		{
+			float min[3] = { std::min(node.min[0], bounds.min.x), std::min(node.min[1], bounds.min.y), std::min(node.min[2], bounds.min.z) };
+			float max[3] = { std::max(node.max[0], bounds.max.x), std::max(node.max[1], bounds.max.y), std::max(node.max[2], bounds.max.z) };
+			return GetArea(min, max);
+		}
+
+		float SpatialIndex::IntersectRay(const Node& node, const Vector3f& origin, const Vector3f& inverseDirection, float maxDistance)
+		{
+			const float o[3] = { origin.x, origin.y, origin.z };
+			const float d[3] = { inverseDirection.x, inverseDirection.y, inverseDirection.z };
+			auto enter = 0.0f;
+			auto exit = maxDistance;
+			for (auto i = 0;i < 3;++i)
+			{
+				auto t0 = (node.min[i] - o[i]) * d[i];
+				auto t1 = (node.max[i] - o[i]) * d[i];
+				enter = std::max(enter, std::min(t0, t1));
+				exit = std::min(exit, std::max(t0, t1));
+			}
+			return enter <= exit ? enter : -1.0f;
+		}
+	}
+}
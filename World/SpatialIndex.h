@@ -0,0 +1,339 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AABB.h"
+#include "Frustum.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		using Foundation::Math::AABBf;
+		using Foundation::Math::Frustum;
+		using Foundation::Math::Vector3f;
+		using SpatialHandle = std::uint32_t;
+		constexpr SpatialHandle INVALID_SPATIAL_HANDLE = 0xffffffff;
+		//bounds stored in the tree are enlarged by margin,so objects moving less than margin don't touch the tree
+		constexpr float SPATIAL_INDEX_DEFAULT_MARGIN = 0.1f;
+		//infinite bounds are clamped to this extent
+		constexpr float SPATIAL_INDEX_MAX_EXTENT = 1.0e12f;
+
+		struct SpatialSphere
+		{
+			Vector3f center;
+			float radius;
+		};
+
+		//direction needs not be normalized,distances are measured in multiples of direction
+		struct SpatialRay
+		{
+			Vector3f origin;
+			Vector3f direction;
+			float maxDistance;
+		};
+
+		//distance is where the ray enters the bounds of the object,0 if the ray starts inside
+		struct SpatialRayHit
+		{
+			SpatialHandle handle;
+			float distance;
+		};
+
+		//Dynamic bounding volume hierarchy of object bounds.Leaves are inserted where they increase the surface area of the
+		//tree the least,and ancestors of inserted or removed leaves are refitted and rebalanced by rotations,so the tree stays
+		//shallow without being rebuilt.Update leaves the tree untouched while the new bounds are inside the enlarged ones,
+		//otherwise the leaf is reinserted.Nodes are 32 bytes with parents and heights stored apart since queries never read them.
+		//Handles are leaf node indices and stay valid until removed.Queries are thread safe against each other but not
+		//against modifications.Visitor queries don't allocate memory
+		class SpatialIndex
+		{
+		public:
+			explicit SpatialIndex(float margin = SPATIAL_INDEX_DEFAULT_MARGIN);
+			//bounds must not be empty
+			SpatialHandle Insert(const AABBf& bounds);
+			void Remove(SpatialHandle handle);
+			//Returns true if the leaf is reinserted
+			bool Update(SpatialHandle handle, const AABBf& bounds);
+			void Clear();
+			//Enlarged bounds stored in the tree
+			AABBf GetFatBounds(SpatialHandle handle)const;
+			std::size_t GetCount()const { return mCount; }
+			std::size_t GetHeight()const;
+			//Sum of surface areas of internal nodes divided by the surface area of root,lower is better
+			float GetAreaRatio()const;
+
+			//visitor(handle) is invoked for each object whose enlarged bounds intersect the query
+			template<typename Visitor>
+			void QueryBox(const AABBf& box, Visitor&& visitor)const;
+			template<typename Visitor>
+			void QuerySphere(const SpatialSphere& sphere, Visitor&& visitor)const;
+			template<typename Visitor>
+			void QueryFrustum(const Frustum& frustum, Visitor&& visitor)const;
+			//Objects hit by ray are visited near to far as far as the tree order allows.visitor(handle, distance) returns the
+			//max distance of the rest of the ray,e.g.the distance to the object actually hit to find the closest one
+			template<typename Visitor>
+			void RayCast(const SpatialRay& ray, Visitor&& visitor)const;
+
+			//Query results are appended to results
+			void QueryBox(const AABBf& box, std::vector<SpatialHandle>& results)const;
+			void QuerySphere(const SpatialSphere& sphere, std::vector<SpatialHandle>& results)const;
+			void QueryFrustum(const Frustum& frustum, std::vector<SpatialHandle>& results)const;
+			void QueryRay(const SpatialRay& ray, std::vector<SpatialHandle>& results)const;
+			//handle is INVALID_SPATIAL_HANDLE if nothing is hit
+			SpatialRayHit RayCastClosest(const SpatialRay& ray)const;
+
+			//Batched queries run in parallel.results[i] is replaced with the result of query i
+			void QueryBoxes(const AABBf* boxes, std::size_t count, std::vector<SpatialHandle>* results)const;
+			void QuerySpheres(const SpatialSphere* spheres, std::size_t count, std::vector<SpatialHandle>* results)const;
+			void QueryFrustums(const Frustum* frustums, std::size_t count, std::vector<SpatialHandle>* results)const;
+			void RayCastClosest(const SpatialRay* rays, std::size_t count, SpatialRayHit* hits)const;
+		private:
+			static constexpr std::uint32_t INVALID_NODE = 0xffffffff;
+			//children[0] is INVALID_NODE for leaves and free nodes,children[1] of a free node is the next free node
+			struct Node
+			{
+				float min[3];
+				float max[3];
+				std::uint32_t children[2];
+				bool IsLeaf()const { return children[0] == INVALID_NODE; }
+			};
+			//Explicit traversal stack which only allocates if the tree is unusually deep
+			template<typename T>
+			class TraversalStack
+			{
+			public:
+				TraversalStack() : mSize(0){}
+				bool Empty()const { return mSize == 0; }
+				void Push(const T& value)
+				{
+					if (mSize < INLINE_CAPACITY)
+						mInline[mSize] = value;
+					else
+						mOverflow.push_back(value);
+					++mSize;
+				}
+				T Pop()
+				{
+					--mSize;
+					if (mSize < INLINE_CAPACITY)
+						return mInline[mSize];
+					auto value = mOverflow.back();
+					mOverflow.pop_back();
+					return value;
+				}
+			private:
+				static constexpr std::size_t INLINE_CAPACITY = 64;
+				T mInline[INLINE_CAPACITY];
+				std::vector<T> mOverflow;
+				std::size_t mSize;
+			};
+			struct FrustumEntry
+			{
+				std::uint32_t node;
+				//planes the node is not known to be inside of
+				std::uint32_t planeMask;
+			};
+			struct RayEntry
+			{
+				std::uint32_t node;
+				float distance;
+			};
+			std::uint32_t AllocateNode();
+			void FreeNode(std::uint32_t node);
+			void InsertLeaf(std::uint32_t leaf);
+			void RemoveLeaf(std::uint32_t leaf);
+			//Refits and rebalances node and its ancestors
+			void RefitAncestors(std::uint32_t node);
+			//Rotates the higher grandchild of node up if children heights differ by more than 1,returns the new subtree root
+			std::uint32_t Balance(std::uint32_t node);
+			void ReplaceChild(std::uint32_t parent, std::uint32_t oldChild, std::uint32_t newChild);
+			void SetUnion(std::uint32_t node, std::uint32_t child0, std::uint32_t child1);
+			void SetBounds(std::uint32_t node, const AABBf& bounds);
+			AABBf GetBounds(std::uint32_t node)const;
+			static float GetArea(const float* min, const float* max);
+			static float GetUnionArea(const Node& node, const AABBf& bounds);
+			//Calls visitor for all leaves under node
+			template<typename Visitor>
+			void VisitLeaves(std::uint32_t node, Visitor& visitor)const;
+			//Entry distance of ray into node,or a negative value if it's missed within maxDistance
+			static float IntersectRay(const Node& node, const Vector3f& origin, const Vector3f& inverseDirection, float maxDistance);
+			std::vector<Node> mNodes;
+			std::vector<std::uint32_t> mParents;
+			//0 for leaves,-1 for free nodes
+			std::vector<std::int32_t> mHeights;
+			std::uint32_t mRoot;
+			std::uint32_t mFreeList;
+			std::size_t mCount;
+			float mMargin;
+		};
+
+		template<typename Visitor>
+		void SpatialIndex::VisitLeaves(std::uint32_t node, Visitor& visitor)const
+		{
+			TraversalStack<std::uint32_t> stack;
+			stack.Push(node);
+			while (!stack.Empty())
+			{
+				const auto& current = mNodes[stack.Pop()];
+				if (current.IsLeaf())
+				{
+					visitor(static_cast<SpatialHandle>(&current - mNodes.data()));
+					continue;
+				}
+				stack.Push(current.children[1]);
+				stack.Push(current.children[0]);
+			}
+		}
+
+		template<typename Visitor>
+		void SpatialIndex::QueryBox(const AABBf& box, Visitor&& visitor)const
+		{
+			if (mRoot == INVALID_NODE)
+				return;
+			TraversalStack<std::uint32_t> stack;
+			stack.Push(mRoot);
+			while (!stack.Empty())
+			{
+				auto index = stack.Pop();
+				const auto& node = mNodes[index];
+				if (node.min[0] > box.max.x || node.max[0] < box.min.x ||
+					node.min[1] > box.max.y || node.max[1] < box.min.y ||
+					node.min[2] > box.max.z || node.max[2] < box.min.z)
+					continue;
+				if (node.IsLeaf())
+				{
+					visitor(static_cast<SpatialHandle>(index));
+					continue;
+				}
+				stack.Push(node.children[1]);
+				stack.Push(node.children[0]);
+			}
+		}
+
+		template<typename Visitor>
+		void SpatialIndex::QuerySphere(const SpatialSphere& sphere, Visitor&& visitor)const
+		{
+			if (mRoot == INVALID_NODE)
+				return;
+			const float center[3] = { sphere.center.x, sphere.center.y, sphere.center.z };
+			const auto radiusSquared = sphere.radius * sphere.radius;
+			TraversalStack<std::uint32_t> stack;
+			stack.Push(mRoot);
+			while (!stack.Empty())
+			{
+				auto index = stack.Pop();
+				const auto& node = mNodes[index];
+				//squared distance from center to the closest point of the box
+				float distanceSquared{ 0.0f };
+				for (auto i = 0;i < 3;++i)
+				{
+					auto d = center[i] < node.min[i] ? node.min[i] - center[i] : (center[i] > node.max[i] ? center[i] - node.max[i] : 0.0f);
+					distanceSquared += d * d;
+				}
+				if (distanceSquared > radiusSquared)
+					continue;
+				if (node.IsLeaf())
+				{
+					visitor(static_cast<SpatialHandle>(index));
+					continue;
+				}
+				stack.Push(node.children[1]);
+				stack.Push(node.children[0]);
+			}
+		}
+
+		template<typename Visitor>
+		void SpatialIndex::QueryFrustum(const Frustum& frustum, Visitor&& visitor)const
+		{
+			if (mRoot == INVALID_NODE)
+				return;
+			constexpr std::uint32_t AllPlanes = (1u << Frustum::PLANE_COUNT) - 1;
+			TraversalStack<FrustumEntry> stack;
+			stack.Push(FrustumEntry{ mRoot, AllPlanes });
+			while (!stack.Empty())
+			{
+				auto entry = stack.Pop();
+				const auto& node = mNodes[entry.node];
+				auto planeMask = entry.planeMask;
+				auto outside = false;
+				for (std::size_t i = 0;i < Frustum::PLANE_COUNT;++i)
+				{
+					if (!(planeMask & (1u << i)))
+						continue;
+					const auto& plane = frustum.planes[i];
+					auto distance = plane.x * (node.min[0] + node.max[0]) + plane.y * (node.min[1] + node.max[1]) +
+						plane.z * (node.min[2] + node.max[2]) + 2.0f * plane.w;
+					auto radius = std::abs(plane.x) * (node.max[0] - node.min[0]) + std::abs(plane.y) * (node.max[1] - node.min[1]) +
+						std::abs(plane.z) * (node.max[2] - node.min[2]);
+					if (distance + radius < 0)
+					{
+						outside = true;
+						break;
+					}
+					//children of a node completely inside a plane are inside it too
+					if (distance - radius >= 0)
+						planeMask &= ~(1u << i);
+				}
+				if (outside)
+					continue;
+				if (node.IsLeaf())
+				{
+					visitor(static_cast<SpatialHandle>(entry.node));
+					continue;
+				}
+				if (planeMask == 0)
+				{
+					VisitLeaves(entry.node, visitor);
+					continue;
+				}
+				stack.Push(FrustumEntry{ node.children[1], planeMask });
+				stack.Push(FrustumEntry{ node.children[0], planeMask });
+			}
+		}
+
+		template<typename Visitor>
+		void SpatialIndex::RayCast(const SpatialRay& ray, Visitor&& visitor)const
+		{
+			if (mRoot == INVALID_NODE)
+				return;
+			//zero components are replaced so that slabs parallel to the ray yield infinities instead of NaNs
+			auto inverse = [](float d) { return 1.0f / (d != 0.0f ? d : 1.0e-30f); };
+			const Vector3f inverseDirection{ inverse(ray.direction.x), inverse(ray.direction.y), inverse(ray.direction.z) };
+			auto maxDistance = ray.maxDistance;
+			auto rootDistance = IntersectRay(mNodes[mRoot], ray.origin, inverseDirection, maxDistance);
+			if (rootDistance < 0)
+				return;
+			TraversalStack<RayEntry> stack;
+			stack.Push(RayEntry{ mRoot, rootDistance });
+			while (!stack.Empty())
+			{
+				auto entry = stack.Pop();
+				//the ray may have been shortened since the node was pushed
+				if (entry.distance > maxDistance)
+					continue;
+				const auto& node = mNodes[entry.node];
+				if (node.IsLeaf())
+				{
+					auto distance = visitor(static_cast<SpatialHandle>(entry.node), entry.distance);
+					maxDistance = distance < maxDistance ? distance : maxDistance;
+					continue;
+				}
+				auto distance0 = IntersectRay(mNodes[node.children[0]], ray.origin, inverseDirection, maxDistance);
+				auto distance1 = IntersectRay(mNodes[node.children[1]], ray.origin, inverseDirection, maxDistance);
+				//the nearer child is popped first
+				if (distance0 >= 0 && distance1 >= 0 && distance1 < distance0)
+				{
+					stack.Push(RayEntry{ node.children[0], distance0 });
+					stack.Push(RayEntry{ node.children[1], distance1 });
+					continue;
+				}
+				if (distance1 >= 0)
+					stack.Push(RayEntry{ node.children[1], distance1 });
+				if (distance0 >= 0)
+					stack.Push(RayEntry{ node.children[0], distance0 });
+			}
+		}
+	}
+}
@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <cassert>
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "SIMD.h"
+#include "TransformSystem.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		namespace
+		{
+			//slots computed by one task,a multiple of SIMD width
+			constexpr std::size_t UPDATE_GRAIN_SIZE = 1024;
+			constexpr std::uint32_t INVALID_SLOT = 0xffffffff;
+
+			template<typename T>
+			void Permute(std::vector<T>& values, const std::vector<std::uint32_t>& order)
+			{
+				std::vector<T> permuted(order.size());
+				for (std::size_t i = 0;i < order.size();++i)
+				{
+					permuted[i] = values[order[i]];
+				}
+				values.swap(permuted);
+			}
+
+			Matrix4f MakeIdentity()
+			{
+				Matrix4f matrix;
+				matrix.SetIdentity();
+				return matrix;
+			}
+		}
+
+		TransformSystem::TransformSystem() : mDestroyedCount(0), mHierarchyChanged(false), mAnyDirty(false)
+		{
+
+		}
+
+		TransformHandle TransformSystem::Create(TransformHandle parent)
+		{
+			TransformHandle handle;
+			if (!mFreeHandles.empty())
+			{
+				handle = mFreeHandles.back();
+				mFreeHandles.pop_back();
+			}
+			else
+			{
+				handle = static_cast<TransformHandle>(mSlots.size());
+				mSlots.push_back(INVALID_SLOT);
+			}
+			assert(parent == INVALID_TRANSFORM_HANDLE || GetSlot(parent) != INVALID_SLOT);
+			auto slot = static_cast<std::uint32_t>(mHandles.size());
+			mSlots[handle] = slot;
+			mPositionX.push_back(0.0f);
+			mPositionY.push_back(0.0f);
+			mPositionZ.push_back(0.0f);
+			mRotationX.push_back(0.0f);
+			mRotationY.push_back(0.0f);
+			mRotationZ.push_back(0.0f);
+			mRotationW.push_back(1.0f);
+			mScaleX.push_back(1.0f);
+			mScaleY.push_back(1.0f);
+			mScaleZ.push_back(1.0f);
+			mWorldMatrices.push_back(MakeIdentity());
+			mHandles.push_back(handle);
+			mParents.push_back(parent);
+			mParentSlots.push_back(INVALID_SLOT);
+			mDirty.push_back(1);
+			mHierarchyChanged = true;
+			mAnyDirty = true;
+			return handle;
+		}
+
+		void TransformSystem::Destroy(TransformHandle handle)
+		{
+			auto slot = GetSlot(handle);
+			assert(slot != INVALID_SLOT && "Destroy an invalid transform!");
+			mHandles[slot] = INVALID_TRANSFORM_HANDLE;
+			mSlots[handle] = INVALID_SLOT;
+			mDestroyedHandles.push_back(handle);
+			++mDestroyedCount;
+			mHierarchyChanged = true;
+		}
+
+		void TransformSystem::SetParent(TransformHandle handle, TransformHandle parent)
+		{
+			auto slot = GetSlot(handle);
+			assert(slot != INVALID_SLOT && "Set parent of an invalid transform!");
+			if (mParents[slot] == parent)
+				return;
+#ifndef NDEBUG
+			//the walk stops at destroyed ancestors,whose children become roots
+			for (auto ancestor = parent;ancestor != INVALID_TRANSFORM_HANDLE;)
+			{
+				assert(ancestor != handle && "A transform can't be a descendant of itself!");
+				auto ancestorSlot = GetSlot(ancestor);
+				if (ancestorSlot == INVALID_SLOT)
+					break;
+				ancestor = mParents[ancestorSlot];
+			}
+#endif
+			mParents[slot] = parent;
+			mHierarchyChanged = true;
+			MarkDirty(slot);
+		}
+
+		TransformHandle TransformSystem::GetParent(TransformHandle handle)const
+		{
+			auto parent = mParents[GetSlot(handle)];
+			if (parent != INVALID_TRANSFORM_HANDLE && GetSlot(parent) == INVALID_SLOT)
+				return INVALID_TRANSFORM_HANDLE;
+			return parent;
+		}
+
+		void TransformSystem::SetLocalPosition(TransformHandle handle, const Vector3f& position)
+		{
+			auto slot = GetSlot(handle);
+			mPositionX[slot] = position.x;
+			mPositionY[slot] = position.y;
+			mPositionZ[slot] = position.z;
+			MarkDirty(slot);
+		}
+
+		void TransformSystem::SetLocalRotation(TransformHandle handle, const Quaternionf& rotation)
+		{
+			auto slot = GetSlot(handle);
+			mRotationX[slot] = rotation.x;
+			mRotationY[slot] = rotation.y;
+			mRotationZ[slot] = rotation.z;
+			mRotationW[slot] = rotation.w;
+			MarkDirty(slot);
+		}
+
+		void TransformSystem::SetLocalScale(TransformHandle handle, const Vector3f& scale)
+		{
+			auto slot = GetSlot(handle);
+			mScaleX[slot] = scale.x;
+			mScaleY[slot] = scale.y;
+			mScaleZ[slot] = scale.z;
+			MarkDirty(slot);
+		}
+
+		void TransformSystem::SetLocalTransform(TransformHandle handle, const Transform& transform)
+		{
+			SetLocalPosition(handle, transform.GetPosition());
+			SetLocalRotation(handle, transform.GetRotation());
+			SetLocalScale(handle, transform.GetScale());
+		}
+
+		Vector3f TransformSystem::GetLocalPosition(TransformHandle handle)const
+		{
+			auto slot = GetSlot(handle);
+			return Vector3f{ mPositionX[slot], mPositionY[slot], mPositionZ[slot] };
+		}
+
+		Quaternionf TransformSystem::GetLocalRotation(TransformHandle handle)const
+		{
+			auto slot = GetSlot(handle);
+			return Quaternionf{ mRotationX[slot], mRotationY[slot], mRotationZ[slot], mRotationW[slot] };
+		}
+
+		Vector3f TransformSystem::GetLocalScale(TransformHandle handle)const
+		{
+			auto slot = GetSlot(handle);
+			return Vector3f{ mScaleX[slot], mScaleY[slot], mScaleZ[slot] };
+		}
+
+		const Matrix4f& TransformSystem::GetWorldMatrix(TransformHandle handle)const
+		{
+			return mWorldMatrices[GetSlot(handle)];
+		}
+
+		void TransformSystem::Update()
+		{
+			if (mHierarchyChanged)
+			{
+				Rebuild();
+			}
+			if (!mAnyDirty)
+				return;
+			mChanged.resize(mHandles.size());
+			//parents are computed in previous levels,so slots of a level are independent of each other
+			for (std::size_t level = 0;level + 1 < mLevelOffsets.size();++level)
+			{
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(mLevelOffsets[level], mLevelOffsets[level + 1], UPDATE_GRAIN_SIZE),
+					[this](const tbb::blocked_range<std::size_t>& range) {
+					UpdateRange(range.begin(), range.end());
+				});
+			}
+			std::fill(mDirty.begin(), mDirty.end(), std::uint8_t(0));
+			mAnyDirty = false;
+		}
+
+		std::uint32_t TransformSystem::GetSlot(TransformHandle handle)const
+		{
+			assert(handle < mSlots.size() && "Invalid transform handle!");
+			return mSlots[handle];
+		}
+
+		void TransformSystem::MarkDirty(std::uint32_t slot)
+		{
+			mDirty[slot] = 1;
+			mAnyDirty = true;
+		}
+
+		void TransformSystem::Rebuild()
+		{
+			const auto slotCount = mHandles.size();
+			//depth of each live slot,children of destroyed transforms become roots
+			std::vector<std::uint32_t> depths(slotCount, INVALID_SLOT);
+			std::vector<std::uint32_t> chain;
+			std::uint32_t maxDepth{ 0 };
+			for (std::uint32_t slot = 0;slot < slotCount;++slot)
+			{
+				if (mHandles[slot] == INVALID_TRANSFORM_HANDLE || depths[slot] != INVALID_SLOT)
+					continue;
+				//walk up to an ancestor of known depth or a root
+				auto current = slot;
+				while (depths[current] == INVALID_SLOT)
+				{
+					auto parent = mParents[current];
+					auto parentSlot = parent == INVALID_TRANSFORM_HANDLE ? INVALID_SLOT : mSlots[parent];
+					if (parentSlot == INVALID_SLOT)
+					{
+						if (parent != INVALID_TRANSFORM_HANDLE)
+						{
+							mParents[current] = INVALID_TRANSFORM_HANDLE;
+							MarkDirty(current);
+						}
+						depths[current] = 0;
+						break;
+					}
+					chain.push_back(current);
+					current = parentSlot;
+				}
+				auto depth = depths[current];
+				while (!chain.empty())
+				{
+					depths[chain.back()] = ++depth;
+					chain.pop_back();
+				}
+				maxDepth = std::max(maxDepth, depths[slot]);
+			}
+
+			//counting sort by depth keeps the relative order of slots in a level
+			const auto liveCount = slotCount - mDestroyedCount;
+			mLevelOffsets.assign(liveCount > 0 ? maxDepth + 2 : 0, 0);
+			for (std::uint32_t slot = 0;slot < slotCount;++slot)
+			{
+				if (mHandles[slot] != INVALID_TRANSFORM_HANDLE)
+					++mLevelOffsets[depths[slot] + 1];
+			}
+			for (std::size_t level = 1;level < mLevelOffsets.size();++level)
+			{
+				mLevelOffsets[level] += mLevelOffsets[level - 1];
+			}
+			std::vector<std::uint32_t> order(liveCount);
+			std::vector<std::size_t> next(mLevelOffsets);
+			for (std::uint32_t slot = 0;slot < slotCount;++slot)
+			{
+				if (mHandles[slot] != INVALID_TRANSFORM_HANDLE)
+					order[next[depths[slot]]++] = slot;
+			}
+
+			Permute(mPositionX, order);
+			Permute(mPositionY, order);
+			Permute(mPositionZ, order);
+			Permute(mRotationX, order);
+			Permute(mRotationY, order);
+			Permute(mRotationZ, order);
+			Permute(mRotationW, order);
+			Permute(mScaleX, order);
+			Permute(mScaleY, order);
+			Permute(mScaleZ, order);
+			Permute(mWorldMatrices, order);
+			Permute(mHandles, order);
+			Permute(mParents, order);
+			Permute(mDirty, order);
+			for (std::uint32_t slot = 0;slot < liveCount;++slot)
+			{
+				mSlots[mHandles[slot]] = slot;
+			}
+			mParentSlots.resize(liveCount);
+			for (std::uint32_t slot = 0;slot < liveCount;++slot)
+			{
+				mParentSlots[slot] = mParents[slot] == INVALID_TRANSFORM_HANDLE ? INVALID_SLOT : mSlots[mParents[slot]];
+			}
+			mFreeHandles.insert(mFreeHandles.end(), mDestroyedHandles.begin(), mDestroyedHandles.end());
+			mDestroyedHandles.clear();
+			mDestroyedCount = 0;
+			mHierarchyChanged = false;
+		}
+
+		const Matrix4f& TransformSystem::GetParentWorldMatrix(std::size_t slot)const
+		{
+			static const Matrix4f identity = MakeIdentity();
+			auto parentSlot = mParentSlots[slot];
+			return parentSlot == INVALID_SLOT ? identity : mWorldMatrices[parentSlot];
+		}
+
+		//World matrix is local * parent world with row vectors,local is scale * rotation * translation like Transform.
+		//Rows 0-2 of local are the rotation rows scaled,row 3 is the position
+		void TransformSystem::UpdateRange(std::size_t begin, std::size_t end)
+		{
+			for (auto slot = begin;slot < end;++slot)
+			{
+				auto parentSlot = mParentSlots[slot];
+				mChanged[slot] = mDirty[slot] | (parentSlot == INVALID_SLOT ? std::uint8_t(0) : mChanged[parentSlot]);
+			}
+			std::size_t n = begin;
+#if defined(LIGHTNING_SIMD_SSE)
+			for (;n + 4 <= end;n += 4)
+			{
+				if (!(mChanged[n] | mChanged[n + 1] | mChanged[n + 2] | mChanged[n + 3]))
+					continue;
+				auto x = _mm_loadu_ps(&mRotationX[n]);
+				auto y = _mm_loadu_ps(&mRotationY[n]);
+				auto z = _mm_loadu_ps(&mRotationZ[n]);
+				auto w = _mm_loadu_ps(&mRotationW[n]);
+				auto two = _mm_set1_ps(2.0f);
+				auto one = _mm_set1_ps(1.0f);
+				auto x2 = _mm_mul_ps(two, _mm_mul_ps(x, x));
+				auto y2 = _mm_mul_ps(two, _mm_mul_ps(y, y));
+				auto z2 = _mm_mul_ps(two, _mm_mul_ps(z, z));
+				auto xy = _mm_mul_ps(two, _mm_mul_ps(x, y));
+				auto xz = _mm_mul_ps(two, _mm_mul_ps(x, z));
+				auto yz = _mm_mul_ps(two, _mm_mul_ps(y, z));
+				auto wx = _mm_mul_ps(two, _mm_mul_ps(w, x));
+				auto wy = _mm_mul_ps(two, _mm_mul_ps(w, y));
+				auto wz = _mm_mul_ps(two, _mm_mul_ps(w, z));
+				auto sx = _mm_loadu_ps(&mScaleX[n]);
+				auto sy = _mm_loadu_ps(&mScaleY[n]);
+				auto sz = _mm_loadu_ps(&mScaleZ[n]);
+				//local[row * 3 + column] for rows 0-2 and columns 0-2
+				__m128 local[12];
+				local[0] = _mm_mul_ps(sx, _mm_sub_ps(_mm_sub_ps(one, y2), z2));
+				local[1] = _mm_mul_ps(sx, _mm_add_ps(xy, wz));
+				local[2] = _mm_mul_ps(sx, _mm_sub_ps(xz, wy));
+				local[3] = _mm_mul_ps(sy, _mm_sub_ps(xy, wz));
+				local[4] = _mm_mul_ps(sy, _mm_sub_ps(_mm_sub_ps(one, x2), z2));
+				local[5] = _mm_mul_ps(sy, _mm_add_ps(yz, wx));
+				local[6] = _mm_mul_ps(sz, _mm_add_ps(xz, wy));
+				local[7] = _mm_mul_ps(sz, _mm_sub_ps(yz, wx));
+				local[8] = _mm_mul_ps(sz, _mm_sub_ps(_mm_sub_ps(one, x2), y2));
+				local[9] = _mm_loadu_ps(&mPositionX[n]);
+				local[10] = _mm_loadu_ps(&mPositionY[n]);
+				local[11] = _mm_loadu_ps(&mPositionZ[n]);
+				//parent[column * 4 + row] holds the cell of 4 parent matrices,transposed from their column major storage
+				__m128 parent[16];
+				const Matrix4f* parents[4] = { &GetParentWorldMatrix(n), &GetParentWorldMatrix(n + 1), 
+					&GetParentWorldMatrix(n + 2), &GetParentWorldMatrix(n + 3) };
+				for (std::size_t column = 0;column < 4;++column)
+				{
+					auto c0 = _mm_loadu_ps(parents[0]->m + column * 4);
+					auto c1 = _mm_loadu_ps(parents[1]->m + column * 4);
+					auto c2 = _mm_loadu_ps(parents[2]->m + column * 4);
+					auto c3 = _mm_loadu_ps(parents[3]->m + column * 4);
+					_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+					parent[column * 4] = c0;
+					parent[column * 4 + 1] = c1;
+					parent[column * 4 + 2] = c2;
+					parent[column * 4 + 3] = c3;
+				}
+				for (std::size_t column = 0;column < 4;++column)
+				{
+					const auto p0 = parent[column * 4];
+					const auto p1 = parent[column * 4 + 1];
+					const auto p2 = parent[column * 4 + 2];
+					const auto p3 = parent[column * 4 + 3];
+					__m128 world[4];
+					for (std::size_t row = 0;row < 4;++row)
+					{
+						world[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(local[row * 3], p0), _mm_mul_ps(local[row * 3 + 1], p1)),
+							_mm_mul_ps(local[row * 3 + 2], p2));
+					}
+					world[3] = _mm_add_ps(world[3], p3);
+					_MM_TRANSPOSE4_PS(world[0], world[1], world[2], world[3]);
+					_mm_storeu_ps(mWorldMatrices[n].m + column * 4, world[0]);
+					_mm_storeu_ps(mWorldMatrices[n + 1].m + column * 4, world[1]);
+					_mm_storeu_ps(mWorldMatrices[n + 2].m + column * 4, world[2]);
+					_mm_storeu_ps(mWorldMatrices[n + 3].m + column * 4, world[3]);
+				}
+			}
+#endif
+			//scalar tail(or the whole range if no SIMD instruction set is available)
+			for (;n < end;++n)
+			{
+				if (mChanged[n])
+				{
+					UpdateSlot(n);
+				}
+			}
+		}
+
+		void TransformSystem::UpdateSlot(std::size_t slot)
+		{
+			auto x = mRotationX[slot], y = mRotationY[slot], z = mRotationZ[slot], w = mRotationW[slot];
+			auto x2 = 2 * x * x, y2 = 2 * y * y, z2 = 2 * z * z;
+			auto xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+			auto wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+			auto sx = mScaleX[slot], sy = mScaleY[slot], sz = mScaleZ[slot];
+			const float local[12] = {
+				sx * (1 - y2 - z2), sx * (xy + wz), sx * (xz - wy),
+				sy * (xy - wz), sy * (1 - x2 - z2), sy * (yz + wx),
+				sz * (xz + wy), sz * (yz - wx), sz * (1 - x2 - y2),
+				mPositionX[slot], mPositionY[slot], mPositionZ[slot] };
+			const auto& parent = GetParentWorldMatrix(slot);
+			auto& world = mWorldMatrices[slot];
+			for (unsigned column = 0;column < 4;++column)
+			{
+				for (unsigned row = 0;row < 4;++row)
+				{
+					auto value = local[row * 3] * parent.GetCell(0, column) + local[row * 3 + 1] * parent.GetCell(1, column)
+						+ local[row * 3 + 2] * parent.GetCell(2, column);
+					if (row == 3)
+						value += parent.GetCell(3, column);
+					world.SetCell(row, column, value);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Transform.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		using Foundation::Math::Transform;
+		using Foundation::Math::Matrix4f;
+		using Foundation::Math::Vector3f;
+		using Foundation::Math::Quaternionf;
+		using TransformHandle = std::uint32_t;
+		constexpr TransformHandle INVALID_TRANSFORM_HANDLE = 0xffffffff;
+
+		//Flat transform hierarchy.Local position,rotation and scale are stored component by component in contiguous arrays
+		//along with parent slots and world matrices.Slots are sorted by depth so parents always precede children,and Update
+		//computes world matrices level by level,each level split into batches computed in parallel with SIMD.Only changed
+		//transforms and their descendants are computed.Transforms are referred to by handles which stay valid while slots
+		//move.Thread unsafe
+		class TransformSystem
+		{
+		public:
+			TransformSystem();
+			TransformHandle Create(TransformHandle parent = INVALID_TRANSFORM_HANDLE);
+			//Children of a destroyed transform become roots
+			void Destroy(TransformHandle handle);
+			//parent must not be a descendant of handle
+			void SetParent(TransformHandle handle, TransformHandle parent);
+			TransformHandle GetParent(TransformHandle handle)const;
+			void SetLocalPosition(TransformHandle handle, const Vector3f& position);
+			void SetLocalRotation(TransformHandle handle, const Quaternionf& rotation);
+			void SetLocalScale(TransformHandle handle, const Vector3f& scale);
+			void SetLocalTransform(TransformHandle handle, const Transform& transform);
+			Vector3f GetLocalPosition(TransformHandle handle)const;
+			Quaternionf GetLocalRotation(TransformHandle handle)const;
+			Vector3f GetLocalScale(TransformHandle handle)const;
+			//Valid after Update
+			const Matrix4f& GetWorldMatrix(TransformHandle handle)const;
+			void Update();
+			std::size_t GetCount()const { return mHandles.size() - mDestroyedCount; }
+			//Valid after Update
+			std::size_t GetLevelCount()const { return mLevelOffsets.empty() ? 0 : mLevelOffsets.size() - 1; }
+		private:
+			std::uint32_t GetSlot(TransformHandle handle)const;
+			void MarkDirty(std::uint32_t slot);
+			//Sorts slots by depth and drops destroyed ones
+			void Rebuild();
+			void UpdateRange(std::size_t begin, std::size_t end);
+			void UpdateSlot(std::size_t slot);
+			const Matrix4f& GetParentWorldMatrix(std::size_t slot)const;
+			//per slot
+			std::vector<float> mPositionX, mPositionY, mPositionZ;
+			std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+			std::vector<float> mScaleX, mScaleY, mScaleZ;
+			std::vector<Matrix4f> mWorldMatrices;
+			std::vector<TransformHandle> mHandles;
+			std::vector<TransformHandle> mParents;
+			//valid after Rebuild,INVALID_TRANSFORM_HANDLE for roots
+			std::vector<std::uint32_t> mParentSlots;
+			std::vector<std::uint8_t> mDirty;
+			//dirty or has a changed parent,computed while updating
+			std::vector<std::uint8_t> mChanged;
+			//slots of level i are [mLevelOffsets[i], mLevelOffsets[i + 1])
+			std::vector<std::size_t> mLevelOffsets;
+			//per handle
+			std::vector<std::uint32_t> mSlots;
+			std::vector<TransformHandle> mFreeHandles;
+			//handles destroyed since last Rebuild,they are not reused before children referring to them are detached
+			std::vector<TransformHandle> mDestroyedHandles;
+			std::size_t mDestroyedCount;
+			bool mHierarchyChanged;
+			bool mAnyDirty;
+		};
+	}
+}
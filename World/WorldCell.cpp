@@ -0,0 +1,149 @@
+#include <cstring>
+#include "WorldCell.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		using Loading::ISerializeBuffer;
+		namespace
+		{
+			//Chunks are written in host byte order,all supported platforms are little endian
+			class ChunkWriter
+			{
+			public:
+				ChunkWriter(std::vector<char>& buffer) : mBuffer(buffer){}
+				template<typename T>
+				void Write(const T& value)
+				{
+					static_assert(std::is_pod<T>::value, "Only POD can be written to chunk!");
+					WriteBytes(&value, sizeof(T));
+				}
+				void WriteBytes(const void* data, std::size_t size)
+				{
+					auto offset = mBuffer.size();
+					mBuffer.resize(offset + size);
+					if (size > 0)
+						std::memcpy(mBuffer.data() + offset, data, size);
+				}
+			private:
+				std::vector<char>& mBuffer;
+			};
+
+			class ChunkReader
+			{
+			public:
+				ChunkReader(const char* buffer, std::size_t size) : mBuffer(buffer), mSize(size), mOffset(0){}
+				template<typename T>
+				bool Read(T& value)
+				{
+					static_assert(std::is_pod<T>::value, "Only POD can be read from chunk!");
+					return ReadBytes(&value, sizeof(T));
+				}
+				bool ReadBytes(void* data, std::size_t size)
+				{
+					if (mSize - mOffset < size)
+						return false;
+					if (size > 0)
+						std::memcpy(data, mBuffer + mOffset, size);
+					mOffset += size;
+					return true;
+				}
+				std::size_t GetRemainSize()const { return mSize - mOffset; }
+			private:
+				const char* mBuffer;
+				std::size_t mSize;
+				std::size_t mOffset;
+			};
+
+			//Smallest size of a serialized object,used to reject corrupted object counts before allocation
+			constexpr std::size_t MIN_OBJECT_SIZE = sizeof(std::uint32_t) * 2 + sizeof(Vector3f) * 2 + sizeof(Quaternionf);
+
+			class WorldCellBuffer : public ISerializeBuffer
+			{
+			public:
+				char* GetBuffer()override { return mBuffer.data(); }
+				std::size_t GetBufferSize()const override { return mBuffer.size(); }
+				std::vector<char> mBuffer;
+			};
+		}
+
+		void WriteWorldCell(const WorldCellData& cell, std::vector<char>& buffer)
+		{
+			ChunkWriter writer(buffer);
+			writer.Write(WORLD_CELL_MAGIC);
+			writer.Write(WORLD_CELL_VERSION);
+			writer.Write(cell.coord);
+			writer.Write(static_cast<std::uint32_t>(cell.objects.size()));
+			for (const auto& object : cell.objects)
+			{
+				writer.Write(object.type);
+				writer.Write(object.position);
+				writer.Write(object.rotation);
+				writer.Write(object.scale);
+				writer.Write(static_cast<std::uint32_t>(object.data.size()));
+				writer.WriteBytes(object.data.data(), object.data.size());
+			}
+		}
+
+		bool ReadWorldCell(const char* buffer, std::size_t size, WorldCellData& cell)
+		{
+			ChunkReader reader(buffer, size);
+			std::uint32_t magic{ 0 }, version{ 0 }, objectCount{ 0 };
+			if (!reader.Read(magic) || magic != WORLD_CELL_MAGIC)
+				return false;
+			if (!reader.Read(version) || version != WORLD_CELL_VERSION)
+				return false;
+			if (!reader.Read(cell.coord) || !reader.Read(objectCount))
+				return false;
+			if (objectCount > reader.GetRemainSize() / MIN_OBJECT_SIZE)
+				return false;
+			cell.objects.resize(objectCount);
+			for (auto& object : cell.objects)
+			{
+				std::uint32_t dataSize{ 0 };
+				if (!reader.Read(object.type) || !reader.Read(object.position) || !reader.Read(object.rotation)
+					|| !reader.Read(object.scale) || !reader.Read(dataSize))
+					return false;
+				if (dataSize > reader.GetRemainSize())
+					return false;
+				object.data.resize(dataSize);
+				if (!reader.ReadBytes(&object.data[0], dataSize))
+					return false;
+			}
+			return reader.GetRemainSize() == 0;
+		}
+
+		WorldCellSerializer::WorldCellSerializer(const WorldCellCoord& coord, WorldCellCallback callback)
+			:mCoord(coord), mFinishCallback(callback)
+		{
+
+		}
+
+		WorldCellSerializer::WorldCellSerializer(const std::shared_ptr<WorldCellData>& cell)
+			:mCoord(cell->coord), mCell(cell)
+		{
+
+		}
+
+		std::shared_ptr<ISerializeBuffer> WorldCellSerializer::Serialize()
+		{
+			if (!mCell)
+				return nullptr;
+			auto buffer = std::make_shared<WorldCellBuffer>();
+			WriteWorldCell(*mCell, buffer->mBuffer);
+			return buffer;
+		}
+
+		void WorldCellSerializer::Deserialize(Foundation::IFile* file, const std::shared_ptr<ISerializeBuffer>& buffer)
+		{
+			//Parsing is done here on loader worker thread,only object creation is left to the thread that owns the world
+			std::size_t chunkSize = buffer ? buffer->GetBufferSize() : 0;
+			auto cell = std::make_shared<WorldCellData>();
+			if (!buffer || !ReadWorldCell(buffer->GetBuffer(), chunkSize, *cell) || cell->coord != mCoord)
+				cell.reset();
+			if (mFinishCallback)
+				mFinishCallback(cell, chunkSize);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "Vector.h"
+#include "Quaternion.h"
+#include "ISerializer.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		using Foundation::Math::Vector3f;
+		using Foundation::Math::Quaternionf;
+
+		//Cell index on the XZ plane of a partitioned world.Cell (x, z) covers [x * cellSize, (x + 1) * cellSize) on both axes
+		struct WorldCellCoord
+		{
+			std::int32_t x;
+			std::int32_t z;
+			bool operator==(const WorldCellCoord& other)const { return x == other.x && z == other.z; }
+			bool operator!=(const WorldCellCoord& other)const { return !(*this == other); }
+		};
+
+		//An object placed in a cell.type and data are interpreted by the cell handler,e.g.a primitive shape or an asset path
+		struct WorldCellObject
+		{
+			std::uint32_t type;
+			Vector3f position;
+			Quaternionf rotation;
+			Vector3f scale;
+			std::string data;
+		};
+
+		//Content of a cell chunk.Each cell is serialized into its own file so it can be streamed independently
+		struct WorldCellData
+		{
+			WorldCellCoord coord;
+			std::vector<WorldCellObject> objects;
+		};
+
+		//Chunk layout(little endian) : magic,version,coord,object count,objects.
+		//Each object is type,position,rotation,scale,data size and data bytes
+		static constexpr std::uint32_t WORLD_CELL_MAGIC = 0x4C435744;	//"DWCL"
+		static constexpr std::uint32_t WORLD_CELL_VERSION = 1;
+
+		void WriteWorldCell(const WorldCellData& cell, std::vector<char>& buffer);
+		//Returns false if the buffer is not a valid chunk,cell is left in an unspecified state then
+		bool ReadWorldCell(const char* buffer, std::size_t size, WorldCellData& cell);
+
+		//Called on a loader worker thread.cell is nullptr if the chunk is corrupted or doesn't belong to the requested cell
+		using WorldCellCallback = std::function<void(const std::shared_ptr<WorldCellData>& cell, std::size_t chunkSize)>;
+
+		class WorldCellSerializer : public Loading::ISerializer
+		{
+		public:
+			//Loading constructor
+			WorldCellSerializer(const WorldCellCoord& coord, WorldCellCallback callback);
+			//Saving constructor
+			WorldCellSerializer(const std::shared_ptr<WorldCellData>& cell);
+			std::shared_ptr<Loading::ISerializeBuffer> Serialize()override;
+			void Deserialize(Foundation::IFile* file, const std::shared_ptr<Loading::ISerializeBuffer>& buffer)override;
+		private:
+			WorldCellCoord mCoord;
+			WorldCellCallback mFinishCallback;
+			std::shared_ptr<WorldCellData> mCell;
+		};
+	}
+}
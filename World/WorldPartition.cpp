@@ -0,0 +1,286 @@
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "WorldPartition.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		WorldPartition::WorldPartition(const WorldPartitionSettings& settings, Loading::ILoader& loader, IWorldCellHandler& handler)
+			:mSettings(settings), mLoader(loader), mHandler(handler), mLoadResults(std::make_shared<LoadResultQueue>())
+			,mStats{}, mUpdateIndex(0), mNextRequestId(0)
+		{
+			assert(mSettings.cellSize > 0.0f && "cell size must be positive!");
+			assert(mSettings.unloadRadius >= mSettings.loadRadius && "unload radius must not be smaller than load radius!");
+			assert(mSettings.maxInFlightLoads > 0 && "at least one load must be allowed in flight!");
+		}
+
+		WorldPartition::~WorldPartition()
+		{
+			UnloadAll();
+		}
+
+		WorldPartition::CellKey WorldPartition::GetCellKey(const WorldCellCoord& coord)
+		{
+			return (CellKey(std::uint32_t(coord.x)) << 32) | std::uint32_t(coord.z);
+		}
+
+		void WorldPartition::RegisterCell(const WorldCellCoord& coord, const std::string& path, std::size_t memorySize)
+		{
+			auto& cell = mCells[GetCellKey(coord)];
+			assert(cell.path.empty() && "cell is already registered!");
+			cell.coord = coord;
+			cell.path = path;
+			cell.memorySize = memorySize;
+			cell.state = WorldCellState::UNLOADED;
+			cell.requestId = 0;
+			cell.requestUpdate = 0;
+			cell.retryUpdate = 0;
+			cell.distance = 0.0f;
+			cell.distanceUpdate = 0;
+		}
+
+		void WorldPartition::UnregisterCell(const WorldCellCoord& coord)
+		{
+			auto it = mCells.find(GetCellKey(coord));
+			if (it == mCells.end())
+				return;
+			auto& cell = it->second;
+			if (cell.state == WorldCellState::LOADED)
+			{
+				UnloadCell(cell);
+				mLoadedCells.erase(std::find(mLoadedCells.begin(), mLoadedCells.end(), &cell));
+			}
+			else if (cell.state == WorldCellState::LOADING)
+			{
+				AbandonLoad(cell);
+				mLoadingCells.erase(std::find(mLoadingCells.begin(), mLoadingCells.end(), &cell));
+			}
+			mCells.erase(it);
+		}
+
+		WorldCellCoord WorldPartition::GetCellCoord(const Vector3f& position)const
+		{
+			return WorldCellCoord{ static_cast<std::int32_t>(std::floor(position.x / mSettings.cellSize)),
+				static_cast<std::int32_t>(std::floor(position.z / mSettings.cellSize)) };
+		}
+
+		WorldCellState WorldPartition::GetCellState(const WorldCellCoord& coord)const
+		{
+			auto it = mCells.find(GetCellKey(coord));
+			if (it == mCells.end())
+				return WorldCellState::UNREGISTERED;
+			return it->second.state;
+		}
+
+		float WorldPartition::GetCellDistance(Cell& cell, const Vector3f* viewers, std::size_t viewerCount)
+		{
+			if (cell.distanceUpdate == mUpdateIndex)
+				return cell.distance;
+			//distance on the XZ plane from viewer to the nearest point of cell
+			auto minX = cell.coord.x * mSettings.cellSize;
+			auto minZ = cell.coord.z * mSettings.cellSize;
+			auto distanceSq = std::numeric_limits<float>::max();
+			for (std::size_t i = 0;i < viewerCount;++i)
+			{
+				auto dx = std::max(std::max(minX - viewers[i].x, viewers[i].x - minX - mSettings.cellSize), 0.0f);
+				auto dz = std::max(std::max(minZ - viewers[i].z, viewers[i].z - minZ - mSettings.cellSize), 0.0f);
+				distanceSq = std::min(distanceSq, dx * dx + dz * dz);
+			}
+			cell.distance = viewerCount > 0 ? std::sqrt(distanceSq) : std::numeric_limits<float>::max();
+			cell.distanceUpdate = mUpdateIndex;
+			return cell.distance;
+		}
+
+		void WorldPartition::Update(const Vector3f* viewers, std::size_t viewerCount)
+		{
+			++mUpdateIndex;
+			ProcessLoadResults(viewers, viewerCount);
+			CancelExpiredLoads();
+			UnloadFarCells(viewers, viewerCount);
+			GatherCandidates(viewers, viewerCount);
+			RequestCandidates();
+			mStats.loadedCellCount = mLoadedCells.size();
+			mStats.loadingCellCount = mLoadingCells.size();
+		}
+
+		void WorldPartition::ProcessLoadResults(const Vector3f* viewers, std::size_t viewerCount)
+		{
+			LoadResult result;
+			while (mLoadResults->try_pop(result))
+			{
+				auto it = mCells.find(GetCellKey(result.coord));
+				//the cell was unregistered or its request was abandoned
+				if (it == mCells.end() || it->second.state != WorldCellState::LOADING || it->second.requestId != result.requestId)
+					continue;
+				auto& cell = it->second;
+				mLoadingCells.erase(std::find(mLoadingCells.begin(), mLoadingCells.end(), &cell));
+				mStats.loadingMemory -= cell.memorySize;
+				if (!result.cell)
+				{
+					cell.state = WorldCellState::UNLOADED;
+					cell.retryUpdate = mUpdateIndex + mSettings.loadTimeoutUpdates;
+					++mStats.failedLoads;
+					continue;
+				}
+				//The real size replaces the estimate from registration
+				cell.memorySize = result.chunkSize;
+				if (GetCellDistance(cell, viewers, viewerCount) > mSettings.unloadRadius)
+				{
+					cell.state = WorldCellState::UNLOADED;
+					++mStats.discardedLoads;
+					continue;
+				}
+				cell.state = WorldCellState::LOADED;
+				mStats.residentMemory += cell.memorySize;
+				++mStats.completedLoads;
+				mLoadedCells.push_back(&cell);
+				mHandler.OnCellLoaded(*result.cell);
+			}
+		}
+
+		void WorldPartition::CancelExpiredLoads()
+		{
+			auto it = std::remove_if(mLoadingCells.begin(), mLoadingCells.end(), [this](Cell* cell) {
+				if (mUpdateIndex - cell->requestUpdate <= mSettings.loadTimeoutUpdates)
+					return false;
+				AbandonLoad(*cell);
+				cell->retryUpdate = mUpdateIndex + mSettings.loadTimeoutUpdates;
+				++mStats.failedLoads;
+				return true;
+			});
+			mLoadingCells.erase(it, mLoadingCells.end());
+		}
+
+		void WorldPartition::UnloadFarCells(const Vector3f* viewers, std::size_t viewerCount)
+		{
+			auto it = std::remove_if(mLoadedCells.begin(), mLoadedCells.end(), [this, viewers, viewerCount](Cell* cell) {
+				if (GetCellDistance(*cell, viewers, viewerCount) <= mSettings.unloadRadius)
+					return false;
+				UnloadCell(*cell);
+				return true;
+			});
+			mLoadedCells.erase(it, mLoadedCells.end());
+		}
+
+		void WorldPartition::GatherCandidates(const Vector3f* viewers, std::size_t viewerCount)
+		{
+			mCandidates.clear();
+			auto tryAdd = [this, viewers, viewerCount](Cell& cell) {
+				if (cell.state != WorldCellState::UNLOADED || cell.retryUpdate > mUpdateIndex)
+					return;
+				if (GetCellDistance(cell, viewers, viewerCount) <= mSettings.loadRadius)
+					mCandidates.push_back(&cell);
+			};
+			auto range = static_cast<std::int64_t>(std::ceil(mSettings.loadRadius / mSettings.cellSize)) * 2 + 1;
+			if (static_cast<std::uint64_t>(range * range * viewerCount) >= mCells.size())
+			{
+				//a sparse world or a large radius,walking registered cells is cheaper than walking the grid
+				for (auto& pair : mCells)
+					tryAdd(pair.second);
+			}
+			else
+			{
+				for (std::size_t i = 0;i < viewerCount;++i)
+				{
+					auto center = GetCellCoord(viewers[i]);
+					auto extent = static_cast<std::int32_t>(range / 2);
+					for (auto z = center.z - extent;z <= center.z + extent;++z)
+					{
+						for (auto x = center.x - extent;x <= center.x + extent;++x)
+						{
+							auto it = mCells.find(GetCellKey(WorldCellCoord{ x, z }));
+							if (it != mCells.end())
+								tryAdd(it->second);
+						}
+					}
+				}
+			}
+			//grids of nearby viewers overlap,the same cell may be gathered more than once
+			std::sort(mCandidates.begin(), mCandidates.end(), [](const Cell* c1, const Cell* c2) {
+				return c1->distance < c2->distance || (c1->distance == c2->distance && c1 < c2);
+			});
+			mCandidates.erase(std::unique(mCandidates.begin(), mCandidates.end()), mCandidates.end());
+		}
+
+		void WorldPartition::RequestCandidates()
+		{
+			if (mCandidates.empty())
+				return;
+			//loaded cells sorted from the nearest to the farthest,eviction starts from the back
+			std::sort(mLoadedCells.begin(), mLoadedCells.end(), [](const Cell* c1, const Cell* c2) {
+				return c1->distance < c2->distance;
+			});
+			for (auto cell : mCandidates)
+			{
+				if (mLoadingCells.size() >= mSettings.maxInFlightLoads)
+					break;
+				//the cell can never fit,loading it would evict the whole world
+				if (cell->memorySize > mSettings.memoryBudget)
+					continue;
+				while (mStats.residentMemory + mStats.loadingMemory + cell->memorySize > mSettings.memoryBudget
+					&& !mLoadedCells.empty() && mLoadedCells.back()->distance > cell->distance)
+				{
+					UnloadCell(*mLoadedCells.back());
+					mLoadedCells.pop_back();
+					++mStats.evictions;
+				}
+				//Memory is held by nearer cells,farther candidates must wait as well
+				if (mStats.residentMemory + mStats.loadingMemory + cell->memorySize > mSettings.memoryBudget)
+					break;
+				RequestLoad(*cell);
+			}
+		}
+
+		void WorldPartition::RequestLoad(Cell& cell)
+		{
+			cell.state = WorldCellState::LOADING;
+			cell.requestId = ++mNextRequestId;
+			cell.requestUpdate = mUpdateIndex;
+			mStats.loadingMemory += cell.memorySize;
+			++mStats.requestedLoads;
+			mLoadingCells.push_back(&cell);
+			std::weak_ptr<LoadResultQueue> results(mLoadResults);
+			auto coord = cell.coord;
+			auto requestId = cell.requestId;
+			auto serializer = std::make_shared<WorldCellSerializer>(coord,
+				[results, coord, requestId](const std::shared_ptr<WorldCellData>& data, std::size_t chunkSize) {
+				auto queue = results.lock();
+				if (queue)
+					queue->push(LoadResult{ coord, requestId, data, chunkSize });
+			});
+			mLoader.Load(cell.path, serializer);
+		}
+
+		void WorldPartition::UnloadCell(Cell& cell)
+		{
+			assert(cell.state == WorldCellState::LOADED && "cell is not loaded!");
+			cell.state = WorldCellState::UNLOADED;
+			mStats.residentMemory -= cell.memorySize;
+			mHandler.OnCellUnloaded(cell.coord);
+		}
+
+		void WorldPartition::AbandonLoad(Cell& cell)
+		{
+			assert(cell.state == WorldCellState::LOADING && "cell is not loading!");
+			//result of the request is dropped when it arrives because request id no longer matches
+			cell.state = WorldCellState::UNLOADED;
+			cell.requestId = 0;
+			mStats.loadingMemory -= cell.memorySize;
+		}
+
+		void WorldPartition::UnloadAll()
+		{
+			for (auto cell : mLoadedCells)
+				UnloadCell(*cell);
+			mLoadedCells.clear();
+			for (auto cell : mLoadingCells)
+				AbandonLoad(*cell);
+			mLoadingCells.clear();
+			mStats.loadedCellCount = 0;
+			mStats.loadingCellCount = 0;
+		}
+	}
+}
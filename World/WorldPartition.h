@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "tbb/concurrent_queue.h"
+#include "ILoader.h"
+#include "WorldCell.h"
+
+namespace Lightning
+{
+	namespace World
+	{
+		enum class WorldCellState : std::uint8_t
+		{
+			UNREGISTERED,
+			UNLOADED,
+			LOADING,
+			LOADED
+		};
+
+		struct WorldPartitionSettings
+		{
+			//edge length of a cell on the XZ plane
+			float cellSize{ 256.0f };
+			//cells closer than loadRadius to any viewer are streamed in
+			float loadRadius{ 512.0f };
+			//loaded cells farther than unloadRadius from all viewers are streamed out.
+			//It should be larger than loadRadius so that cells on the border don't thrash
+			float unloadRadius{ 640.0f };
+			//requests handed to loader but not finished yet
+			std::size_t maxInFlightLoads{ 4 };
+			//bytes of loaded cells plus bytes of cells being loaded
+			std::size_t memoryBudget{ 256 * 1024 * 1024 };
+			//Loader drops requests of missing files silently,so requests not finished after this many updates are given up.
+			//A failed cell is not requested again within the same number of updates
+			std::size_t loadTimeoutUpdates{ 300 };
+		};
+
+		struct WorldPartitionStats
+		{
+			std::size_t loadedCellCount;
+			std::size_t loadingCellCount;
+			std::size_t residentMemory;
+			std::size_t loadingMemory;
+			std::size_t requestedLoads;
+			std::size_t completedLoads;
+			std::size_t failedLoads;
+			//loads finished after their cells went out of range
+			std::size_t discardedLoads;
+			//loaded cells unloaded to make room for nearer cells
+			std::size_t evictions;
+		};
+
+		//Creates and destroys the objects of streamed cells.Called from WorldPartition::Update
+		struct IWorldCellHandler
+		{
+			virtual ~IWorldCellHandler() = default;
+			virtual void OnCellLoaded(const WorldCellData& cell) = 0;
+			virtual void OnCellUnloaded(const WorldCellCoord& coord) = 0;
+		};
+
+		//Streams cells of a world in and out through loader based on distance to viewers(usually active cameras).
+		//Nearer cells are requested first,requests in flight are capped and the memory of loaded and loading cells is kept
+		//within budget by evicting the farthest cells.All methods must be called from the same thread,chunks are parsed on
+		//loader threads and handed back in Update
+		class WorldPartition
+		{
+		public:
+			WorldPartition(const WorldPartitionSettings& settings, Loading::ILoader& loader, IWorldCellHandler& handler);
+			~WorldPartition();
+			//memorySize is an estimate used before the cell is loaded,usually the size of its chunk file
+			void RegisterCell(const WorldCellCoord& coord, const std::string& path, std::size_t memorySize);
+			void UnregisterCell(const WorldCellCoord& coord);
+			void Update(const Vector3f* viewers, std::size_t viewerCount);
+			void UnloadAll();
+			WorldCellCoord GetCellCoord(const Vector3f& position)const;
+			WorldCellState GetCellState(const WorldCellCoord& coord)const;
+			const WorldPartitionSettings& GetSettings()const { return mSettings; }
+			const WorldPartitionStats& GetStats()const { return mStats; }
+		private:
+			using CellKey = std::uint64_t;
+			struct Cell
+			{
+				WorldCellCoord coord;
+				std::string path;
+				std::size_t memorySize;
+				WorldCellState state;
+				std::uint64_t requestId;
+				std::size_t requestUpdate;
+				//failed cells are not requested before this update
+				std::size_t retryUpdate;
+				//distance to the nearest viewer,computed once per update
+				float distance;
+				std::size_t distanceUpdate;
+			};
+			struct LoadResult
+			{
+				WorldCellCoord coord;
+				std::uint64_t requestId;
+				std::shared_ptr<WorldCellData> cell;
+				std::size_t chunkSize;
+			};
+			using LoadResultQueue = tbb::concurrent_queue<LoadResult>;
+			static CellKey GetCellKey(const WorldCellCoord& coord);
+			float GetCellDistance(Cell& cell, const Vector3f* viewers, std::size_t viewerCount);
+			void ProcessLoadResults(const Vector3f* viewers, std::size_t viewerCount);
+			void CancelExpiredLoads();
+			void UnloadFarCells(const Vector3f* viewers, std::size_t viewerCount);
+			void GatherCandidates(const Vector3f* viewers, std::size_t viewerCount);
+			void RequestCandidates();
+			void RequestLoad(Cell& cell);
+			void UnloadCell(Cell& cell);
+			void AbandonLoad(Cell& cell);
+			WorldPartitionSettings mSettings;
+			Loading::ILoader& mLoader;
+			IWorldCellHandler& mHandler;
+			//shared with serializers so that loads finishing after destruction of partition are harmless
+			std::shared_ptr<LoadResultQueue> mLoadResults;
+			std::unordered_map<CellKey, Cell> mCells;
+			std::vector<Cell*> mLoadedCells;
+			std::vector<Cell*> mLoadingCells;
+			std::vector<Cell*> mCandidates;
+			WorldPartitionStats mStats;
+			std::size_t mUpdateIndex;
+			std::uint64_t mNextRequestId;
+		};
+	}
+}